@@ -1,350 +1,671 @@
-/*****************************************************************************
- *                                                                           *
- *  gpifont.h                                                                *
- *                                                                           *
- *  Definitions for handling standard OS/2 GPI bitmap fonts.                 *
- *                                                                           *
- *  There are several OS/2-specific font formats, but the main one is the    *
- *  'standard' GPI format.  This is the format which is supported here,      *
- *  although some of the structures and routines may someday prove useful    *
- *  in implementing support for other types.                                 *
- *                                                                           *
- *  Those others include the extremely obscure Uni-font format (of which I   *
- *  have never found a single example), several related 'combined font'      *
- *  formats which are basically wrappers or aliases to other fonts, and the  *
- *  ultra-convoluted native DBCS fonts which are composed of standard GPI    *
- *  fonts in association with separately-loaded CJK glyph libraries (which   *
- *  themselves seem to support a few different formats but are mostly        *
- *  something from MS called WIFE).  But none of these concern us here.      *
- *                                                                           *
- *  The GPI documentation implies that the GPI font format may also contain  *
- *  outline data, but the format of such outlines is only alluded to.  In    *
- *  any event, I'm not aware of any such fonts actually existing (all        *
- *  outline fonts included with OS/2 are in TTF or Type 1 format).           *
- *                                                                           *
- *  (C) 2012 Alexander Taylor                                                *
- *                                                                           *
- *  This code is placed in the public domain.                                *
- *                                                                           *
- *****************************************************************************/
-
-#ifndef __GPIFONT_H__
-#define __GPIFONT_H__
-
-
-// ----------------------------------------------------------------------------
-// CONSTANTS
-
-/* Text signatures for standard OS/2 bitmap fonts.
- */
-#define OS2FNT_SIGNATURE    "OS/2 FONT"
-#define OS2FNT2_SIGNATURE   "OS/2 FONT 2"
-
-/* Binary signatures for various OS/2 font records.
- */
-#define SIG_OS2FONTSTART    0xFFFFFFFE
-#define SIG_OS2METRICS      0x1
-#define SIG_OS2FONTDEF      0x2
-#define SIG_OS2KERN         0x3
-#define SIG_OS2ADDMETRICS   0x4
-#define SIG_OS2FONTEND      0xFFFFFFFF
-
-/* GPI categorizes fonts in 3 types according to character increment definition:
- * Type 1 : Fixed-width font
- * Type 2 : Proportional-width font with each character increment defined as
- *          one value in the character definition.
- * Type 3 : Proportional-width font with each character increment defined in
- *          terms of: a_space + b_space + c_space
- *             Where: a_space = leading space in front of the character
- *                    b_space = width of the character glyph
- *                    c_space = space following the character
- *
- * Each type is required to have specific values of flFontDef and flCharDef
- * in the font definition header.  These values are defined below.
- */
-#define OS2FONTDEF_FONT1    0x47
-#define OS2FONTDEF_FONT2    0x42
-#define OS2FONTDEF_FONT3    0x42
-#define OS2FONTDEF_CHAR1    0x81
-#define OS2FONTDEF_CHAR2    0x81
-#define OS2FONTDEF_CHAR3    0XB8
-
-/* Font charset-support flags.
- */
-#define FOCA_CHARSET_LATIN1         0x10
-#define FOCA_CHARSET_PC             0x20
-#define FOCA_CHARSET_LATINX         0x40
-#define FOCA_CHARSET_CYRILLIC       0x80
-#define FOCA_CHARSET_HEBREW         0x100
-#define FOCA_CHARSET_GREEK          0x200
-#define FOCA_CHARSET_ARABIC         0x400
-#define FOCA_CHARSET_UGLEXT         0x800
-#define FOCA_CHARSET_KANA           0x1000
-#define FOCA_CHARSET_THAI           0x2000
-#define FOCA_SELECTION_JAPAN        0x1000
-#define FOCA_SELECTION_TAIWAN       0x2000
-#define FOCA_SELECTION_CHINA        0x4000
-#define FOCA_SELECTION_KOREA        0x8000
-
-/* Error definitions.
- */
-#define OS2FNT_ERR_BASE     0x0F00
-#define ERR_FILE_OPEN       OS2FNT_ERR_BASE + 1
-#define ERR_FILE_STAT       OS2FNT_ERR_BASE + 2
-#define ERR_FILE_READ       OS2FNT_ERR_BASE + 3
-#define ERR_FILE_FORMAT     OS2FNT_ERR_BASE + 4
-
-#define ERR_NO_FONT         OS2FNT_ERR_BASE + 10
-
-#define ERR_MEMORY          OS2FNT_ERR_BASE + 20
-
-
-// ----------------------------------------------------------------------------
-// TYPEDEFS
-
-/* All structures must be byte-aligned.
- */
-#pragma pack(1)
-
-
-/* A generic font record structure, mostly used for typecasting.
- */
-typedef struct _Generic_Font_Record {
-    ULONG   Identity;                    /* structure identity code  */
-    ULONG   ulSize;                      /* structure size in bytes  */
-} GENERICRECORD, *PGENERICRECORD;
-
-
-/* A reasonably generic structure used to store a glyph bitmap.  The first
- * four fields deliberately parallel those of the basic bitmap type
- * (FT_Bitmap) used by FreeType, in the hopes of making porting easier.  The
- * last two reflect horizontal glyph metrics (similar to those in the
- * FT_Glyph_Metrics type).
- *
- * Note that the horizontal advance (increment) is equivalent to
- *   a_space + b_space + c_space
- * for type 3 fonts.  (Type 1 & 2 fonts have no side-bearings, so in those
- * cases the advance will be the same as the bitmap width.)
- *
- * GPI fonts do not contain any information related to vertical text flow, so
- * the vertical side-bearing is derived from the font's external-leading value.
- */
-typedef struct _Glyph_Bitmap {
-    ULONG  rows;                    /* number of rows (== height in pels)   */
-    ULONG  width;                   /* number of pels per row (== width)    */
-    ULONG  pitch;                   /* number of bytes per row              */
-    PUCHAR buffer;                  /* pointer to bitmap data               */
-    ULONG  cbBuffer;                /* size of buffer in bytes              */
-    SHORT  horiBearingX;            /* horizontal (left) side-bearing       */
-    SHORT  horiAdvance;             /* horizontal advance (increment)       */
-    SHORT  vertBearingY;            /* vertical (top) side-bearing          */
-    SHORT  vertAdvance;             /* vertical advance (increment)         */
-} GLYPHBITMAP, *PGLYPHBITMAP;
-
-
-/* A font signature (header) block.
- */
-typedef struct _OS2_Font_Header {
-    ULONG   Identity;               /* 0xFFFFFFFE                    */
-    ULONG   ulSize;                 /* size of this structure        */
-    CHAR    achSignature[12];       /* string indicating font format */
-} OS2FONTSTART, *POS2FONTSTART;
-
-
-/* A font end signature block (identical to the generic record).  The
- * Identity field in this case should be 0xFFFFFFFF.
- */
-typedef GENERICRECORD OS2FONTEND, *POS2FONTEND;
-
-
-/* The font metrics structure ("IBM Font Object Content Architecture" metrics).
- *
- * The number of _reported_ glyphs in the raster font normally equals
- * usLastChar+1 (as this value is an index offset from usFirstChar).  Most
- * fonts actually have an additional glyph definition (and corresponding
- * bitmap) at the end, which isn't included in the count, for the so-called
- * .null character.  However (and the GPI documentation doesn't mention this),
- * some fonts have the .null character explicitly defined at index 0, in which
- * case there is no extra glyph at the end.
- */
-typedef struct _OS2_FOCA_Metrics {
-    ULONG   Identity;               /* 0x00000001                           */
-    ULONG   ulSize;                 /* size of this structure               */
-    CHAR    szFamilyname[32];       /* font family name (null-terminated)   */
-    CHAR    szFacename[32];         /* font face name (null-terminated)     */
-    SHORT   usRegistryId;           /* the registered font ID number        */
-    SHORT   usCodePage;             /* font encoding (850 indicates PMUGL)  */
-    SHORT   yEmHeight;              /* height of the em square              */
-    SHORT   yXHeight;               /* lowercase x height                   */
-    SHORT   yMaxAscender;           /* total cell height above baseline     */
-    SHORT   yMaxDescender;          /* total cell depth below baseline      */
-    SHORT   yLowerCaseAscent;       /* height (+) of a lowercase ascender   */
-    SHORT   yLowerCaseDescent;      /* height (+) of a lowercase descender  */
-    SHORT   yInternalLeading;       /* space above glyph used for accents   */
-    SHORT   yExternalLeading;       /* extra linespace padding              */
-    SHORT   xAveCharWidth;          /* average character width              */
-    SHORT   xMaxCharInc;            /* maximum character increment (width)  */
-    SHORT   xEmInc;                 /* width of the em square               */
-    SHORT   yMaxBaselineExt;        /* sum of max ascender and descender    */
-    SHORT   sCharSlope;             /* nominal character slope in degrees   */
-    SHORT   sInlineDir;             /* inline text direction in degrees     */
-    SHORT   sCharRot;               /* nominal character rotation angle     */
-    USHORT  usWeightClass;          /* font weight class (1000-9000)        */
-    USHORT  usWidthClass;           /* font width class (1000-9000)         */
-    SHORT   xDeviceRes;             /* target horiz. resolution (dpi)       */
-    SHORT   yDeviceRes;             /* target vert. resolution (dpi)        */
-    SHORT   usFirstChar;            /* codepoint of the first character     */
-    SHORT   usLastChar;             /* codepoint offset of the last char    */
-    SHORT   usDefaultChar;          /* codepoint offset of the default char */
-    SHORT   usBreakChar;            /* codepoint offset of the space char   */
-    SHORT   usNominalPointSize;     /* font's point size multiplied by 10   */
-    SHORT   usMinimumPointSize;     /* (same as above for bitmap fonts)     */
-    SHORT   usMaximumPointSize;     /* (same as above for bitmap fonts)     */
-    SHORT   fsTypeFlags;            /* font type flags                      */
-    SHORT   fsDefn;                 /* font definition flags                */
-    SHORT   fsSelectionFlags;       /* font selection flags                 */
-    SHORT   fsCapabilities;         /* font capability flags                */
-    SHORT   ySubscriptXSize;        /* width of subscript characters        */
-    SHORT   ySubscriptYSize;        /* height of subscript characters       */
-    SHORT   ySubscriptXOffset;      /* x-offset of subscript characters     */
-    SHORT   ySubscriptYOffset;      /* y-offset of subscript characters     */
-    SHORT   ySuperscriptXSize;      /* width of superscript characters      */
-    SHORT   ySuperscriptYSize;      /* height of superscript characters     */
-    SHORT   ySuperscriptXOffset;    /* x-offset of superscript characters   */
-    SHORT   ySuperscriptYOffset;    /* y-offset of superscript characters   */
-    SHORT   yUnderscoreSize;        /* underscore stroke thickness          */
-    SHORT   yUnderscorePosition;    /* underscore depth below baseline      */
-    SHORT   yStrikeoutSize;         /* strikeout stroke thickness           */
-    SHORT   yStrikeoutPosition;     /* strikeout height above baseline      */
-    SHORT   usKerningPairs;         /* number of kerning pairs defined      */
-    SHORT   sFamilyClass;           /* IBM font family class and subclass   */
-    ULONG   reserved;               /* device name address (not used)       */
-} OS2FOCAMETRICS, *POS2FOCAMETRICS;
-
-
-/* The font definition header.  Not all of these fields may be used, depending
- * on the font type (indicated by the flags in fsFontdef).
- * According to the GPI documentation, the ulSize field is supposed to contain
- * the size of this data structure. In fact, it actually contains the size of
- * the data structure _plus_ all the glyph data that follows.
- */
-typedef struct _OS2_Font_Definition {
-    ULONG Identity;             /* 0x00000002                               */
-    ULONG ulSize;               /* size of character data (see note above)  */
-    SHORT fsFontdef;            /* flags indicating which fields are used   */
-    SHORT fsChardef;            /* flags indicating format of char defs     */
-    SHORT usCellSize;           /* size (in bytes) of each char definition  */
-    SHORT xCellWidth;           /* char cell-width in pixels (type 1 only)  */
-    SHORT yCellHeight;          /* char cell-height in pixels               */
-    SHORT xCellIncrement;       /* char increment in pixels (type 1 only)   */
-    SHORT xCellA;               /* character a_space (type 3 only)          */
-    SHORT xCellB;               /* character b_space (type 3 only)          */
-    SHORT xCellC;               /* character c_space (type 3 only)          */
-    SHORT pCellBaseOffset;      /* distance between baseline & top of cell  */
-} OS2FONTDEFHEADER, *POS2FONTDEFHEADER;
-
-
-/* The font kerning-pairs table.  This and the following structure are a bit
- * of a mystery.  They are defined here as the specification in the OS/2 GPI
- * programming guide describes them.  However, the specification also says
- * that the ulSize field should be 10 bytes (not 9), and doesn't describe at
- * all what the cFirstpair field does.  The KERNINGPAIRS structure is even more
- * problematic, as the standard GPI toolkit headers define a KERNINGPAIRS
- * structure which is different from what the documentation describes.
- *
- * Unfortunately, I cannot find any examples of fonts which actually contain
- * kerning information, and the IBM Font Editor doesn't support kerning at
- * all... so there's no way to analyze how it really works.  (It's entirely
- * possible that kerning support was never actually implemented.)
- *
- * The good news is that the kerning information is right at the end of the
- * font file (except for the PANOSE structure and the font-end signature),
- * so even if our kern-table parsing is flawed it shouldn't be fatal.
- */
-typedef struct _OS2_Kerning_Table {
-    ULONG   Identity;               /* 0x00000003       */
-    ULONG   ulSize;                 /* must be 10 (??)  */
-    CHAR    cFirstpair;             /* undocumented     */
-} OS2KERNPAIRTABLE, *POS2KERNPAIRTABLE;
-
-typedef struct _OS2_Kerning_Pair {
-    SHORT   sFirstChar;             /* first character of pair  */
-    SHORT   sSecondChar;            /* second character of pair */
-    SHORT   sKerningAmount;         /* kerning amount           */
-} OS2KERNINGPAIRS, *POS2KERNINGPAIRS;
-
-
-/* The "additional metrics" structure contains the PANOSE table.
- */
-typedef struct _OS2_Extra_Metrics {
-    ULONG   Identity;               /* 0x00000004                       */
-    ULONG   ulSize;                 /* structure size (20 bytes)        */
-    UCHAR   panose[12];             /* PANOSE table padded to 12 bytes  */
-} OS2ADDMETRICS, *POS2ADDMETRICS;
-
-
-/* An individual character definition for a type 1 or 2 font.
- */
-typedef struct _OS2_Character_1 {
-    ULONG   ulOffset;           /* offset of glyph bitmap within the font */
-    USHORT  ulWidth;            /* width of the glyph bitmap (in pixels)  */
-} OS2CHARDEF1, *POS2CHARDEF1;
-
-/* An individual character definition for a type 3 font.
- */
-typedef struct _OS2_Character_3 {
-    ULONG   ulOffset;           /* offset of glyph bitmap within the font */
-    SHORT   aSpace;             /* character a_space (in pixels)          */
-    SHORT   bSpace;             /* character b_space (in pixels)          */
-    SHORT   cSpace;             /* character c_space (in pixels)          */
-} OS2CHARDEF3, *POS2CHARDEF3;
-
-
-/* A font directory (used in compiled fonts).
- */
-typedef struct _OS2_FontDir_Entry {
-    USHORT          usIndex;             /* The resource ID of the font   */
-    OS2FOCAMETRICS  metrics;             /* The font's metrics            */
-    UCHAR           panose[12];          /* The font's PANOSE data        */
-} OS2FONTDIRENTRY, *POS2FONTDIRENTRY;
-
-typedef struct _OS2_Font_Directory {
-    USHORT          usHeaderSize;        /* The size of this header       */
-    USHORT          usnFonts;            /* The number of fonts           */
-    USHORT          usiMetrics;          /* The size of all the metrics   */
-    OS2FONTDIRENTRY fntEntry[ 1 ];       /* Array of individual font info */
-} OS2FONTDIRECTORY, *POS2FONTDIRECTORY;
-
-
-/* Structure used to refer to the various parts of a font resource.  This is
- * used by most of the various functions to reference the font as a whole.
- */
-typedef struct _OS2_Font_Resource {
-    POS2FONTSTART       pSignature;    /* Pointer to the signature block    */
-    POS2FOCAMETRICS     pMetrics;      /* Pointer to the font metrics       */
-    POS2FONTDEFHEADER   pFontDef;      /* Pointer to the font definition    */
-    union {
-        POS2CHARDEF1    pChars;        /* Character data for type 1/2 fonts */
-        POS2CHARDEF3    pABC;          /* Character data for type 3 fonts   */
-    } data;
-    POS2KERNPAIRTABLE   pKerning;      /* Pointer to kerning table          */
-    POS2ADDMETRICS      pPanose;       /* Pointer to PANOSE table           */
-    POS2FONTEND         pEnd;          /* Pointer to end-signature block    */
-    ULONG               cbSize;        /* Total size of the font resource   */
-} OS2FONTRESOURCE, *POS2FONTRESOURCE;
-
-
-#pragma pack()
-
-
-// ----------------------------------------------------------------------------
-// FUNCTION PROTOTYPES
-
-BOOL  ExtractOS2FontGlyph( ULONG ulOffset, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph );
-ULONG OS2FontGlyphIndex( POS2FONTRESOURCE pFont, ULONG index );
-ULONG ParseOS2FontResource( PVOID pBuffer, ULONG cbBuffer, POS2FONTRESOURCE pFont );
-ULONG ReadOS2FNTFile( FILE *pf, PBYTE *ppBuffer, PULONG pulSize );
-ULONG ReadOS2FontResource( PSZ pszFile, ULONG ulFace, PULONG pulCount, POS2FONTRESOURCE pFont );
-
-#endif      // #ifndef __GPIFONT_H__
-
+/*****************************************************************************
+ *                                                                           *
+ *  gpifont.h                                                                *
+ *                                                                           *
+ *  Definitions for handling standard OS/2 GPI bitmap fonts.                 *
+ *                                                                           *
+ *  There are several OS/2-specific font formats, but the main one is the    *
+ *  'standard' GPI format.  This is the format which is supported here,      *
+ *  although some of the structures and routines may someday prove useful    *
+ *  in implementing support for other types.                                 *
+ *                                                                           *
+ *  Those others include the extremely obscure Uni-font format (of which I   *
+ *  have never found a single example), several related 'combined font'      *
+ *  formats which are basically wrappers or aliases to other fonts, and the  *
+ *  ultra-convoluted native DBCS fonts which are composed of standard GPI    *
+ *  fonts in association with separately-loaded CJK glyph libraries (which   *
+ *  themselves seem to support a few different formats but are mostly        *
+ *  something from MS called WIFE).  But none of these concern us here.      *
+ *                                                                           *
+ *  The GPI documentation implies that the GPI font format may also contain  *
+ *  outline data, but the format of such outlines is only alluded to.  In    *
+ *  any event, I'm not aware of any such fonts actually existing (all        *
+ *  outline fonts included with OS/2 are in TTF or Type 1 format).           *
+ *                                                                           *
+ *  (C) 2012 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+#ifndef __GPIFONT_H__
+#define __GPIFONT_H__
+
+
+// ----------------------------------------------------------------------------
+// CONSTANTS
+
+/* Text signatures for standard OS/2 bitmap fonts.
+ */
+#define OS2FNT_SIGNATURE    "OS/2 FONT"
+#define OS2FNT2_SIGNATURE   "OS/2 FONT 2"
+
+/* Binary signatures for various OS/2 font records.
+ */
+#define SIG_OS2FONTSTART    0xFFFFFFFE
+#define SIG_OS2METRICS      0x1
+#define SIG_OS2FONTDEF      0x2
+#define SIG_OS2KERN         0x3
+#define SIG_OS2ADDMETRICS   0x4
+#define SIG_OS2FONTEND      0xFFFFFFFF
+
+/* GPI categorizes fonts in 3 types according to character increment definition:
+ * Type 1 : Fixed-width font
+ * Type 2 : Proportional-width font with each character increment defined as
+ *          one value in the character definition.
+ * Type 3 : Proportional-width font with each character increment defined in
+ *          terms of: a_space + b_space + c_space
+ *             Where: a_space = leading space in front of the character
+ *                    b_space = width of the character glyph
+ *                    c_space = space following the character
+ *
+ * Each type is required to have specific values of flFontDef and flCharDef
+ * in the font definition header.  These values are defined below.
+ */
+#define OS2FONTDEF_FONT1    0x47
+#define OS2FONTDEF_FONT2    0x42
+#define OS2FONTDEF_FONT3    0x42
+#define OS2FONTDEF_CHAR1    0x81
+#define OS2FONTDEF_CHAR2    0x81
+#define OS2FONTDEF_CHAR3    0XB8
+
+/* Font charset-support flags.
+ */
+#define FOCA_CHARSET_LATIN1         0x10
+#define FOCA_CHARSET_PC             0x20
+#define FOCA_CHARSET_LATINX         0x40
+#define FOCA_CHARSET_CYRILLIC       0x80
+#define FOCA_CHARSET_HEBREW         0x100
+#define FOCA_CHARSET_GREEK          0x200
+#define FOCA_CHARSET_ARABIC         0x400
+#define FOCA_CHARSET_UGLEXT         0x800
+#define FOCA_CHARSET_KANA           0x1000
+#define FOCA_CHARSET_THAI           0x2000
+#define FOCA_SELECTION_JAPAN        0x1000
+#define FOCA_SELECTION_TAIWAN       0x2000
+#define FOCA_SELECTION_CHINA        0x4000
+#define FOCA_SELECTION_KOREA        0x8000
+
+/* Error definitions.
+ */
+#define OS2FNT_ERR_BASE     0x0F00
+#define ERR_FILE_OPEN       OS2FNT_ERR_BASE + 1
+#define ERR_FILE_STAT       OS2FNT_ERR_BASE + 2
+#define ERR_FILE_READ       OS2FNT_ERR_BASE + 3
+#define ERR_FILE_FORMAT     OS2FNT_ERR_BASE + 4
+#define ERR_FILE_WRITE      OS2FNT_ERR_BASE + 5
+
+#define ERR_NO_FONT         OS2FNT_ERR_BASE + 10
+
+#define ERR_MEMORY          OS2FNT_ERR_BASE + 20
+
+/* Ways in which the data referenced by an OS2FONTRESOURCE may be held (see
+ * the ulStorage field).  FreeOS2FontResource() uses this to decide how the
+ * font should be released.
+ */
+#define OS2FONT_STORE_HEAP      0   /* pSignature is an allocated buffer    */
+#define OS2FONT_STORE_MAPPED    1   /* data lies within an OS2FILEMAP       */
+#define OS2FONT_STORE_MODULE    2   /* data lies within an OS2FONTMODULE    */
+#define OS2FONT_STORE_OBJECT    3   /* data lies within a cached LX object  */
+
+/* Size of the UGL coverage bitmap in an OS2FONTRESOURCE, in bytes (one bit
+ * for each UGL glyph index; see pmugl.h).
+ */
+#define OS2FONT_COVERAGE_SIZE   130
+
+/* Text encodings accepted by OS2FontGlyphIndices().
+ */
+#define OS2TEXT_UTF8            0   /* UTF-8                                */
+#define OS2TEXT_UTF16           1   /* UTF-16 in native byte order          */
+
+/* Flag which may be combined with the text encoding passed to
+ * RenderOS2FontText() and MeasureOS2FontText(), to apply the font's kerning
+ * pairs (see OS2FontKerning) between consecutive glyphs.
+ */
+#define OS2TEXT_KERNING         0x100
+
+/* Value of an unused slot in a kerning index.
+ */
+#define OS2KERN_NO_PAIR         0xFFFFFFFF
+
+/* Alignment of the bitmap data in a glyph atlas (one cache line), and the
+ * offset which marks a glyph that does not exist in the font.
+ */
+#define OS2ATLAS_ALIGN          64
+#define OS2ATLAS_NO_GLYPH       0xFFFFFFFF
+
+/* Compression methods for LX object pages (see PackOS2ObjectPage), which
+ * may be combined with OS2PACK_BEST to search for the smallest encoding
+ * instead of taking the first good match.
+ */
+#define OS2PACK_EXEPACK1        1   /* run-length (OP32_ITERDATA)           */
+#define OS2PACK_EXEPACK2        2   /* LZ77 (OP32_ITERDATA2)                */
+#define OS2PACK_BEST            0x100
+
+
+// ----------------------------------------------------------------------------
+// TYPEDEFS
+
+/* All structures must be byte-aligned.
+ */
+#pragma pack(1)
+
+
+/* A generic font record structure, mostly used for typecasting.
+ */
+typedef struct _Generic_Font_Record {
+    ULONG   Identity;                    /* structure identity code  */
+    ULONG   ulSize;                      /* structure size in bytes  */
+} GENERICRECORD, *PGENERICRECORD;
+
+
+/* A reasonably generic structure used to store a glyph bitmap.  The first
+ * four fields deliberately parallel those of the basic bitmap type
+ * (FT_Bitmap) used by FreeType, in the hopes of making porting easier.  The
+ * last two reflect horizontal glyph metrics (similar to those in the
+ * FT_Glyph_Metrics type).
+ *
+ * Note that the horizontal advance (increment) is equivalent to
+ *   a_space + b_space + c_space
+ * for type 3 fonts.  (Type 1 & 2 fonts have no side-bearings, so in those
+ * cases the advance will be the same as the bitmap width.)
+ *
+ * GPI fonts do not contain any information related to vertical text flow, so
+ * the vertical side-bearing is derived from the font's external-leading value.
+ */
+typedef struct _Glyph_Bitmap {
+    ULONG  rows;                    /* number of rows (== height in pels)   */
+    ULONG  width;                   /* number of pels per row (== width)    */
+    ULONG  pitch;                   /* number of bytes per row              */
+    PUCHAR buffer;                  /* pointer to bitmap data               */
+    ULONG  cbBuffer;                /* size of buffer in bytes              */
+    SHORT  horiBearingX;            /* horizontal (left) side-bearing       */
+    SHORT  horiAdvance;             /* horizontal advance (increment)       */
+    SHORT  vertBearingY;            /* vertical (top) side-bearing          */
+    SHORT  vertAdvance;             /* vertical advance (increment)         */
+} GLYPHBITMAP, *PGLYPHBITMAP;
+
+
+/* A font signature (header) block.
+ */
+typedef struct _OS2_Font_Header {
+    ULONG   Identity;               /* 0xFFFFFFFE                    */
+    ULONG   ulSize;                 /* size of this structure        */
+    CHAR    achSignature[12];       /* string indicating font format */
+} OS2FONTSTART, *POS2FONTSTART;
+
+
+/* A font end signature block (identical to the generic record).  The
+ * Identity field in this case should be 0xFFFFFFFF.
+ */
+typedef GENERICRECORD OS2FONTEND, *POS2FONTEND;
+
+
+/* The font metrics structure ("IBM Font Object Content Architecture" metrics).
+ *
+ * The number of _reported_ glyphs in the raster font normally equals
+ * usLastChar+1 (as this value is an index offset from usFirstChar).  Most
+ * fonts actually have an additional glyph definition (and corresponding
+ * bitmap) at the end, which isn't included in the count, for the so-called
+ * .null character.  However (and the GPI documentation doesn't mention this),
+ * some fonts have the .null character explicitly defined at index 0, in which
+ * case there is no extra glyph at the end.
+ */
+typedef struct _OS2_FOCA_Metrics {
+    ULONG   Identity;               /* 0x00000001                           */
+    ULONG   ulSize;                 /* size of this structure               */
+    CHAR    szFamilyname[32];       /* font family name (null-terminated)   */
+    CHAR    szFacename[32];         /* font face name (null-terminated)     */
+    SHORT   usRegistryId;           /* the registered font ID number        */
+    SHORT   usCodePage;             /* font encoding (850 indicates PMUGL)  */
+    SHORT   yEmHeight;              /* height of the em square              */
+    SHORT   yXHeight;               /* lowercase x height                   */
+    SHORT   yMaxAscender;           /* total cell height above baseline     */
+    SHORT   yMaxDescender;          /* total cell depth below baseline      */
+    SHORT   yLowerCaseAscent;       /* height (+) of a lowercase ascender   */
+    SHORT   yLowerCaseDescent;      /* height (+) of a lowercase descender  */
+    SHORT   yInternalLeading;       /* space above glyph used for accents   */
+    SHORT   yExternalLeading;       /* extra linespace padding              */
+    SHORT   xAveCharWidth;          /* average character width              */
+    SHORT   xMaxCharInc;            /* maximum character increment (width)  */
+    SHORT   xEmInc;                 /* width of the em square               */
+    SHORT   yMaxBaselineExt;        /* sum of max ascender and descender    */
+    SHORT   sCharSlope;             /* nominal character slope in degrees   */
+    SHORT   sInlineDir;             /* inline text direction in degrees     */
+    SHORT   sCharRot;               /* nominal character rotation angle     */
+    USHORT  usWeightClass;          /* font weight class (1000-9000)        */
+    USHORT  usWidthClass;           /* font width class (1000-9000)         */
+    SHORT   xDeviceRes;             /* target horiz. resolution (dpi)       */
+    SHORT   yDeviceRes;             /* target vert. resolution (dpi)        */
+    SHORT   usFirstChar;            /* codepoint of the first character     */
+    SHORT   usLastChar;             /* codepoint offset of the last char    */
+    SHORT   usDefaultChar;          /* codepoint offset of the default char */
+    SHORT   usBreakChar;            /* codepoint offset of the space char   */
+    SHORT   usNominalPointSize;     /* font's point size multiplied by 10   */
+    SHORT   usMinimumPointSize;     /* (same as above for bitmap fonts)     */
+    SHORT   usMaximumPointSize;     /* (same as above for bitmap fonts)     */
+    SHORT   fsTypeFlags;            /* font type flags                      */
+    SHORT   fsDefn;                 /* font definition flags                */
+    SHORT   fsSelectionFlags;       /* font selection flags                 */
+    SHORT   fsCapabilities;         /* font capability flags                */
+    SHORT   ySubscriptXSize;        /* width of subscript characters        */
+    SHORT   ySubscriptYSize;        /* height of subscript characters       */
+    SHORT   ySubscriptXOffset;      /* x-offset of subscript characters     */
+    SHORT   ySubscriptYOffset;      /* y-offset of subscript characters     */
+    SHORT   ySuperscriptXSize;      /* width of superscript characters      */
+    SHORT   ySuperscriptYSize;      /* height of superscript characters     */
+    SHORT   ySuperscriptXOffset;    /* x-offset of superscript characters   */
+    SHORT   ySuperscriptYOffset;    /* y-offset of superscript characters   */
+    SHORT   yUnderscoreSize;        /* underscore stroke thickness          */
+    SHORT   yUnderscorePosition;    /* underscore depth below baseline      */
+    SHORT   yStrikeoutSize;         /* strikeout stroke thickness           */
+    SHORT   yStrikeoutPosition;     /* strikeout height above baseline      */
+    SHORT   usKerningPairs;         /* number of kerning pairs defined      */
+    SHORT   sFamilyClass;           /* IBM font family class and subclass   */
+    ULONG   reserved;               /* device name address (not used)       */
+} OS2FOCAMETRICS, *POS2FOCAMETRICS;
+
+
+/* The font definition header.  Not all of these fields may be used, depending
+ * on the font type (indicated by the flags in fsFontdef).
+ * According to the GPI documentation, the ulSize field is supposed to contain
+ * the size of this data structure. In fact, it actually contains the size of
+ * the data structure _plus_ all the glyph data that follows.
+ */
+typedef struct _OS2_Font_Definition {
+    ULONG Identity;             /* 0x00000002                               */
+    ULONG ulSize;               /* size of character data (see note above)  */
+    SHORT fsFontdef;            /* flags indicating which fields are used   */
+    SHORT fsChardef;            /* flags indicating format of char defs     */
+    SHORT usCellSize;           /* size (in bytes) of each char definition  */
+    SHORT xCellWidth;           /* char cell-width in pixels (type 1 only)  */
+    SHORT yCellHeight;          /* char cell-height in pixels               */
+    SHORT xCellIncrement;       /* char increment in pixels (type 1 only)   */
+    SHORT xCellA;               /* character a_space (type 3 only)          */
+    SHORT xCellB;               /* character b_space (type 3 only)          */
+    SHORT xCellC;               /* character c_space (type 3 only)          */
+    SHORT pCellBaseOffset;      /* distance between baseline & top of cell  */
+} OS2FONTDEFHEADER, *POS2FONTDEFHEADER;
+
+
+/* The font kerning-pairs table.  This and the following structure are a bit
+ * of a mystery.  They are defined here as the specification in the OS/2 GPI
+ * programming guide describes them.  However, the specification also says
+ * that the ulSize field should be 10 bytes (not 9), and doesn't describe at
+ * all what the cFirstpair field does.  The KERNINGPAIRS structure is even more
+ * problematic, as the standard GPI toolkit headers define a KERNINGPAIRS
+ * structure which is different from what the documentation describes.
+ *
+ * Unfortunately, I cannot find any examples of fonts which actually contain
+ * kerning information, and the IBM Font Editor doesn't support kerning at
+ * all... so there's no way to analyze how it really works.  (It's entirely
+ * possible that kerning support was never actually implemented.)
+ *
+ * The good news is that the kerning information is right at the end of the
+ * font file (except for the PANOSE structure and the font-end signature),
+ * so even if our kern-table parsing is flawed it shouldn't be fatal.
+ */
+typedef struct _OS2_Kerning_Table {
+    ULONG   Identity;               /* 0x00000003       */
+    ULONG   ulSize;                 /* must be 10 (??)  */
+    CHAR    cFirstpair;             /* undocumented     */
+} OS2KERNPAIRTABLE, *POS2KERNPAIRTABLE;
+
+typedef struct _OS2_Kerning_Pair {
+    SHORT   sFirstChar;             /* first character of pair  */
+    SHORT   sSecondChar;            /* second character of pair */
+    SHORT   sKerningAmount;         /* kerning amount           */
+} OS2KERNINGPAIRS, *POS2KERNINGPAIRS;
+
+
+/* The "additional metrics" structure contains the PANOSE table.
+ */
+typedef struct _OS2_Extra_Metrics {
+    ULONG   Identity;               /* 0x00000004                       */
+    ULONG   ulSize;                 /* structure size (20 bytes)        */
+    UCHAR   panose[12];             /* PANOSE table padded to 12 bytes  */
+} OS2ADDMETRICS, *POS2ADDMETRICS;
+
+
+/* An individual character definition for a type 1 or 2 font.
+ */
+typedef struct _OS2_Character_1 {
+    ULONG   ulOffset;           /* offset of glyph bitmap within the font */
+    USHORT  ulWidth;            /* width of the glyph bitmap (in pixels)  */
+} OS2CHARDEF1, *POS2CHARDEF1;
+
+/* An individual character definition for a type 3 font.
+ */
+typedef struct _OS2_Character_3 {
+    ULONG   ulOffset;           /* offset of glyph bitmap within the font */
+    SHORT   aSpace;             /* character a_space (in pixels)          */
+    SHORT   bSpace;             /* character b_space (in pixels)          */
+    SHORT   cSpace;             /* character c_space (in pixels)          */
+} OS2CHARDEF3, *POS2CHARDEF3;
+
+
+/* A font directory (used in compiled fonts).
+ */
+typedef struct _OS2_FontDir_Entry {
+    USHORT          usIndex;             /* The resource ID of the font   */
+    OS2FOCAMETRICS  metrics;             /* The font's metrics            */
+    UCHAR           panose[12];          /* The font's PANOSE data        */
+} OS2FONTDIRENTRY, *POS2FONTDIRENTRY;
+
+typedef struct _OS2_Font_Directory {
+    USHORT          usHeaderSize;        /* The size of this header       */
+    USHORT          usnFonts;            /* The number of fonts           */
+    USHORT          usiMetrics;          /* The size of all the metrics   */
+    OS2FONTDIRENTRY fntEntry[ 1 ];       /* Array of individual font info */
+} OS2FONTDIRECTORY, *POS2FONTDIRECTORY;
+
+
+/* The identity of a file, by which cached data taken from it is found
+ * again.  The size and modification time are included so that a file which
+ * has been rewritten in place is not mistaken for its earlier contents.
+ */
+typedef struct _OS2_File_ID {
+    uint64_t    ullDevice;             /* Device the file is on             */
+    uint64_t    ullFile;               /* File (inode) number on the device */
+    uint64_t    ullSize;               /* Size of the file                  */
+    uint64_t    ullMTime;              /* Modification time of the file     */
+} OS2FILEID, *POS2FILEID;
+
+
+/* A font file which has been mapped (or, where memory mapping is not
+ * available, read in its entirety) into memory.  Fonts loaded with
+ * MapOS2FontResource() may point directly into this data, in which case they
+ * hold a reference to it; it is released once the last reference is gone.
+ */
+typedef struct _OS2_File_Map {
+    PBYTE       pData;                 /* Start of the file contents        */
+    ULONG       cbData;                /* Size of the file contents         */
+    ULONG       cRefs;                 /* Number of outstanding references  */
+    BOOL        fMapped;               /* TRUE if mmap()ed, FALSE if read   */
+    OS2FILEID   id;                    /* Identity of the file (see above)  */
+} OS2FILEMAP, *POS2FILEMAP;
+
+
+/* Statistics about the extraction of resources from LX modules, accumulated
+ * across all calls.  Only the pages which cover the requested resource are
+ * read from an object; the rest are counted as skipped.
+ */
+typedef struct _OS2_Extract_Stats {
+    ULONG       ulPagesUnpacked;       /* Object pages read (and unpacked)  */
+    ULONG       ulPagesSkipped;        /* Object pages which were not read  */
+} OS2EXTRACTSTATS, *POS2EXTRACTSTATS;
+
+
+/* Statistics about the object cache, which holds the unpacked pages of LX
+ * objects for reuse by every font module and file in the process (see
+ * SetOS2ObjectCacheBudget).  Only the pages spanned by the requested font
+ * are unpacked into a cached object.  The counters accumulate from the
+ * start of the process (or the time the statistics were last reset).
+ */
+typedef struct _OS2_Object_Cache_Stats {
+    ULONG       ulHits;                /* Lookups with all pages cached     */
+    ULONG       ulMisses;              /* Lookups which unpacked pages      */
+    ULONG       ulEvictions;           /* Objects evicted to stay in budget */
+    ULONG       cEntries;              /* Objects currently cached          */
+    ULONG       cbUsed;                /* Memory used by unpacked pages     */
+    ULONG       cbBudget;              /* Maximum memory for objects        */
+} OS2OBJECTCACHESTATS, *POS2OBJECTCACHESTATS;
+
+
+/* An opened font module (or plain font file).  The resource table and font
+ * directory are indexed once when the module is opened, so that every face
+ * can be retrieved without re-parsing the file.  Any LX objects which have to
+ * be unpacked are unpacked once, no matter how many faces they contain: into
+ * the object cache, where they are shared with other modules (see
+ * SetOS2ObjectCacheBudget), or into the module itself if the cache is
+ * disabled.
+ *
+ * The module is reference-counted: faces which point into its unpacked
+ * objects keep it alive until they are freed, even after the handle itself
+ * has been closed.
+ */
+typedef struct _OS2_Font_Module {
+    POS2FILEMAP pMap;                  /* The mapped module file            */
+    ULONG       ulBase;                /* File offset of the LX/NE header   */
+    USHORT      usMagic;               /* MAGIC_LX or MAGIC_NE; 0 if FNT     */
+    ULONG       cFaces;                /* Number of faces in the module     */
+    PULONG      paulFaceRes;           /* Resource-table index of each face */
+    ULONG       cObjects;              /* Number of objects in the module   */
+    PBYTE      *papObjects;            /* Unpacked object data (or NULL)    */
+    PBYTE      *papPagesDone;          /* Which object pages are unpacked   */
+    ULONG       cRefs;                 /* Open handle + faces using it      */
+} OS2FONTMODULE, *POS2FONTMODULE;
+
+
+/* The metrics of a single glyph in a glyph atlas (see below).
+ */
+typedef struct _OS2_Atlas_Glyph {
+    ULONG   ulOffset;                  /* Bitmap offset within the atlas    */
+    USHORT  usWidth;                   /* Bitmap width in pels              */
+    USHORT  usPitch;                   /* Number of bytes per row           */
+    SHORT   sBearingX;                 /* Horizontal (left) side-bearing    */
+    SHORT   sAdvance;                  /* Horizontal advance (increment)    */
+} OS2ATLASGLYPH, *POS2ATLASGLYPH;
+
+
+/* A glyph atlas holds every glyph of a font already converted to row-major
+ * bitmaps, so that glyphs can be looked up without any conversion.  It is
+ * built by BuildOS2GlyphAtlas() and belongs to the font it was built from.
+ * All glyphs in a font have the same height and vertical metrics, so only
+ * the horizontal metrics are kept for each glyph.
+ *
+ * Bitmaps are packed back-to-back in glyph order, starting on a cache line
+ * boundary.  A bitmap no larger than a cache line never crosses a boundary,
+ * and a larger one always starts on a boundary.  The atlas (structure, glyph
+ * metrics and bitmaps) is a single allocation of cbTotal bytes.
+ */
+typedef struct _OS2_Glyph_Atlas {
+    ULONG           ulFirstChar;       /* Glyph index of the first entry    */
+    ULONG           cGlyphs;           /* Number of entries in paGlyphs     */
+    ULONG           cRows;             /* Height of every bitmap in pels    */
+    SHORT           sBearingY;         /* Vertical (top) side-bearing       */
+    SHORT           sAdvanceY;         /* Vertical advance (increment)      */
+    POS2ATLASGLYPH  paGlyphs;          /* Metrics of each glyph             */
+    PBYTE           pData;             /* Bitmap data (cache-line aligned)  */
+    ULONG           cbData;            /* Size of the bitmap data           */
+    ULONG           cbTotal;           /* Total memory used by the atlas    */
+} OS2GLYPHATLAS, *POS2GLYPHATLAS;
+
+
+/* One slot of a kerning index (see below): a pair of glyph indices, with
+ * the first in the high word, and the kerning amount between them.
+ */
+typedef struct _OS2_Kerning_Slot {
+    ULONG           ulPair;            /* Glyph pair, or OS2KERN_NO_PAIR    */
+    LONG            lAmount;           /* Kerning amount in pels            */
+} OS2KERNSLOT, *POS2KERNSLOT;
+
+
+/* A kerning index holds a font's kerning pairs in an open-addressed hash
+ * table, so that the amount for any pair of glyphs can be looked up in
+ * constant time.  It is built by ParseOS2FontResource() for fonts with a
+ * kerning table, and belongs to the font it was built from.  The characters
+ * in each OS2KERNINGPAIRS record are taken to be glyph indices.  The index
+ * (structure and slots) is a single allocation.
+ */
+typedef struct _OS2_Kerning_Index {
+    POS2KERNINGPAIRS paPairs;          /* The pairs within the font data    */
+    ULONG            cPairs;           /* Number of pairs in paPairs        */
+    ULONG            ulMask;           /* Number of slots, minus one        */
+    POS2KERNSLOT     paSlots;          /* The hash table                    */
+} OS2KERNINDEX, *POS2KERNINDEX;
+
+
+/* A cache of extracted glyphs, shared between any number of fonts (see
+ * CreateOS2GlyphCache).  Its contents are private to gpifont.c.
+ */
+typedef struct _OS2_Glyph_Cache OS2GLYPHCACHE, *POS2GLYPHCACHE;
+
+
+/* Statistics about a glyph cache.  The counters accumulate from the time the
+ * cache is created (or the statistics were last reset).
+ */
+typedef struct _OS2_Glyph_Cache_Stats {
+    ULONG       ulHits;                /* Lookups found in the cache        */
+    ULONG       ulMisses;              /* Lookups which extracted the glyph */
+    ULONG       ulEvictions;           /* Glyphs evicted to stay in budget  */
+    ULONG       cEntries;              /* Glyphs currently cached           */
+    ULONG       cPinned;               /* ...of which are pinned            */
+    ULONG       cbUsed;                /* Memory currently used by glyphs   */
+    ULONG       cbBudget;              /* Maximum memory for glyphs         */
+} OS2GLYPHCACHESTATS, *POS2GLYPHCACHESTATS;
+
+
+/* A font catalog records the faces found in a set of font files, so that a
+ * face can be chosen without opening any of them (see OpenOS2FontCatalog).
+ * Its contents are private to gpifont.c.
+ */
+typedef struct _OS2_Font_Catalog OS2FONTCATALOG, *POS2FONTCATALOG;
+
+
+/* The catalog record of a single face, which is also how the face is stored
+ * in the catalog's index file.  The coverage bitmap has one bit for each
+ * glyph index which the face supports: for a UGL font this is a UGL glyph
+ * index, and otherwise it is the codepoint itself (as in OS2FontGlyphIndex).
+ */
+typedef struct _OS2_Catalog_Face {
+    USHORT  usFace;                    /* Face number within the file       */
+    USHORT  usResourceID;              /* Resource ID (0 in a FNT file)     */
+    CHAR    szFamilyname[ 32 ];        /* Font family name                  */
+    CHAR    szFacename[ 32 ];          /* Font face name                    */
+    USHORT  usCodePage;                /* Font encoding (850 for PMUGL)     */
+    USHORT  usPointSize;               /* Nominal point size * 10           */
+    USHORT  xDeviceRes;                /* Target horizontal resolution      */
+    USHORT  yDeviceRes;                /* Target vertical resolution        */
+    USHORT  usWeightClass;             /* Weight class (1000-9000)          */
+    USHORT  usWidthClass;              /* Width class (1000-9000)           */
+    USHORT  fsSelection;               /* Font selection flags              */
+    USHORT  usFirstChar;               /* Glyph index of the first glyph    */
+    USHORT  usLastChar;                /* Glyph index of the last glyph     */
+    USHORT  yCellHeight;               /* Character cell height in pels     */
+    USHORT  xAveCharWidth;             /* Average character width in pels   */
+    BYTE    fUGL;                      /* Font uses UGL encoding            */
+    BYTE    abCoverage[ OS2FONT_COVERAGE_SIZE ];
+                                       /* Glyph indices supported by face   */
+} OS2CATALOGFACE, *POS2CATALOGFACE;
+
+
+/* A face found by QueryOS2FontCatalog(), and the file which contains it.
+ * Both point into the catalog, and remain valid until it is next changed.
+ */
+typedef struct _OS2_Catalog_Match {
+    PSZ             pszFile;           /* Name of the font file             */
+    POS2CATALOGFACE pFace;             /* The face's catalog record         */
+} OS2CATALOGMATCH, *POS2CATALOGMATCH;
+
+
+/* Statistics about a font catalog.  The last three counters accumulate from
+ * the time the catalog is opened.
+ */
+typedef struct _OS2_Catalog_Stats {
+    ULONG       cFiles;                /* Files in the catalog              */
+    ULONG       cFaces;                /* Faces in the catalog              */
+    ULONG       cParsed;               /* Files which had to be parsed      */
+    ULONG       cUnchanged;            /* Files found to be unchanged       */
+    ULONG       cRemoved;              /* Files dropped by pruning          */
+} OS2CATALOGSTATS, *POS2CATALOGSTATS;
+
+
+/* A bitmap surface onto which text can be drawn (see RenderOS2FontText).
+ * Rows are stored top row first.  At 1 bit per pel the most significant bit
+ * of each byte is the leftmost pel, and drawing sets the bits of the glyphs'
+ * pels; at 8 bits per pel, bColor is written to each of the glyphs' pels.
+ * Either way, the rest of the surface is left as it was.
+ */
+typedef struct _OS2_Text_Surface {
+    PBYTE       pBits;                 /* The surface bitmap                */
+    ULONG       cx;                    /* Width in pels                     */
+    ULONG       cy;                    /* Height in pels (rows)             */
+    ULONG       ulPitch;               /* Number of bytes per row           */
+    ULONG       ulDepth;               /* Bits per pel (1 or 8)             */
+    BYTE        bColor;                /* Pel value used at 8 bits per pel  */
+} OS2TEXTSURFACE, *POS2TEXTSURFACE;
+
+
+/* Structure used to refer to the various parts of a font resource.  This is
+ * used by most of the various functions to reference the font as a whole.
+ */
+typedef struct _OS2_Font_Resource {
+    POS2FONTSTART       pSignature;    /* Pointer to the signature block    */
+    POS2FOCAMETRICS     pMetrics;      /* Pointer to the font metrics       */
+    POS2FONTDEFHEADER   pFontDef;      /* Pointer to the font definition    */
+    union {
+        POS2CHARDEF1    pChars;        /* Character data for type 1/2 fonts */
+        POS2CHARDEF3    pABC;          /* Character data for type 3 fonts   */
+    } data;
+    POS2KERNPAIRTABLE   pKerning;      /* Pointer to kerning table          */
+    POS2ADDMETRICS      pPanose;       /* Pointer to PANOSE table           */
+    POS2FONTEND         pEnd;          /* Pointer to end-signature block    */
+    ULONG               cbSize;        /* Total size of the font resource   */
+    ULONG               ulStorage;     /* How the data is held (see above)  */
+    PVOID               pStorage;      /* Owning storage object, if any     */
+    BOOL                fUGL;          /* Font uses UGL encoding            */
+    BYTE                abCoverage[ OS2FONT_COVERAGE_SIZE ];
+                                       /* UGL glyphs supported by the font  */
+    POS2GLYPHATLAS      pAtlas;        /* Pre-converted glyphs, or NULL     */
+    LONG                lFixedAdvance; /* Advance of every glyph, or 0      */
+    POS2KERNINDEX       pKernIndex;    /* Hashed kerning pairs, or NULL     */
+} OS2FONTRESOURCE, *POS2FONTRESOURCE;
+
+
+#pragma pack()
+
+
+// ----------------------------------------------------------------------------
+// FUNCTION PROTOTYPES
+
+ULONG BuildOS2FontModule( POS2FONTRESOURCE paFonts, ULONG cFonts, PSZ pszName, ULONG ulPack, PBYTE *ppModule, PULONG pcbModule );
+ULONG BuildOS2GlyphAtlas( POS2FONTRESOURCE pFont );
+void  CloseOS2FontCatalog( POS2FONTCATALOG pCatalog );
+void  CloseOS2FontModule( POS2FONTMODULE pModule );
+ULONG CreateOS2GlyphCache( ULONG cbBudget, POS2GLYPHCACHE *ppCache );
+void  DestroyOS2GlyphCache( POS2GLYPHCACHE pCache );
+BOOL  ExtractOS2FontGlyph( ULONG ulOffset, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph );
+BOOL  ExtractOS2FontGlyphInto( ULONG ulOffset, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph, PBYTE pBuffer, ULONG cbBuffer );
+ULONG ExtractOS2FontGlyphs( POS2FONTRESOURCE pFont, PULONG pulIndices, ULONG cGlyphs, PBYTE pSlab, ULONG cbSlab, PULONG paulOffsets, PGLYPHBITMAP paGlyphs );
+void  FreeOS2FontResource( POS2FONTRESOURCE pFont );
+BOOL  GetOS2AtlasGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph );
+BOOL  GetOS2CachedGlyph( POS2GLYPHCACHE pCache, ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph );
+ULONG GetOS2FontModuleFace( POS2FONTMODULE pModule, ULONG ulFace, POS2FONTRESOURCE pFont );
+ULONG MapOS2FontResource( PSZ pszFile, ULONG ulFace, PULONG pulCount, POS2FONTRESOURCE pFont );
+LONG  MeasureOS2FontGlyphs( POS2FONTRESOURCE pFont, PULONG pulGlyphs, ULONG cGlyphs );
+LONG  MeasureOS2FontText( POS2FONTRESOURCE pFont, PVOID pText, ULONG cbText, ULONG ulFormat );
+ULONG OS2FontGlyphIndex( POS2FONTRESOURCE pFont, ULONG index );
+ULONG OS2FontGlyphIndices( POS2FONTRESOURCE pFont, PVOID pText, ULONG cbText, ULONG ulFormat, PULONG pulGlyphs, ULONG cMax, PULONG pcbUsed );
+BOOL  OS2FontGlyphMetrics( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph );
+ULONG OS2FontGlyphSize( ULONG ulIndex, POS2FONTRESOURCE pFont );
+LONG  OS2FontKerning( POS2FONTRESOURCE pFont, ULONG ulFirst, ULONG ulSecond );
+ULONG OS2MapFile( PSZ pszFile, POS2FILEMAP *ppMap );
+void  OS2ReleaseFileMap( POS2FILEMAP pMap );
+ULONG OpenOS2FontCatalog( PSZ pszIndexFile, POS2FONTCATALOG *ppCatalog );
+ULONG OpenOS2FontModule( PSZ pszFile, POS2FONTMODULE *ppModule );
+ULONG PackOS2ObjectPage( PBYTE pPage, ULONG cbPage, ULONG ulMethod, PBYTE pOut );
+ULONG ParseOS2FontResource( PVOID pBuffer, ULONG cbBuffer, POS2FONTRESOURCE pFont );
+ULONG PinOS2CachedGlyphs( POS2GLYPHCACHE pCache, ULONG ulFirst, ULONG ulLast, POS2FONTRESOURCE pFont );
+ULONG PruneOS2FontCatalog( POS2FONTCATALOG pCatalog );
+void  PurgeOS2GlyphCache( POS2GLYPHCACHE pCache, POS2FONTRESOURCE pFont );
+void  QueryOS2ExtractStats( POS2EXTRACTSTATS pStats, BOOL fReset );
+ULONG QueryOS2FontCatalog( POS2FONTCATALOG pCatalog, ULONG ulChar, ULONG ulPointSize, POS2CATALOGMATCH paMatches, ULONG cMax );
+void  QueryOS2FontCatalogStats( POS2FONTCATALOG pCatalog, POS2CATALOGSTATS pStats );
+ULONG QueryOS2FontModuleFaces( POS2FONTMODULE pModule );
+ULONG QueryOS2GlyphAtlasSize( POS2FONTRESOURCE pFont );
+void  QueryOS2GlyphCacheStats( POS2GLYPHCACHE pCache, POS2GLYPHCACHESTATS pStats, BOOL fReset );
+void  QueryOS2ObjectCacheStats( POS2OBJECTCACHESTATS pStats, BOOL fReset );
+ULONG QueryOS2UnpackThreads( void );
+ULONG ReadOS2FNTFile( FILE *pf, PBYTE *ppBuffer, PULONG pulSize );
+ULONG ReadOS2FontResource( PSZ pszFile, ULONG ulFace, PULONG pulCount, POS2FONTRESOURCE pFont );
+void  ReleaseOS2CachedGlyph( PGLYPHBITMAP pGlyph );
+LONG  RenderOS2FontText( POS2FONTRESOURCE pFont, PVOID pText, ULONG cbText, ULONG ulFormat, POS2TEXTSURFACE pSurface, LONG x, LONG y );
+ULONG SaveOS2FontCatalog( POS2FONTCATALOG pCatalog );
+void  SetOS2ObjectCacheBudget( ULONG cbBudget );
+ULONG SetOS2UnpackThreads( ULONG cThreads );
+ULONG UpdateOS2FontCatalog( POS2FONTCATALOG pCatalog, PSZ pszFile );
+ULONG WriteOS2FontModule( PSZ pszFile, POS2FONTRESOURCE paFonts, ULONG cFonts, ULONG ulPack, PULONG pcbModule );
+
+#endif      // #ifndef __GPIFONT_H__
+
@@ -1,123 +1,173 @@
-/*****************************************************************************
- *                                                                           *
- *  os2res.h                                                                 *
- *                                                                           *
- *  Definitions used in extracting binary resources from OS/2 modules.       *
- *  There are two types of OS/2 module: 16-bit (or "NE") format, and 32-bit  *
- *  (or "LX") format.  Information for both types is included here.  Note    *
- *  that the structures defined here only provide the fields which are       *
- *  necessary for extracting resources.                                      *
- *                                                                           *
- *  (C) 2012 Alexander Taylor                                                *
- *                                                                           *
- *  This code is placed in the public domain.                                *
- *                                                                           *
- *****************************************************************************/
-
-#ifndef __OS2RES_H__
-#define __OS2RES_H__
-
-
-// ----------------------------------------------------------------------------
-// CONSTANTS
-
-/* Magic numbers indicating executable headers.
- */
-#define MAGIC_MZ        0x5A4D    /* "MZ": DOS/old-style executable header */
-#define MAGIC_NE        0x454E    /* "NE": 16-bit OS/2 executable header   */
-#define MAGIC_LX        0x584C    /* "LX": 32-bit OS/2 executable header   */
-
-#define EH_OFFSET_ADDRESS   0x3C  /* Location of the 'real' exe header offset */
-
-/* OS/2 resource types that we're interested in.
- */
-#define OS2RES_FONTDIR      6
-#define OS2RES_FONTFACE     7
-
-/* Values of interest for flags field of LXOPMENTRY (LX object page map entry).
- */
-#define OP32_VALID           0x0000             /* Normal unpacked data    */
-#define OP32_ITERDATA        0x0001             /* Data in EXEPACK1 format */
-#define OP32_ITERDATA2       0x0005             /* Data in EXEPACK2 format */
-
-
-// ----------------------------------------------------------------------------
-// TYPEDEFS
-
-/* Structures used for parsing 16-bit OS/2 executables.  These must be
- * single-byte aligned.
- */
-
-#pragma pack(1)
-
-
-typedef struct _NE_rt_entry {           /* Resource table entry */
-    USHORT etype;
-    USHORT ename;
-} NERTENTRY, *PNERTENTRY;
-
-typedef struct _NE_header {             /* 16-bit EXE header    */
-    USHORT  magic;                  /* 0x454E ("NE")                  */
-    CHAR    unused1[26];            /* various unnecessary fields     */
-    USHORT  cseg;                   /* number of file segments        */
-    CHAR    unused2[4];             /* various unnecessary fields     */
-    USHORT  seg_tbl;                /* offset to segment table        */
-    USHORT  res_tbl;                /* offset to resource table       */
-    USHORT  rnam_tbl;               /* offset to resident-names table */
-    CHAR    unused3[10];            /* various unnecessary fields     */
-    USHORT  segshift;               /* segment alignment shift        */
-    USHORT  cres;                   /* number of resource entries     */
-    /*  10 bytes of various unnecessary fields follow */
-} NEHEADER, *PNEHEADER;
-
-
-/* Structures used for parsing 32-bit OS/2 executables.
- */
-
-typedef struct _LX_rt_entry {           /* Resource table entry  */
-    USHORT type;
-    USHORT name;
-    ULONG  cb;
-    USHORT obj;
-    ULONG  offset;
-} LXRTENTRY;
-
-typedef struct _LX_ot_entry {           /* Object table entry    */
-    ULONG size;
-    ULONG base;
-    ULONG flags;
-    ULONG pagemap;
-    ULONG mapsize;
-    ULONG reserved;
-} LXOTENTRY;
-
-typedef struct LX_opm_entry {           /* Object page-map entry */
-    ULONG  dataoffset;
-    USHORT size;
-    USHORT flags;
-} LXOPMENTRY, *PLXOPMENTRY;
-
-typedef struct _LX_header {             /* 32-bit EXE header     */
-    USHORT  magic;                  /* 0x4C58 ("LX")                  */
-    UCHAR   unused1[42];            /* various unnecessary fields     */
-    ULONG   pageshift;              /* page alignment shift           */
-    UCHAR   unused2[8];             /* various unnecessary fields     */
-    ULONG   ldrsize;                /* loader section size            */
-    ULONG   ldrsum;                 /* loader section checksum        */
-    ULONG   obj_tbl;                /* offset to object table         */
-    UCHAR   unused3[4];             /* various unnecessary fields     */
-    ULONG   objmap;                 /* offset to object page map      */
-    UCHAR   unused4[4];             /* various unnecessary fields     */
-    ULONG   res_tbl;                /* offset to resource table       */
-    ULONG   cres;                   /* number of resource entries     */
-    ULONG   rnam_tbl;               /* offset to resident-names table */
-    UCHAR   unused5[36];            /* various unnecessary fields     */
-    ULONG   datapage;               /* offset to data pages           */
-    /* 64 bytes of various unnecessary fields follow                          */
-} LXHEADER;
-
-
-#pragma pack()
-
-#endif      /* #ifndef __OS2RES_H__ */
-
+/*****************************************************************************
+ *                                                                           *
+ *  os2res.h                                                                 *
+ *                                                                           *
+ *  Definitions used in extracting binary resources from OS/2 modules.       *
+ *  There are two types of OS/2 module: 16-bit (or "NE") format, and 32-bit  *
+ *  (or "LX") format.  Information for both types is included here.  Note    *
+ *  that the structures defined here only provide the fields which are       *
+ *  necessary for extracting resources (or, for LX, writing a font module).  *
+ *                                                                           *
+ *  (C) 2012 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+#ifndef __OS2RES_H__
+#define __OS2RES_H__
+
+
+// ----------------------------------------------------------------------------
+// CONSTANTS
+
+/* Magic numbers indicating executable headers.
+ */
+#define MAGIC_MZ        0x5A4D    /* "MZ": DOS/old-style executable header */
+#define MAGIC_NE        0x454E    /* "NE": 16-bit OS/2 executable header   */
+#define MAGIC_LX        0x584C    /* "LX": 32-bit OS/2 executable header   */
+
+#define EH_OFFSET_ADDRESS   0x3C  /* Location of the 'real' exe header offset */
+
+/* OS/2 resource types that we're interested in.
+ */
+#define OS2RES_FONTDIR      6
+#define OS2RES_FONTFACE     7
+
+/* Values of interest for flags field of LXOPMENTRY (LX object page map entry).
+ */
+#define OP32_VALID           0x0000             /* Normal unpacked data    */
+#define OP32_ITERDATA        0x0001             /* Data in EXEPACK1 format */
+#define OP32_ITERDATA2       0x0005             /* Data in EXEPACK2 format */
+
+/* Values of interest for flags field of LXOTENTRY (LX object table entry).
+ */
+#define OBJ32_READ           0x0001             /* Readable                */
+#define OBJ32_RESOURCE       0x0008             /* Holds resources         */
+#define OBJ32_DISCARD        0x0010             /* Discardable             */
+#define OBJ32_SHARED         0x0020             /* Shareable               */
+#define OBJ32_BIGDEF         0x2000             /* 32-bit object           */
+
+/* Values of interest for fields of LXHEADER (LX executable header), and the
+ * full size of the header (LXHEADER itself leaves out the last 64 bytes).
+ */
+#define LX_HEADER_SIZE       0x00C4             /* Size of a whole header  */
+#define LX_CPU_386           0x0002             /* Intel 80386 or later    */
+#define LX_OS_OS2            0x0001             /* OS/2                    */
+#define LX_MOD_NOINTFIX      0x00000010         /* No internal fixups      */
+#define LX_MOD_NOEXTFIX      0x00000020         /* No external fixups      */
+#define LX_MOD_DLL           0x00008000         /* Library module (DLL)    */
+
+/* Values of interest for flags field of NESTENTRY (NE segment table entry).
+ */
+#define NESEG_ITERATED       0x0008             /* Data in iterated format */
+
+
+// ----------------------------------------------------------------------------
+// TYPEDEFS
+
+/* Structures used for parsing 16-bit OS/2 executables.  These must be
+ * single-byte aligned.
+ */
+
+#pragma pack(1)
+
+
+typedef struct _NE_rt_entry {           /* Resource table entry */
+    USHORT etype;
+    USHORT ename;
+} NERTENTRY, *PNERTENTRY;
+
+typedef struct _NE_st_entry {           /* Segment table entry  */
+    USHORT offset;                  /* file offset (in segshift units) */
+    USHORT cb;                      /* size in bytes (0 means 64 KB)   */
+    USHORT flags;                   /* segment flags                   */
+    USHORT minalloc;                /* minimum allocation size         */
+} NESTENTRY, *PNESTENTRY;
+
+typedef struct _NE_header {             /* 16-bit EXE header    */
+    USHORT  magic;                  /* 0x454E ("NE")                  */
+    CHAR    unused1[26];            /* various unnecessary fields     */
+    USHORT  cseg;                   /* number of file segments        */
+    CHAR    unused2[4];             /* various unnecessary fields     */
+    USHORT  seg_tbl;                /* offset to segment table        */
+    USHORT  res_tbl;                /* offset to resource table       */
+    USHORT  rnam_tbl;               /* offset to resident-names table */
+    CHAR    unused3[10];            /* various unnecessary fields     */
+    USHORT  segshift;               /* segment alignment shift        */
+    USHORT  cres;                   /* number of resource entries     */
+    /*  10 bytes of various unnecessary fields follow */
+} NEHEADER, *PNEHEADER;
+
+
+/* Structures used for parsing 32-bit OS/2 executables.
+ */
+
+typedef struct _LX_rt_entry {           /* Resource table entry  */
+    USHORT type;
+    USHORT name;
+    ULONG  cb;
+    USHORT obj;
+    ULONG  offset;
+} LXRTENTRY;
+
+typedef struct _LX_ot_entry {           /* Object table entry    */
+    ULONG size;
+    ULONG base;
+    ULONG flags;
+    ULONG pagemap;
+    ULONG mapsize;
+    ULONG reserved;
+} LXOTENTRY;
+
+typedef struct LX_opm_entry {           /* Object page-map entry */
+    ULONG  dataoffset;
+    USHORT size;
+    USHORT flags;
+} LXOPMENTRY, *PLXOPMENTRY;
+
+typedef struct _LX_header {             /* 32-bit EXE header     */
+    USHORT  magic;                  /* 0x4C58 ("LX")                  */
+    UCHAR   border;                 /* byte order (0 = little-endian) */
+    UCHAR   worder;                 /* word order (0 = little-endian) */
+    ULONG   level;                  /* format level                   */
+    USHORT  cpu;                    /* CPU type                       */
+    USHORT  os;                     /* operating system type          */
+    ULONG   ver;                    /* module version                 */
+    ULONG   mflags;                 /* module flags                   */
+    ULONG   mpages;                 /* number of pages in module      */
+    ULONG   startobj;               /* object holding the entry point */
+    ULONG   eip;                    /* entry point offset             */
+    ULONG   stackobj;               /* object holding the stack       */
+    ULONG   esp;                    /* initial stack pointer          */
+    ULONG   pagesize;               /* page size (always 4096)        */
+    ULONG   pageshift;              /* page alignment shift           */
+    ULONG   fixupsize;              /* fixup section size             */
+    ULONG   fixupsum;               /* fixup section checksum         */
+    ULONG   ldrsize;                /* loader section size            */
+    ULONG   ldrsum;                 /* loader section checksum        */
+    ULONG   obj_tbl;                /* offset to object table         */
+    ULONG   objcnt;                 /* number of objects in module    */
+    ULONG   objmap;                 /* offset to object page map      */
+    ULONG   itermap;                /* offset to iterated data map    */
+    ULONG   res_tbl;                /* offset to resource table       */
+    ULONG   cres;                   /* number of resource entries     */
+    ULONG   rnam_tbl;               /* offset to resident-names table */
+    ULONG   ent_tbl;                /* offset to entry table          */
+    ULONG   dir_tbl;                /* offset to module directives    */
+    ULONG   dircnt;                 /* number of module directives    */
+    ULONG   fpage_tbl;              /* offset to fixup page table     */
+    ULONG   frec_tbl;               /* offset to fixup record table   */
+    ULONG   impmod_tbl;             /* offset to import module names  */
+    ULONG   impmodcnt;              /* number of imported modules     */
+    ULONG   impproc_tbl;            /* offset to import proc. names   */
+    ULONG   pagesum_tbl;            /* offset to page checksums       */
+    ULONG   datapage;               /* offset to data pages           */
+    /* 64 bytes of various unnecessary fields follow                          */
+} LXHEADER;
+
+
+#pragma pack()
+
+#endif      /* #ifndef __OS2RES_H__ */
+
@@ -1,347 +1,810 @@
-/***************************************************************************/
-/*                                                                         */
-/*  pmugl.h                                                                */
-/*                                                                         */
-/*  This file defines the mapping from the IBM extended Universal Glyph    */
-/*  List, which is the native character encoding for OS/2 fonts, to        */
-/*  Unicode UCS codepoint.                                                 */
-/*                                                                         */
-/*  Derived from the FreeType/2 project sources by Michal Necasek (which   */
-/*  was in turn based upon information provided by IBM).                   */
-/*                                                                         */
-/*       Copyright (C) 2012       Alex Taylor (alex @ altsan . org)        */
-/*       Copyright (C) 1997--2000 Michal Necasek <mike@mendelu.cz>         */
-/*       Copyright (C) 1997, 1999 International Business Machines          */
-/*                                                                         */
-/*  This header file is licensed under the FreeType license; see FTL.TXT.  */
-/*                                                                         */
-/***************************************************************************/
-
-#ifndef __PMUGL_H__
-#define __PMUGL_H__
-
-
-#define CHAR_IS_LATIN1( c )     ((( c < 32 ) || \
-                                 (( c >= 127 ) && ( c <= 255 )))? 1 : 0 )
-#define CHAR_IS_PCEXTRA( c )    ((( c >= 256 ) && ( c <= 331 )) ? 1 : 0 )
-#define CHAR_IS_CYRILLIC( c )   ((( c >= 384 ) && ( c <= 478 )) ? 1 : 0 )
-#define CHAR_IS_LATINEXT( c )   (((( c >= 332 ) && ( c <= 383 )) || \
-                                  (( c >= 479 ) && ( c <= 504 )))? 1: 0 )
-#define CHAR_IS_HEBREW( c )     ((( c >= 535 ) && ( c <= 584 )) ? 1 : 0 )
-#define CHAR_IS_GREEK( c )      ((( c >= 585 ) && ( c <= 646 )) ? 1 : 0 )
-#define CHAR_IS_ARABIC( c )     ((( c >= 647 ) && ( c <= 747 )) ? 1 : 0 )
-#define CHAR_IS_UGLEXT( c )     (((( c >= 505 ) && ( c <= 511 )) || \
-                                  (( c >= 748 ) && ( c <= 767 )))? 1: 0 )
-#define CHAR_IS_KANA( c )       ((( c >= 768 ) && ( c <= 891 )) ? 1 : 0 )
-#define CHAR_IS_HANGUL( c )     ((( c >= 896 ) && ( c <= 949 )) ? 1 : 0 )
-#define CHAR_IS_THAI( c )       ((( c >= 950 ) && ( c <= 1036)) ? 1 : 0 )
-
-
-#define OS2UGL_MAX_GLYPH        1036
-
-static const USHORT UGL2Uni[] = {
-
-  /* Note: codepoints 0 to 255 correspond to IBM codepage 850/858 */
-
-  /* 0..9 */
-  0x0000, 0x263a, 0x263b, 0x2665, 0x2666, 0x2663, 0x2660, 0x2022, 0x25d8, 0x25cb,
-  /* 10..19 */
-  0x25d9, 0x2642, 0x2640, 0x266a, 0x266b, 0x263c, 0x25ba, 0x25c4, 0x2195, 0x203c,
-  /* 20..29 */
-  0x00b6, 0x00a7, 0x25ac, 0x21a8, 0x2191, 0x2193, 0x2192, 0x2190, 0x221f, 0x2194,
-  /* 30..39 */
-  0x25b2, 0x25bc, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
-  /* 40..49 */
-  0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31,
-  /* 50..59 */
-  0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b,
-  /* 60..69 */
-  0x3c, 0x3d, 0x3e, 0x3f, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45,
-  /* 70..79 */
-  0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
-  /* 80..89 */
-  0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
-  /* 90..99 */
-  0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62, 0x63,
-  /* 100..109 */
-  0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d,
-  /* 110..119 */
-  0x6e, 0x6f, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77,
-  /* 120..129 */
-  0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x2302, 0xc7, 0xfc,
-  /* 130..139 */
-  0xe9, 0xe2, 0xe4, 0xe0, 0xe5, 0xe7, 0xea, 0xeb, 0xe8, 0xef,
-  /* 140..149 */
-  0xee, 0xec, 0xc4, 0xc5, 0xc9, 0xe6, 0xc6, 0xf4, 0xf6, 0xf2,
-  /* 150..159 */
-  0xfb, 0xf9, 0xff, 0xd6, 0xdc, 0xf8, 0xa3, 0xd8, 0xd7, 0x192,
-  /* 160..169 */
-  0xe1, 0xed, 0xf3, 0xfa, 0xf1, 0xd1, 0xaa, 0xba, 0xbf, 0xae,
-  /* 170..179 */
-  0xac, 0xbd, 0xbc, 0xa1, 0xab, 0xbb, 0x2591, 0x2592, 0x2593, 0x2502,
-  /* 180..189 */
-  0x2524, 0xc1, 0xc2, 0xc0, 0xa9, 0x2563, 0x2551, 0x2557, 0x255d, 0xa2,
-  /* 190..199 */
-  0xa5, 0x2510, 0x2514, 0x2534, 0x252c, 0x251c, 0x2500, 0x253c, 0xe3, 0xc3,
-  /* 200..209 */
-  0x255a, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256c, 0xa4, 0xf0, 0xd0,
-  /* 210..219 */
-  0xca, 0xcb, 0xc8, 0x131, 0xcd, 0xce, 0xcf, 0x2518, 0x250c, 0x2588,
-  /* 220..229 */
-  0x2584, 0xa6, 0xcc, 0x2580, 0xd3, 0xdf, 0xd4, 0xd2, 0xf5, 0xd5,
-  /* 230..239 */
-  0xb5, 0xfe, 0xde, 0xda, 0xdb, 0xd9, 0xfd, 0xdd, 0xaf, 0xb4,
-  /* 240..249 */
-  0xad, 0xb1, 0x2017, 0xbe, 0xb6, 0xa7, 0xf7, 0xb8, 0xb0, 0xa8,
-  /* 250..255 */
-  0xb7, 0xb9, 0xb3, 0xb2, 0x25a0, 0xa0,
-
-  /* Extra characters for codepages 437 and 1004 */
-
-  /* 256..259 */
-  0x20a7, 0x2310, 0x2561, 0x2562,
-  /* 260..269 */
-  0x2556, 0x2555, 0x255c, 0x255b, 0x255e, 0x255f, 0x2567, 0x2568, 0x2564, 0x2565,
-  /* 270..279 */
-  0x2559, 0x2558, 0x2552, 0x2553, 0x256b, 0x256a, 0x258c, 0x2590, 0x3b1, 0x393,
-  /* 280..289 */
-  0x3c0, 0x3a3, 0x3c3, 0x3c4, 0x3a6, 0x398, 0x3a9, 0x3b4, 0x221e, 0x3c6,
-  /* 290..299 */
-  0x3b5, 0x2229, 0x2261, 0x2265, 0x2264, 0x2320, 0x2321, 0x2248, 0x2219, 0x221a,
-  /* 300..309 */
-  0x207f, 0x2c9, 0x2d8, 0x2d9, 0x2da, 0x2dd, 0x2db, 0x2c7, 0x2018, 0x2019,
-  /* 310..318 */
-  0x201c, 0x201d, 0x2013, 0x2014, 0x2c6, 0x2dc, 0x201a, 0x201e, 0x2026,
-  /* 319..329 */
-  0x2020, 0x2021, 0x2c6, 0x2030, 0x160, 0x2039, 0x152, 0x303, 0x2122, 0x161, 0x203a,
-  /* 330..331 */
-  0x153, 0x178,
-
-  /* OS/2 v2.x ended at this point. */
-
-  /* 330..339 */
-  0x11f, 0x11e, 0x130, 0x15f, 0x15e, 0x103, 0x102, 0x105,
-  /* 340..349 */
-  0x104, 0x107, 0x106, 0x10d, 0x10c, 0x10f, 0x10e, 0x111, 0x11b, 0x11a,
-  /* 350..359 */
-  0x119, 0x118, 0x13a, 0x139, 0x13e, 0x13d, 0x142, 0x141, 0x144, 0x143,
-  /* 360..369 */
-  0x148, 0x147, 0x151, 0x150, 0x155, 0x154, 0x159, 0x158, 0x15b, 0x15a,
-  /* 370..379 */
-  0x165, 0x164, 0x163, 0x162, 0x171, 0x170, 0x16f, 0x16e, 0x17a, 0x179,
-  /* 380..383 */
-  0x17e, 0x17d, 0x17c, 0x17b,
-
-  /* OS/2 Warp 3 ended at this point. */
-
-  /* 384..389 */
-  0x401, 0x402, 0x403, 0x404, 0x405, 0x406,
-  /* 390..399 */
-  0x407, 0x408, 0x409, 0x40a, 0x40b, 0x40c, 0x40e, 0x40f, 0x410, 0x411,
-  /* 400..409 */
-  0x412, 0x413, 0x414, 0x415, 0x416, 0x417, 0x418, 0x419, 0x41a, 0x41b,
-  /* 410..419 */
-  0x41c, 0x41d, 0x41e, 0x41f, 0x420, 0x421, 0x422, 0x423, 0x424, 0x425,
-  /* 420..429 */
-  0x426, 0x427, 0x428, 0x429, 0x42a, 0x42b, 0x42c, 0x42d, 0x42e, 0x42f,
-  /* 430..439 */
-  0x430, 0x431, 0x432, 0x433, 0x434, 0x435, 0x436, 0x437, 0x438, 0x439,
-  /* 440..449 */
-  0x43a, 0x43b, 0x43c, 0x43d, 0x43e, 0x43f, 0x440, 0x441, 0x442, 0x443,
-  /* 450..459 */
-  0x444, 0x445, 0x446, 0x447, 0x448, 0x449, 0x44a, 0x44b, 0x44c, 0x44d,
-  /* 460..469 */
-  0x44e, 0x44f, 0x2116, 0x451, 0x452, 0x453, 0x454, 0x455, 0x456, 0x457,
-  /* 470..479 */
-  0x458, 0x459, 0x45a, 0x45b, 0x45c, 0x45e, 0x45f, 0x490, 0x491, 0x156,
-  /* 480..489 */
-  0x12e, 0x100, 0x112, 0x116, 0x122, 0x136, 0x12a, 0x1eb, 0x145, 0x14c,
-  /* 490..499 */
-  0x172, 0x16a, 0x157, 0x12f, 0x101, 0x113, 0x117, 0x123, 0x137, 0x12b,
-  /* 500..504 */
-  0x13c, 0x146, 0x14d, 0x173, 0x16b,
-
-  /* OS/2 Warp 4 support ended here.
-   * Starting with Aurora, all previously-separate languages were unified
-   * into the extended glyphlist from this point.
-   */
-
-  /* 505..509 */
-  0xfffd, 0x2260, 0x25ca, 0x2318, 0x2113,
-  /* 510..519 */
-  0x2044, 0x2202, 0x0300, 0x0301, 0x0302, 0x0308, 0x0303, 0x0327, 0x030c, 0x030b,
-  /* 520..529 */
-  0x030a, 0x0306, 0x0328, 0x0307, 0x0000, 0x0000, 0x0000, 0x0000, 0x0344, 0x0304,
-  /* 530..539 */
-  0x0000, 0x200c, 0x200d, 0x200e, 0x200f, 0x20aa, 0x05d0, 0x05d1, 0x05d2, 0x05d3,
-  /* 540..549 */
-  0x05d4, 0x05d5, 0x05d6, 0x05d7, 0x05d8, 0x05d9, 0x05da, 0x05db, 0x05dc, 0x05dd,
-  /* 550..559 */
-  0x05de, 0x05df, 0x05e0, 0x05e1, 0x05e2, 0x05e3, 0x05e4, 0x05e5, 0x05e6, 0x05e7,
-  /* 560..569 */
-  0x05e8, 0x05e9, 0x05ea, 0x05b0, 0x05b1, 0x05b2, 0x05b3, 0x05b4, 0x05b5, 0x05b6,
-  /* 570..579 */
-  0x05b7, 0x05b8, 0x05b9, 0x05bb, 0x05bc, 0x05bd, 0x05be, 0x05bf, 0x05c0, 0x05c1,
-  /* 580..589 */
-  0x05c2, 0x05c3, 0x05f0, 0x05f1, 0x05f2, 0x2015, 0x0384, 0x0385, 0x0391, 0x0392,
-  /* 590..599 */
-  0x0394, 0x0395, 0x0396, 0x0397, 0x03d1, 0x0399, 0x039a, 0x039b, 0x039c, 0x039d,
-  /* 600..609 */
-  0x039e, 0x039f, 0x03a0, 0x03a1, 0x03a4, 0x03a5, 0x03a6, 0x03a7, 0x03b2, 0x03b3,
-  /* 610..619 */
-  0x03b6, 0x03b7, 0x03b8, 0x03b9, 0x03ba, 0x03bb, 0x03bc, 0x03bd, 0x03be, 0x03bf,
-  /* 620..629 */
-  0x03c1, 0x03c2, 0x03c4, 0x03c6, 0x03c7, 0x03c8, 0x03c9, 0x0386, 0x0388, 0x0389,
-  /* 630..639 */
-  0x038a, 0x038c, 0x038e, 0x038f, 0x03aa, 0x03ab, 0x03ac, 0x03ad, 0x03ae, 0x03af,
-  /* 640..649 */
-  0x03cc, 0x03cd, 0x03ce, 0x03ca, 0x03cb, 0x0390, 0x03b0, 0xfef7, 0xfef8, 0xfefb,
-  /* 650..659 */
-  0xfefc, 0xf8fc, 0xfe82, 0xfe84, 0xfe8e, 0x0628, 0x062a, 0x062b, 0x060c, 0x062c,
-  /* 660..669 */
-  0x062d, 0x062e, 0x0660, 0x0661, 0x0662, 0x0663, 0x0664, 0x0665, 0x0666, 0x0667,
-  /* 670..679 */
-  0x0668, 0x0669, 0x0641, 0x061b, 0xf8f6, 0xf8f5, 0xf8f4, 0x061f, 0x0621, 0x0622,
-  /* 680..689 */
-  0x0623, 0x0624, 0xfeca, 0x0626, 0x0627, 0xfe91, 0x0629, 0xfe97, 0xfe9b, 0xfe9f,
-  /* 690..699 */
-  0xfea3, 0xfea7, 0x062f, 0x0630, 0x0631, 0x0632, 0xfeb3, 0xfeb7, 0xfebb, 0xfec0,
-  /* 700..709 */
-  0x0637, 0x0638, 0xfecb, 0xfecf, 0x0639, 0x0640, 0xfed3, 0xfed7, 0xfed8, 0xfedf,
-  /* 710..719 */
-  0xfee3, 0xfee7, 0xfeeb, 0x0648, 0x0649, 0xfef3, 0xf8f7, 0xfecc, 0xfece, 0x063a,
-  /* 720..729 */
-  0x0645, 0xfe7d, 0x0651, 0x0646, 0x0647, 0xfeec, 0xfef0, 0xfef2, 0xfed0, 0x0642,
-  /* 730..739 */
-  0xfef5, 0xfef6, 0x0644, 0x0643, 0x064a, 0x0686, 0x06af, 0x067e, 0x0698, 0x0625,
-  /* 740..749 */
-  0x064b, 0x064c, 0x064d, 0x064e, 0x064f, 0x0650, 0x0652, 0x0698, 0x202a, 0x202b,
-  /* 750..759 */
-  0x202c, 0x202d, 0x202e, 0x25c5, 0x2007, 0xf8ff, 0xfb00, 0xfb01, 0xfb02, 0xfb03,
-  /* 760..769 */
-  0xfb04, 0x0133, 0x222b, 0x215b, 0x215c, 0x215d, 0x215e, 0xf8b3, 0x303f, 0x21b5,
-
-
-  /* The official UGL assigns codepoints 770-832 to the fullwidth katakana set,
-   * and when using Unicode TrueType fonts under OS/2 they will be mapped as
-   * such.  However, in all OS/2 bitmap fonts, as well as non-Unicode TrueType
-   * and Type 1 fonts, the actual characters returned by these codepoints are
-   * HALF-width katakana (U+FF61-FF9F) -- full-width kana (along with kanji and
-   * other CJK characters) are loaded from separate fonts according to the
-   * system's DBCS association settings (if any).
-   *
-   * Codepoints 833-891 are even more peculiar, as UGL assigns them to hiragana
-   * and a handful of additional CJK characters.  However, OS/2 never uses them
-   * -- the characters don't exist under any single-byte codepage, and when a
-   * UGL bitmap font is active under a DBCS/MBCS codepage OS/2 will always look
-   * for those characters in the separate associated DBCS fonts.  Presumably,
-   * IBM assigned these codepoints as part of some vague idea for future support
-   * which was later abandoned.  (No extant bitmap font from IBM actually uses
-   * them.)
-   *
-   * In light of the above, I have modified the Unicode-to-UGL mappings to treat
-   * 770-832 as halfwidth kana and to report 833-891 as unsupported.  If desired
-   * the following #ifdef can be toggled in order to cause hiragana and
-   * (fullwidth) katakana to be loaded from the font at these codepoints,
-   * although this is probably not useful.  (The conversion code in gpifont.c
-   * will always map halfwidth Unicode characters to this range regardless of
-   * what's in the table here.)
-   */
-
-#if 1
-
-  /* 770..779 */
-  0xff61, 0xff62, 0xff63, 0xff64, 0xff65, 0xff66, 0xff67, 0xff68, 0xff69, 0xff6a,
-  /* 780..789 */
-  0xff6b, 0xff6c, 0xff6d, 0xff6e, 0xff6f, 0xff70, 0xff71, 0xff72, 0xff73, 0xff74,
-  /* 790..799 */
-  0xff75, 0xff76, 0xff77, 0xff78, 0xff79, 0xff7a, 0xff7b, 0xff7c, 0xff7d, 0xff7e,
-  /* 800..809 */
-  0xff7f, 0xff80, 0xff81, 0xff82, 0xff83, 0xff84, 0xff85, 0xff86, 0xff87, 0xff88,
-  /* 810..819 */
-  0xff89, 0xff8a, 0xff8b, 0xff8c, 0xff8d, 0xff8e, 0xff8f, 0xff90, 0xff91, 0xff92,
-  /* 820..829 */
-  0xff93, 0xff94, 0xff95, 0xff96, 0xff97, 0xff98, 0xff99, 0xff9a, 0xff9b, 0xff9c,
-  /* 830..839 */
-  0xff9d, 0xff9e, 0xff9f, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
-  /* 840..849 */
-  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
-  /* 850..859 */
-  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
-  /* 860..869 */
-  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
-  /* 870..879 */
-  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
-  /* 880..889 */
-  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
-  /* 890..895 */
-  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
-
-#else
-
-  /* 770..779 */
-  0x3002, 0x300c, 0x300d, 0x3001, 0x30fb, 0x30f2, 0x30a1, 0x30a3, 0x30a5, 0x30a7,
-  /* 780..789 */
-  0x30a9, 0x30e3, 0x30e5, 0x30e7, 0x30c3, 0x30fc, 0x30a2, 0x30a4, 0x30a6, 0x30a8,
-  /* 790..799 */
-  0x30aa, 0x30ab, 0x30ad, 0x30af, 0x30b1, 0x30b3, 0x30b5, 0x30b7, 0x30b9, 0x30bb,
-  /* 800..809 */
-  0x30bd, 0x30bf, 0x30c1, 0x30c4, 0x30c6, 0x30c8, 0x30ca, 0x30cb, 0x30cc, 0x30cd,
-  /* 810..819 */
-  0x30ce, 0x30cf, 0x30d2, 0x30d5, 0x30d8, 0x30db, 0x30de, 0x30df, 0x30e0, 0x30e1,
-  /* 820..829 */
-  0x30e2, 0x30e4, 0x30e6, 0x30e8, 0x30e9, 0x30ea, 0x30eb, 0x30ec, 0x30ed, 0x30ef,
-  /* 830..839 */
-  0x30f3, 0x309b, 0x309c, 0x3041, 0x3043, 0x3045, 0x3047, 0x3049, 0x3083, 0x3085,
-  /* 840..849 */
-  0x3049, 0x3063, 0x3042, 0x3044, 0x3046, 0x3048, 0x304a, 0x304b, 0x304d, 0x304f,
-  /* 850..859 */
-  0x3051, 0x3053, 0x3055, 0x3057, 0x3059, 0x305b, 0x305d, 0x305f, 0x3061, 0x3064,
-  /* 860..869 */
-  0x3066, 0x3068, 0x306a, 0x306b, 0x306c, 0x306d, 0x306e, 0x306f, 0x3072, 0x3075,
-  /* 870..879 */
-  0x3078, 0x307b, 0x307e, 0x307f, 0x3080, 0x3081, 0x3082, 0x3084, 0x3086, 0x3088,
-  /* 880..889 */
-  0x3089, 0x308a, 0x308b, 0x308c, 0x308d, 0x308f, 0x3092, 0x3093, 0x300e, 0x300f,
-  /* 890..895 */
-  0x30f6, 0x3005, 0x0000, 0x0000, 0x0000, 0x0000,
-
-#endif  /* 1 */
-
-  /* 896..899 */
-  0x3131, 0x3132, 0x3133, 0x3134,
-  /* 900..909 */
-  0x3135, 0x3136, 0x3137, 0x3138, 0x3139, 0x313a, 0x313b, 0x313c, 0x313d, 0x313e,
-  /* 910..919 */
-  0x313f, 0x3140, 0x3141, 0x3142, 0x3143, 0x3144, 0x3145, 0x3146, 0x3147, 0x3148,
-  /* 920..929 */
-  0x3149, 0x314a, 0x314b, 0x314c, 0x314d, 0x314e, 0x314f, 0x3150, 0x3151, 0x3152,
-  /* 930..939 */
-  0x3153, 0x3154, 0x3155, 0x3156, 0x3157, 0x3158, 0x3159, 0x315a, 0x315b, 0x315c,
-  /* 940..949 */
-  0x315d, 0x315e, 0x315f, 0x3160, 0x3161, 0x3162, 0x3163, 0x20a9, 0x0000, 0x3164,
-  /* 950..959 */
-  0x0e3f, 0x0e01, 0x0e02, 0x0e03, 0x0e04, 0x0e05, 0x0e06, 0x0e07, 0x0e08, 0x0e09,
-  /* 960..969 */
-  0x0e0a, 0x0e0b, 0x0e0c, 0x0e0d, 0x0e0e, 0x0e0f, 0x0e10, 0x0e11, 0x0e12, 0x0e13,
-  /* 970..979 */
-  0x0e14, 0x0e15, 0x0e16, 0x0e17, 0x0e18, 0x0e19, 0x0e1a, 0x0e1b, 0x0e1c, 0x0e1d,
-  /* 980..989 */
-  0x0e1e, 0x0e1f, 0x0e20, 0x0e21, 0x0e22, 0x0e23, 0x0e24, 0x0e25, 0x0e26, 0x0e27,
-  /* 990..999 */
-  0x0e28, 0x0e29, 0x0e2a, 0x0e2b, 0x0e2c, 0x0e2d, 0x0e2e, 0x0e2f, 0x0e30, 0x0e31,
-  /* 1000..1009 */
-  0x0e32, 0x0e33, 0x0e34, 0x0e35, 0x0e36, 0x0e37, 0x0e38, 0x0e39, 0x0e3a, 0x0e40,
-  /* 1010..1019 */
-  0x0e41, 0x0e42, 0x0e43, 0x0e44, 0x0e45, 0x0e46, 0x0e47, 0x0e48, 0x0e49, 0x0e4a,
-  /* 1020..1029 */
-  0x0e4b, 0x0e4c, 0x0e4d, 0x0e4e, 0x0e4f, 0x0e5a, 0x0e5b, 0x0e50, 0x0e51, 0x0e52,
-  /* 1030..1036 */
-  0x0e53, 0x0e54, 0x0e55, 0x0e56, 0x0e57, 0x0e58, 0x0e59
-
-  /* Note: UGL codepoints above 1036 do not correspond to Unicode characters. */
-
-};
-
-
-#endif  /* #ifndef __PMUGL_H__ */
+/***************************************************************************/
+/*                                                                         */
+/*  pmugl.h                                                                */
+/*                                                                         */
+/*  This file defines the mapping from the IBM extended Universal Glyph    */
+/*  List, which is the native character encoding for OS/2 fonts, to        */
+/*  Unicode UCS codepoint.                                                 */
+/*                                                                         */
+/*  Derived from the FreeType/2 project sources by Michal Necasek (which   */
+/*  was in turn based upon information provided by IBM).                   */
+/*                                                                         */
+/*       Copyright (C) 2012       Alex Taylor (alex @ altsan . org)        */
+/*       Copyright (C) 1997--2000 Michal Necasek <mike@mendelu.cz>         */
+/*       Copyright (C) 1997, 1999 International Business Machines          */
+/*                                                                         */
+/*  This header file is licensed under the FreeType license; see FTL.TXT.  */
+/*                                                                         */
+/***************************************************************************/
+
+#ifndef __PMUGL_H__
+#define __PMUGL_H__
+
+
+#define CHAR_IS_LATIN1( c )     ((( c < 32 ) || \
+                                 (( c >= 127 ) && ( c <= 255 )))? 1 : 0 )
+#define CHAR_IS_PCEXTRA( c )    ((( c >= 256 ) && ( c <= 331 )) ? 1 : 0 )
+#define CHAR_IS_CYRILLIC( c )   ((( c >= 384 ) && ( c <= 478 )) ? 1 : 0 )
+#define CHAR_IS_LATINEXT( c )   (((( c >= 332 ) && ( c <= 383 )) || \
+                                  (( c >= 479 ) && ( c <= 504 )))? 1: 0 )
+#define CHAR_IS_HEBREW( c )     ((( c >= 535 ) && ( c <= 584 )) ? 1 : 0 )
+#define CHAR_IS_GREEK( c )      ((( c >= 585 ) && ( c <= 646 )) ? 1 : 0 )
+#define CHAR_IS_ARABIC( c )     ((( c >= 647 ) && ( c <= 747 )) ? 1 : 0 )
+#define CHAR_IS_UGLEXT( c )     (((( c >= 505 ) && ( c <= 511 )) || \
+                                  (( c >= 748 ) && ( c <= 767 )))? 1: 0 )
+#define CHAR_IS_KANA( c )       ((( c >= 768 ) && ( c <= 891 )) ? 1 : 0 )
+#define CHAR_IS_HANGUL( c )     ((( c >= 896 ) && ( c <= 949 )) ? 1 : 0 )
+#define CHAR_IS_THAI( c )       ((( c >= 950 ) && ( c <= 1036)) ? 1 : 0 )
+
+
+#define OS2UGL_MAX_GLYPH        1036
+
+/* See the note on UGL codepoints 770..895 below. */
+#ifndef UGL_HALFWIDTH_KANA
+#define UGL_HALFWIDTH_KANA      1
+#endif
+
+static const USHORT UGL2Uni[] = {
+
+  /* Note: codepoints 0 to 255 correspond to IBM codepage 850/858 */
+
+  /* 0..9 */
+  0x0000, 0x263a, 0x263b, 0x2665, 0x2666, 0x2663, 0x2660, 0x2022, 0x25d8, 0x25cb,
+  /* 10..19 */
+  0x25d9, 0x2642, 0x2640, 0x266a, 0x266b, 0x263c, 0x25ba, 0x25c4, 0x2195, 0x203c,
+  /* 20..29 */
+  0x00b6, 0x00a7, 0x25ac, 0x21a8, 0x2191, 0x2193, 0x2192, 0x2190, 0x221f, 0x2194,
+  /* 30..39 */
+  0x25b2, 0x25bc, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+  /* 40..49 */
+  0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31,
+  /* 50..59 */
+  0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b,
+  /* 60..69 */
+  0x3c, 0x3d, 0x3e, 0x3f, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45,
+  /* 70..79 */
+  0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+  /* 80..89 */
+  0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+  /* 90..99 */
+  0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62, 0x63,
+  /* 100..109 */
+  0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d,
+  /* 110..119 */
+  0x6e, 0x6f, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77,
+  /* 120..129 */
+  0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x2302, 0xc7, 0xfc,
+  /* 130..139 */
+  0xe9, 0xe2, 0xe4, 0xe0, 0xe5, 0xe7, 0xea, 0xeb, 0xe8, 0xef,
+  /* 140..149 */
+  0xee, 0xec, 0xc4, 0xc5, 0xc9, 0xe6, 0xc6, 0xf4, 0xf6, 0xf2,
+  /* 150..159 */
+  0xfb, 0xf9, 0xff, 0xd6, 0xdc, 0xf8, 0xa3, 0xd8, 0xd7, 0x192,
+  /* 160..169 */
+  0xe1, 0xed, 0xf3, 0xfa, 0xf1, 0xd1, 0xaa, 0xba, 0xbf, 0xae,
+  /* 170..179 */
+  0xac, 0xbd, 0xbc, 0xa1, 0xab, 0xbb, 0x2591, 0x2592, 0x2593, 0x2502,
+  /* 180..189 */
+  0x2524, 0xc1, 0xc2, 0xc0, 0xa9, 0x2563, 0x2551, 0x2557, 0x255d, 0xa2,
+  /* 190..199 */
+  0xa5, 0x2510, 0x2514, 0x2534, 0x252c, 0x251c, 0x2500, 0x253c, 0xe3, 0xc3,
+  /* 200..209 */
+  0x255a, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256c, 0xa4, 0xf0, 0xd0,
+  /* 210..219 */
+  0xca, 0xcb, 0xc8, 0x131, 0xcd, 0xce, 0xcf, 0x2518, 0x250c, 0x2588,
+  /* 220..229 */
+  0x2584, 0xa6, 0xcc, 0x2580, 0xd3, 0xdf, 0xd4, 0xd2, 0xf5, 0xd5,
+  /* 230..239 */
+  0xb5, 0xfe, 0xde, 0xda, 0xdb, 0xd9, 0xfd, 0xdd, 0xaf, 0xb4,
+  /* 240..249 */
+  0xad, 0xb1, 0x2017, 0xbe, 0xb6, 0xa7, 0xf7, 0xb8, 0xb0, 0xa8,
+  /* 250..255 */
+  0xb7, 0xb9, 0xb3, 0xb2, 0x25a0, 0xa0,
+
+  /* Extra characters for codepages 437 and 1004 */
+
+  /* 256..259 */
+  0x20a7, 0x2310, 0x2561, 0x2562,
+  /* 260..269 */
+  0x2556, 0x2555, 0x255c, 0x255b, 0x255e, 0x255f, 0x2567, 0x2568, 0x2564, 0x2565,
+  /* 270..279 */
+  0x2559, 0x2558, 0x2552, 0x2553, 0x256b, 0x256a, 0x258c, 0x2590, 0x3b1, 0x393,
+  /* 280..289 */
+  0x3c0, 0x3a3, 0x3c3, 0x3c4, 0x3a6, 0x398, 0x3a9, 0x3b4, 0x221e, 0x3c6,
+  /* 290..299 */
+  0x3b5, 0x2229, 0x2261, 0x2265, 0x2264, 0x2320, 0x2321, 0x2248, 0x2219, 0x221a,
+  /* 300..309 */
+  0x207f, 0x2c9, 0x2d8, 0x2d9, 0x2da, 0x2dd, 0x2db, 0x2c7, 0x2018, 0x2019,
+  /* 310..318 */
+  0x201c, 0x201d, 0x2013, 0x2014, 0x2c6, 0x2dc, 0x201a, 0x201e, 0x2026,
+  /* 319..329 */
+  0x2020, 0x2021, 0x2c6, 0x2030, 0x160, 0x2039, 0x152, 0x303, 0x2122, 0x161, 0x203a,
+  /* 330..331 */
+  0x153, 0x178,
+
+  /* OS/2 v2.x ended at this point. */
+
+  /* 330..339 */
+  0x11f, 0x11e, 0x130, 0x15f, 0x15e, 0x103, 0x102, 0x105,
+  /* 340..349 */
+  0x104, 0x107, 0x106, 0x10d, 0x10c, 0x10f, 0x10e, 0x111, 0x11b, 0x11a,
+  /* 350..359 */
+  0x119, 0x118, 0x13a, 0x139, 0x13e, 0x13d, 0x142, 0x141, 0x144, 0x143,
+  /* 360..369 */
+  0x148, 0x147, 0x151, 0x150, 0x155, 0x154, 0x159, 0x158, 0x15b, 0x15a,
+  /* 370..379 */
+  0x165, 0x164, 0x163, 0x162, 0x171, 0x170, 0x16f, 0x16e, 0x17a, 0x179,
+  /* 380..383 */
+  0x17e, 0x17d, 0x17c, 0x17b,
+
+  /* OS/2 Warp 3 ended at this point. */
+
+  /* 384..389 */
+  0x401, 0x402, 0x403, 0x404, 0x405, 0x406,
+  /* 390..399 */
+  0x407, 0x408, 0x409, 0x40a, 0x40b, 0x40c, 0x40e, 0x40f, 0x410, 0x411,
+  /* 400..409 */
+  0x412, 0x413, 0x414, 0x415, 0x416, 0x417, 0x418, 0x419, 0x41a, 0x41b,
+  /* 410..419 */
+  0x41c, 0x41d, 0x41e, 0x41f, 0x420, 0x421, 0x422, 0x423, 0x424, 0x425,
+  /* 420..429 */
+  0x426, 0x427, 0x428, 0x429, 0x42a, 0x42b, 0x42c, 0x42d, 0x42e, 0x42f,
+  /* 430..439 */
+  0x430, 0x431, 0x432, 0x433, 0x434, 0x435, 0x436, 0x437, 0x438, 0x439,
+  /* 440..449 */
+  0x43a, 0x43b, 0x43c, 0x43d, 0x43e, 0x43f, 0x440, 0x441, 0x442, 0x443,
+  /* 450..459 */
+  0x444, 0x445, 0x446, 0x447, 0x448, 0x449, 0x44a, 0x44b, 0x44c, 0x44d,
+  /* 460..469 */
+  0x44e, 0x44f, 0x2116, 0x451, 0x452, 0x453, 0x454, 0x455, 0x456, 0x457,
+  /* 470..479 */
+  0x458, 0x459, 0x45a, 0x45b, 0x45c, 0x45e, 0x45f, 0x490, 0x491, 0x156,
+  /* 480..489 */
+  0x12e, 0x100, 0x112, 0x116, 0x122, 0x136, 0x12a, 0x1eb, 0x145, 0x14c,
+  /* 490..499 */
+  0x172, 0x16a, 0x157, 0x12f, 0x101, 0x113, 0x117, 0x123, 0x137, 0x12b,
+  /* 500..504 */
+  0x13c, 0x146, 0x14d, 0x173, 0x16b,
+
+  /* OS/2 Warp 4 support ended here.
+   * Starting with Aurora, all previously-separate languages were unified
+   * into the extended glyphlist from this point.
+   */
+
+  /* 505..509 */
+  0xfffd, 0x2260, 0x25ca, 0x2318, 0x2113,
+  /* 510..519 */
+  0x2044, 0x2202, 0x0300, 0x0301, 0x0302, 0x0308, 0x0303, 0x0327, 0x030c, 0x030b,
+  /* 520..529 */
+  0x030a, 0x0306, 0x0328, 0x0307, 0x0000, 0x0000, 0x0000, 0x0000, 0x0344, 0x0304,
+  /* 530..539 */
+  0x0000, 0x200c, 0x200d, 0x200e, 0x200f, 0x20aa, 0x05d0, 0x05d1, 0x05d2, 0x05d3,
+  /* 540..549 */
+  0x05d4, 0x05d5, 0x05d6, 0x05d7, 0x05d8, 0x05d9, 0x05da, 0x05db, 0x05dc, 0x05dd,
+  /* 550..559 */
+  0x05de, 0x05df, 0x05e0, 0x05e1, 0x05e2, 0x05e3, 0x05e4, 0x05e5, 0x05e6, 0x05e7,
+  /* 560..569 */
+  0x05e8, 0x05e9, 0x05ea, 0x05b0, 0x05b1, 0x05b2, 0x05b3, 0x05b4, 0x05b5, 0x05b6,
+  /* 570..579 */
+  0x05b7, 0x05b8, 0x05b9, 0x05bb, 0x05bc, 0x05bd, 0x05be, 0x05bf, 0x05c0, 0x05c1,
+  /* 580..589 */
+  0x05c2, 0x05c3, 0x05f0, 0x05f1, 0x05f2, 0x2015, 0x0384, 0x0385, 0x0391, 0x0392,
+  /* 590..599 */
+  0x0394, 0x0395, 0x0396, 0x0397, 0x03d1, 0x0399, 0x039a, 0x039b, 0x039c, 0x039d,
+  /* 600..609 */
+  0x039e, 0x039f, 0x03a0, 0x03a1, 0x03a4, 0x03a5, 0x03a6, 0x03a7, 0x03b2, 0x03b3,
+  /* 610..619 */
+  0x03b6, 0x03b7, 0x03b8, 0x03b9, 0x03ba, 0x03bb, 0x03bc, 0x03bd, 0x03be, 0x03bf,
+  /* 620..629 */
+  0x03c1, 0x03c2, 0x03c4, 0x03c6, 0x03c7, 0x03c8, 0x03c9, 0x0386, 0x0388, 0x0389,
+  /* 630..639 */
+  0x038a, 0x038c, 0x038e, 0x038f, 0x03aa, 0x03ab, 0x03ac, 0x03ad, 0x03ae, 0x03af,
+  /* 640..649 */
+  0x03cc, 0x03cd, 0x03ce, 0x03ca, 0x03cb, 0x0390, 0x03b0, 0xfef7, 0xfef8, 0xfefb,
+  /* 650..659 */
+  0xfefc, 0xf8fc, 0xfe82, 0xfe84, 0xfe8e, 0x0628, 0x062a, 0x062b, 0x060c, 0x062c,
+  /* 660..669 */
+  0x062d, 0x062e, 0x0660, 0x0661, 0x0662, 0x0663, 0x0664, 0x0665, 0x0666, 0x0667,
+  /* 670..679 */
+  0x0668, 0x0669, 0x0641, 0x061b, 0xf8f6, 0xf8f5, 0xf8f4, 0x061f, 0x0621, 0x0622,
+  /* 680..689 */
+  0x0623, 0x0624, 0xfeca, 0x0626, 0x0627, 0xfe91, 0x0629, 0xfe97, 0xfe9b, 0xfe9f,
+  /* 690..699 */
+  0xfea3, 0xfea7, 0x062f, 0x0630, 0x0631, 0x0632, 0xfeb3, 0xfeb7, 0xfebb, 0xfec0,
+  /* 700..709 */
+  0x0637, 0x0638, 0xfecb, 0xfecf, 0x0639, 0x0640, 0xfed3, 0xfed7, 0xfed8, 0xfedf,
+  /* 710..719 */
+  0xfee3, 0xfee7, 0xfeeb, 0x0648, 0x0649, 0xfef3, 0xf8f7, 0xfecc, 0xfece, 0x063a,
+  /* 720..729 */
+  0x0645, 0xfe7d, 0x0651, 0x0646, 0x0647, 0xfeec, 0xfef0, 0xfef2, 0xfed0, 0x0642,
+  /* 730..739 */
+  0xfef5, 0xfef6, 0x0644, 0x0643, 0x064a, 0x0686, 0x06af, 0x067e, 0x0698, 0x0625,
+  /* 740..749 */
+  0x064b, 0x064c, 0x064d, 0x064e, 0x064f, 0x0650, 0x0652, 0x0698, 0x202a, 0x202b,
+  /* 750..759 */
+  0x202c, 0x202d, 0x202e, 0x25c5, 0x2007, 0xf8ff, 0xfb00, 0xfb01, 0xfb02, 0xfb03,
+  /* 760..769 */
+  0xfb04, 0x0133, 0x222b, 0x215b, 0x215c, 0x215d, 0x215e, 0xf8b3, 0x303f, 0x21b5,
+
+
+  /* The official UGL assigns codepoints 770-832 to the fullwidth katakana set,
+   * and when using Unicode TrueType fonts under OS/2 they will be mapped as
+   * such.  However, in all OS/2 bitmap fonts, as well as non-Unicode TrueType
+   * and Type 1 fonts, the actual characters returned by these codepoints are
+   * HALF-width katakana (U+FF61-FF9F) -- full-width kana (along with kanji and
+   * other CJK characters) are loaded from separate fonts according to the
+   * system's DBCS association settings (if any).
+   *
+   * Codepoints 833-891 are even more peculiar, as UGL assigns them to hiragana
+   * and a handful of additional CJK characters.  However, OS/2 never uses them
+   * -- the characters don't exist under any single-byte codepage, and when a
+   * UGL bitmap font is active under a DBCS/MBCS codepage OS/2 will always look
+   * for those characters in the separate associated DBCS fonts.  Presumably,
+   * IBM assigned these codepoints as part of some vague idea for future support
+   * which was later abandoned.  (No extant bitmap font from IBM actually uses
+   * them.)
+   *
+   * In light of the above, I have modified the Unicode-to-UGL mappings to treat
+   * 770-832 as halfwidth kana and to report 833-891 as unsupported.  If desired
+   * UGL_HALFWIDTH_KANA can be defined as 0 in order to cause hiragana and
+   * (fullwidth) katakana to be loaded from the font at these codepoints,
+   * although this is probably not useful.  (The conversion code in gpifont.c
+   * will always map halfwidth Unicode characters to this range regardless of
+   * what's in the table here.)
+   */
+
+#if UGL_HALFWIDTH_KANA
+
+  /* 770..779 */
+  0xff61, 0xff62, 0xff63, 0xff64, 0xff65, 0xff66, 0xff67, 0xff68, 0xff69, 0xff6a,
+  /* 780..789 */
+  0xff6b, 0xff6c, 0xff6d, 0xff6e, 0xff6f, 0xff70, 0xff71, 0xff72, 0xff73, 0xff74,
+  /* 790..799 */
+  0xff75, 0xff76, 0xff77, 0xff78, 0xff79, 0xff7a, 0xff7b, 0xff7c, 0xff7d, 0xff7e,
+  /* 800..809 */
+  0xff7f, 0xff80, 0xff81, 0xff82, 0xff83, 0xff84, 0xff85, 0xff86, 0xff87, 0xff88,
+  /* 810..819 */
+  0xff89, 0xff8a, 0xff8b, 0xff8c, 0xff8d, 0xff8e, 0xff8f, 0xff90, 0xff91, 0xff92,
+  /* 820..829 */
+  0xff93, 0xff94, 0xff95, 0xff96, 0xff97, 0xff98, 0xff99, 0xff9a, 0xff9b, 0xff9c,
+  /* 830..839 */
+  0xff9d, 0xff9e, 0xff9f, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  /* 840..849 */
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  /* 850..859 */
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  /* 860..869 */
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  /* 870..879 */
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  /* 880..889 */
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  /* 890..895 */
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+
+#else
+
+  /* 770..779 */
+  0x3002, 0x300c, 0x300d, 0x3001, 0x30fb, 0x30f2, 0x30a1, 0x30a3, 0x30a5, 0x30a7,
+  /* 780..789 */
+  0x30a9, 0x30e3, 0x30e5, 0x30e7, 0x30c3, 0x30fc, 0x30a2, 0x30a4, 0x30a6, 0x30a8,
+  /* 790..799 */
+  0x30aa, 0x30ab, 0x30ad, 0x30af, 0x30b1, 0x30b3, 0x30b5, 0x30b7, 0x30b9, 0x30bb,
+  /* 800..809 */
+  0x30bd, 0x30bf, 0x30c1, 0x30c4, 0x30c6, 0x30c8, 0x30ca, 0x30cb, 0x30cc, 0x30cd,
+  /* 810..819 */
+  0x30ce, 0x30cf, 0x30d2, 0x30d5, 0x30d8, 0x30db, 0x30de, 0x30df, 0x30e0, 0x30e1,
+  /* 820..829 */
+  0x30e2, 0x30e4, 0x30e6, 0x30e8, 0x30e9, 0x30ea, 0x30eb, 0x30ec, 0x30ed, 0x30ef,
+  /* 830..839 */
+  0x30f3, 0x309b, 0x309c, 0x3041, 0x3043, 0x3045, 0x3047, 0x3049, 0x3083, 0x3085,
+  /* 840..849 */
+  0x3049, 0x3063, 0x3042, 0x3044, 0x3046, 0x3048, 0x304a, 0x304b, 0x304d, 0x304f,
+  /* 850..859 */
+  0x3051, 0x3053, 0x3055, 0x3057, 0x3059, 0x305b, 0x305d, 0x305f, 0x3061, 0x3064,
+  /* 860..869 */
+  0x3066, 0x3068, 0x306a, 0x306b, 0x306c, 0x306d, 0x306e, 0x306f, 0x3072, 0x3075,
+  /* 870..879 */
+  0x3078, 0x307b, 0x307e, 0x307f, 0x3080, 0x3081, 0x3082, 0x3084, 0x3086, 0x3088,
+  /* 880..889 */
+  0x3089, 0x308a, 0x308b, 0x308c, 0x308d, 0x308f, 0x3092, 0x3093, 0x300e, 0x300f,
+  /* 890..895 */
+  0x30f6, 0x3005, 0x0000, 0x0000, 0x0000, 0x0000,
+
+#endif  /* 1 */
+
+  /* 896..899 */
+  0x3131, 0x3132, 0x3133, 0x3134,
+  /* 900..909 */
+  0x3135, 0x3136, 0x3137, 0x3138, 0x3139, 0x313a, 0x313b, 0x313c, 0x313d, 0x313e,
+  /* 910..919 */
+  0x313f, 0x3140, 0x3141, 0x3142, 0x3143, 0x3144, 0x3145, 0x3146, 0x3147, 0x3148,
+  /* 920..929 */
+  0x3149, 0x314a, 0x314b, 0x314c, 0x314d, 0x314e, 0x314f, 0x3150, 0x3151, 0x3152,
+  /* 930..939 */
+  0x3153, 0x3154, 0x3155, 0x3156, 0x3157, 0x3158, 0x3159, 0x315a, 0x315b, 0x315c,
+  /* 940..949 */
+  0x315d, 0x315e, 0x315f, 0x3160, 0x3161, 0x3162, 0x3163, 0x20a9, 0x0000, 0x3164,
+  /* 950..959 */
+  0x0e3f, 0x0e01, 0x0e02, 0x0e03, 0x0e04, 0x0e05, 0x0e06, 0x0e07, 0x0e08, 0x0e09,
+  /* 960..969 */
+  0x0e0a, 0x0e0b, 0x0e0c, 0x0e0d, 0x0e0e, 0x0e0f, 0x0e10, 0x0e11, 0x0e12, 0x0e13,
+  /* 970..979 */
+  0x0e14, 0x0e15, 0x0e16, 0x0e17, 0x0e18, 0x0e19, 0x0e1a, 0x0e1b, 0x0e1c, 0x0e1d,
+  /* 980..989 */
+  0x0e1e, 0x0e1f, 0x0e20, 0x0e21, 0x0e22, 0x0e23, 0x0e24, 0x0e25, 0x0e26, 0x0e27,
+  /* 990..999 */
+  0x0e28, 0x0e29, 0x0e2a, 0x0e2b, 0x0e2c, 0x0e2d, 0x0e2e, 0x0e2f, 0x0e30, 0x0e31,
+  /* 1000..1009 */
+  0x0e32, 0x0e33, 0x0e34, 0x0e35, 0x0e36, 0x0e37, 0x0e38, 0x0e39, 0x0e3a, 0x0e40,
+  /* 1010..1019 */
+  0x0e41, 0x0e42, 0x0e43, 0x0e44, 0x0e45, 0x0e46, 0x0e47, 0x0e48, 0x0e49, 0x0e4a,
+  /* 1020..1029 */
+  0x0e4b, 0x0e4c, 0x0e4d, 0x0e4e, 0x0e4f, 0x0e5a, 0x0e5b, 0x0e50, 0x0e51, 0x0e52,
+  /* 1030..1036 */
+  0x0e53, 0x0e54, 0x0e55, 0x0e56, 0x0e57, 0x0e58, 0x0e59
+
+  /* Note: UGL codepoints above 1036 do not correspond to Unicode characters. */
+
+};
+
+
+
+/* Reverse mapping from Unicode (BMP) codepoints to UGL.  This is a two-level
+ * table: the high byte of the codepoint selects an entry in Uni2UGLPage, and
+ * that entry is the row of Uni2UGL which holds the UGL indices of the 256
+ * codepoints in that block (indexed by the low byte).  Blocks which contain
+ * no UGL characters share the empty row 0.  Codepoints with no UGL mapping
+ * give 0 (as does U+0000 itself, which maps to the .null glyph).
+ *
+ * The table was generated from UGL2Uni above, together with the directly-
+ * mapped ranges which OS2FontGlyphIndex() in gpifont.c has always used (and
+ * which take precedence); where a codepoint occurs more than once in UGL2Uni
+ * the lowest UGL index is used.  It must be regenerated whenever UGL2Uni is
+ * changed.  (The uglbench program in parser/bench checks the two against
+ * each other.)
+ */
+
+#define UNI2UGL( c )            ( Uni2UGL[ Uni2UGLPage[ ((c) >> 8) & 0xFF ]][ (c) & 0xFF ] )
+
+static const BYTE Uni2UGLPage[ 256 ] = {
+  /* U+0000..U+0FFF */
+   1,  2,  3,  4,  5,  6,  7,  0,  0,  0,  0,  0,  0,  0,  8,  0,
+  /* U+1000..U+1FFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+2000..U+2FFF */
+   9, 10, 11, 12,  0, 13, 14,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+3000..U+3FFF */
+  15, 16,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+4000..U+4FFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+5000..U+5FFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+6000..U+6FFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+7000..U+7FFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+8000..U+8FFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+9000..U+9FFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+A000..U+AFFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+B000..U+BFFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+C000..U+CFFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+D000..U+DFFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+E000..U+EFFF */
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+  /* U+F000..U+FFFF */
+   0,  0,  0,  0,  0,  0,  0,  0, 17,  0,  0, 18,  0,  0, 19, 20
+};
+
+static const USHORT Uni2UGL[ 21 ][ 256 ] = {
+  /* 0: unmapped blocks */
+  { 0 },
+  /* 1: U+0000..U+00FF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      32,   33,   34,   35,   36,   37,   38,   39,   40,   41,   42,   43,   44,   45,   46,   47,
+      48,   49,   50,   51,   52,   53,   54,   55,   56,   57,   58,   59,   60,   61,   62,   63,
+      64,   65,   66,   67,   68,   69,   70,   71,   72,   73,   74,   75,   76,   77,   78,   79,
+      80,   81,   82,   83,   84,   85,   86,   87,   88,   89,   90,   91,   92,   93,   94,   95,
+      96,   97,   98,   99,  100,  101,  102,  103,  104,  105,  106,  107,  108,  109,  110,  111,
+     112,  113,  114,  115,  116,  117,  118,  119,  120,  121,  122,  123,  124,  125,  126,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     255,  173,  189,  156,  207,  190,  221,   21,  249,  184,  166,  174,  170,  240,  169,  238,
+     248,  241,  253,  252,  239,  230,   20,  250,  247,  251,  167,  175,  172,  171,  243,  168,
+     183,  181,  182,  199,  142,  143,  146,  128,  212,  144,  210,  211,  222,  214,  215,  216,
+     209,  165,  227,  224,  226,  229,  153,  158,  157,  235,  233,  234,  154,  237,  232,  225,
+     133,  160,  131,  198,  132,  134,  145,  135,  138,  130,  136,  137,  141,  161,  140,  139,
+     208,  164,  149,  162,  147,  228,  148,  246,  155,  151,  163,  150,  129,  236,  231,  152
+  },
+  /* 2: U+0100..U+01FF */
+  {
+     481,  494,  338,  337,  340,  339,  342,  341,    0,    0,    0,    0,  344,  343,  346,  345,
+       0,  347,  482,  495,    0,    0,  483,  496,  351,  350,  349,  348,    0,    0,  333,  332,
+       0,    0,  484,  497,    0,    0,    0,    0,    0,    0,  486,  499,    0,    0,  480,  493,
+     334,  213,    0,  761,    0,    0,  485,  498,    0,  353,  352,    0,  500,  355,  354,    0,
+       0,  357,  356,  359,  358,  488,  501,  361,  360,    0,    0,    0,  489,  502,    0,    0,
+     363,  362,  325,  330,  365,  364,  479,  492,  367,  366,  369,  368,    0,    0,  336,  335,
+     323,  328,  373,  372,  371,  370,    0,    0,    0,    0,  491,  504,    0,    0,  377,  376,
+     375,  374,  490,  503,    0,    0,    0,    0,  331,  379,  378,  383,  382,  381,  380,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,  159,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  487,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 3: U+0200..U+02FF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,  314,  307,    0,  301,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,  302,  303,  304,  306,  315,  305,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 4: U+0300..U+03FF */
+  {
+     512,  513,  514,  326,  529,    0,  521,  523,  515,    0,  520,  519,  518,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,  517,  522,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,  528,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,  586,  587,  627,    0,  628,  629,  630,    0,  631,    0,  632,  633,
+     645,  588,  589,  279,  590,  591,  592,  593,  285,  595,  596,  597,  598,  599,  600,  601,
+     602,  603,    0,  281,  604,  605,  284,  607,    0,  286,  634,  635,  636,  637,  638,  639,
+     646,  278,  608,  609,  287,  290,  610,  611,  612,  613,  614,  615,  616,  617,  618,  619,
+     280,  620,  621,  282,  283,    0,  289,  624,  625,  626,  643,  644,  640,  641,  642,    0,
+       0,  594,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 5: U+0400..U+04FF */
+  {
+       0,  384,  385,  386,  387,  388,  389,  390,  391,  392,  393,  394,  395,    0,  396,  397,
+     398,  399,  400,  401,  402,  403,  404,  405,  406,  407,  408,  409,  410,  411,  412,  413,
+     414,  415,  416,  417,  418,  419,  420,  421,  422,  423,  424,  425,  426,  427,  428,  429,
+     430,  431,  432,  433,  434,  435,  436,  437,  438,  439,  440,  441,  442,  443,  444,  445,
+     446,  447,  448,  449,  450,  451,  452,  453,  454,  455,  456,  457,  458,  459,  460,  461,
+       0,  463,  464,  465,  466,  467,  468,  469,  470,  471,  472,  473,  474,    0,  475,  476,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     477,  478,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 6: U+0500..U+05FF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     563,  564,  565,  566,  567,  568,  569,  570,  571,  572,    0,  573,  574,  575,  576,  577,
+     578,  579,  580,  581,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     536,  537,  538,  539,  540,  541,  542,  543,  544,  545,  546,  547,  548,  549,  550,  551,
+     552,  553,  554,  555,  556,  557,  558,  559,  560,  561,  562,    0,    0,    0,    0,    0,
+     582,  583,  584,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 7: U+0600..U+06FF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  658,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  673,    0,    0,    0,  677,
+       0,  678,  679,  680,  681,  739,  683,  684,  655,  686,  656,  657,  659,  660,  661,  692,
+     693,  694,  695,    0,    0,    0,    0,  700,  701,  704,  719,    0,    0,    0,    0,    0,
+     705,  672,  729,  733,  732,  720,  723,  724,  713,  714,  734,  740,  741,  742,  743,  744,
+     745,  722,  746,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     662,  663,  664,  665,  666,  667,  668,  669,  670,  671,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  737,    0,
+       0,    0,    0,    0,    0,    0,  735,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,  738,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  736,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 8: U+0E00..U+0EFF */
+  {
+       0,  951,  952,  953,  954,  955,  956,  957,  958,  959,  960,  961,  962,  963,  964,  965,
+     966,  967,  968,  969,  970,  971,  972,  973,  974,  975,  976,  977,  978,  979,  980,  981,
+     982,  983,  984,  985,  986,  987,  988,  989,  990,  991,  992,  993,  994,  995,  996,  997,
+     998,  999, 1000, 1001, 1002, 1003, 1004, 1005, 1006, 1007, 1008,    0,    0,    0,    0,  950,
+    1009, 1010, 1011, 1012, 1013, 1014, 1015, 1016, 1017, 1018, 1019, 1020, 1021, 1022, 1023, 1024,
+    1027, 1028, 1029, 1030, 1031, 1032, 1033, 1034, 1035, 1036, 1025, 1026,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 9: U+2000..U+20FF */
+  {
+       0,    0,    0,    0,    0,    0,    0,  754,    0,    0,    0,    0,  531,  532,  533,  534,
+       0,    0,    0,  312,  313,  585,    0,  242,  308,  309,  316,    0,  310,  311,  317,    0,
+     319,  320,    7,    0,    0,    0,  318,    0,    0,    0,  748,  749,  750,  751,  752,    0,
+     322,    0,    0,    0,    0,    0,    0,    0,    0,  324,  329,    0,   19,    0,    0,    0,
+       0,    0,    0,    0,  510,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  300,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,  256,    0,  947,  535,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 10: U+2100..U+21FF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,  509,    0,    0,  462,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,  327,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  763,  764,  765,  766,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+      27,   24,   26,   25,   29,   18,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,   23,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,  769,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 11: U+2200..U+22FF */
+  {
+       0,    0,  511,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,  298,  299,    0,    0,    0,  288,   28,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,  291,    0,  762,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,  297,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     506,  292,    0,    0,  294,  293,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 12: U+2300..U+23FF */
+  {
+       0,    0,  127,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     257,    0,    0,    0,    0,    0,    0,    0,  508,    0,    0,    0,    0,    0,    0,    0,
+     295,  296,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 13: U+2500..U+25FF */
+  {
+     196,    0,  179,    0,    0,    0,    0,    0,    0,    0,    0,    0,  218,    0,    0,    0,
+     191,    0,    0,    0,  192,    0,    0,    0,  217,    0,    0,    0,  195,    0,    0,    0,
+       0,    0,    0,    0,  180,    0,    0,    0,    0,    0,    0,    0,  194,    0,    0,    0,
+       0,    0,    0,    0,  193,    0,    0,    0,    0,    0,    0,    0,  197,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     205,  186,  272,  273,  201,  261,  260,  187,  271,  270,  200,  263,  262,  188,  264,  265,
+     204,  258,  259,  185,  268,  269,  203,  266,  267,  202,  275,  274,  206,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     223,    0,    0,    0,  220,    0,    0,    0,  219,    0,    0,    0,  276,    0,    0,    0,
+     277,  176,  177,  178,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+     254,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,   22,    0,    0,    0,
+       0,    0,   30,    0,    0,    0,    0,    0,    0,    0,   16,    0,   31,    0,    0,    0,
+       0,    0,    0,    0,   17,  753,    0,    0,    0,    0,  507,    9,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    8,   10,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 14: U+2600..U+26FF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    1,    2,   15,    0,    0,    0,
+      12,    0,   11,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       6,    0,    0,    5,    0,    3,    4,    0,    0,    0,   13,   14,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 15: U+3000..U+30FF */
+  {
+#if UGL_HALFWIDTH_KANA
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  768,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+#else
+       0,  773,  770,    0,    0,  891,    0,    0,    0,    0,    0,    0,  771,  772,  888,  889,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  768,
+       0,  833,  842,  834,  843,  835,  844,  836,  845,  837,  846,  847,    0,  848,    0,  849,
+       0,  850,    0,  851,    0,  852,    0,  853,    0,  854,    0,  855,    0,  856,    0,  857,
+       0,  858,    0,  841,  859,    0,  860,    0,  861,    0,  862,  863,  864,  865,  866,  867,
+       0,    0,  868,    0,    0,  869,    0,    0,  870,    0,    0,  871,    0,    0,  872,  873,
+     874,  875,  876,  838,  877,  839,  878,    0,  879,  880,  881,  882,  883,  884,    0,  885,
+       0,    0,  886,  887,    0,    0,    0,    0,    0,    0,    0,  831,  832,    0,    0,    0,
+       0,  776,  786,  777,  787,  778,  788,  779,  789,  780,  790,  791,    0,  792,    0,  793,
+       0,  794,    0,  795,    0,  796,    0,  797,    0,  798,    0,  799,    0,  800,    0,  801,
+       0,  802,    0,  784,  803,    0,  804,    0,  805,    0,  806,  807,  808,  809,  810,  811,
+       0,    0,  812,    0,    0,  813,    0,    0,  814,    0,    0,  815,    0,    0,  816,  817,
+     818,  819,  820,  781,  821,  782,  822,  783,  823,  824,  825,  826,  827,  828,    0,  829,
+       0,    0,  775,  830,    0,    0,  890,    0,    0,    0,    0,  774,  785,    0,    0,    0
+#endif
+  },
+  /* 16: U+3100..U+31FF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,  896,  897,  898,  899,  900,  901,  902,  903,  904,  905,  906,  907,  908,  909,  910,
+     911,  912,  913,  914,  915,  916,  917,  918,  919,  920,  921,  922,  923,  924,  925,  926,
+     927,  928,  929,  930,  931,  932,  933,  934,  935,  936,  937,  938,  939,  940,  941,  942,
+     943,  944,  945,  946,  949,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 17: U+F800..U+F8FF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,  767,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,  676,  675,  674,  716,    0,    0,    0,    0,  651,    0,    0,  755
+  },
+  /* 18: U+FB00..U+FBFF */
+  {
+     756,  757,  758,  759,  760,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0
+  },
+  /* 19: U+FE00..U+FEFF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  721,    0,    0,
+       0,    0,  652,    0,  653,    0,    0,    0,    0,    0,    0,    0,    0,    0,  654,    0,
+       0,  685,    0,    0,    0,    0,    0,  687,    0,    0,    0,  688,    0,    0,    0,  689,
+       0,    0,    0,  690,    0,    0,    0,  691,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,  696,    0,    0,    0,  697,    0,    0,    0,  698,    0,    0,    0,    0,
+     699,    0,    0,    0,    0,    0,    0,    0,    0,    0,  682,  702,  717,    0,  718,  703,
+     728,    0,    0,  706,    0,    0,    0,  707,  708,    0,    0,    0,    0,    0,    0,  709,
+       0,    0,    0,  710,    0,    0,    0,  711,    0,    0,    0,  712,  725,    0,    0,    0,
+     726,    0,  727,  715,    0,  730,  731,  647,  648,    0,    0,  649,  650,    0,    0,    0
+  },
+  /* 20: U+FF00..U+FFFF */
+  {
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,  770,  771,  772,  773,  774,  775,  776,  777,  778,  779,  780,  781,  782,  783,  784,
+     785,  786,  787,  788,  789,  790,  791,  792,  793,  794,  795,  796,  797,  798,  799,  800,
+     801,  802,  803,  804,  805,  806,  807,  808,  809,  810,  811,  812,  813,  814,  815,  816,
+     817,  818,  819,  820,  821,  822,  823,  824,  825,  826,  827,  828,  829,  830,  831,  832,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+       0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  505,    0,    0
+  }
+};
+
+
+#endif  /* #ifndef __PMUGL_H__ */
@@ -0,0 +1,636 @@
+/*****************************************************************************
+ *                                                                           *
+ * fontgen.c                                                                 *
+ *                                                                           *
+ * Synthetic font corpus generator for the benchmarks.  Writes one GPI font  *
+ * file for each type of character definition (1, 2 and 3), with a chosen    *
+ * number of glyphs and cell size, and four LX modules which hold all three  *
+ * fonts: one with plain (OP32_VALID) object pages, one packed with EXEPACK1 *
+ * (OP32_ITERDATA), one packed with EXEPACK2 (OP32_ITERDATA2), and one which *
+ * mixes all three.  The same fonts are also written to a 16-bit (NE)        *
+ * module, as long as each one fits in a 64 KB segment.  Every file is read  *
+ * back with the parser and checked against the generated fonts before the   *
+ * program exits.                                                            *
+ *                                                                           *
+ *  (C) 2023 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "otypes.h"
+#include "gpifont.h"
+#include "os2res.h"
+
+#define PAGE_SIZE       4096
+#define STUB_SIZE       128         /* size of the MZ stub                    */
+#define NE_HEADER_SIZE  64          /* NEHEADER plus the fields it leaves out */
+#define FIRST_FACE_ID   100         /* resource ID of the first font          */
+#define FONT_TYPES      3
+
+#define MAX_GLYPHS      4096
+#define MAX_CELL        64
+
+/* How the object pages of a module are stored */
+#define PACK_VALID      0
+#define PACK_ITER1      1
+#define PACK_ITER2      2
+#define PACK_MIXED      3
+
+static const char *apszModules[] = { "valid.fon", "iter1.fon", "iter2.fon", "mixed.fon" };
+
+static ULONG ulSeed = 1;
+
+/* Local function prototypes */
+ULONG check_file( PSZ pszFile, PBYTE *papFonts, PULONG pacbFonts, ULONG cFonts );
+void  draw_glyph( PBYTE pBits, ULONG cx, ULONG cy, ULONG ulShape );
+PBYTE make_directory( PBYTE *papFonts, ULONG cFonts, PULONG pcbDir );
+ULONG make_font( ULONG ulType, ULONG cGlyphs, ULONG cx, ULONG cy, PBYTE *ppFont );
+ULONG make_lx_module( PBYTE *papFonts, PULONG pacbFonts, ULONG cFonts, ULONG ulPacking, PBYTE *ppModule, PULONG pacPages );
+ULONG make_ne_module( PBYTE *papFonts, PULONG pacbFonts, ULONG cFonts, PBYTE *ppModule );
+ULONG next_random( void );
+BOOL  write_file( PSZ pszFile, PBYTE pData, ULONG cb );
+
+
+/* ------------------------------------------------------------------------ */
+int main( int argc, char *argv[] )
+{
+    PBYTE  apFonts[ FONT_TYPES ],
+           pModule;
+    ULONG  acbFonts[ FONT_TYPES ],
+           acPages[ 3 ],
+           cGlyphs = 224,
+           cx      = 8,
+           cy      = 16,
+           cbModule,
+           i;
+    char   szFile[ 512 ];
+    PSZ    pszDir = NULL;
+    int    a;
+
+
+    for ( a = 1; a < argc; a++ ) {
+        if ((( argv[ a ][ 0 ] == '/' ) || ( argv[ a ][ 0 ] == '-' )) &&
+            ( strlen( argv[ a ] ) > 3 ) && ( argv[ a ][ 2 ] == ':' )) {
+            switch ( argv[ a ][ 1 ] ) {
+                case 'n':
+                case 'N': cGlyphs = atoi( argv[ a ] + 3 ); break;
+                case 'w':
+                case 'W': cx      = atoi( argv[ a ] + 3 ); break;
+                case 'h':
+                case 'H': cy      = atoi( argv[ a ] + 3 ); break;
+                case 's':
+                case 'S': ulSeed  = atoi( argv[ a ] + 3 ); break;
+                default : pszDir  = NULL; a = argc; break;
+            }
+        }
+        else pszDir = argv[ a ];
+    }
+    if ( !pszDir ) {
+        printf("FONTGEN <directory> [/N:<glyphs>] [/W:<width>] [/H:<height>] [/S:<seed>]\n\n");
+        printf("Writes synthetic GPI fonts of all three character definition types to the\n");
+        printf("given directory, both as font files and as LX modules whose object pages are\n");
+        printf("unpacked, EXEPACK1 or EXEPACK2-compressed.  The default is 224 glyphs in an\n");
+        printf("8x16 cell.\n");
+        return 0;
+    }
+    if (( cGlyphs < 2 ) || ( cGlyphs > MAX_GLYPHS ) ||
+        ( cx < 1 ) || ( cx > MAX_CELL ) || ( cy < 4 ) || ( cy > MAX_CELL )) {
+        fprintf( stderr, "Glyph count must be 2-%u, width 1-%u and height 4-%u.\n",
+                 MAX_GLYPHS, MAX_CELL, MAX_CELL );
+        return 1;
+    }
+#ifdef _WIN32
+    mkdir( pszDir );
+#else
+    mkdir( pszDir, 0777 );
+#endif
+
+    for ( i = 0; i < FONT_TYPES; i++ ) {
+        acbFonts[ i ] = make_font( i + 1, cGlyphs, cx, cy, apFonts + i );
+        if ( !acbFonts[ i ] ) {
+            fprintf( stderr, "Out of memory.\n");
+            return 1;
+        }
+        sprintf( szFile, "%s/type%u.fnt", pszDir, i + 1 );
+        if ( !write_file( szFile, apFonts[ i ], acbFonts[ i ] ) ||
+             check_file( szFile, apFonts + i, acbFonts + i, 1 ))
+            return 2;
+        printf("%s: type %u font, %u glyphs, %u bytes\n", szFile, i + 1, cGlyphs, acbFonts[ i ] );
+    }
+
+    for ( i = PACK_VALID; i <= PACK_MIXED; i++ ) {
+        cbModule = make_lx_module( apFonts, acbFonts, FONT_TYPES, i, &pModule, acPages );
+        if ( !cbModule ) {
+            fprintf( stderr, "Out of memory.\n");
+            return 1;
+        }
+        sprintf( szFile, "%s/%s", pszDir, apszModules[ i ] );
+        if ( !write_file( szFile, pModule, cbModule ) ||
+             check_file( szFile, apFonts, acbFonts, FONT_TYPES ))
+            return 2;
+        printf("%s: %u fonts, %u bytes, pages: %u unpacked, %u EXEPACK1, %u EXEPACK2\n",
+               szFile, FONT_TYPES, cbModule, acPages[ PACK_VALID ],
+               acPages[ PACK_ITER1 ], acPages[ PACK_ITER2 ] );
+        free( pModule );
+    }
+
+    // NE segments are limited to 64 KB, so large fonts cannot be stored
+    sprintf( szFile, "%s/ne.fon", pszDir );
+    cbModule = make_ne_module( apFonts, acbFonts, FONT_TYPES, &pModule );
+    if ( cbModule ) {
+        if ( !write_file( szFile, pModule, cbModule ) ||
+             check_file( szFile, apFonts, acbFonts, FONT_TYPES ))
+            return 2;
+        printf("%s: %u fonts, %u bytes, NE format\n", szFile, FONT_TYPES, cbModule );
+        free( pModule );
+    }
+    else printf("%s: not written, as the fonts are too large for NE segments\n", szFile );
+
+    for ( i = 0; i < FONT_TYPES; i++ ) free( apFonts[ i ] );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Open a generated file with the parser and check that it holds exactly    *
+ * the given fonts.  Returns 0 if so, otherwise 1 (after saying why).       *
+ * ------------------------------------------------------------------------ */
+ULONG check_file( PSZ pszFile, PBYTE *papFonts, PULONG pacbFonts, ULONG cFonts )
+{
+    POS2FONTMODULE  pModule;
+    OS2FONTRESOURCE font;
+    ULONG           ulRC,
+                    i;
+
+    ulRC = OpenOS2FontModule( pszFile, &pModule );
+    if ( ulRC ) {
+        fprintf( stderr, "%s: parser error %u.\n", pszFile, ulRC );
+        return 1;
+    }
+    if ( QueryOS2FontModuleFaces( pModule ) != cFonts ) {
+        fprintf( stderr, "%s: %u fonts found, expected %u.\n",
+                 pszFile, QueryOS2FontModuleFaces( pModule ), cFonts );
+        CloseOS2FontModule( pModule );
+        return 1;
+    }
+    for ( i = 0; i < cFonts; i++ ) {
+        ulRC = GetOS2FontModuleFace( pModule, i, &font );
+        if ( ulRC ) {
+            fprintf( stderr, "%s: parser error %u on font %u.\n", pszFile, ulRC, i );
+            break;
+        }
+        if ( memcmp( font.pSignature, papFonts[ i ], pacbFonts[ i ] )) {
+            fprintf( stderr, "%s: font %u does not match.\n", pszFile, i );
+            ulRC = 1;
+        }
+        FreeOS2FontResource( &font );
+        if ( ulRC ) break;
+    }
+    CloseOS2FontModule( pModule );
+    return ulRC ? 1 : 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Draw a glyph into a (zeroed) GPI glyph bitmap, which is stored as one    *
+ * column of cy bytes for every 8 pels of width.  The shapes are simple     *
+ * outlines, stems and diagonals, plus some noise, so that the fonts        *
+ * compress about as well as real ones.                                     *
+ * ------------------------------------------------------------------------ */
+void draw_glyph( PBYTE pBits, ULONG cx, ULONG cy, ULONG ulShape )
+{
+    ULONG ulTop    = cy / 8,
+          ulBase   = cy - ( cy / 4 ),
+          ulHeight = ulBase - ulTop,
+          x, y;
+    BOOL  fSet;
+
+    for ( y = ulTop; y < ulBase; y++ ) {
+        for ( x = 0; x < cx; x++ ) {
+            switch ( ulShape % 4 ) {
+                case 0:  fSet = ( x == 0 ) || ( x == cx - 1 ) || ( y == ulTop ) || ( y == ulBase - 1 ); break;
+                case 1:  fSet = ( x == cx / 4 ) || ( x == cx - 1 - ( cx / 4 )) || ( y == ulTop + ( ulHeight / 2 )); break;
+                case 2:  fSet = ( x == (( y - ulTop ) * cx ) / ulHeight ); break;
+                default: fSet = (( next_random() % 3 ) == 0 ); break;
+            }
+            if ( fSet ) pBits[ (( x / 8 ) * cy ) + y ] |= 0x80 >> ( x % 8 );
+        }
+    }
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Build the font directory resource for a module holding the given fonts,  *
+ * whose resource IDs start at FIRST_FACE_ID.  Returns the (allocated)      *
+ * directory, or NULL if out of memory.                                     *
+ * ------------------------------------------------------------------------ */
+PBYTE make_directory( PBYTE *papFonts, ULONG cFonts, PULONG pcbDir )
+{
+    OS2FONTDIRECTORY *pDir;
+    OS2FONTDIRENTRY  *pEntry;
+    ULONG             cbDir,
+                      i;
+
+    cbDir = 6 + ( cFonts * sizeof( OS2FONTDIRENTRY ));
+    pDir  = (OS2FONTDIRECTORY *) calloc( cbDir, 1 );
+    if ( !pDir ) return NULL;
+    pDir->usHeaderSize = 6;
+    pDir->usnFonts     = cFonts;
+    pDir->usiMetrics   = sizeof( OS2FONTDIRENTRY );
+    for ( i = 0; i < cFonts; i++ ) {
+        pEntry = (OS2FONTDIRENTRY *)( (PBYTE) pDir + 6 + ( i * sizeof( OS2FONTDIRENTRY )));
+        pEntry->usIndex = FIRST_FACE_ID + i;
+        memcpy( &(pEntry->metrics), papFonts[ i ] + sizeof( OS2FONTSTART ), sizeof( OS2FOCAMETRICS ));
+    }
+    *pcbDir = cbDir;
+    return (PBYTE) pDir;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Build a GPI font with the given type of character definitions, glyph     *
+ * count and cell size.  The font covers codepoints 1 to cGlyphs, and has   *
+ * an empty glyph at the end for the .null character.  Returns the size of  *
+ * the font, or 0 if out of memory.                                         *
+ * ------------------------------------------------------------------------ */
+ULONG make_font( ULONG ulType, ULONG cGlyphs, ULONG cx, ULONG cy, PBYTE *ppFont )
+{
+    OS2FONTSTART     start;
+    OS2FOCAMETRICS   metrics;
+    OS2FONTDEFHEADER fontdef;
+    OS2CHARDEF1      def1;
+    OS2CHARDEF3      def3;
+    OS2ADDMETRICS    panose;
+    OS2FONTEND       end;
+    PBYTE            pFont,
+                     pDef,
+                     pBits;
+    ULONG            cDefs = cGlyphs + 1,
+                     cbDef = ( ulType == 3 ) ? sizeof( def3 ) : sizeof( def1 ),
+                     cbBits = 0,
+                     cbFont,
+                     ulWidth,
+                     i;
+    USHORT           ausWidths[ MAX_GLYPHS + 1 ];
+
+    for ( i = 0; i < cDefs; i++ ) {
+        ausWidths[ i ] = ( ulType == 1 ) ? cx : 1 + ( next_random() % cx );
+        cbBits += (( ausWidths[ i ] + 7 ) / 8 ) * cy;
+    }
+    cbFont = sizeof( start ) + sizeof( metrics ) + sizeof( fontdef ) + ( cDefs * cbDef ) +
+             cbBits + sizeof( panose ) + sizeof( end );
+    pFont = (PBYTE) calloc( cbFont, 1 );
+    if ( !pFont ) return 0;
+
+    memset( &start, 0, sizeof( start ));
+    start.Identity = SIG_OS2FONTSTART;
+    start.ulSize   = sizeof( start );
+    memcpy( start.achSignature, OS2FNT2_SIGNATURE, sizeof( OS2FNT2_SIGNATURE ));
+
+    memset( &metrics, 0, sizeof( metrics ));
+    metrics.Identity           = SIG_OS2METRICS;
+    metrics.ulSize             = sizeof( metrics );
+    sprintf( (char *) metrics.szFamilyname, "Synthetic");
+    sprintf( (char *) metrics.szFacename, "Synthetic Type %u", ulType );
+    metrics.usCodePage         = 850;
+    metrics.yEmHeight          = cy;
+    metrics.yXHeight           = cy / 2;
+    metrics.yMaxAscender       = cy - ( cy / 4 );
+    metrics.yMaxDescender      = cy / 4;
+    metrics.yLowerCaseAscent   = cy - ( cy / 4 );
+    metrics.yLowerCaseDescent  = cy / 4;
+    metrics.yInternalLeading   = cy / 8;
+    metrics.yExternalLeading   = 1;
+    metrics.xAveCharWidth      = ( ulType == 1 ) ? cx : ( cx + 1 ) / 2;
+    metrics.xMaxCharInc        = ( ulType == 3 ) ? cx + 2 : cx;
+    metrics.xEmInc             = cx;
+    metrics.yMaxBaselineExt    = cy;
+    metrics.usWeightClass      = 5000;
+    metrics.usWidthClass       = 5000;
+    metrics.xDeviceRes         = 96;
+    metrics.yDeviceRes         = 96;
+    metrics.usFirstChar        = 1;
+    metrics.usLastChar         = cGlyphs - 1;
+    metrics.usBreakChar        = ( cGlyphs > 31 ) ? 31 : 0;
+    metrics.usNominalPointSize = ( cy * 720 ) / 96;
+    metrics.usMinimumPointSize = metrics.usNominalPointSize;
+    metrics.usMaximumPointSize = metrics.usNominalPointSize;
+    metrics.fsTypeFlags        = ( ulType == 1 ) ? 1 : 0;
+    metrics.fsDefn             = 0x3FF0;
+    metrics.yUnderscoreSize    = 1;
+    metrics.yUnderscorePosition = 2;
+    metrics.yStrikeoutSize     = 1;
+    metrics.yStrikeoutPosition = cy / 3;
+
+    memset( &fontdef, 0, sizeof( fontdef ));
+    fontdef.Identity        = SIG_OS2FONTDEF;
+    fontdef.ulSize          = sizeof( fontdef ) + ( cDefs * cbDef ) + cbBits;
+    fontdef.fsFontdef       = ( ulType == 1 ) ? OS2FONTDEF_FONT1 :
+                              ( ulType == 2 ) ? OS2FONTDEF_FONT2 : OS2FONTDEF_FONT3;
+    fontdef.fsChardef       = ( ulType == 1 ) ? OS2FONTDEF_CHAR1 :
+                              ( ulType == 2 ) ? OS2FONTDEF_CHAR2 : OS2FONTDEF_CHAR3;
+    fontdef.usCellSize      = cbDef;
+    fontdef.xCellWidth      = cx;
+    fontdef.yCellHeight     = cy;
+    fontdef.xCellIncrement  = cx;
+    fontdef.xCellA          = 1;
+    fontdef.xCellB          = cx;
+    fontdef.xCellC          = 1;
+    fontdef.pCellBaseOffset = cy - ( cy / 4 );
+
+    pDef = pFont;
+    memcpy( pDef, &start, sizeof( start ));
+    pDef += sizeof( start );
+    memcpy( pDef, &metrics, sizeof( metrics ));
+    pDef += sizeof( metrics );
+    memcpy( pDef, &fontdef, sizeof( fontdef ));
+    pDef += sizeof( fontdef );
+    pBits = pDef + ( cDefs * cbDef );
+
+    for ( i = 0; i < cDefs; i++ ) {
+        ulWidth = ausWidths[ i ];
+        if ( ulType == 3 ) {
+            def3.ulOffset = pBits - pFont;
+            def3.aSpace   = next_random() % 3;
+            def3.bSpace   = ulWidth;
+            def3.cSpace   = next_random() % 3;
+            memcpy( pDef, &def3, sizeof( def3 ));
+        }
+        else {
+            def1.ulOffset = pBits - pFont;
+            def1.ulWidth  = ulWidth;
+            memcpy( pDef, &def1, sizeof( def1 ));
+        }
+        pDef += cbDef;
+        if ( i < cGlyphs )
+            draw_glyph( pBits, ulWidth, cy, next_random() );
+        pBits += (( ulWidth + 7 ) / 8 ) * cy;
+    }
+
+    panose.Identity = SIG_OS2ADDMETRICS;
+    panose.ulSize   = sizeof( panose );
+    memset( panose.panose, 0, sizeof( panose.panose ));
+    memcpy( pBits, &panose, sizeof( panose ));
+    pBits += sizeof( panose );
+    end.Identity = SIG_OS2FONTEND;
+    end.ulSize   = sizeof( end );
+    memcpy( pBits, &end, sizeof( end ));
+
+    *ppFont = pFont;
+    return cbFont;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Build an LX module holding the given fonts, one object per font plus one *
+ * for the font directory, with the object pages stored as requested (for   *
+ * PACK_MIXED, each page is stored in a randomly chosen way).  So that the  *
+ * corpus exercises every decoder, a packed page is kept even if it is no   *
+ * smaller than the original, as long as it still fits in a page.  Returns  *
+ * the size of the module (0 if out of memory), and the number of pages     *
+ * stored in each way.                                                      *
+ * ------------------------------------------------------------------------ */
+ULONG make_lx_module( PBYTE *papFonts, PULONG pacbFonts, ULONG cFonts, ULONG ulPacking, PBYTE *ppModule, PULONG pacPages )
+{
+    PBYTE       pDir;
+    LXHEADER   *plx_hd;
+    LXOTENTRY   lx_ote;
+    LXOPMENTRY  lx_opm;
+    LXRTENTRY   lx_rte;
+    PBYTE       apObjects[ FONT_TYPES + 1 ],
+                pModule,
+                pOut;
+    ULONG       acbObjects[ FONT_TYPES + 1 ],
+                cObjects = cFonts + 1,
+                cPages = 0,
+                cbDir,
+                cbHeaders,
+                cbModule,
+                ofData,
+                ofPage,
+                ulMode,
+                cb,
+                i, j;
+    BYTE        abPacked[ PAGE_SIZE ];
+    static const USHORT ausFlags[] = { OP32_VALID, OP32_ITERDATA, OP32_ITERDATA2 };
+
+    pDir = make_directory( papFonts, cFonts, &cbDir );
+    if ( !pDir ) return 0;
+    for ( i = 0; i < cFonts; i++ ) {
+        apObjects[ i ]  = papFonts[ i ];
+        acbObjects[ i ] = pacbFonts[ i ];
+        cPages += ( pacbFonts[ i ] + PAGE_SIZE - 1 ) / PAGE_SIZE;
+    }
+    apObjects[ cFonts ]  = pDir;
+    acbObjects[ cFonts ] = cbDir;
+    cPages += ( cbDir + PAGE_SIZE - 1 ) / PAGE_SIZE;
+
+    /* Lay out the headers and tables, then the page data at the next
+     * 16-byte boundary.  The pages are at most their unpacked size.
+     */
+    cbHeaders = STUB_SIZE + LX_HEADER_SIZE + ( cObjects * sizeof( LXOTENTRY )) +
+                ( cPages * sizeof( LXOPMENTRY )) + ( cObjects * sizeof( LXRTENTRY ));
+    ofData    = ( cbHeaders + 15 ) & ~15;
+    cbModule  = ofData + ( cPages * PAGE_SIZE );
+    pModule   = (PBYTE) calloc( cbModule, 1 );
+    if ( !pModule ) {
+        free( pDir );
+        return 0;
+    }
+
+    pModule[ 0 ] = 'M';
+    pModule[ 1 ] = 'Z';
+    cb = STUB_SIZE;
+    memcpy( pModule + EH_OFFSET_ADDRESS, &cb, 4 );
+    plx_hd = (LXHEADER *)( pModule + STUB_SIZE );
+    plx_hd->magic     = MAGIC_LX;
+    plx_hd->pageshift = 0;
+    plx_hd->obj_tbl   = LX_HEADER_SIZE;
+    plx_hd->objcnt    = cObjects;
+    plx_hd->objmap    = plx_hd->obj_tbl + ( cObjects * sizeof( LXOTENTRY ));
+    plx_hd->res_tbl   = plx_hd->objmap + ( cPages * sizeof( LXOPMENTRY ));
+    plx_hd->cres      = cObjects;
+    plx_hd->datapage  = ofData;
+
+    // Resources: the font directory, then the fonts
+    for ( i = 0; i < cObjects; i++ ) {
+        j = ( i + cFonts ) % cObjects;
+        lx_rte.type   = j < cFonts ? OS2RES_FONTFACE : OS2RES_FONTDIR;
+        lx_rte.name   = j < cFonts ? FIRST_FACE_ID + j : 1;
+        lx_rte.cb     = acbObjects[ j ];
+        lx_rte.obj    = j + 1;
+        lx_rte.offset = 0;
+        memcpy( pModule + STUB_SIZE + plx_hd->res_tbl + ( i * sizeof( LXRTENTRY )),
+                &lx_rte, sizeof( LXRTENTRY ));
+    }
+
+    // Objects and their pages
+    memset( pacPages, 0, 3 * sizeof( ULONG ));
+    pOut   = pModule + ofData;
+    ofPage = 0;
+    for ( i = 0; i < cObjects; i++ ) {
+        lx_ote.size     = acbObjects[ i ];
+        lx_ote.base     = 0x10000 * ( i + 1 );
+        lx_ote.flags    = 0x2001;
+        lx_ote.pagemap  = ofPage + 1;
+        lx_ote.mapsize  = ( acbObjects[ i ] + PAGE_SIZE - 1 ) / PAGE_SIZE;
+        lx_ote.reserved = 0;
+        memcpy( pModule + STUB_SIZE + plx_hd->obj_tbl + ( i * sizeof( LXOTENTRY )),
+                &lx_ote, sizeof( LXOTENTRY ));
+        for ( j = 0; j < lx_ote.mapsize; j++, ofPage++ ) {
+            cb = acbObjects[ i ] - ( j * PAGE_SIZE );
+            if ( cb > PAGE_SIZE ) cb = PAGE_SIZE;
+            ulMode = ( ulPacking == PACK_MIXED ) ? next_random() % 3 : ulPacking;
+            lx_opm.size = cb;
+            if ( ulMode == PACK_ITER1 )
+                lx_opm.size = PackOS2ObjectPage( apObjects[ i ] + ( j * PAGE_SIZE ), cb,
+                                                 OS2PACK_EXEPACK1, abPacked );
+            else if ( ulMode == PACK_ITER2 )
+                lx_opm.size = PackOS2ObjectPage( apObjects[ i ] + ( j * PAGE_SIZE ), cb,
+                                                 OS2PACK_EXEPACK2, abPacked );
+            if (( ulMode == PACK_VALID ) || !lx_opm.size ) {
+                ulMode      = PACK_VALID;
+                lx_opm.size = cb;
+                memcpy( pOut, apObjects[ i ] + ( j * PAGE_SIZE ), cb );
+            }
+            else
+                memcpy( pOut, abPacked, lx_opm.size );
+            lx_opm.dataoffset = pOut - ( pModule + ofData );
+            lx_opm.flags      = ausFlags[ ulMode ];
+            memcpy( pModule + STUB_SIZE + plx_hd->objmap + ( ofPage * sizeof( LXOPMENTRY )),
+                    &lx_opm, sizeof( LXOPMENTRY ));
+            pOut += lx_opm.size;
+            pacPages[ ulMode ]++;
+        }
+    }
+
+    free( pDir );
+    *ppModule = pModule;
+    return pOut - pModule;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Build an NE module holding the given fonts.  Each resource has a segment *
+ * of its own: the font directory comes first, then the fonts.  Returns the *
+ * size of the module, or 0 if out of memory or a font is too large for a   *
+ * segment.                                                                 *
+ * ------------------------------------------------------------------------ */
+ULONG make_ne_module( PBYTE *papFonts, PULONG pacbFonts, ULONG cFonts, PBYTE *ppModule )
+{
+    PNEHEADER  pne_hd;
+    NESTENTRY  ne_seg;
+    NERTENTRY  ne_rte;
+    PBYTE      apRes[ FONT_TYPES + 1 ],
+               pModule,
+               pDir;
+    ULONG      acbRes[ FONT_TYPES + 1 ],
+               cRes = cFonts + 1,
+               cbDir,
+               cbModule,
+               ofData,
+               i;
+
+    pDir = make_directory( papFonts, cFonts, &cbDir );
+    if ( !pDir ) return 0;
+    apRes[ 0 ]  = pDir;
+    acbRes[ 0 ] = cbDir;
+    for ( i = 0; i < cFonts; i++ ) {
+        apRes[ i + 1 ]  = papFonts[ i ];
+        acbRes[ i + 1 ] = pacbFonts[ i ];
+    }
+
+    /* The segment table, resource table and (empty) resident-names table
+     * follow the header; the segments start at the next 16-byte boundary,
+     * and are aligned to 16 bytes (a segment shift of 4).
+     */
+    ofData   = ( STUB_SIZE + NE_HEADER_SIZE + ( cRes * sizeof( NESTENTRY )) +
+                 ( cRes * sizeof( NERTENTRY )) + 1 + 15 ) & ~15;
+    cbModule = ofData;
+    for ( i = 0; i < cRes; i++ ) {
+        if ( acbRes[ i ] > 0xFFFF ) {
+            free( pDir );
+            return 0;
+        }
+        cbModule += ( acbRes[ i ] + 15 ) & ~15;
+    }
+    if (( cbModule >> 4 ) > 0xFFFF ) {
+        free( pDir );
+        return 0;
+    }
+    pModule = (PBYTE) calloc( cbModule, 1 );
+    if ( !pModule ) {
+        free( pDir );
+        return 0;
+    }
+
+    pModule[ 0 ] = 'M';
+    pModule[ 1 ] = 'Z';
+    i = STUB_SIZE;
+    memcpy( pModule + EH_OFFSET_ADDRESS, &i, 4 );
+    pne_hd = (PNEHEADER)( pModule + STUB_SIZE );
+    pne_hd->magic    = MAGIC_NE;
+    pne_hd->cseg     = cRes;
+    pne_hd->seg_tbl  = NE_HEADER_SIZE;
+    pne_hd->res_tbl  = pne_hd->seg_tbl + ( cRes * sizeof( NESTENTRY ));
+    pne_hd->rnam_tbl = pne_hd->res_tbl + ( cRes * sizeof( NERTENTRY ));
+    pne_hd->segshift = 4;
+    pne_hd->cres     = cRes;
+
+    for ( i = 0; i < cRes; i++ ) {
+        ne_seg.offset   = ofData >> 4;
+        ne_seg.cb       = acbRes[ i ];
+        ne_seg.flags    = 0x0001;               /* data segment */
+        ne_seg.minalloc = acbRes[ i ];
+        memcpy( pModule + STUB_SIZE + pne_hd->seg_tbl + ( i * sizeof( NESTENTRY )),
+                &ne_seg, sizeof( NESTENTRY ));
+        ne_rte.etype = i ? OS2RES_FONTFACE : OS2RES_FONTDIR;
+        ne_rte.ename = i ? FIRST_FACE_ID + i - 1 : 1;
+        memcpy( pModule + STUB_SIZE + pne_hd->res_tbl + ( i * sizeof( NERTENTRY )),
+                &ne_rte, sizeof( NERTENTRY ));
+        memcpy( pModule + ofData, apRes[ i ], acbRes[ i ] );
+        ofData += ( acbRes[ i ] + 15 ) & ~15;
+    }
+
+    free( pDir );
+    *ppModule = pModule;
+    return cbModule;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * A simple linear congruential generator, so that the same seed always     *
+ * produces the same corpus.                                                *
+ * ------------------------------------------------------------------------ */
+ULONG next_random( void )
+{
+    ulSeed = ( ulSeed * 1103515245 ) + 12345;
+    return ( ulSeed >> 16 ) & 0x7FFF;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Write a buffer to a new file.  Returns TRUE on success.                  *
+ * ------------------------------------------------------------------------ */
+BOOL write_file( PSZ pszFile, PBYTE pData, ULONG cb )
+{
+    FILE *pf;
+    BOOL  fOK;
+
+    pf = fopen( pszFile, "wb");
+    if ( !pf ) {
+        fprintf( stderr, "Failed to create file %s.\n", pszFile );
+        return FALSE;
+    }
+    fOK = ( fwrite( pData, 1, cb, pf ) == cb );
+    if ( fclose( pf ) || !fOK ) {
+        fprintf( stderr, "Failed to write file %s.\n", pszFile );
+        return FALSE;
+    }
+    return TRUE;
+}
@@ -0,0 +1,212 @@
+/*****************************************************************************
+ *                                                                           *
+ * kernbench.c                                                               *
+ *                                                                           *
+ * Microbenchmark for kerned text layout.  Since fonts with kerning tables   *
+ * are rare, this adds a synthetic kerning table (pairs of ASCII letters) to *
+ * a copy of the given font, checks that every pair is found by the kerning  *
+ * index and that kerned text measures as expected, and then reports the     *
+ * throughput of measuring and drawing text with and without kerning.        *
+ *                                                                           *
+ *  (C) 2023 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "otypes.h"
+#include "gpifont.h"
+
+#define MIN_SECONDS     1.0
+#define SURFACE_CX      1024
+#define SURFACE_CY      64
+
+static const char szSample[] = "AVAST! Type WAVY, Yolk, To Tell Lovely Yarns: "
+                               "the quick brown fox jumps over the lazy dog.";
+
+/* Local function prototypes */
+ULONG  add_kerning( POS2FONTRESOURCE pFont, POS2FONTRESOURCE pKerned );
+LONG   kern_amount( ULONG c1, ULONG c2 );
+double time_layout( POS2FONTRESOURCE pFont, POS2TEXTSURFACE pSurface, ULONG ulFlags, PULONG pulRuns );
+
+
+/* ------------------------------------------------------------------------ */
+int main( int argc, char *argv[] )
+{
+    OS2FONTRESOURCE font,
+                    kerned;
+    OS2TEXTSURFACE  surface;
+    ULONG           aulGlyphs[ sizeof( szSample ) ],
+                    cGlyphs,
+                    cFonts,
+                    cPairs,
+                    ulRuns,
+                    c1, c2,
+                    i, t;
+    LONG            lExpected,
+                    lWidth;
+    double          dElapsed;
+    static const ULONG aulFlags[] = { OS2TEXT_UTF8, OS2TEXT_UTF8 | OS2TEXT_KERNING };
+
+
+    if ( argc < 2 ) {
+        printf("KERNBENCH <font file> [<face>]\n\n");
+        printf("Times kerned and unkerned text layout in the given font, after adding a\n");
+        printf("synthetic kerning table to it.\n");
+        return 0;
+    }
+    if ( ReadOS2FontResource( argv[ 1 ], ( argc > 2 ) ? atoi( argv[ 2 ] ) : 0, &cFonts, &font )) {
+        fprintf( stderr, "Failed to read a font from %s.\n", argv[ 1 ] );
+        return 1;
+    }
+    cPairs = add_kerning( &font, &kerned );
+    if ( !cPairs ) {
+        fprintf( stderr, "Failed to add a kerning table to the font.\n");
+        return 1;
+    }
+    printf("%s: %u kerning pairs added.\n", font.pMetrics->szFacename, cPairs );
+
+    // Verify every pair of glyph indices (other than 0) against the table
+    for ( c1 = 1; c1 < 256; c1++ ) {
+        for ( c2 = 1; c2 < 256; c2++ ) {
+            if ( OS2FontKerning( &kerned, c1, c2 ) != kern_amount( c1, c2 )) {
+                fprintf( stderr, "Wrong kerning amount for pair %u,%u.\n", c1, c2 );
+                return 2;
+            }
+        }
+    }
+    cGlyphs = OS2FontGlyphIndices( &kerned, (PVOID) szSample, strlen( szSample ),
+                                   OS2TEXT_UTF8, aulGlyphs, sizeof( szSample ), NULL );
+    lExpected = MeasureOS2FontText( &kerned, (PVOID) szSample, strlen( szSample ), OS2TEXT_UTF8 );
+    for ( i = 1; i < cGlyphs; i++ )
+        lExpected += kern_amount( aulGlyphs[ i - 1 ], aulGlyphs[ i ] );
+    lWidth = MeasureOS2FontText( &kerned, (PVOID) szSample, strlen( szSample ),
+                                 OS2TEXT_UTF8 | OS2TEXT_KERNING );
+    if ( lWidth != lExpected ) {
+        fprintf( stderr, "Kerned width is %d, expected %d.\n", lWidth, lExpected );
+        return 2;
+    }
+    printf("Kerning index verified; sample text is %d pels wide (%d unkerned).\n\n",
+           lWidth, MeasureOS2FontText( &kerned, (PVOID) szSample, strlen( szSample ), OS2TEXT_UTF8 ));
+
+    surface.cx      = SURFACE_CX;
+    surface.cy      = SURFACE_CY;
+    surface.ulDepth = 1;
+    surface.ulPitch = SURFACE_CX / 8;
+    surface.bColor  = 1;
+    surface.pBits   = (PBYTE) calloc( surface.ulPitch, surface.cy );
+    if ( !surface.pBits ) return 1;
+
+    for ( t = 0; t < 2; t++ ) {
+        for ( i = 0; i < 2; i++ ) {
+            dElapsed = time_layout( &kerned, t ? &surface : NULL, aulFlags[ i ], &ulRuns );
+            printf("%-7s %-8s : %12.0f glyphs/s\n", t ? "render" : "measure",
+                   i ? "kerned" : "unkerned", ( ulRuns * (double) cGlyphs ) / dElapsed );
+        }
+    }
+
+    free( surface.pBits );
+    FreeOS2FontResource( &kerned );
+    FreeOS2FontResource( &font );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Make a copy of a font with a kerning table holding every pair of glyphs  *
+ * for which kern_amount() is nonzero, and parse it.  Returns the number of *
+ * pairs, or 0 on error.                                                    *
+ * ------------------------------------------------------------------------ */
+ULONG add_kerning( POS2FONTRESOURCE pFont, POS2FONTRESOURCE pKerned )
+{
+    OS2KERNPAIRTABLE kern;
+    OS2KERNINGPAIRS  pair;
+    OS2FONTEND       end;
+    POS2FOCAMETRICS  pMetrics;
+    PBYTE            pBuf,
+                     p;
+    ULONG            cbFonts,
+                     cPairs = 0,
+                     c1, c2;
+
+    cbFonts = ( (PBYTE) pFont->pFontDef + pFont->pFontDef->ulSize ) - (PBYTE) pFont->pSignature;
+    for ( c1 = 0; c1 < 256; c1++ )
+        for ( c2 = 0; c2 < 256; c2++ )
+            if ( kern_amount( c1, c2 )) cPairs++;
+
+    pBuf = (PBYTE) malloc( cbFonts + sizeof( kern ) + ( cPairs * sizeof( pair )) + sizeof( end ));
+    if ( !pBuf ) return 0;
+    memcpy( pBuf, pFont->pSignature, cbFonts );
+    p = pBuf + cbFonts;
+
+    kern.Identity   = SIG_OS2KERN;
+    kern.ulSize     = 10;
+    kern.cFirstpair = 0;
+    memcpy( p, &kern, sizeof( kern ));
+    p += sizeof( kern );
+    for ( c1 = 0; c1 < 256; c1++ ) {
+        for ( c2 = 0; c2 < 256; c2++ ) {
+            if ( !kern_amount( c1, c2 )) continue;
+            pair.sFirstChar     = c1;
+            pair.sSecondChar    = c2;
+            pair.sKerningAmount = kern_amount( c1, c2 );
+            memcpy( p, &pair, sizeof( pair ));
+            p += sizeof( pair );
+        }
+    }
+    end.Identity = SIG_OS2FONTEND;
+    end.ulSize   = sizeof( end );
+    memcpy( p, &end, sizeof( end ));
+    p += sizeof( end );
+
+    pMetrics = (POS2FOCAMETRICS)( pBuf + ( (PBYTE) pFont->pMetrics - (PBYTE) pFont->pSignature ));
+    pMetrics->usKerningPairs = cPairs;
+    if ( ParseOS2FontResource( pBuf, p - pBuf, pKerned ) || !pKerned->pKernIndex ) {
+        free( pBuf );
+        return 0;
+    }
+    return cPairs;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * The synthetic kerning amount between two glyphs: uppercase letters are   *
+ * kerned against about a third of the letters which may follow them.      *
+ * ------------------------------------------------------------------------ */
+LONG kern_amount( ULONG c1, ULONG c2 )
+{
+    if (( c1 < 'A' ) || ( c1 > 'Z' )) return 0;
+    if ((( c2 < 'A' ) || ( c2 > 'Z' )) && (( c2 < 'a' ) || ( c2 > 'z' ))) return 0;
+    if ((( c1 * 7 ) + c2 ) % 3 ) return 0;
+    return -1 - ( LONG )(( c1 + c2 ) % 2 );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Measure the text repeatedly (or draw it, if a surface is given) for at   *
+ * least MIN_SECONDS, and return the elapsed time in seconds.               *
+ * ------------------------------------------------------------------------ */
+double time_layout( POS2FONTRESOURCE pFont, POS2TEXTSURFACE pSurface, ULONG ulFlags, PULONG pulRuns )
+{
+    clock_t start;
+    double  dElapsed;
+    LONG    lTotal = 0;
+
+    *pulRuns = 0;
+    start = clock();
+    do {
+        if ( pSurface )
+            lTotal += RenderOS2FontText( pFont, (PVOID) szSample, strlen( szSample ),
+                                         ulFlags, pSurface, 0, pFont->pFontDef->pCellBaseOffset );
+        else
+            lTotal += MeasureOS2FontText( pFont, (PVOID) szSample, strlen( szSample ), ulFlags );
+        (*pulRuns)++;
+        dElapsed = (double)( clock() - start ) / CLOCKS_PER_SEC;
+    } while ( dElapsed < MIN_SECONDS );
+    if ( !lTotal ) printf("(empty text)\n");
+    return dElapsed;
+}
@@ -0,0 +1,314 @@
+/*****************************************************************************
+ *                                                                           *
+ * packbench.c                                                               *
+ *                                                                           *
+ * Benchmark for the EXEPACK page encoders (PackOS2ObjectPage).  Every font  *
+ * in the given files (or in the files in the given directories, such as a   *
+ * corpus written by fontgen) is split into 4 KiB object pages, as it would  *
+ * be stored in an LX module, and each distinct font is packed once with     *
+ * every method.  Each packed page is first checked by unpacking it with     *
+ * the decoders which the parser uses (LXUnpack1 and LXDecodePage2).  The    *
+ * compression ratio counts a page which doesn't shrink at its unpacked size *
+ * (since that is how a module writer would store it), and the throughput is *
+ * in megabytes of unpacked data per second.                                 *
+ *                                                                           *
+ *  (C) 2023 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include "otypes.h"
+#include "gpifont.h"
+
+#define PAGE_SIZE       4096
+#define MIN_SECONDS     1.0         /* per method */
+
+/* A page of font data to be packed */
+typedef struct _Font_Page {
+    PBYTE  pData;
+    ULONG  cb;
+} FONTPAGE, *PFONTPAGE;
+
+/* A packing method under test */
+typedef struct _Pack_Method {
+    PSZ    pszName;
+    ULONG  ulMethod;
+} PACKMETHOD;
+
+/* The decoders (internal to gpifont.c) */
+USHORT LXDecodePage2( PBYTE pOut, PBYTE pIn, USHORT cbIn );
+USHORT LXUnpack1( PBYTE pBuf, USHORT cbPage );
+
+/* Local function prototypes */
+ULONG  add_input( PSZ pszPath, PSZ **pppszFiles, PULONG pcFiles );
+ULONG  add_pages( POS2FONTRESOURCE pFont, PFONTPAGE *ppPages, PULONG pcPages, PULONG pcAlloc );
+int    compare_names( const void *p1, const void *p2 );
+ULONG  read_fonts( PSZ pszFile, POS2FONTRESOURCE *ppFonts, PULONG pcFonts, PFONTPAGE *ppPages, PULONG pcPages, PULONG pcAlloc );
+double time_method( const PACKMETHOD *pMethod, PFONTPAGE pPages, ULONG cPages, PULONG pulPasses );
+ULONG  verify_method( const PACKMETHOD *pMethod, PFONTPAGE pPages, ULONG cPages, double *pdPacked, PULONG pcPacked );
+
+static const PACKMETHOD aMethods[] = {
+    { "exepack1",      OS2PACK_EXEPACK1                },
+    { "exepack1-best", OS2PACK_EXEPACK1 | OS2PACK_BEST },
+    { "exepack2",      OS2PACK_EXEPACK2                },
+    { "exepack2-best", OS2PACK_EXEPACK2 | OS2PACK_BEST }
+};
+
+
+/* ------------------------------------------------------------------------ */
+int main( int argc, char *argv[] )
+{
+    POS2FONTRESOURCE paFonts = NULL;
+    PFONTPAGE        pPages  = NULL;
+    PSZ             *ppszFiles = NULL;
+    ULONG            cFiles = 0,
+                     cFonts = 0,
+                     cPages = 0,
+                     cAlloc = 0,
+                     cPacked,
+                     cBad = 0,
+                     ulPasses,
+                     i;
+    double           dBytes = 0,
+                     dPacked,
+                     dElapsed;
+    int              a;
+
+
+    if ( argc < 2 ) {
+        printf("PACKBENCH <file|directory> [<file|directory> ...]\n\n");
+        printf("Packs every distinct font in the given font files (or in every file in the\n");
+        printf("given directories) as 4 KiB LX object pages, using each EXEPACK method, and\n");
+        printf("reports the compression ratio and throughput of each.\n");
+        return 0;
+    }
+    for ( a = 1; a < argc; a++ )
+        if ( add_input( argv[ a ], &ppszFiles, &cFiles ))
+            fprintf( stderr, "Failed to read %s.\n", argv[ a ] );
+    for ( i = 0; i < cFiles; i++ ) {
+        if ( read_fonts( ppszFiles[ i ], &paFonts, &cFonts, &pPages, &cPages, &cAlloc ))
+            fprintf( stderr, "%s: no fonts could be read.\n", ppszFiles[ i ] );
+        free( ppszFiles[ i ] );
+    }
+    free( ppszFiles );
+    if ( !cPages ) {
+        fprintf( stderr, "No fonts found.\n");
+        return 1;
+    }
+    for ( i = 0; i < cPages; i++ ) dBytes += pPages[ i ].cb;
+
+    printf("%u distinct fonts, %u pages, %.0f bytes\n\n", cFonts, cPages, dBytes );
+    printf("Method          Packed pages   Packed bytes   Ratio       MB/s\n");
+    for ( i = 0; i < sizeof( aMethods ) / sizeof( aMethods[ 0 ] ); i++ ) {
+        if ( verify_method( aMethods + i, pPages, cPages, &dPacked, &cPacked )) {
+            cBad++;
+            continue;
+        }
+        dElapsed = time_method( aMethods + i, pPages, cPages, &ulPasses );
+        printf("%-15s %12u %14.0f %6.1f%% %10.2f\n", aMethods[ i ].pszName, cPacked, dPacked,
+               ( dPacked * 100 ) / dBytes, ( dBytes * ulPasses ) / ( dElapsed * 1048576.0 ));
+    }
+
+    for ( i = 0; i < cFonts; i++ ) FreeOS2FontResource( paFonts + i );
+    free( paFonts );
+    free( pPages );
+    return cBad ? 2 : 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Add a file, or every file in a directory, to the input list.  Returns 0  *
+ * on success, or 1 if the path cannot be read.                             *
+ * ------------------------------------------------------------------------ */
+ULONG add_input( PSZ pszPath, PSZ **pppszFiles, PULONG pcFiles )
+{
+    struct stat    st;
+    struct dirent *pEntry;
+    DIR           *pDir;
+    PSZ           *ppsz,
+                   pszFile;
+    ULONG          cFirst = *pcFiles;
+
+    if ( stat( pszPath, &st )) return 1;
+    if ( !S_ISDIR( st.st_mode )) {
+        ppsz = (PSZ *) realloc( *pppszFiles, ( *pcFiles + 1 ) * sizeof( PSZ ));
+        if ( !ppsz ) return 1;
+        *pppszFiles = ppsz;
+        ppsz[ (*pcFiles)++ ] = strdup( pszPath );
+        return 0;
+    }
+
+    pDir = opendir( pszPath );
+    if ( !pDir ) return 1;
+    while (( pEntry = readdir( pDir )) != NULL ) {
+        if ( pEntry->d_name[ 0 ] == '.') continue;
+        pszFile = (PSZ) malloc( strlen( pszPath ) + strlen( pEntry->d_name ) + 2 );
+        if ( !pszFile ) break;
+        sprintf( pszFile, "%s/%s", pszPath, pEntry->d_name );
+        if ( stat( pszFile, &st ) || !S_ISREG( st.st_mode )) {
+            free( pszFile );
+            continue;
+        }
+        ppsz = (PSZ *) realloc( *pppszFiles, ( *pcFiles + 1 ) * sizeof( PSZ ));
+        if ( !ppsz ) {
+            free( pszFile );
+            break;
+        }
+        *pppszFiles = ppsz;
+        ppsz[ (*pcFiles)++ ] = pszFile;
+    }
+    closedir( pDir );
+
+    // Directory order is arbitrary, so sort the files for repeatable output
+    if ( *pcFiles > cFirst )
+        qsort( *pppszFiles + cFirst, *pcFiles - cFirst, sizeof( PSZ ), compare_names );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Add the pages of a font's data to the page list.  Returns 0 on success,  *
+ * or 1 if out of memory.                                                   *
+ * ------------------------------------------------------------------------ */
+ULONG add_pages( POS2FONTRESOURCE pFont, PFONTPAGE *ppPages, PULONG pcPages, PULONG pcAlloc )
+{
+    PFONTPAGE pPages;
+    ULONG     cNew = ( pFont->cbSize + PAGE_SIZE - 1 ) / PAGE_SIZE,
+              i;
+
+    if (( *pcPages + cNew ) > *pcAlloc ) {
+        pPages = (PFONTPAGE) realloc( *ppPages, ( *pcPages + cNew + 64 ) * sizeof( FONTPAGE ));
+        if ( !pPages ) return 1;
+        *ppPages = pPages;
+        *pcAlloc = *pcPages + cNew + 64;
+    }
+    for ( i = 0; i < cNew; i++ ) {
+        (*ppPages)[ *pcPages ].pData = (PBYTE) pFont->pSignature + ( i * PAGE_SIZE );
+        (*ppPages)[ *pcPages ].cb    = ( i < ( cNew - 1 )) ? PAGE_SIZE :
+                                       pFont->cbSize - ( i * PAGE_SIZE );
+        (*pcPages)++;
+    }
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * qsort() comparison function for file names.                              *
+ * ------------------------------------------------------------------------ */
+int compare_names( const void *p1, const void *p2 )
+{
+    return strcmp( *(PSZ *) p1, *(PSZ *) p2 );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Read every font in a file into memory, and add the pages of any which    *
+ * have not been seen already (the same fonts are stored in several ways in *
+ * a fontgen corpus) to the page list.  Returns 0 on success, or an ERR_*   *
+ * code if no fonts could be read.                                          *
+ * ------------------------------------------------------------------------ */
+ULONG read_fonts( PSZ pszFile, POS2FONTRESOURCE *ppFonts, PULONG pcFonts, PFONTPAGE *ppPages, PULONG pcPages, PULONG pcAlloc )
+{
+    POS2FONTRESOURCE pFonts,
+                     pFont;
+    ULONG            cFaces = 1,
+                     ulRC,
+                     c, i, j;
+
+    for ( i = 0; i < cFaces; i++ ) {
+        pFonts = (POS2FONTRESOURCE) realloc( *ppFonts, ( *pcFonts + 1 ) * sizeof( OS2FONTRESOURCE ));
+        if ( !pFonts ) return ERR_MEMORY;
+        *ppFonts = pFonts;
+        pFont    = pFonts + *pcFonts;
+        ulRC = ReadOS2FontResource( pszFile, i, &c, pFont );
+        if ( ulRC ) return i ? 0 : ulRC;
+        if ( !i ) cFaces = c;
+
+        for ( j = 0; j < *pcFonts; j++ )
+            if (( pFonts[ j ].cbSize == pFont->cbSize ) &&
+                !memcmp( pFonts[ j ].pSignature, pFont->pSignature, pFont->cbSize ))
+                break;
+        if ( j < *pcFonts ) {
+            FreeOS2FontResource( pFont );
+            continue;
+        }
+        if ( add_pages( pFont, ppPages, pcPages, pcAlloc )) {
+            FreeOS2FontResource( pFont );
+            return ERR_MEMORY;
+        }
+        (*pcFonts)++;
+    }
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Pack every page repeatedly with the given method for at least            *
+ * MIN_SECONDS.  Returns the time taken, and the number of passes made over *
+ * the pages.                                                               *
+ * ------------------------------------------------------------------------ */
+double time_method( const PACKMETHOD *pMethod, PFONTPAGE pPages, ULONG cPages, PULONG pulPasses )
+{
+    BYTE    abPacked[ PAGE_SIZE ];
+    clock_t start;
+    double  dElapsed;
+    ULONG   i;
+
+    *pulPasses = 0;
+    start = clock();
+    do {
+        for ( i = 0; i < cPages; i++ )
+            PackOS2ObjectPage( pPages[ i ].pData, pPages[ i ].cb, pMethod->ulMethod, abPacked );
+        (*pulPasses)++;
+        dElapsed = (double)( clock() - start ) / CLOCKS_PER_SEC;
+    } while ( dElapsed < MIN_SECONDS );
+    return dElapsed;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Pack every page once with the given method, and check that unpacking     *
+ * each one gives back the original data.  Returns 0 if all of them do, and *
+ * the total size of the pages as they would be stored in a module, along   *
+ * with the number which are stored packed.                                 *
+ * ------------------------------------------------------------------------ */
+ULONG verify_method( const PACKMETHOD *pMethod, PFONTPAGE pPages, ULONG cPages, double *pdPacked, PULONG pcPacked )
+{
+    BYTE  abPacked[ PAGE_SIZE ],
+          abPage[ PAGE_SIZE ];
+    ULONG cb,
+          i;
+
+    *pdPacked = 0;
+    *pcPacked = 0;
+    for ( i = 0; i < cPages; i++ ) {
+        cb = PackOS2ObjectPage( pPages[ i ].pData, pPages[ i ].cb, pMethod->ulMethod, abPacked );
+        if ( !cb || ( cb >= pPages[ i ].cb )) {
+            *pdPacked += pPages[ i ].cb;
+            continue;
+        }
+        memset( abPage, 0xFF, PAGE_SIZE );
+        if ( pMethod->ulMethod & OS2PACK_EXEPACK2 )
+            LXDecodePage2( abPage, abPacked, cb );
+        else {
+            memcpy( abPage, abPacked, cb );
+            LXUnpack1( abPage, cb );
+        }
+        if ( memcmp( abPage, pPages[ i ].pData, pPages[ i ].cb )) {
+            fprintf( stderr, "%s: page %u does not unpack to the original data.\n",
+                     pMethod->pszName, i );
+            return 1;
+        }
+        *pdPacked += cb;
+        (*pcPacked)++;
+    }
+    return 0;
+}
@@ -0,0 +1,718 @@
+/*****************************************************************************
+ *                                                                           *
+ * parsebench.c                                                              *
+ *                                                                           *
+ * Benchmark harness for every stage of the font parser, from reading and    *
+ * mapping font files through page unpacking and resource parsing to glyph   *
+ * lookup, extraction and text layout.  Each stage is run on every font file *
+ * given (or found in the given directories, such as a corpus written by     *
+ * fontgen) after checking that the different ways of loading a font agree.  *
+ * The results are written to standard output as CSV, one row per stage and  *
+ * file, giving the time per operation, the throughput in bytes per second   *
+ * (where the stage has a natural byte count) and the number of heap         *
+ * allocations per operation (where the build supports counting them).       *
+ *                                                                           *
+ *  (C) 2023 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include "otypes.h"
+#include "gpifont.h"
+#include "os2res.h"
+
+#define PAGE_SIZE       4096
+#define MIN_SECONDS     0.2         /* per stage and file */
+#define SURFACE_CX      1024
+#define SURFACE_CY      64
+#define INDEX_CHARS     1024        /* codepoints looked up by glyph_index */
+
+#define WORDFROMBYTES( b1, b2 )         ( b1 | (b2 << 8) )
+
+static const char szSample[] = "The quick brown fox jumps over the lazy dog; "
+                               "PACK MY BOX WITH FIVE DOZEN LIQUOR JUGS (0123456789).";
+
+/* A packed page collected from a module */
+typedef struct _Packed_Page {
+    PBYTE  pData;
+    USHORT cb;
+} PACKEDPAGE, *PPACKEDPAGE;
+
+/* Everything the stages need to know about one input file */
+typedef struct _Bench_Input {
+    PSZ              pszFile;       /* name of the file                  */
+    POS2FILEMAP      pMap;          /* the mapped file                   */
+    ULONG            cFaces;        /* number of fonts in the file       */
+    POS2FONTRESOURCE paFonts;       /* every font, read into memory      */
+    PBYTE            pCopy;         /* scratch buffer for parsing        */
+    PBYTE            pGlyph;        /* buffer for the largest glyph      */
+    ULONG            cbGlyph;       /* size of pGlyph                    */
+    PPACKEDPAGE      paPages[ 2 ];  /* EXEPACK1 and EXEPACK2 pages       */
+    ULONG            acPages[ 2 ];  /* number of pages in each array     */
+    OS2TEXTSURFACE   surface;       /* render target                     */
+} BENCHINPUT, *PBENCHINPUT;
+
+/* A single run of a stage; returns the number of operations performed and
+ * adds the number of bytes processed to *pdBytes.
+ */
+typedef ULONG ( *PFNSTAGE )( PBENCHINPUT pInput, double *pdBytes );
+
+/* A parser stage */
+typedef struct _Bench_Stage {
+    PSZ      pszName;
+    PSZ      pszUnit;
+    PFNSTAGE pfnRun;
+    BOOL     fBytes;                /* TRUE if bytes/s is meaningful     */
+} BENCHSTAGE;
+
+/* The unpackers under test (internal to gpifont.c) */
+USHORT LXDecodePage2( PBYTE pOut, PBYTE pIn, USHORT cbIn );
+USHORT LXUnpack1( PBYTE pBuf, USHORT cbPage );
+
+/* Local function prototypes */
+ULONG add_input( PSZ pszPath, PSZ **pppszFiles, PULONG pcFiles );
+ULONG collect_pages( PBENCHINPUT pInput );
+int   compare_names( const void *p1, const void *p2 );
+void  free_input( PBENCHINPUT pInput );
+ULONG open_input( PSZ pszFile, PBENCHINPUT pInput );
+ULONG run_atlas( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_extract( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_extract_into( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_glyph_index( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_map( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_measure( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_module_faces( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_module_open( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_parse( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_read( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_render( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_unpack1( PBENCHINPUT pInput, double *pdBytes );
+ULONG run_unpack2( PBENCHINPUT pInput, double *pdBytes );
+void  time_stage( const BENCHSTAGE *pStage, PBENCHINPUT pInput );
+ULONG verify_input( PBENCHINPUT pInput );
+
+static const BENCHSTAGE aStages[] = {
+    { "read",         "face",  run_read,         TRUE  },
+    { "map",          "face",  run_map,          TRUE  },
+    { "module_open",  "file",  run_module_open,  TRUE  },
+    { "module_faces", "face",  run_module_faces, TRUE  },
+    { "unpack1",      "page",  run_unpack1,      TRUE  },
+    { "unpack2",      "page",  run_unpack2,      TRUE  },
+    { "parse",        "face",  run_parse,        TRUE  },
+    { "glyph_index",  "char",  run_glyph_index,  FALSE },
+    { "extract",      "glyph", run_extract,      TRUE  },
+    { "extract_into", "glyph", run_extract_into, TRUE  },
+    { "atlas",        "face",  run_atlas,        TRUE  },
+    { "measure",      "char",  run_measure,      FALSE },
+    { "render",       "char",  run_render,       FALSE }
+};
+
+
+#ifdef COUNT_ALLOCS
+/* When linked with --wrap for the allocation functions, every allocation
+ * made by the parser (or by this program) passes through here.
+ */
+static ULONG ulAllocs = 0;
+
+void *__real_malloc( size_t cb );
+void *__real_calloc( size_t c, size_t cb );
+void *__real_realloc( void *p, size_t cb );
+char *__real_strdup( const char *psz );
+
+void *__wrap_malloc( size_t cb )            { ulAllocs++; return __real_malloc( cb ); }
+void *__wrap_calloc( size_t c, size_t cb )  { ulAllocs++; return __real_calloc( c, cb ); }
+void *__wrap_realloc( void *p, size_t cb )  { ulAllocs++; return __real_realloc( p, cb ); }
+char *__wrap_strdup( const char *psz )      { ulAllocs++; return __real_strdup( psz ); }
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+int main( int argc, char *argv[] )
+{
+    BENCHINPUT input;
+    PSZ       *ppszFiles = NULL;
+    ULONG      cFiles = 0,
+               cBad   = 0,
+               i, s;
+    int        a;
+
+
+    if ( argc < 2 ) {
+        printf("PARSEBENCH <file|directory> [<file|directory> ...]\n\n");
+        printf("Times every stage of the font parser on the given font files (or on every\n");
+        printf("file in the given directories), and writes the results as CSV.\n");
+        return 0;
+    }
+    for ( a = 1; a < argc; a++ )
+        if ( add_input( argv[ a ], &ppszFiles, &cFiles ))
+            fprintf( stderr, "Failed to read %s.\n", argv[ a ] );
+    if ( !cFiles ) {
+        fprintf( stderr, "No input files.\n");
+        return 1;
+    }
+
+    printf("stage,input,unit,ops,ns_per_op,bytes_per_s,allocs_per_op\n");
+    for ( i = 0; i < cFiles; i++ ) {
+        if ( open_input( ppszFiles[ i ], &input )) {
+            fprintf( stderr, "%s: no fonts could be read.\n", ppszFiles[ i ] );
+            free_input( &input );
+            cBad++;
+            continue;
+        }
+        if ( verify_input( &input )) {
+            cBad++;
+            free_input( &input );
+            continue;
+        }
+        for ( s = 0; s < sizeof( aStages ) / sizeof( aStages[ 0 ] ); s++ )
+            time_stage( aStages + s, &input );
+        free_input( &input );
+        fflush( stdout );
+    }
+
+    for ( i = 0; i < cFiles; i++ ) free( ppszFiles[ i ] );
+    free( ppszFiles );
+    return cBad ? 2 : 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Add a file, or every file in a directory, to the input list.  Returns 0  *
+ * on success, or 1 if the path cannot be read.                             *
+ * ------------------------------------------------------------------------ */
+ULONG add_input( PSZ pszPath, PSZ **pppszFiles, PULONG pcFiles )
+{
+    struct stat    st;
+    struct dirent *pEntry;
+    DIR           *pDir;
+    PSZ           *ppsz,
+                   pszFile;
+    ULONG          cFirst = *pcFiles;
+
+    if ( stat( pszPath, &st )) return 1;
+    if ( !S_ISDIR( st.st_mode )) {
+        ppsz = (PSZ *) realloc( *pppszFiles, ( *pcFiles + 1 ) * sizeof( PSZ ));
+        if ( !ppsz ) return 1;
+        *pppszFiles = ppsz;
+        ppsz[ (*pcFiles)++ ] = strdup( pszPath );
+        return 0;
+    }
+
+    pDir = opendir( pszPath );
+    if ( !pDir ) return 1;
+    while (( pEntry = readdir( pDir )) != NULL ) {
+        if ( pEntry->d_name[ 0 ] == '.') continue;
+        pszFile = (PSZ) malloc( strlen( pszPath ) + strlen( pEntry->d_name ) + 2 );
+        if ( !pszFile ) break;
+        sprintf( pszFile, "%s/%s", pszPath, pEntry->d_name );
+        if ( stat( pszFile, &st ) || !S_ISREG( st.st_mode )) {
+            free( pszFile );
+            continue;
+        }
+        ppsz = (PSZ *) realloc( *pppszFiles, ( *pcFiles + 1 ) * sizeof( PSZ ));
+        if ( !ppsz ) {
+            free( pszFile );
+            break;
+        }
+        *pppszFiles = ppsz;
+        ppsz[ (*pcFiles)++ ] = pszFile;
+    }
+    closedir( pDir );
+
+    // Directory order is arbitrary, so sort the files for repeatable output
+    if ( *pcFiles > cFirst )
+        qsort( *pppszFiles + cFirst, *pcFiles - cFirst, sizeof( PSZ ), compare_names );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Collect the EXEPACK1 and EXEPACK2 pages of an LX module.  Returns the    *
+ * number of pages found.                                                   *
+ * ------------------------------------------------------------------------ */
+ULONG collect_pages( PBENCHINPUT pInput )
+{
+    POS2FILEMAP pMap = pInput->pMap;
+    LXHEADER   *plx_hd;
+    PLXOPMENTRY plxpages;
+    PPACKEDPAGE pPage;
+    ULONG       ulBase = 0,
+                cbPageAddr,
+                cPages,
+                i, t;
+
+    if ( pMap->cbData < 0x40 ) return 0;
+    if ( WORDFROMBYTES( pMap->pData[ 0 ], pMap->pData[ 1 ] ) == MAGIC_MZ )
+        memcpy( &ulBase, pMap->pData + EH_OFFSET_ADDRESS, 4 );
+    if (( ulBase + sizeof( LXHEADER )) > pMap->cbData ) return 0;
+    plx_hd = (LXHEADER *)( pMap->pData + ulBase );
+    if ( plx_hd->magic != MAGIC_LX ) return 0;
+
+    // As in unpkbench, walk the whole page map without the object table
+    plxpages = (PLXOPMENTRY)( pMap->pData + ulBase + plx_hd->objmap );
+    cPages   = 0;
+    for ( i = 0; ( ulBase + plx_hd->objmap + (( i + 1 ) * sizeof( LXOPMENTRY ))) <= plx_hd->datapage; i++ )
+        cPages++;
+    for ( t = 0; t < 2; t++ ) {
+        pInput->paPages[ t ] = (PPACKEDPAGE) calloc( cPages + 1, sizeof( PACKEDPAGE ));
+        if ( !pInput->paPages[ t ] ) return 0;
+    }
+    for ( i = 0; i < cPages; i++ ) {
+        if ( plxpages[ i ].flags == OP32_ITERDATA ) t = 0;
+        else if ( plxpages[ i ].flags == OP32_ITERDATA2 ) t = 1;
+        else continue;
+        cbPageAddr = plx_hd->datapage + ( plxpages[ i ].dataoffset << plx_hd->pageshift );
+        if ((( cbPageAddr + plxpages[ i ].size ) > pMap->cbData ) ||
+            ( plxpages[ i ].size > PAGE_SIZE ))
+            break;
+        pPage = pInput->paPages[ t ] + pInput->acPages[ t ]++;
+        pPage->pData = pMap->pData + cbPageAddr;
+        pPage->cb    = plxpages[ i ].size;
+    }
+    return pInput->acPages[ 0 ] + pInput->acPages[ 1 ];
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * qsort() comparison function for file names.                              *
+ * ------------------------------------------------------------------------ */
+int compare_names( const void *p1, const void *p2 )
+{
+    return strcmp( *(PSZ *) p1, *(PSZ *) p2 );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Release everything held for an input file.                               *
+ * ------------------------------------------------------------------------ */
+void free_input( PBENCHINPUT pInput )
+{
+    ULONG i;
+
+    for ( i = 0; i < pInput->cFaces; i++ )
+        FreeOS2FontResource( pInput->paFonts + i );
+    free( pInput->paFonts );
+    free( pInput->pCopy );
+    free( pInput->pGlyph );
+    free( pInput->paPages[ 0 ] );
+    free( pInput->paPages[ 1 ] );
+    free( pInput->surface.pBits );
+    if ( pInput->pMap ) OS2ReleaseFileMap( pInput->pMap );
+    memset( pInput, 0, sizeof( BENCHINPUT ));
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Read every font in a file into memory, and set up the buffers which the  *
+ * stages use.  Returns 0 on success, or an ERR_* code.                     *
+ * ------------------------------------------------------------------------ */
+ULONG open_input( PSZ pszFile, PBENCHINPUT pInput )
+{
+    ULONG cFaces = 0,
+          cbMax  = 0,
+          ulRC,
+          c, i;
+
+    memset( pInput, 0, sizeof( BENCHINPUT ));
+    pInput->pszFile = pszFile;
+    ulRC = OS2MapFile( pszFile, &(pInput->pMap) );
+    if ( ulRC ) return ulRC;
+
+    // Read the first face to find out how many there are
+    pInput->paFonts = (POS2FONTRESOURCE) calloc( 1, sizeof( OS2FONTRESOURCE ));
+    if ( !pInput->paFonts ) return ERR_MEMORY;
+    ulRC = ReadOS2FontResource( pszFile, 0, &cFaces, pInput->paFonts );
+    if ( ulRC ) return ulRC;
+    pInput->cFaces = 1;
+    if ( cFaces > 1 ) {
+        POS2FONTRESOURCE pFonts = (POS2FONTRESOURCE) realloc( pInput->paFonts, cFaces * sizeof( OS2FONTRESOURCE ));
+        if ( !pFonts ) return ERR_MEMORY;
+        pInput->paFonts = pFonts;
+        for ( i = 1; i < cFaces; i++ ) {
+            ulRC = ReadOS2FontResource( pszFile, i, &c, pFonts + i );
+            if ( ulRC ) return ulRC;
+            pInput->cFaces++;
+        }
+    }
+
+    for ( i = 0; i < pInput->cFaces; i++ ) {
+        if ( pInput->paFonts[ i ].cbSize > cbMax ) cbMax = pInput->paFonts[ i ].cbSize;
+        for ( c = 0; c <= (ULONG) pInput->paFonts[ i ].pMetrics->usLastChar; c++ ) {
+            ULONG cb = OS2FontGlyphSize( pInput->paFonts[ i ].pMetrics->usFirstChar + c,
+                                         pInput->paFonts + i );
+            if ( cb > pInput->cbGlyph ) pInput->cbGlyph = cb;
+        }
+    }
+    pInput->pCopy  = (PBYTE) malloc( cbMax );
+    pInput->pGlyph = (PBYTE) malloc( pInput->cbGlyph + 1 );
+    pInput->surface.cx      = SURFACE_CX;
+    pInput->surface.cy      = SURFACE_CY;
+    pInput->surface.ulDepth = 1;
+    pInput->surface.ulPitch = SURFACE_CX / 8;
+    pInput->surface.bColor  = 1;
+    pInput->surface.pBits   = (PBYTE) calloc( pInput->surface.ulPitch, pInput->surface.cy );
+    if ( !pInput->pCopy || !pInput->pGlyph || !pInput->surface.pBits ) return ERR_MEMORY;
+
+    collect_pages( pInput );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: build (and discard) the glyph atlas of every font.                *
+ * ------------------------------------------------------------------------ */
+ULONG run_atlas( PBENCHINPUT pInput, double *pdBytes )
+{
+    POS2FONTRESOURCE pFont;
+    ULONG            cOps = 0,
+                     i;
+
+    for ( i = 0; i < pInput->cFaces; i++ ) {
+        pFont = pInput->paFonts + i;
+        if ( BuildOS2GlyphAtlas( pFont )) continue;
+        *pdBytes += pFont->pAtlas->cbData;
+        free( pFont->pAtlas );
+        pFont->pAtlas = NULL;
+        cOps++;
+    }
+    return cOps;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: extract every glyph of every font into a new buffer.              *
+ * ------------------------------------------------------------------------ */
+ULONG run_extract( PBENCHINPUT pInput, double *pdBytes )
+{
+    POS2FONTRESOURCE pFont;
+    GLYPHBITMAP      glyph;
+    ULONG            cOps = 0,
+                     c, i;
+
+    for ( i = 0; i < pInput->cFaces; i++ ) {
+        pFont = pInput->paFonts + i;
+        for ( c = 0; c <= (ULONG) pFont->pMetrics->usLastChar; c++ ) {
+            if ( !ExtractOS2FontGlyph( pFont->pMetrics->usFirstChar + c, pFont, &glyph ))
+                continue;
+            *pdBytes += glyph.cbBuffer;
+            free( glyph.buffer );
+            cOps++;
+        }
+    }
+    return cOps;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: extract every glyph of every font into the same buffer.           *
+ * ------------------------------------------------------------------------ */
+ULONG run_extract_into( PBENCHINPUT pInput, double *pdBytes )
+{
+    POS2FONTRESOURCE pFont;
+    GLYPHBITMAP      glyph;
+    ULONG            cOps = 0,
+                     c, i;
+
+    for ( i = 0; i < pInput->cFaces; i++ ) {
+        pFont = pInput->paFonts + i;
+        for ( c = 0; c <= (ULONG) pFont->pMetrics->usLastChar; c++ ) {
+            if ( !ExtractOS2FontGlyphInto( pFont->pMetrics->usFirstChar + c, pFont, &glyph,
+                                           pInput->pGlyph, pInput->cbGlyph ))
+                continue;
+            *pdBytes += glyph.cbBuffer;
+            cOps++;
+        }
+    }
+    return cOps;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: look up the glyph index of the first INDEX_CHARS codepoints in    *
+ * every font.                                                              *
+ * ------------------------------------------------------------------------ */
+ULONG run_glyph_index( PBENCHINPUT pInput, double *pdBytes )
+{
+    ULONG ulTotal = 0,
+          c, i;
+
+    for ( i = 0; i < pInput->cFaces; i++ )
+        for ( c = 0; c < INDEX_CHARS; c++ )
+            ulTotal += OS2FontGlyphIndex( pInput->paFonts + i, c );
+    *pdBytes += ulTotal & 1;     /* keeps the lookups from being optimized out */
+    return pInput->cFaces * INDEX_CHARS;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: load every font with MapOS2FontResource(), then release it.       *
+ * ------------------------------------------------------------------------ */
+ULONG run_map( PBENCHINPUT pInput, double *pdBytes )
+{
+    OS2FONTRESOURCE font;
+    ULONG           cFaces,
+                    cOps = 0,
+                    i;
+
+    for ( i = 0; i < pInput->cFaces; i++ ) {
+        if ( MapOS2FontResource( pInput->pszFile, i, &cFaces, &font )) continue;
+        *pdBytes += font.cbSize;
+        FreeOS2FontResource( &font );
+        cOps++;
+    }
+    return cOps;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: measure the sample text in every font.                            *
+ * ------------------------------------------------------------------------ */
+ULONG run_measure( PBENCHINPUT pInput, double *pdBytes )
+{
+    LONG  lTotal = 0;
+    ULONG i;
+
+    for ( i = 0; i < pInput->cFaces; i++ )
+        lTotal += MeasureOS2FontText( pInput->paFonts + i, (PVOID) szSample,
+                                      strlen( szSample ), OS2TEXT_UTF8 );
+    *pdBytes += lTotal & 1;
+    return pInput->cFaces * strlen( szSample );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: open the file as a font module, get every font from it, and       *
+ * release them all.                                                        *
+ * ------------------------------------------------------------------------ */
+ULONG run_module_faces( PBENCHINPUT pInput, double *pdBytes )
+{
+    POS2FONTMODULE  pModule;
+    OS2FONTRESOURCE font;
+    ULONG           cOps = 0,
+                    i;
+
+    if ( OpenOS2FontModule( pInput->pszFile, &pModule )) return 0;
+    for ( i = 0; i < QueryOS2FontModuleFaces( pModule ); i++ ) {
+        if ( GetOS2FontModuleFace( pModule, i, &font )) continue;
+        *pdBytes += font.cbSize;
+        FreeOS2FontResource( &font );
+        cOps++;
+    }
+    CloseOS2FontModule( pModule );
+    return cOps;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: open the file as a font module and close it again.                *
+ * ------------------------------------------------------------------------ */
+ULONG run_module_open( PBENCHINPUT pInput, double *pdBytes )
+{
+    POS2FONTMODULE pModule;
+
+    if ( OpenOS2FontModule( pInput->pszFile, &pModule )) return 0;
+    CloseOS2FontModule( pModule );
+    *pdBytes += pInput->pMap->cbData;
+    return 1;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: parse a copy of every font's data.                                *
+ * ------------------------------------------------------------------------ */
+ULONG run_parse( PBENCHINPUT pInput, double *pdBytes )
+{
+    OS2FONTRESOURCE font;
+    ULONG           cOps = 0,
+                    i;
+
+    for ( i = 0; i < pInput->cFaces; i++ ) {
+        memcpy( pInput->pCopy, pInput->paFonts[ i ].pSignature, pInput->paFonts[ i ].cbSize );
+        if ( ParseOS2FontResource( pInput->pCopy, pInput->paFonts[ i ].cbSize, &font )) continue;
+        // The font data is ours, so only what the parser built is freed
+        free( font.pKernIndex );
+        *pdBytes += font.cbSize;
+        cOps++;
+    }
+    return cOps;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: load every font with ReadOS2FontResource(), then free it.         *
+ * ------------------------------------------------------------------------ */
+ULONG run_read( PBENCHINPUT pInput, double *pdBytes )
+{
+    OS2FONTRESOURCE font;
+    ULONG           cFaces,
+                    cOps = 0,
+                    i;
+
+    for ( i = 0; i < pInput->cFaces; i++ ) {
+        if ( ReadOS2FontResource( pInput->pszFile, i, &cFaces, &font )) continue;
+        *pdBytes += font.cbSize;
+        FreeOS2FontResource( &font );
+        cOps++;
+    }
+    return cOps;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: draw the sample text in every font.                               *
+ * ------------------------------------------------------------------------ */
+ULONG run_render( PBENCHINPUT pInput, double *pdBytes )
+{
+    LONG  lTotal = 0;
+    ULONG i;
+
+    for ( i = 0; i < pInput->cFaces; i++ )
+        lTotal += RenderOS2FontText( pInput->paFonts + i, (PVOID) szSample, strlen( szSample ),
+                                     OS2TEXT_UTF8, &(pInput->surface), 0,
+                                     pInput->paFonts[ i ].pFontDef->pCellBaseOffset );
+    *pdBytes += lTotal & 1;
+    return pInput->cFaces * strlen( szSample );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: unpack every EXEPACK1 page of the module.                         *
+ * ------------------------------------------------------------------------ */
+ULONG run_unpack1( PBENCHINPUT pInput, double *pdBytes )
+{
+    BYTE  abPage[ PAGE_SIZE ];
+    ULONG i;
+
+    for ( i = 0; i < pInput->acPages[ 0 ]; i++ ) {
+        memcpy( abPage, pInput->paPages[ 0 ][ i ].pData, pInput->paPages[ 0 ][ i ].cb );
+        *pdBytes += LXUnpack1( abPage, pInput->paPages[ 0 ][ i ].cb );
+    }
+    return pInput->acPages[ 0 ];
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Stage: unpack every EXEPACK2 page of the module.                         *
+ * ------------------------------------------------------------------------ */
+ULONG run_unpack2( PBENCHINPUT pInput, double *pdBytes )
+{
+    BYTE  abPage[ PAGE_SIZE ];
+    ULONG i;
+
+    for ( i = 0; i < pInput->acPages[ 1 ]; i++ )
+        *pdBytes += LXDecodePage2( abPage, pInput->paPages[ 1 ][ i ].pData,
+                                   pInput->paPages[ 1 ][ i ].cb );
+    return pInput->acPages[ 1 ];
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Run a stage repeatedly for at least MIN_SECONDS and write its CSV row.   *
+ * Stages which do nothing for this file (no packed pages, say) are left    *
+ * out.                                                                     *
+ * ------------------------------------------------------------------------ */
+void time_stage( const BENCHSTAGE *pStage, PBENCHINPUT pInput )
+{
+    clock_t start;
+    double  dElapsed,
+            dBytes = 0,
+            dOps   = 0;
+    ULONG   cOps;
+#ifdef COUNT_ALLOCS
+    ULONG   ulFirst;
+#endif
+
+    // One untimed run, which also warms the caches
+    cOps = pStage->pfnRun( pInput, &dBytes );
+    if ( !cOps ) return;
+    dBytes = 0;
+
+#ifdef COUNT_ALLOCS
+    ulFirst = ulAllocs;
+#endif
+    start = clock();
+    do {
+        dOps += pStage->pfnRun( pInput, &dBytes );
+        dElapsed = (double)( clock() - start ) / CLOCKS_PER_SEC;
+    } while ( dElapsed < MIN_SECONDS );
+
+    printf("%s,%s,%s,%.0f,%.1f,", pStage->pszName, pInput->pszFile, pStage->pszUnit,
+           dOps, ( dElapsed * 1e9 ) / dOps );
+    if ( pStage->fBytes )
+        printf("%.0f", dBytes / dElapsed );
+#ifdef COUNT_ALLOCS
+    printf(",%.2f\n", ( ulAllocs - ulFirst ) / dOps );
+#else
+    printf(",\n");
+#endif
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Check that the different ways of loading and reading a font agree: the   *
+ * fonts returned by MapOS2FontResource() and by the font module functions  *
+ * must match those returned by ReadOS2FontResource(), and the glyphs must  *
+ * be the same whether they are extracted, extracted into a buffer, or      *
+ * taken from an atlas.  Returns 0 if so, otherwise 1 (after saying why).   *
+ * ------------------------------------------------------------------------ */
+ULONG verify_input( PBENCHINPUT pInput )
+{
+    POS2FONTMODULE   pModule;
+    POS2FONTRESOURCE pFont;
+    OS2FONTRESOURCE  font;
+    GLYPHBITMAP      glyph,
+                     into,
+                     atlas;
+    ULONG            cFaces,
+                     ulRC = 0,
+                     c, i;
+
+    if ( OpenOS2FontModule( pInput->pszFile, &pModule )) {
+        fprintf( stderr, "%s: cannot be opened as a font module.\n", pInput->pszFile );
+        return 1;
+    }
+    for ( i = 0; ( i < pInput->cFaces ) && !ulRC; i++ ) {
+        pFont = pInput->paFonts + i;
+        if ( MapOS2FontResource( pInput->pszFile, i, &cFaces, &font ) ||
+             ( font.cbSize != pFont->cbSize ) || memcmp( font.pSignature, pFont->pSignature, pFont->cbSize ))
+            ulRC = 1;
+        FreeOS2FontResource( &font );
+        if ( GetOS2FontModuleFace( pModule, i, &font ) ||
+             ( font.cbSize != pFont->cbSize ) || memcmp( font.pSignature, pFont->pSignature, pFont->cbSize ))
+            ulRC = 1;
+        FreeOS2FontResource( &font );
+        if ( ulRC ) {
+            fprintf( stderr, "%s: font %u is not loaded consistently.\n", pInput->pszFile, i );
+            break;
+        }
+
+        if ( BuildOS2GlyphAtlas( pFont )) continue;
+        for ( c = pFont->pMetrics->usFirstChar;
+              c <= (ULONG)( pFont->pMetrics->usFirstChar + pFont->pMetrics->usLastChar ); c++ )
+        {
+            if ( !ExtractOS2FontGlyph( c, pFont, &glyph )) continue;
+            if ( !ExtractOS2FontGlyphInto( c, pFont, &into, pInput->pGlyph, pInput->cbGlyph ) ||
+                 !GetOS2AtlasGlyph( c, pFont, &atlas ) ||
+                 memcmp( glyph.buffer, into.buffer, glyph.cbBuffer ) ||
+                 memcmp( glyph.buffer, atlas.buffer, glyph.cbBuffer ))
+            {
+                fprintf( stderr, "%s: glyph %u of font %u does not match.\n", pInput->pszFile, c, i );
+                ulRC = 1;
+            }
+            free( glyph.buffer );
+            if ( ulRC ) break;
+        }
+        free( pFont->pAtlas );
+        pFont->pAtlas = NULL;
+    }
+    CloseOS2FontModule( pModule );
+    return ulRC;
+}
@@ -0,0 +1,199 @@
+/*****************************************************************************
+ *                                                                           *
+ * rendbench.c                                                               *
+ *                                                                           *
+ * Microbenchmark for the text-run renderer, RenderOS2FontText().  Checks    *
+ * that it draws exactly what extracting each glyph and plotting its pels    *
+ * one by one would (at a range of positions, partly off the surface), and   *
+ * then reports its throughput in glyphs/s on 1 and 8 bit per pel surfaces,  *
+ * along with that of extracting each glyph into a buffer and copying it     *
+ * onto the surface for comparison.                                          *
+ *                                                                           *
+ *  (C) 2023 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "otypes.h"
+#include "gpifont.h"
+
+#define MIN_SECONDS     1.0
+#define SURFACE_CX      1024
+#define SURFACE_CY      64
+#define MAX_GLYPHS      512
+
+static const char szSample[] = "The quick brown fox jumps over the lazy dog.  "
+                               "PACK MY BOX WITH FIVE DOZEN LIQUOR JUGS!  0123456789";
+
+/* Local function prototypes */
+void   draw_extracted( POS2FONTRESOURCE pFont, PULONG pulGlyphs, ULONG cGlyphs, POS2TEXTSURFACE pSurface, LONG x, LONG y );
+double time_render( POS2FONTRESOURCE pFont, PULONG pulGlyphs, ULONG cGlyphs, POS2TEXTSURFACE pSurface, BOOL fExtract, LONG x, PULONG pulRuns );
+
+
+/* ------------------------------------------------------------------------ */
+int main( int argc, char *argv[] )
+{
+    OS2FONTRESOURCE font;
+    OS2TEXTSURFACE  surface,
+                    check;
+    ULONG           aulGlyphs[ MAX_GLYPHS ],
+                    cGlyphs,
+                    cFonts,
+                    ulRuns,
+                    cbSurface,
+                    d, t;
+    LONG            x, y;
+    double          dElapsed;
+    BOOL            fExtract;
+    static const ULONG aulDepths[] = { 1, 8 };
+
+
+    if ( argc < 2 ) {
+        printf("RENDBENCH <font file> [<face>]\n\n");
+        printf("Times the text-run renderer on a line of sample text in the given font.\n");
+        return 0;
+    }
+    if ( ReadOS2FontResource( argv[ 1 ], ( argc > 2 ) ? atoi( argv[ 2 ] ) : 0, &cFonts, &font )) {
+        fprintf( stderr, "Failed to read a font from %s.\n", argv[ 1 ] );
+        return 1;
+    }
+    cGlyphs = OS2FontGlyphIndices( &font, (PVOID) szSample, strlen( szSample ),
+                                   OS2TEXT_UTF8, aulGlyphs, MAX_GLYPHS, NULL );
+    printf("%s, %u pels high: %u glyphs of sample text.\n",
+           font.pMetrics->szFacename, font.pFontDef->yCellHeight, cGlyphs );
+
+    for ( d = 0; d < 2; d++ ) {
+        surface.cx      = SURFACE_CX;
+        surface.cy      = SURFACE_CY;
+        surface.ulDepth = aulDepths[ d ];
+        surface.ulPitch = ( surface.ulDepth == 1 ) ? SURFACE_CX / 8 : SURFACE_CX;
+        surface.bColor  = 0xC3;
+        cbSurface       = surface.ulPitch * surface.cy;
+        surface.pBits   = (PBYTE) malloc( cbSurface );
+        check           = surface;
+        check.pBits     = (PBYTE) malloc( cbSurface );
+        if ( !surface.pBits || !check.pBits ) return 1;
+
+        // Verify the renderer at assorted (partly clipped) positions
+        srand( 1 );
+        for ( t = 0; t < 1000; t++ ) {
+            x = ( rand() % ( SURFACE_CX + 64 )) - 64;
+            y = ( rand() % ( SURFACE_CY + 32 )) - 16;
+            memset( surface.pBits, 0, cbSurface );
+            memset( check.pBits, 0, cbSurface );
+            RenderOS2FontText( &font, (PVOID) szSample, strlen( szSample ),
+                               OS2TEXT_UTF8, &surface, x, y );
+            draw_extracted( &font, aulGlyphs, cGlyphs, &check, x, y );
+            if ( memcmp( surface.pBits, check.pBits, cbSurface )) {
+                fprintf( stderr, "%u bpp: output mismatch at (%d,%d).\n",
+                         surface.ulDepth, x, y );
+                return 2;
+            }
+        }
+        printf("%u bpp: renderer output verified.\n", surface.ulDepth );
+
+        for ( fExtract = FALSE; fExtract <= TRUE; fExtract++ ) {
+            for ( x = 0; x < 2; x++ ) {
+                dElapsed = time_render( &font, aulGlyphs, cGlyphs, &surface, fExtract, x * 3, &ulRuns );
+                printf("  %-18s %-9s : %12.0f glyphs/s\n",
+                       fExtract ? "extract and copy" : "render", x ? "unaligned" : "aligned",
+                       ( ulRuns * (double) cGlyphs ) / dElapsed );
+            }
+        }
+        free( surface.pBits );
+        free( check.pBits );
+    }
+
+    FreeOS2FontResource( &font );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Draw a run of glyphs by extracting each one and plotting its pels one at *
+ * a time (the reference for checking the renderer).                        *
+ * ------------------------------------------------------------------------ */
+void draw_extracted( POS2FONTRESOURCE pFont, PULONG pulGlyphs, ULONG cGlyphs, POS2TEXTSURFACE pSurface, LONG x, LONG y )
+{
+    GLYPHBITMAP glyph;
+    BYTE        abBuffer[ 8192 ];
+    LONG        px, py;
+    ULONG       i, r, c;
+
+    y -= pFont->pFontDef->pCellBaseOffset;
+    for ( i = 0; i < cGlyphs; i++ ) {
+        if ( !ExtractOS2FontGlyphInto( pulGlyphs[ i ], pFont, &glyph, abBuffer, sizeof( abBuffer )))
+            continue;
+        for ( r = 0; r < glyph.rows; r++ ) {
+            for ( c = 0; c < glyph.width; c++ ) {
+                if ( !( glyph.buffer[ ( r * glyph.pitch ) + ( c / 8 ) ] & ( 0x80 >> ( c % 8 ))))
+                    continue;
+                px = x + glyph.horiBearingX + c;
+                py = y + r;
+                if (( px < 0 ) || ( py < 0 ) ||
+                    ( px >= (LONG) pSurface->cx ) || ( py >= (LONG) pSurface->cy ))
+                    continue;
+                if ( pSurface->ulDepth == 1 )
+                    pSurface->pBits[ ( py * pSurface->ulPitch ) + ( px / 8 ) ] |= 0x80 >> ( px % 8 );
+                else
+                    pSurface->pBits[ ( py * pSurface->ulPitch ) + px ] = pSurface->bColor;
+            }
+        }
+        x += glyph.horiAdvance;
+    }
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Draw the text repeatedly for at least MIN_SECONDS, either with the       *
+ * renderer or by extracting each glyph and copying its rows onto the       *
+ * surface, and return the elapsed time in seconds.                         *
+ * ------------------------------------------------------------------------ */
+double time_render( POS2FONTRESOURCE pFont, PULONG pulGlyphs, ULONG cGlyphs, POS2TEXTSURFACE pSurface, BOOL fExtract, LONG x, PULONG pulRuns )
+{
+    GLYPHBITMAP glyph;
+    BYTE        abBuffer[ 8192 ];
+    clock_t     start;
+    double      dElapsed;
+    PBYTE       pDest;
+    LONG        px;
+    ULONG       i, r, c,
+                y = pFont->pFontDef->pCellBaseOffset;
+
+    *pulRuns = 0;
+    start = clock();
+    do {
+        if ( !fExtract )
+            RenderOS2FontText( pFont, (PVOID) szSample, strlen( szSample ),
+                               OS2TEXT_UTF8, pSurface, x, y );
+        else {
+            // Extract each glyph, then copy it (unclipped) onto the surface
+            px = x;
+            for ( i = 0; i < cGlyphs; i++ ) {
+                if ( !ExtractOS2FontGlyphInto( pulGlyphs[ i ], pFont, &glyph, abBuffer, sizeof( abBuffer )))
+                    continue;
+                if (( px + glyph.horiBearingX + glyph.width ) > pSurface->cx ) break;
+                for ( r = 0; r < glyph.rows; r++ ) {
+                    pDest = pSurface->pBits + ( r * pSurface->ulPitch );
+                    for ( c = 0; c < glyph.width; c++ ) {
+                        if ( !( glyph.buffer[ ( r * glyph.pitch ) + ( c / 8 ) ] & ( 0x80 >> ( c % 8 ))))
+                            continue;
+                        if ( pSurface->ulDepth == 1 )
+                            pDest[ ( px + glyph.horiBearingX + c ) / 8 ] |= 0x80 >> (( px + glyph.horiBearingX + c ) % 8 );
+                        else
+                            pDest[ px + glyph.horiBearingX + c ] = pSurface->bColor;
+                    }
+                }
+                px += glyph.horiAdvance;
+            }
+        }
+        (*pulRuns)++;
+        dElapsed = (double)( clock() - start ) / CLOCKS_PER_SEC;
+    } while ( dElapsed < MIN_SECONDS );
+    return dElapsed;
+}
@@ -0,0 +1,306 @@
+/*****************************************************************************
+ *                                                                           *
+ * uglbench.c                                                                *
+ *                                                                           *
+ * Microbenchmark for the Unicode-to-UGL conversion in OS2FontGlyphIndex().  *
+ * Checks that the table-driven lookup gives the same result as the original *
+ * linear search for every codepoint (under a range of font character-set    *
+ * flags), and then times both over multilingual text, along with the batch  *
+ * conversion of the same text by OS2FontGlyphIndices().  UTF-8 text files   *
+ * may be given on the command line; otherwise a built-in sample is used.    *
+ *                                                                           *
+ *  (C) 2023 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "otypes.h"
+#include "gpifont.h"
+#include "pmugl.h"
+
+#define MIN_SECONDS     1.0
+#define MAX_TEXT        0x100000
+
+/* Article 1 of the Universal Declaration of Human Rights in various languages
+ * (plus some halfwidth katakana), covering most of the UGL character groups.
+ */
+static const char *apszSample[] = {
+    "All human beings are born free and equal in dignity and rights.",
+    "Tous les êtres humains naissent libres et égaux en dignité et en droits.",
+    "Alle Menschen sind frei und gleich an Würde und Rechten geboren.",
+    "Wszyscy ludzie rodzą się wolni i równi pod względem swej godności i swych praw.",
+    "Bütün insanlar hür, haysiyet ve haklar bakımından eşit doğarlar.",
+    "Все люди рождаются свободными и равными в своем достоинстве и правах.",
+    "Όλοι οι άνθρωποι γεννιούνται ελεύθεροι και ίσοι στην αξιοπρέπεια και τα δικαιώματα.",
+    "כל בני האדם נולדו בני חורין ושווים בערכם ובזכויותיהם.",
+    "يولد جميع الناس أحرارًا متساوين في الكرامة والحقوق.",
+    "มนุษย์ทั้งหลายเกิดมามีอิสระและเสมอภาคกันในเกียรติศักดิ์และสิทธิ",
+    "모든 인간은 태어날 때부터 자유로우며 그 존엄과 권리에 있어 동등하다.",
+    "ｽﾍﾞﾃﾉ ﾆﾝｹﾞﾝﾊ, ｳﾏﾚﾅｶﾞﾗﾆｼﾃ ｼﾞﾕｳﾃﾞｱﾘ.",
+    NULL
+};
+
+/* Builds the coverage bitmap of a font (internal to gpifont.c) */
+void SetUGLCoverage( POS2FONTRESOURCE pFont );
+
+/* Local function prototypes */
+double time_batch( POS2FONTRESOURCE pFont, PBYTE pchText, ULONG cbText, PULONG pulGlyphs, PULONG pulRuns );
+ULONG  decode_utf8( const unsigned char *pch, ULONG cb, PULONG pulText, ULONG cMax );
+double time_lookup( POS2FONTRESOURCE pFont, PULONG pulText, ULONG cText, BOOL fOriginal, PULONG pulRuns );
+ULONG  orig_glyph_index( POS2FONTRESOURCE pFont, ULONG index );
+
+
+/* ------------------------------------------------------------------------ */
+int main( int argc, char *argv[] )
+{
+    OS2FONTRESOURCE font = {0};
+    OS2FOCAMETRICS  metrics = {0};
+    FILE           *pf;
+    unsigned char  *pch;
+    PULONG          pulText,
+                    pulGlyphs;
+    ULONG           cText = 0,
+                    cbText = 0,
+                    cb,
+                    ulRuns,
+                    c, i;
+    double          dOrig,
+                    dNew,
+                    dBatch;
+    int             a;
+    static const USHORT ausDefn[] = { 0x3FF0, 0x0030, 0x00B0, 0x1070, 0x2300, 0x0000 };
+
+
+    pulText   = (PULONG) malloc( MAX_TEXT * sizeof( ULONG ));
+    pulGlyphs = (PULONG) malloc( MAX_TEXT * sizeof( ULONG ));
+    pch       = (unsigned char *) malloc( MAX_TEXT );
+    if ( !pulText || !pulGlyphs || !pch ) return 1;
+
+    // The UTF-8 text is kept (in pch) for timing the batch conversion
+    if ( argc < 2 ) {
+        for ( i = 0; apszSample[ i ]; i++ ) {
+            cb = strlen( apszSample[ i ] );
+            if (( cbText + cb ) > MAX_TEXT ) break;
+            memcpy( pch + cbText, apszSample[ i ], cb );
+            cbText += cb;
+        }
+    }
+    for ( a = 1; a < argc; a++ ) {
+        pf = fopen( argv[ a ], "rb");
+        if ( !pf ) {
+            fprintf( stderr, "The file %s could not be opened.\n", argv[ a ] );
+            continue;
+        }
+        cbText += fread( pch + cbText, 1, MAX_TEXT - cbText, pf );
+        fclose( pf );
+    }
+    cText = decode_utf8( pch, cbText, pulText, MAX_TEXT );
+    if ( !cText ) {
+        fprintf( stderr, "No text to process.\n");
+        return 1;
+    }
+
+    // A UGL font covering all of UGL (with various character groups)
+    font.pMetrics = &metrics;
+    metrics.usCodePage  = 850;
+    metrics.usFirstChar = 1;
+    metrics.usLastChar  = OS2UGL_MAX_GLYPH - 1;
+
+    // Verify that both lookups agree on every codepoint
+    for ( i = 0; i < ( sizeof( ausDefn ) / sizeof( USHORT )); i++ ) {
+        metrics.fsDefn = ausDefn[ i ];
+        SetUGLCoverage( &font );
+        for ( c = 0; c < 0x20000; c++ ) {
+            if ( OS2FontGlyphIndex( &font, c ) != orig_glyph_index( &font, c )) {
+                fprintf( stderr, "Mismatch for U+%04X (fsDefn 0x%04X): %u vs %u\n",
+                         c, metrics.fsDefn, OS2FontGlyphIndex( &font, c ),
+                         orig_glyph_index( &font, c ));
+                return 2;
+            }
+        }
+    }
+    printf("Both lookups agree for all codepoints up to U+1FFFF.\n");
+
+    metrics.fsDefn = ausDefn[ 0 ];
+    SetUGLCoverage( &font );
+    for ( c = 0, i = 0; i < cText; i++ )
+        if ( OS2FontGlyphIndex( &font, pulText[ i ] )) c++;
+    printf("%u characters of text, %u of them supported by UGL.\n", cText, c );
+
+    // Check the batch conversion against the single lookups
+    if ( OS2FontGlyphIndices( &font, pch, cbText, OS2TEXT_UTF8, pulGlyphs, MAX_TEXT, NULL ) != cText ) {
+        fprintf( stderr, "Batch conversion returned the wrong number of glyphs.\n");
+        return 2;
+    }
+    for ( i = 0; i < cText; i++ ) {
+        if ( pulGlyphs[ i ] != OS2FontGlyphIndex( &font, pulText[ i ] )) {
+            fprintf( stderr, "Batch conversion mismatch for U+%04X.\n", pulText[ i ] );
+            return 2;
+        }
+    }
+    printf("Batch conversion agrees with the single lookups.\n\n");
+
+    dOrig = time_lookup( &font, pulText, cText, TRUE, &ulRuns );
+    printf("original : %12.0f chars/s  (%6.1f ns/char)\n",
+           ( ulRuns * (double) cText ) / dOrig,
+           ( dOrig * 1e9 ) / ( ulRuns * (double) cText ));
+    dNew = time_lookup( &font, pulText, cText, FALSE, &ulRuns );
+    printf("current  : %12.0f chars/s  (%6.1f ns/char)\n",
+           ( ulRuns * (double) cText ) / dNew,
+           ( dNew * 1e9 ) / ( ulRuns * (double) cText ));
+    dBatch = time_batch( &font, pch, cbText, pulGlyphs, &ulRuns );
+    printf("batch    : %12.0f chars/s  (%6.1f ns/char, UTF-8 decoding included)\n",
+           ( ulRuns * (double) cText ) / dBatch,
+           ( dBatch * 1e9 ) / ( ulRuns * (double) cText ));
+
+    free( pch );
+    free( pulGlyphs );
+    free( pulText );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Decode UTF-8 text into an array of codepoints.  Invalid sequences are    *
+ * skipped a byte at a time.                                                *
+ * ------------------------------------------------------------------------ */
+ULONG decode_utf8( const unsigned char *pch, ULONG cb, PULONG pulText, ULONG cMax )
+{
+    ULONG i = 0,
+          n = 0,
+          cTrail,
+          c;
+
+    while (( i < cb ) && ( n < cMax )) {
+        c = pch[ i++ ];
+        if ( c < 0x80 ) cTrail = 0;
+        else if (( c & 0xE0 ) == 0xC0 ) { c &= 0x1F; cTrail = 1; }
+        else if (( c & 0xF0 ) == 0xE0 ) { c &= 0x0F; cTrail = 2; }
+        else if (( c & 0xF8 ) == 0xF0 ) { c &= 0x07; cTrail = 3; }
+        else continue;
+        if (( i + cTrail ) > cb ) break;
+        for ( ; cTrail; cTrail-- ) {
+            if (( pch[ i ] & 0xC0 ) != 0x80 ) break;
+            c = ( c << 6 ) | ( pch[ i++ ] & 0x3F );
+        }
+        if ( cTrail ) continue;
+        pulText[ n++ ] = c;
+    }
+    return n;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Look up every character of the text repeatedly for at least MIN_SECONDS, *
+ * and return the elapsed time in seconds.                                  *
+ * ------------------------------------------------------------------------ */
+double time_lookup( POS2FONTRESOURCE pFont, PULONG pulText, ULONG cText, BOOL fOriginal, PULONG pulRuns )
+{
+    clock_t        start;
+    double         dElapsed;
+    volatile ULONG ulSum = 0;
+    ULONG          i;
+
+    *pulRuns = 0;
+    start = clock();
+    do {
+        if ( fOriginal )
+            for ( i = 0; i < cText; i++ ) ulSum += orig_glyph_index( pFont, pulText[ i ] );
+        else
+            for ( i = 0; i < cText; i++ ) ulSum += OS2FontGlyphIndex( pFont, pulText[ i ] );
+        (*pulRuns)++;
+        dElapsed = (double)( clock() - start ) / CLOCKS_PER_SEC;
+    } while ( dElapsed < MIN_SECONDS );
+    return dElapsed;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Convert the whole UTF-8 text with OS2FontGlyphIndices() repeatedly for   *
+ * at least MIN_SECONDS, and return the elapsed time in seconds.            *
+ * ------------------------------------------------------------------------ */
+double time_batch( POS2FONTRESOURCE pFont, PBYTE pchText, ULONG cbText, PULONG pulGlyphs, PULONG pulRuns )
+{
+    clock_t start;
+    double  dElapsed;
+
+    *pulRuns = 0;
+    start = clock();
+    do {
+        OS2FontGlyphIndices( pFont, pchText, cbText, OS2TEXT_UTF8, pulGlyphs, MAX_TEXT, NULL );
+        (*pulRuns)++;
+        dElapsed = (double)( clock() - start ) / CLOCKS_PER_SEC;
+    } while ( dElapsed < MIN_SECONDS );
+    return dElapsed;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * The original OS2FontGlyphIndex(), kept here as the reference for         *
+ * correctness and speed.  A few blocks are mapped directly; everything      *
+ * else is found by a linear search of UGL2Uni.                             *
+ * ------------------------------------------------------------------------ */
+ULONG orig_glyph_index( POS2FONTRESOURCE pFont, ULONG index )
+{
+    USHORT i;
+
+    if ( pFont->pMetrics->usCodePage && ( pFont->pMetrics->usCodePage != 850 ))
+        return index;
+    if ( index >= 32 && index <= 126 ) return index;
+
+    if ( index >= 0x401 && index <= 0x40C )
+        i = index - 0x281;
+    else if (( index >= 0x40E && index <= 0x45C && index != 0x450 ))
+        i = index - 0x282;
+    else if ( index >= 0x5D0 && index <= 0x5EA )
+        i = index - 0x3B8;
+    else if ( index >= 0x5B0 && index <= 0x5B9 )
+        i = index - 0x37D;
+    else if ( index >= 0x5BB && index <= 0x5C3 )
+        i = index - 0x37E;
+    else if ( index >= 0xFF61 && index <= 0xFF9F )
+        i = index - 0xFC5F;
+    else if ( index >= 0x3131 && index <= 0x3163 )
+        i = index - 0x2DB1;
+    else if ( index >= 0xE01 && index <= 0xE3A )
+        i = index - 0xA4A;
+    else if ( index >= 0xE40 && index <= 0xE4F )
+        i = index - 0xA4F;
+    else if ( index >= 0xE50 && index <= 0xE59 )
+        i = index - 0xA4D;
+    else
+        for ( i = 0; ( i < OS2UGL_MAX_GLYPH ) && ( UGL2Uni[i] != index ); i++ );
+
+    if ( i >= OS2UGL_MAX_GLYPH ) return 0;
+    if (( i < pFont->pMetrics->usFirstChar ) ||
+        ( i > ( pFont->pMetrics->usFirstChar + pFont->pMetrics->usLastChar )))
+        return 0;
+
+    if ( CHAR_IS_LATIN1( i )   && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_LATIN1 ))
+        return 0;
+    if ( CHAR_IS_PCEXTRA( i )  && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_PC ))
+        return 0;
+    if ( CHAR_IS_LATINEXT( i ) && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_LATINX ))
+        return 0;
+    if ( CHAR_IS_CYRILLIC( i ) && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_CYRILLIC ))
+        return 0;
+    if ( CHAR_IS_HEBREW( i )   && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_HEBREW ))
+        return 0;
+    if ( CHAR_IS_GREEK( i )    && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_GREEK ))
+        return 0;
+    if ( CHAR_IS_ARABIC( i )   && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_ARABIC ))
+        return 0;
+    if ( CHAR_IS_UGLEXT( i )   && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_UGLEXT ))
+        return 0;
+    if ( CHAR_IS_KANA( i )     && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_KANA ))
+        return 0;
+    if ( CHAR_IS_THAI( i )     && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_THAI ))
+        return 0;
+
+    return ( i );
+}
@@ -0,0 +1,260 @@
+/*****************************************************************************
+ *                                                                           *
+ * unpkbench.c                                                               *
+ *                                                                           *
+ * Microbenchmark for the EXEPACK2 page decoder.  Collects every EXEPACK2    *
+ * (OP32_ITERDATA2) page from a set of LX font modules, checks that the      *
+ * current decoder (LXDecodePage2) produces output identical to the original *
+ * byte-at-a-time decoder, and reports the throughput of each in pages/s.    *
+ *                                                                           *
+ *  (C) 2023 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "otypes.h"
+#include "gpifont.h"
+#include "os2res.h"
+
+#define PAGE_SIZE       4096
+#define MIN_SECONDS     1.0
+
+#define HIBYTE( x )                     (( x & 0xFF00 ) >> 8 )
+#define LOBYTE( x )                     ( x & 0xFF )
+#define WORDFROMBYTES( b1, b2 )         ( b1 | (b2 << 8) )
+#define LONGFROMBYTES( b1, b2, b3, b4 ) ( b1 | (b2 << 8) | (b3 << 16) | ((ULONG) b4 << 24) )
+
+/* A packed page collected from the corpus */
+typedef struct _Packed_Page {
+    PBYTE  pData;
+    USHORT cb;
+} PACKEDPAGE, *PPACKEDPAGE;
+
+/* The decoder under test (internal to gpifont.c) */
+USHORT LXDecodePage2( PBYTE pOut, PBYTE pIn, USHORT cbIn );
+
+/* Local function prototypes */
+ULONG  collect_pages( POS2FILEMAP pMap, PPACKEDPAGE *ppPages, PULONG pcPages, PULONG pcAlloc );
+double time_decoder( PPACKEDPAGE pPages, ULONG cPages, BOOL fOriginal, PULONG pulRuns );
+USHORT orig_unpack2( PBYTE pBuf, USHORT cbPage );
+
+
+/* ------------------------------------------------------------------------ */
+int main( int argc, char *argv[] )
+{
+    POS2FILEMAP pMap;
+    PPACKEDPAGE pPages = NULL;
+    BYTE        abOrig[ PAGE_SIZE ],
+                abNew[ PAGE_SIZE ];
+    ULONG       cPages = 0,
+                cAlloc = 0,
+                cFiles = 0,
+                ulRuns,
+                i;
+    double      dOrig,
+                dNew;
+    int         a;
+
+
+    if ( argc < 2 ) {
+        printf("UNPKBENCH <module> [<module> ...]\n\n");
+        printf("Times the EXEPACK2 page decoder against the original implementation,\n");
+        printf("using every EXEPACK2-compressed page in the given LX font modules.\n");
+        return 0;
+    }
+
+    for ( a = 1; a < argc; a++ ) {
+        if ( OS2MapFile( argv[ a ], &pMap )) {
+            fprintf( stderr, "Failed to read file %s.\n", argv[ a ] );
+            continue;
+        }
+        if ( collect_pages( pMap, &pPages, &cPages, &cAlloc ))
+            cFiles++;
+        /* the collected pages point into the map, so it is kept */
+    }
+    if ( !cPages ) {
+        fprintf( stderr, "No EXEPACK2 pages were found.\n");
+        return 1;
+    }
+    printf("%u EXEPACK2 pages in %u files.\n", cPages, cFiles );
+
+    // Verify that both decoders agree
+    for ( i = 0; i < cPages; i++ ) {
+        memset( abOrig, 0, PAGE_SIZE );
+        memcpy( abOrig, pPages[ i ].pData, pPages[ i ].cb );
+        orig_unpack2( abOrig, pPages[ i ].cb );
+        LXDecodePage2( abNew, pPages[ i ].pData, pPages[ i ].cb );
+        if ( memcmp( abOrig, abNew, PAGE_SIZE )) {
+            fprintf( stderr, "Output mismatch on page %u.\n", i );
+            return 2;
+        }
+    }
+    printf("Output of both decoders is identical.\n\n");
+
+    dOrig = time_decoder( pPages, cPages, TRUE, &ulRuns );
+    printf("original : %12.0f pages/s  (%8.1f MB/s out)\n",
+           ( ulRuns * (double) cPages ) / dOrig,
+           ( ulRuns * (double) cPages * PAGE_SIZE ) / ( dOrig * 1048576.0 ));
+    dNew = time_decoder( pPages, cPages, FALSE, &ulRuns );
+    printf("current  : %12.0f pages/s  (%8.1f MB/s out)\n",
+           ( ulRuns * (double) cPages ) / dNew,
+           ( ulRuns * (double) cPages * PAGE_SIZE ) / ( dNew * 1048576.0 ));
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Add every EXEPACK2 page of an LX module to the page list.                *
+ * ------------------------------------------------------------------------ */
+ULONG collect_pages( POS2FILEMAP pMap, PPACKEDPAGE *ppPages, PULONG pcPages, PULONG pcAlloc )
+{
+    LXHEADER   *plx_hd;
+    PLXOPMENTRY plxpages;
+    ULONG       ulBase = 0,
+                cbPageAddr,
+                cFound = 0,
+                i;
+
+    if ( pMap->cbData < 0x40 ) return 0;
+    if ( WORDFROMBYTES( pMap->pData[ 0 ], pMap->pData[ 1 ] ) == MAGIC_MZ )
+        memcpy( &ulBase, pMap->pData + EH_OFFSET_ADDRESS, 4 );
+    if (( ulBase + sizeof( LXHEADER )) > pMap->cbData ) return 0;
+    plx_hd = (LXHEADER *)( pMap->pData + ulBase );
+    if ( plx_hd->magic != MAGIC_LX ) return 0;
+
+    /* The object page map holds one entry for every page of every object,
+     * so it can be walked from start to end without going through the
+     * object table.  Stop at the first entry outside the file.
+     */
+    plxpages = (PLXOPMENTRY)( pMap->pData + ulBase + plx_hd->objmap );
+    for ( i = 0; ( ulBase + plx_hd->objmap + (( i + 1 ) * sizeof( LXOPMENTRY ))) <= plx_hd->datapage; i++ ) {
+        if ( plxpages[ i ].flags != OP32_ITERDATA2 ) continue;
+        cbPageAddr = plx_hd->datapage + ( plxpages[ i ].dataoffset << plx_hd->pageshift );
+        if ((( cbPageAddr + plxpages[ i ].size ) > pMap->cbData ) ||
+            ( plxpages[ i ].size > PAGE_SIZE ))
+            break;
+        if ( *pcPages == *pcAlloc ) {
+            PPACKEDPAGE p = (PPACKEDPAGE) realloc( *ppPages, ( *pcAlloc + 256 ) * sizeof( PACKEDPAGE ));
+            if ( !p ) break;
+            *ppPages = p;
+            *pcAlloc += 256;
+        }
+        (*ppPages)[ *pcPages ].pData = pMap->pData + cbPageAddr;
+        (*ppPages)[ *pcPages ].cb    = plxpages[ i ].size;
+        (*pcPages)++;
+        cFound++;
+    }
+    return cFound;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Decode the whole page list repeatedly for at least MIN_SECONDS, and      *
+ * return the elapsed time in seconds.                                      *
+ * ------------------------------------------------------------------------ */
+double time_decoder( PPACKEDPAGE pPages, ULONG cPages, BOOL fOriginal, PULONG pulRuns )
+{
+    BYTE    abPage[ PAGE_SIZE ];
+    clock_t start;
+    double  dElapsed;
+    ULONG   i;
+
+    *pulRuns = 0;
+    start = clock();
+    do {
+        for ( i = 0; i < cPages; i++ ) {
+            if ( fOriginal ) {
+                memcpy( abPage, pPages[ i ].pData, pPages[ i ].cb );
+                orig_unpack2( abPage, pPages[ i ].cb );
+            }
+            else
+                LXDecodePage2( abPage, pPages[ i ].pData, pPages[ i ].cb );
+        }
+        (*pulRuns)++;
+        dElapsed = (double)( clock() - start ) / CLOCKS_PER_SEC;
+    } while ( dElapsed < MIN_SECONDS );
+    return dElapsed;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * The original EXEPACK2 decoder, kept here as the reference for            *
+ * correctness and speed.  It unpacks into a temporary buffer, copies each  *
+ * back-reference one byte at a time, and then copies the result back into  *
+ * the input buffer.                                                        *
+ * ------------------------------------------------------------------------ */
+USHORT orig_unpack2( PBYTE pBuf, USHORT cbPage )
+{
+    BYTE   abOut[ 4096 ] = {0};     // temporary output buffer
+    ULONG  ofIn,                    // current input buffer offset
+           ofOut,                   // current output buffer offset
+           ulControl,               // control word(s)
+           ulLen,                   // length of current sequence
+           i;
+    PBYTE  pSrc;
+
+
+    if ( cbPage > 4096 ) return cbPage;
+    ofIn  = 0;
+    ofOut = 0;
+    do {
+        ulControl = WORDFROMBYTES( *(pBuf+ofIn), *(pBuf+ofIn+1) );
+        switch ( ulControl & 0x3 ) {
+            case 0:
+                if ( LOBYTE( ulControl ) == 0 ) {
+                    ulLen = HIBYTE( ulControl );
+                    if ( !ulLen ) goto done;
+                    memset( abOut + ofOut, *(pBuf + ofIn + 2), ulLen );
+                    ofIn  += 3;
+                    ofOut += ulLen;
+                }
+                else {
+                    ulLen = ( LOBYTE( ulControl ) >> 2 );
+                    memcpy( abOut + ofOut, pBuf + ofIn + 1, ulLen );
+                    ofIn  += (ulLen + 1);
+                    ofOut += ulLen;
+                }
+                break;
+
+            case 1:
+                ulLen = ( ulControl >> 2 ) & 0x3;
+                memcpy( abOut + ofOut, pBuf + ofIn + 2, ulLen );
+                ofIn += ulLen + 2;
+                ofOut += ulLen;
+                ulLen = (( ulControl >> 4 ) & 0x7 ) + 3;
+                pSrc = abOut + ( ofOut - (( ulControl >> 7 ) & 0x1FF ));
+                for ( i = 0; i < ulLen; i++ ) abOut[ ofOut + i ] = pSrc[ i ];
+                ofOut += ulLen;
+                break;
+
+            case 2:
+                ulLen = (( ulControl >> 2 ) & 0x3 ) + 3;
+                pSrc = abOut + ( ofOut - (( ulControl >> 4 ) & 0xFFF ));
+                for ( i = 0; i < ulLen; i++ ) abOut[ ofOut + i ] = pSrc[ i ];
+                ofIn  += 2;
+                ofOut += ulLen;
+                break;
+
+            case 3:
+                ulControl = LONGFROMBYTES( *(pBuf+ofIn), *(pBuf+ofIn+1), *(pBuf+ofIn+2), *(pBuf+ofIn+3) );
+                ulLen = ( ulControl >> 2 ) & 0xF;
+                memcpy( abOut + ofOut, pBuf + ofIn + 3, ulLen );
+                ofIn  += ulLen + 3;
+                ofOut += ulLen;
+                ulLen = ( ulControl >> 6 ) & 0x3F;
+                pSrc = abOut + ( ofOut - (( ulControl >> 12 ) & 0xFFF ));
+                for ( i = 0; i < ulLen; i++ ) abOut[ ofOut + i ] = pSrc[ i ];
+                ofOut += ulLen;
+                break;
+        }
+    } while ( ofIn < cbPage );
+
+done:
+    memcpy( pBuf, abOut, 4096 );
+    return 4096;
+}
@@ -0,0 +1,190 @@
+/*****************************************************************************
+ *                                                                           *
+ * xposebench.c                                                              *
+ *                                                                           *
+ * Microbenchmark for the glyph bitmap transpose used when extracting        *
+ * glyphs.  Checks that each SIMD version supported by the CPU gives the     *
+ * same output as the scalar version for every bitmap size up to 8 bytes by  *
+ * 96 rows, and then times each over a range of typical glyph sizes.         *
+ *                                                                           *
+ *  (C) 2023 Alexander Taylor                                                *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "otypes.h"
+#include "gpifont.h"
+
+#define MIN_SECONDS     0.5
+#define MAX_WIDTH       8
+#define MAX_ROWS        96
+#define GLYPH_COUNT     256
+
+#if ( defined( __x86_64__ ) || defined( __i386__ )) && \
+    ( defined( __clang__ ) || \
+      ( defined( __GNUC__ ) && (( __GNUC__ > 4 ) || (( __GNUC__ == 4 ) && ( __GNUC_MINOR__ >= 9 )))))
+#define HAVE_X86_SIMD
+#endif
+
+/* The transpose routines under test (internal to gpifont.c) */
+typedef ULONG (*PFNROWS)( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst );
+#ifdef HAVE_X86_SIMD
+ULONG TransposeRowsAVX2( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst );
+ULONG TransposeRowsSSE2( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst );
+#endif
+ULONG TransposeRowsScalar( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst );
+
+/* A transpose routine and the narrower ones which finish its leftover rows,
+ * the same way TransposeGlyph() chains them.
+ */
+typedef struct _Kernel {
+    const char *pszName;
+    PFNROWS     apfn[ 3 ];
+    const char *pszFeature;
+} KERNEL;
+
+static const KERNEL aKernels[] = {
+    { "scalar", { TransposeRowsScalar, NULL, NULL }, NULL },
+#ifdef HAVE_X86_SIMD
+    { "sse2",   { TransposeRowsSSE2, TransposeRowsScalar, NULL }, "sse2" },
+    { "avx2",   { TransposeRowsAVX2, TransposeRowsSSE2, TransposeRowsScalar }, "avx2" },
+#endif
+    { NULL, { NULL }, NULL }
+};
+
+/* Glyph sizes to time: width in bytes and height in rows */
+static const ULONG aulSizes[][ 2 ] = {
+    { 1, 16 }, { 2, 16 }, { 2, 24 }, { 3, 24 }, { 4, 32 }, { 6, 48 }, { 0, 0 }
+};
+
+/* Local function prototypes */
+BOOL   kernel_supported( const KERNEL *pk );
+void   run_kernel( const KERNEL *pk, PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest );
+double time_kernel( const KERNEL *pk, PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, PULONG pulRuns );
+
+
+/* ------------------------------------------------------------------------ */
+int main( void )
+{
+    PBYTE  pSrc,
+           pRef,
+           pOut;
+    ULONG  cbMax = MAX_WIDTH * MAX_ROWS * GLYPH_COUNT,
+           cx, cy,
+           ulRuns,
+           i, k, s;
+    double dElapsed;
+
+
+    pSrc = (PBYTE) malloc( cbMax );
+    pRef = (PBYTE) malloc( cbMax );
+    pOut = (PBYTE) malloc( cbMax );
+    if ( !pSrc || !pRef || !pOut ) {
+        fprintf( stderr, "Out of memory.\n");
+        return 1;
+    }
+    srand( 1 );
+    for ( i = 0; i < cbMax; i++ ) pSrc[ i ] = (BYTE) rand();
+
+    // Verify every supported kernel against the scalar version
+    for ( k = 1; aKernels[ k ].pszName; k++ ) {
+        if ( !kernel_supported( aKernels + k )) {
+            printf("%-6s : not supported by this CPU\n", aKernels[ k ].pszName );
+            continue;
+        }
+        for ( cx = 1; cx <= MAX_WIDTH; cx++ ) {
+            for ( cy = 1; cy <= MAX_ROWS; cy++ ) {
+                memset( pRef, 0, cx * cy );
+                memset( pOut, 0xFF, cx * cy );
+                run_kernel( aKernels, pSrc, cy, cx, pRef );
+                run_kernel( aKernels + k, pSrc, cy, cx, pOut );
+                if ( memcmp( pRef, pOut, cx * cy )) {
+                    fprintf( stderr, "%s: output mismatch at %u x %u bytes.\n",
+                             aKernels[ k ].pszName, cx, cy );
+                    return 2;
+                }
+            }
+        }
+        printf("%-6s : output identical to scalar\n", aKernels[ k ].pszName );
+    }
+    printf("\n");
+
+    printf("size (bytes x rows)");
+    for ( k = 0; aKernels[ k ].pszName; k++ )
+        if ( kernel_supported( aKernels + k ))
+            printf(" %14s", aKernels[ k ].pszName );
+    printf("   (glyphs/s)\n");
+    for ( s = 0; aulSizes[ s ][ 0 ]; s++ ) {
+        printf("%10u x %-7u", aulSizes[ s ][ 0 ], aulSizes[ s ][ 1 ] );
+        for ( k = 0; aKernels[ k ].pszName; k++ ) {
+            if ( !kernel_supported( aKernels + k )) continue;
+            dElapsed = time_kernel( aKernels + k, pSrc, aulSizes[ s ][ 1 ],
+                                    aulSizes[ s ][ 0 ], pOut, &ulRuns );
+            printf(" %14.0f", ( ulRuns * (double) GLYPH_COUNT ) / dElapsed );
+        }
+        printf("\n");
+    }
+
+    free( pSrc );
+    free( pRef );
+    free( pOut );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Check whether the CPU supports the instruction set used by a kernel.     *
+ * ------------------------------------------------------------------------ */
+BOOL kernel_supported( const KERNEL *pk )
+{
+    if ( !pk->pszFeature ) return TRUE;
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if ( !strcmp( pk->pszFeature, "avx2"))
+        return __builtin_cpu_supports("avx2") ? TRUE : FALSE;
+    if ( !strcmp( pk->pszFeature, "sse2"))
+        return __builtin_cpu_supports("sse2") ? TRUE : FALSE;
+#endif
+    return FALSE;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Transpose one bitmap with a kernel and the ones that follow it.          *
+ * ------------------------------------------------------------------------ */
+void run_kernel( const KERNEL *pk, PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest )
+{
+    ULONG i = 0,
+          n;
+
+    for ( n = 0; ( n < 3 ) && pk->apfn[ n ]; n++ )
+        i = pk->apfn[ n ]( pSrc, cy, usWidth, pDest, i );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Transpose GLYPH_COUNT consecutive bitmaps of the given size repeatedly   *
+ * for at least MIN_SECONDS, and return the elapsed time in seconds.        *
+ * ------------------------------------------------------------------------ */
+double time_kernel( const KERNEL *pk, PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, PULONG pulRuns )
+{
+    clock_t start;
+    double  dElapsed;
+    ULONG   cb = cy * usWidth,
+            i;
+
+    *pulRuns = 0;
+    start = clock();
+    do {
+        for ( i = 0; i < GLYPH_COUNT; i++ )
+            run_kernel( pk, pSrc + ( i * cb ), cy, usWidth, pDest + ( i * cb ));
+        (*pulRuns)++;
+        dElapsed = (double)( clock() - start ) / CLOCKS_PER_SEC;
+    } while ( dElapsed < MIN_SECONDS );
+    return dElapsed;
+}
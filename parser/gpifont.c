@@ -1,932 +1,6760 @@
-/*****************************************************************************
- *                                                                           *
- *  gpifont.c                                                                *
- *                                                                           *
- *  Implementation of support for standard OS/2 PM/GPI bitmap fonts.  The    *
- *  aim is to be as platform-independent as possible, so OS/2-specific APIs  *
- *  are avoided.                                                             *
- *                                                                           *
- *  (C) 2012,2023 Alexander Taylor                                           *
- *                                                                           *
- *  This code is placed in the public domain.                                *
- *                                                                           *
- *****************************************************************************/
-
-/* Uncomment to write the extracted font and fontdir to files:
- * #define DEBUG_DUMP_RESOURCE
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <sys/stat.h>
-#include "otypes.h"
-#include "gpifont.h"
-#include "pmugl.h"
-#include "os2res.h"
-
-
-/* File I/O routines.
- */
-#define _FILE_OPEN( fspec )         fopen( fspec, "rb")
-#define _FILE_STAT( f, pstat )      fstat( fileno(f), pstat )
-#define _FILE_SEEK( f, ofs )        fseek( f, ofs, SEEK_SET )
-#define _FILE_READ( f, pbuf, cb )   fread( (void *) pbuf, 1, cb, f )
-#define _FILE_CLOSE( f )            fclose( f )
-
-
-/* Useful byte-manipulation macros.
- */
-#define HIBYTE( x )                     (( x & 0xFF00 ) >> 8 )
-#define LOBYTE( x )                     ( x & 0xFF )
-#define WORDFROMBYTES( b1, b2 )         ( b1 | (b2 << 8) )
-#define LONGFROMBYTES( b1, b2, b3, b4 ) ( b1 | (b2 << 8) | (b3 << 16) | (b4 << 24) )
-
-
-/* Internal function prototypes.
- */
-void   CopyByteSeq( PUCHAR target, PUCHAR source, ULONG count );
-BOOL   LXExtractResource( FILE *pf, LXHEADER lx_hd, LXRTENTRY lx_rte, ULONG ulBase, PBYTE *ppBuffer, PULONG pulSize );
-USHORT LXUnpack1( PBYTE pBuf, USHORT cbPage );
-USHORT LXUnpack2( PBYTE pBuf, USHORT cbPage );
-
-
-
-/* ------------------------------------------------------------------------- *
- * CopyByteSeq                                                               *
- *                                                                           *
- * Perform a byte-over-byte iterative copy from one byte array into another, *
- * or from one point to another within the same array.  Used by LXUnpack2(). *
- * Note that memcpy() does not work for this purpose, because the source and *
- * target address spaces could overlap - that is, the end of the source      *
- * sequence could extend into the start of the target sequence, thus copying *
- * bytes that were previously written by the same call to this function.     *
- *                                                                           *
- * ------------------------------------------------------------------------- */
-void CopyByteSeq( PUCHAR target, PUCHAR source, ULONG count )
-{
-    ULONG i;
-    for ( i = 0; i < count; i++ ) target[ i ] = source[ i ];
-}
-
-
-/* ------------------------------------------------------------------------- *
- * ExtractOS2FontGlyph                                                       *
- *                                                                           *
- * Extracts the bitmap data for the OS/2 font glyph at the given index, and  *
- * converts it into standard bitmap format.  The bitmap will be written into *
- * the buffer field of the provided glyph information structure; the buffer  *
- * will be allocated by this function and should be freed by the caller when *
- * no longer needed.                                                         *
- *                                                                           *
- * The bitmap has to be converted manually by this function because the      *
- * standard OS/2 font format stores bitmap data with consecutive bytes       *
- * representing vertical columns, rather than rows as with standard bitmaps. *
- *                                                                           *
- * The written bitmap buffer contains the image bits only, no header         *
- * information is included.  The image format is 1 bit per pixel.            *
- *                                                                           *
- * ARGUMENTS:                                                                *
- *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
- *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
- *   PGLYPHBITMAP     pGlyph : Pointer to the glyph information.         (O) *
- *                                                                           *
- * RETURNS: BOOL                                                             *
- * ------------------------------------------------------------------------- */
-BOOL ExtractOS2FontGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph )
-{
-    USHORT       cx, cy,        // size of the character bitmap in pels
-                 bearingL,      // left side-bearing (a_space) in pels
-                 bearingR,      // right side-bearing (c_space) in pels
-                 usWidth,       // number of bytes in each row
-                 i, j, k;       // loop indices
-    PBYTE        pBitmap,       // pointer to bitmap within the font data
-                 pBuffer;       // new buffer to receive the glyph bitmap
-    ULONG        ulPos;         // offset into pBuffer
-    POS2CHARDEF1 pChar1;        // pointer to type 1/2 glyph definition
-    POS2CHARDEF3 pChar3;        // pointer to type 3 glyph definition
-
-
-    // Map index 0 to the default/substitution glyph
-    if ( ulIndex == 0 )
-        ulIndex = pFont->pMetrics->usFirstChar + pFont->pMetrics->usDefaultChar;
-
-    // Make sure our index actually falls within the range contained in the font
-    if (( ulIndex < pFont->pMetrics->usFirstChar ) ||
-        ( ulIndex > ( pFont->pMetrics->usFirstChar +
-                       pFont->pMetrics->usLastChar )))
-        return FALSE;
-
-    ulIndex -= pFont->pMetrics->usFirstChar;
-
-    // Find the character data for the given offset
-    if ( pFont->pFontDef->fsChardef == OS2FONTDEF_CHAR3 ) {
-        pChar3 = (POS2CHARDEF3) ( (PBYTE) pFont->data.pABC +
-                                  ( ulIndex * pFont->pFontDef->usCellSize ));
-        if ( pChar3->ulOffset == 0 ) return FALSE;
-        pBitmap = (PBYTE) pFont->pSignature + pChar3->ulOffset;
-        cx = pChar3->bSpace;
-        bearingL = pChar3->aSpace;
-        bearingR = pChar3->cSpace;
-    }
-    else {
-        pChar1 = (POS2CHARDEF1) ( (PBYTE) pFont->data.pABC +
-                                  ( ulIndex * pFont->pFontDef->usCellSize ));
-        pBitmap = (PBYTE) pFont->pSignature + pChar1->ulOffset;
-        if ( pChar1->ulOffset == 0 ) return FALSE;
-        cx = pChar1->ulWidth;
-        bearingL = 0;
-        bearingR = 0;
-    }
-    cy = pFont->pFontDef->yCellHeight;
-    usWidth = cx / 8;
-    if ( cx % 8 ) usWidth++;
-
-    pBuffer = (PBYTE) calloc( cy, usWidth );
-    if ( !pBuffer ) return FALSE;
-
-    // Now convert the bitmap
-    ulPos = 0;
-    for ( i = 0; i < cy; i++ ) {
-        for ( j = 0; j < usWidth; j++ ) {
-            pBuffer[ ulPos++ ] = pBitmap[ i + (cy * j) ];
-        }
-    }
-    pGlyph->rows         = cy;
-    pGlyph->width        = cx;
-    pGlyph->pitch        = usWidth;
-    pGlyph->buffer       = pBuffer;
-    pGlyph->cbBuffer     = cy * usWidth;
-    pGlyph->horiBearingX = bearingL;
-    pGlyph->horiAdvance  = bearingL + cx + bearingR;
-    pGlyph->vertBearingY = pFont->pMetrics->yExternalLeading;
-    pGlyph->vertAdvance  = cy + pFont->pMetrics->yExternalLeading;
-    return TRUE;
-}
-
-
-/* ------------------------------------------------------------------------- *
- * LXExtractResource                                                         *
- *                                                                           *
- * Extracts a binary resource from an LX-format (32-bit OS/2) module.  The   *
- * function takes a pointer to a buffer which will receive the extracted     *
- * data of the object containing the resource.  It is up to the caller to    *
- * locate the actual resource data within this buffer (this should be        *
- * lx_rte.offset bytes from the start of the buffer).  The buffer is         *
- * allocated by this function on successful return, and must be freed once   *
- * no longer needed.                                                         *
- *                                                                           *
- * This routine is based on information made available by Martin Lafaix,     *
- * Veit Kannegieser and Max Alekseyev.                                       *
- *                                                                           *
- * ARGUMENTS:                                                                *
- *   FILE      *pf      : Pointer to the open file.                      (I) *
- *   LXHEADER   lx_hd   : LX-format executable header                    (I) *
- *   LXRTENTRY  lx_rte  : Resource-table entry of the requested resource (I) *
- *   ULONG      ulBase  : File offset of the LX-format header            (I) *
- *   PBYTE     *ppBuffer: Pointer to a buffer for the resource data      (O) *
- *   PULONG     pulSize : Pointer to the returned resource size          (O) *
- *                                                                           *
- * RETURNS: BOOL                                                             *
- *   FALSE: Failed to extract object data; ppBuffer & pulSize are unchanged. *
- *   TRUE: Data extracted successfully, ppBuffer points to allocated buffer. *
- * ------------------------------------------------------------------------- */
-BOOL LXExtractResource( FILE *pf, LXHEADER lx_hd, LXRTENTRY lx_rte, ULONG ulBase, PBYTE *ppBuffer, PULONG pulSize )
-{
-    LXOTENTRY   lx_obj;      // object table entry
-    PLXOPMENTRY plxpages;    // array of individual object page information
-    USHORT      cb_obj,      // size of an object table entry
-                cb_pme;      // size of an object page map entry
-    ULONG       cbData,      // total size of the object data
-                cbPageAddr,  // address of an individual object page
-                i;
-    PBYTE       pBuf,
-                pBufOff;
-    BOOL        fOK = FALSE;
-
-//printf("Extracting resource %u (%u bytes from %u) from object %u\n", lx_rte.name, lx_rte.cb, lx_rte.offset, lx_rte.obj );
-
-    cb_obj = sizeof( LXOTENTRY );
-    cb_pme = sizeof( LXOPMENTRY );
-
-    // Locate & read the object table entry for this resource
-    if (( _FILE_SEEK( pf, ulBase + lx_hd.obj_tbl +
-                      ( cb_obj * (lx_rte.obj-1) ))) ||
-        ( ! _FILE_READ( pf, &lx_obj, cb_obj ))        )
-        return FALSE;
-
-    // Locate & read the object page table entries for this object
-    plxpages = (PLXOPMENTRY) calloc( lx_obj.mapsize, cb_pme );
-    if ( !plxpages ) return FALSE;
-    cbData = 0;
-    // - go to the first indicated entry in the pagemap
-    if ( _FILE_SEEK( pf, ulBase + lx_hd.objmap +
-                         ( cb_pme * ( lx_obj.pagemap-1 )))) goto finish;
-    // - read the indicated number of pages from this point
-    for ( i = 0; i < lx_obj.mapsize; i++ ) {
-        if ( ! _FILE_READ( pf, (PVOID)(plxpages + i), cb_pme ))
-            goto finish;
-        cbData += (( plxpages[ i ].flags == OP32_ITERDATA ) ||
-                   ( plxpages[ i ].flags == OP32_ITERDATA2 )) ?
-                  4096 : plxpages[ i ].size;
-    }
-
-    if ( cbData < ( lx_rte.offset + lx_rte.cb - 1 )) goto finish;
-
-    // Now read each page from its indicated location into our buffer
-    pBuf = (PBYTE) calloc( cbData, 1 );
-    if ( !pBuf ) goto finish;
-    pBufOff = pBuf;
-    cbData  = 0;
-    for ( i = 0; i < lx_obj.mapsize; i++ ) {
-        cbPageAddr = lx_hd.datapage +
-                     ( plxpages[ i ].dataoffset << lx_hd.pageshift );
-        if (( _FILE_SEEK( pf, cbPageAddr )) ||
-            ( ! _FILE_READ( pf, pBufOff, plxpages[ i ].size )))
-            break;
-//printf(" - page %u [flags 0x%x] size is %u\n", i, plxpages[ i ].flags, plxpages[ i ].size );
-        if ( plxpages[ i ].flags == OP32_ITERDATA )
-            cbData += LXUnpack1( pBufOff, plxpages[ i ].size );
-        else if ( plxpages[ i ].flags == OP32_ITERDATA2 )
-            cbData += LXUnpack2( pBufOff, plxpages[ i ].size );
-        else if ( plxpages[ i ].flags == OP32_VALID )
-            cbData += plxpages[ i ].size;
-        else continue;
-//printf(" - resource buffer size: %u\n", cbData );
-        pBufOff = (PBYTE)(pBuf + cbData);
-        if (( i + 1 ) == lx_obj.mapsize ) fOK = TRUE;
-    }
-    if ( fOK ) {
-        *ppBuffer = pBuf;
-        *pulSize  = cbData;
-    }
-    else free( pBuf );
-
-finish:
-    free( plxpages );
-    return ( fOK );
-}
-
-
-/* ------------------------------------------------------------------------- *
- * LXUnpack1                                                                 *
- *                                                                           *
- * Unpacks a (max 4096-byte) page which has been compressed using the OS/2   *
- * /EXEPACK1 method (a simple form of run-length encoding).  The unpacked    *
- * data (max 4096 bytes) is written back into the input buffer.  The input   *
- * buffer must therefore provide at least 4096 bytes.                        *
- *                                                                           *
- * This algorithm was derived from public-domain Pascal code by Veit         *
- * Kannegieser (based on previous work by Max Alekseyev).                    *
- *                                                                           *
- * ARGUMENTS:                                                                *
- *   PBYTE  pBuf  : Buffer containing the page data.                    (IO) *
- *   USHORT cbPage: The size of the input page data.                     (I) *
- *                                                                           *
- * RETURNS: USHORT                                                           *
- *   The number of output bytes written back to the buffer.                  *
- * ------------------------------------------------------------------------- */
-USHORT LXUnpack1( PBYTE pBuf, USHORT cbPage )
-{
-    BYTE   abOut[ 4096 ] = {0};     // temporary output buffer
-    USHORT ofIn,                    // current input buffer offset
-           ofOut,                   // current output buffer offset
-           usReps,                  // number of repetitions of current sequence
-           usLen;                   // length of current sequence
-
-    if ( cbPage > 4096 ) return cbPage;
-    ofIn  = 0;
-    ofOut = 0;
-    do {
-        usReps = (USHORT)( pBuf[ofIn] | (pBuf[ofIn+1] << 8 ));
-        if ( !usReps ) break;
-        ofIn += 2;
-        usLen = (USHORT)( pBuf[ofIn] | (pBuf[ofIn+1] << 8 ));
-        ofIn += 2;
-        if (( ofOut + ( usReps * usLen )) > 4096 ) break;
-        while ( usReps ) {
-            memcpy( abOut + ofOut, pBuf + ofIn, usLen );
-            usReps--;
-            ofOut += usLen;
-        }
-        ofIn += usLen;
-    } while ( ofIn <= cbPage );
-
-    memcpy( pBuf, abOut, ofOut );
-    return ofOut;
-}
-
-
-/* ------------------------------------------------------------------------- *
- * LXUnpack2                                                                 *
- *                                                                           *
- * Unpacks a (max 4096-byte) page which has been compressed using the OS/2   *
- * /EXEPACK2 method (which is apparently a modified Lempel-Ziv algorithm).   *
- * The unpacked data (max 4096 bytes) is written back into the input buffer. *
- * The input buffer must therefore provide at least 4096 bytes.              *
- *                                                                           *
- * This algorithm was derived from public-domain Pascal-and-x86-assembly     *
- * code by Veit Kannegieser (based on previous work by Max Alekseyev).       *
- *                                                                           *
- * ARGUMENTS:                                                                *
- *   PBYTE  pBuf  : Buffer containing the page data.                    (IO) *
- *   USHORT cbPage: The size of the input page data.                     (I) *
- *                                                                           *
- * RETURNS: USHORT                                                           *
- *   The number of output bytes written back to the buffer.                  *
- * ------------------------------------------------------------------------- */
-USHORT LXUnpack2( PBYTE pBuf, USHORT cbPage )
-{
-    BYTE   abOut[ 4096 ] = {0};     // temporary output buffer
-    ULONG  ofIn,                    // current input buffer offset
-           ofOut,                   // current output buffer offset
-           ulControl,               // control word(s)
-           ulLen;                   // length of current sequence
-
-
-    if ( cbPage > 4096 ) return cbPage;
-    ofIn  = 0;
-    ofOut = 0;
-    do {
-        ulControl = WORDFROMBYTES( *(pBuf+ofIn), *(pBuf+ofIn+1) );
-
-        /* Bits 1 & 0 hold the case flag (0-3); the interpretation of the
-         * remaining bits depend on the flag value.
-         */
-        switch ( ulControl & 0x3 ) {
-            case 0:
-                /* bits 15..8  = length2
-                 * bits  7..2  = length1
-                 */
-                if ( LOBYTE( ulControl ) == 0 ) {
-                    /* When length1 == 0, fill (length2) bytes with the byte
-                     * value following ulControl; if length2 is 0 we're done.
-                     */
-                    ulLen = HIBYTE( ulControl );
-                    if ( !ulLen ) goto done;
-                    memset( abOut + ofOut, *(pBuf + ofIn + 2), ulLen );
-                    ofIn  += 3;
-                    ofOut += ulLen;
-                }
-                else {
-                    // block copy (length1) bytes from after ulControl
-                    ulLen = ( LOBYTE( ulControl ) >> 2 );
-                    memcpy( abOut + ofOut, pBuf + ofIn + 1, ulLen );
-                    ofIn  += (ulLen + 1);
-                    ofOut += ulLen;
-                }
-                break;
-
-            case 1:
-                /* bits 15..7     = backwards reference
-                 * bits  6..4  +3 = length2
-                 * bits  3..2     = length1
-                 */
-                // copy length1 bytes following ulControl
-                ulLen = ( ulControl >> 2 ) & 0x3;
-                memcpy( abOut + ofOut, pBuf + ofIn + 2, ulLen );
-                ofIn += ulLen + 2;
-                ofOut += ulLen;
-                // get length2 from what's been unpacked already
-                ulLen = (( ulControl >> 4 ) & 0x7 ) + 3;
-                CopyByteSeq( abOut + ofOut, abOut + ( ofOut - ((ulControl >> 7 ) & 0x1FF )), ulLen );
-                ofOut += ulLen;
-                break;
-
-            case 2:
-                /* bits 15.. 4     = backwards reference
-                 * bits  3.. 2  +3 = length
-                 */
-                ulLen = (( ulControl >> 2 ) & 0x3 ) + 3;
-                CopyByteSeq( abOut + ofOut, abOut + ( ofOut - ((ulControl >> 4 ) & 0xFFF )), ulLen );
-                ofIn  += 2;
-                ofOut += ulLen;
-                break;
-
-            case 3:
-                ulControl = LONGFROMBYTES( *(pBuf+ofIn), *(pBuf+ofIn+1), *(pBuf+ofIn+2), *(pBuf+ofIn+3) );
-                /* bits 23..21  = ?
-                 * bits 20..12  = backwards reference
-                 * bits 11.. 6  = length2
-                 * bits  5.. 2  = length1
-                 */
-                // block copy (length1) bytes
-                ulLen = ( ulControl >> 2 ) & 0xF;
-                memcpy( abOut + ofOut, pBuf + ofIn + 3, ulLen );
-                ofIn  += ulLen + 3;
-                ofOut += ulLen;
-                // copy (length2) bytes from previously-unpacked data
-                ulLen = ( ulControl >> 6 ) & 0x3F;
-                CopyByteSeq( abOut + ofOut, abOut + ( ofOut - ((ulControl >> 12) & 0xFFF )), ulLen );
-                ofOut += ulLen;
-                break;
-
-        }
-
-    } while ( ofIn < cbPage );
-
-done:
-    /* It seems that the unpacked data will always be 4096 bytes, except for
-     * the final page (which will be taken care of when the caller uses the
-     * total object length to read the concatenated buffer).
-     */
-    memcpy( pBuf, abOut, 4096 );
-    return 4096;
-}
-
-
-/* ------------------------------------------------------------------------- *
- * OS2FontGlyphIndex                                                         *
- *                                                                           *
- * Given a Unicode (UCS) codepoint, convert it into a glyph index/codepoint  *
- * within an OS/2 GPI bitmap font.  This currently supports only standard    *
- * UGL encoding; everything else will be treated as a symbol font (that is   *
- * to say, with passthrough encoding).  Fonts from non-English versions of   *
- * OS/2 prior to 4.5x therefore may not work properly, but such fonts are    *
- * likely vanishingly rare nowadays anyway.  (If the utilising program cares *
- * about this, it should check the pFont->pMetrics->usCodepage field and     *
- * reject any font which does not report 850 or 65400.)  Since OS/2 4.5x     *
- * (circa 1998) bitmap fonts from all languages use the common UGL encoding. *
- *                                                                           *
- * Note that while there is a direct correspondence between the glyph index  *
- * and the physical glyph offset, the two may not be exactly the same if the *
- * first actual character in the font is not character index 0.  The glyph   *
- * offset will be equal to the character index minus the index of the first  *
- * actual character in the font; the conversion is done in the               *
- * ExtractOS2FontGlyph() function.  (The caller need not be aware of the     *
- * distinction, but it is mentioned here just to be thorough.)               *
- *                                                                           *
- * ARGUMENTS:                                                                *
- *   POS2FONTRESOURCE pFont: Pointer to the font data structure.         (I) *
- *   ULONG            index: UCS-2 codepoint requested.                  (I) *
- *                                                                           *
- * RETURNS: ULONG                                                            *
- *   The corresponding index within the font's own encoding (either UGL or   *
- *   passthrough/verbatim), or 0 if the requested character does not exist.  *
- *   (Technically index 0 corresponds to the .null character, but there      *
- *   should be no need to maintain a distinction as .null is by definition   *
- *   not a displayable glyph in any case.)                                   *
- * ------------------------------------------------------------------------- */
-ULONG OS2FontGlyphIndex( POS2FONTRESOURCE pFont, ULONG index )
-{
-    USHORT i;
-
-    // If this is not a UGL font (reported as 0 or 850), assume no translation
-    if ( pFont->pMetrics->usCodePage && ( pFont->pMetrics->usCodePage != 850 ))
-        return index;
-
-    // Basic ASCII needs no translation and is always supported
-    if ( index >= 32 && index <= 126 ) return index;
-
-
-    /* Certain character blocks have direct mappings...
-     */
-
-    // Parts of Cyrillic
-    if ( index >= 0x401 && index <= 0x40C )
-        i = index - 0x281;
-    else if (( index >= 0x40E && index <= 0x45C && index != 0x450 ))
-        i = index - 0x282;
-
-    // Parts of Hebrew
-    else if ( index >= 0x5D0 && index <= 0x5EA )
-        i = index - 0x3B8;
-    else if ( index >= 0x5B0 && index <= 0x5B9 )
-        i = index - 0x37D;
-    else if ( index >= 0x5BB && index <= 0x5C3 )
-        i = index - 0x37E;
-
-    // Halfwidth katakana
-    else if ( index >= 0xFF61 && index <= 0xFF9F )
-        i = index - 0xFC5F;
-
-    // Hangul
-    else if ( index >= 0x3131 && index <= 0x3163 )
-        i = index - 0x2DB1;
-
-    // Thai
-    else if ( index >= 0xE01 && index <= 0xE3A )
-        i = index - 0xA4A;
-    else if ( index >= 0xE40 && index <= 0xE4F )
-        i = index - 0xA4F;
-    else if ( index >= 0xE50 && index <= 0xE59 )
-        i = index - 0xA4D;
-
-
-    /* Otherwise do a brute-force search for the Unicode to UGL mapping
-     * (this is not terribly efficient...)
-     */
-    else
-        for ( i = 0; ( i < OS2UGL_MAX_GLYPH ) && ( UGL2Uni[i] != index ); i++ );
-
-
-    /* We have our UGL index, now see if the font actually supports it
-     */
-
-    // Character not supported by UGL encoding at all, return 0.
-    if ( i >= OS2UGL_MAX_GLYPH ) return 0;
-
-    // Character falls outside the font's own range
-    if (( i < pFont->pMetrics->usFirstChar ) ||
-        ( i > ( pFont->pMetrics->usFirstChar + pFont->pMetrics->usLastChar )))
-        return 0;
-
-    // Character belongs to an unsupported character group
-    if ( CHAR_IS_LATIN1( i )   && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_LATIN1 ))
-        return 0;
-    if ( CHAR_IS_PCEXTRA( i )  && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_PC ))
-        return 0;
-    if ( CHAR_IS_LATINEXT( i ) && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_LATINX ))
-        return 0;
-    if ( CHAR_IS_CYRILLIC( i ) && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_CYRILLIC ))
-        return 0;
-    if ( CHAR_IS_HEBREW( i )   && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_HEBREW ))
-        return 0;
-    if ( CHAR_IS_GREEK( i )    && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_GREEK ))
-        return 0;
-    if ( CHAR_IS_ARABIC( i )   && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_ARABIC ))
-        return 0;
-    if ( CHAR_IS_UGLEXT( i )   && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_UGLEXT ))
-        return 0;
-    if ( CHAR_IS_KANA( i )     && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_KANA ))
-        return 0;
-    if ( CHAR_IS_THAI( i )     && !( pFont->pMetrics->fsDefn & FOCA_CHARSET_THAI ))
-        return 0;
-
-    return ( i );
-}
-
-
-/* ------------------------------------------------------------------------- *
- * ParseOS2FontResource                                                      *
- *                                                                           *
- * Parses a standard GPI-format OS/2 font resource.  Takes as input an       *
- * already-populated memory buffer containing the raw font resource data.    *
- * On successful return, the fields within the OS2FONTRESOURCE structure     *
- * will point to the appropriate structures within the font file data.       *
- *                                                                           *
- * NOTE: Even if this function returns success, the pPanose, pKerning and    *
- * pEnd fields of the pFont structure may be NULL.  The application must     *
- * check for this if it intends to use these fields.                         *
- *                                                                           *
- * ARGUMENTS:                                                                *
- *   PVOID            pBuffer : Buffer containing the font resource data.(I) *
- *   ULONG            cbBuffer: Size of pBuffer in bytes.                (I) *
- *   POS2FONTRESOURCE pFont   : Pointer to an OS2FONTRESOURCE structure      *
- *                              which will receive the parsed font data. (O) *
- *                                                                           *
- * RETURNS: ULONG                                                            *
- *   0 on success or ERR_* on error                                          *
- * ------------------------------------------------------------------------- */
-ULONG ParseOS2FontResource( PVOID pBuffer, ULONG cbBuffer, POS2FONTRESOURCE pFont )
-{
-    PGENERICRECORD pRecord;
-
-    // Verify the file format
-    pRecord = (PGENERICRECORD) pBuffer;
-    if ( ( pRecord->Identity != SIG_OS2FONTSTART ) ||
-         ( pRecord->ulSize != sizeof( OS2FONTSTART )))
-        return ERR_FILE_FORMAT;
-
-    // Now set the pointers in our font type to the correct offsets
-    pFont->pSignature = (POS2FONTSTART) pBuffer;
-    pFont->pMetrics   = (POS2FOCAMETRICS)( (PBYTE) pBuffer + sizeof( OS2FONTSTART ));
-    pFont->pKerning   = NULL;
-    pFont->pPanose    = NULL;
-    pRecord           = (PGENERICRECORD)( (PBYTE)pFont->pMetrics + pFont->pMetrics->ulSize );
-    if ( pRecord->Identity != SIG_OS2FONTDEF ) {
-        return ERR_FILE_FORMAT;
-    }
-    pFont->pFontDef  = (POS2FONTDEFHEADER) pRecord;
-    if ( pFont->pFontDef->fsChardef == OS2FONTDEF_CHAR3 ) {
-        pFont->data.pABC = (POS2CHARDEF3)( (PBYTE) pRecord + sizeof( OS2FONTDEFHEADER ));
-    }
-    else {
-        pFont->data.pChars = (POS2CHARDEF1)( (PBYTE) pRecord + sizeof( OS2FONTDEFHEADER ));
-    }
-    pRecord = (PGENERICRECORD)( (PBYTE) pRecord + pFont->pFontDef->ulSize );
-
-    if ( pFont->pMetrics->usKerningPairs  && ( pRecord->Identity == SIG_OS2KERN )) {
-        pFont->pKerning = (POS2KERNPAIRTABLE) pRecord;
-        /* Advance to the next record (whether OS2ADDMETRICS or OS2FONTEND).
-         * This is a guess; since the actual format, and thus size, of the
-         * kerning information is unclear (see remarks in gpifont.h), there is
-         * no guarantee this will work.  Fortunately, we've already parsed the
-         * important stuff.
-         */
-        pRecord = (PGENERICRECORD)
-                     ( (PBYTE)pRecord + sizeof( OS2KERNPAIRTABLE ) +
-                       ( pFont->pMetrics->usKerningPairs * sizeof ( OS2KERNINGPAIRS )));
-    }
-    if ( pRecord->Identity == SIG_OS2ADDMETRICS ) {
-        pFont->pPanose = (POS2ADDMETRICS) pRecord;
-        pRecord = (PGENERICRECORD)( (PBYTE)pRecord + pRecord->ulSize );
-    }
-
-    /* We set the pointer to the end signature, but there's really no need to
-     * use it for anything.  We check the Identity field to make sure it's
-     * valid (if we did miscalculate the kern table size above, then it could
-     * well be wrong) before setting the pointer.
-     */
-    if ( pRecord->Identity == SIG_OS2FONTEND )
-        pFont->pEnd = (POS2FONTEND) pRecord;
-
-    pFont->cbSize = cbBuffer;
-    return 0;
-}
-
-
-/* ------------------------------------------------------------------------- *
- * ReadOS2FNTFile                                                            *
- *                                                                           *
- * Opens, reads, and parses a standard GPI-format OS/2 font from a FNT file  *
- * (as produced by the Font Editor).  It does NOT read compiled fonts        *
- * (FON/DLL or EXE resources), which are handled by ReadOS2FontResource().   *
- *                                                                           *
- * On successful return, the font contents will be read into the unformatted *
- * buffer pointed to by ppBuffer, which is allocated by this function.  This *
- * buffer should then be passed to ParseOS2FontResource(), and will be       *
- * retained in the resulting OS2FONTRESOURCE structure.                      *
- *                                                                           *
- * ARGUMENTS:                                                                *
- *   FILE  *pf      : Handle to the already-opened file.                 (I) *
- *   PBYTE *ppBuffer: Pointer to the buffer which will be created.       (O) *
- *   PULONG pulSize : Pointer to the created buffer size.                (O) *
- *                                                                           *
- * RETURNS: ULONG                                                            *
- *   0 on success, in which case ppBuffer will point to the read file        *
- *   contents.  ERR_* on failure (in which case ppBuffer will be unchanged). *
- * ------------------------------------------------------------------------- */
-ULONG ReadOS2FNTFile( FILE *pf, PBYTE *ppBuffer, PULONG pulSize )
-{
-    struct stat   fs = {0};    // file information structure
-    size_t        cbRead;
-    ULONG         ulRC;           // return code variable
-    PBYTE         pBuf;           // raw buffer containing file contents
-    GENERICRECORD startrec;
-
-
-    // Get the file size
-    if ( _FILE_STAT( pf, &fs ))
-        return ERR_FILE_STAT;
-    if (( fs.st_size < sizeof( GENERICRECORD )) ||
-        ( ! _FILE_READ( pf, &startrec, sizeof( GENERICRECORD ))))
-        return ERR_FILE_FORMAT;
-    if ( _FILE_SEEK( pf, 0 ))
-        return ERR_FILE_READ;
-
-    if ( startrec.Identity != SIG_OS2FONTSTART )
-        return ERR_FILE_FORMAT;
-
-    // Allocate our read/write buffer using the file size
-    pBuf = (char *) calloc( fs.st_size, 1 );
-    if ( !pBuf )
-        return ERR_MEMORY;
-
-    /* Read the file contents into memory (this shouldn't be too expensive, as
-     * an average FNT file is only around 15-30 KB, and even the largest font
-     * shouldn't be more than about twice that).
-     */
-    cbRead = _FILE_READ( pf, pBuf, fs.st_size );
-    if ( !cbRead ) {
-        free( pBuf );
-        return ERR_FILE_READ;
-    }
-    *ppBuffer = pBuf;
-    *pulSize  = fs.st_size;
-    return 0;
-}
-
-
-/* ------------------------------------------------------------------------- *
- * ReadOS2FontResource                                                       *
- *                                                                           *
- * Extracts and parses a font face from the specified file.  This requires   *
- * reading the binary resources from an OS/2 executable (program or DLL).    *
- *                                                                           *
- * On successful return, the fields within the OS2FONTRESOURCE structure     *
- * will point to the appropriate structures within the font file data.  The  *
- * entire font is read into an allocated memory buffer which must be freed   *
- * when no longer needed.  (The pSignature pointer within OS2FONTRESOURCE    *
- * corresponds to the start of the buffer, and can be used as a reference to *
- * the allocated buffer as a whole.)                                         *
- *                                                                           *
- * ARGUMENTS:                                                                *
- *   PSZ              pszFile : Fully-qualified name of the font file.   (I) *
- *   ULONG            ulFace  : Font (face) number within the file to        *
- *                              retrieve (where 0 is the first font).    (I) *
- *   PULONG           pulCount: Total number of faces found in file.     (O) *
- *   POS2FONTRESOURCE pFont   : Pointer to an OS2FONTRESOURCE structure      *
- *                              which will receive the parsed font data. (O) *
- *                                                                           *
- * RETURNS: ULONG                                                            *
- *   0 if the font was successfully read and parsed, ERR_* otherwise.        *
- * ------------------------------------------------------------------------- */
-ULONG ReadOS2FontResource( PSZ pszFile, ULONG ulFace, PULONG pulCount, POS2FONTRESOURCE pFont )
-{
-    ULONG       ulAddr,         // address of the new-style EXE header
-                ulFaceCount,    // number of faces found
-                ulResID,        // target resource ID (when fontdir is used)
-                cbFont = 0,     // size of found font resource
-                cbInc,          // offset increment of current resource entry
-                i,
-                ulRC;
-    USHORT      usMagic,        // 2-byte magic number
-                cb_rte;         // size of a resource entry
-    BOOL        fFound;         // has the requested font been found?
-    PBYTE       pBuf;
-    FILE        *pf;
-
-#ifdef DEBUG_DUMP_RESOURCE
-    FILE *tf;
-#endif
-
-
-    ulRC        = ERR_NO_FONT;
-    fFound      = FALSE;
-    ulFaceCount = 0;
-    ulResID     = 0;
-    pBuf        = NULL;
-
-    // Open the file
-    if (( pf = _FILE_OPEN( pszFile )) == NULL )
-        return ERR_FILE_OPEN;
-
-    // See if it's an executable (EXE or DLL)
-    if ( ! _FILE_READ( pf, &usMagic, 2 )) goto read_fail;
-
-    if ( usMagic == MAGIC_MZ ) {
-        // Locate the new-type executable header
-        if ( _FILE_SEEK( pf, EH_OFFSET_ADDRESS )) goto read_fail;
-        if ( ! _FILE_READ( pf, &ulAddr, 4 ))      goto read_fail;
-        // Read the 2-byte magic number from this address
-        if ( _FILE_SEEK( pf, ulAddr ))            goto read_fail;
-        if ( ! _FILE_READ( pf, &usMagic, 2 ))     goto read_fail;
-        // Now back up to the start of the new-type header again
-        if ( _FILE_SEEK( pf, ulAddr ))            goto read_fail;
-    }
-    else if (( usMagic == MAGIC_LX ) || ( usMagic == MAGIC_NE )) {
-        // No stub header, just start at the beginning of the file
-        ulAddr = 0;
-        if ( _FILE_SEEK( pf, 0 )) goto read_fail;
-    }
-    else {
-        // Not a compiled (exe) font module
-        // (non-compiled fonts cannot contain more than one face)
-        if ( ulFace ) return ERR_NO_FONT;
-
-        // Try to read it as a raw font file and then return
-        if ( _FILE_SEEK( pf, 0 )) goto read_fail;
-        ulRC = ReadOS2FNTFile( pf, &pBuf, &cbFont );
-        if ( ulRC != 0 ) goto read_fail;
-        ulRC = ParseOS2FontResource( pBuf, cbFont, pFont );
-        if ( ulRC != 0 ) {
-            free( pBuf );
-            goto read_fail;
-        }
-        fFound = TRUE;
-        ulFaceCount = 1;
-        goto done;
-    }
-
-    // Identify the executable type and parse the resource data accordingly
-    if ( usMagic == MAGIC_LX )
-    {
-        LXHEADER  lx_hd;   // executable header
-        LXRTENTRY lx_rte;  // resource table entry
-
-        if ( ! _FILE_READ( pf, &lx_hd, sizeof( LXHEADER ))) goto read_fail;
-
-        // Make sure the file actually contains resources...
-        if ( !lx_hd.cres ) {
-            ulRC = ERR_FILE_FORMAT;
-            goto done;
-        }
-        // ...and at least as many as the number of the font requested
-        if ( ulFace >= lx_hd.cres )  {
-            ulRC = ERR_NO_FONT;
-            goto done;
-        }
-
-        // Now look for font resources
-        cb_rte = sizeof( LXRTENTRY );
-        for ( i = 0; i < lx_hd.cres; i++ ) {
-            cbInc = cb_rte * i;
-            if ( _FILE_SEEK( pf, ulAddr + lx_hd.res_tbl + cbInc )) goto read_fail;
-            if ( ! _FILE_READ( pf, &lx_rte, cb_rte ))              goto read_fail;
-
-            /* If ulResID is non-0 then we've already found & parsed a font
-             * directory resource (see below), so we look for the resource with
-             * that as its ID.  Otherwise, look for the ulFace'th font resource
-             * found.
-             */
-            if ( lx_rte.type == OS2RES_FONTFACE ) {
-                if ( !ulResID ) ulFaceCount++;
-                // If we've already got our font then just count the remaining ones
-                if ( fFound ) continue;
-                if ((( ulFaceCount - 1 ) != ulFace ) &&
-                    !( ulResID && ( lx_rte.name == ulResID )))
-                    continue;
-            }
-            if (( lx_rte.type != OS2RES_FONTDIR ) &&
-                !( ulResID && ( lx_rte.name == ulResID )))
-                continue;
-
-            /* This is either our target font, or else a font directory
-             * resource.  Either way, extract the resource data.
-             */
-            pBuf = NULL;
-            if ( !LXExtractResource( pf, lx_hd, lx_rte, ulAddr, &pBuf, &cbFont ) || !pBuf )
-                goto read_fail;
-
-#ifdef DEBUG_DUMP_RESOURCE
-            tf = fopen( tmpnam(NULL), "wb");
-            fwrite( pBuf+lx_rte.offset, 1, lx_rte.cb, tf );
-            fclose( tf );
-#endif
-
-            if ( lx_rte.type == OS2RES_FONTDIR ) {
-                /* If a font directory exists we use that to find the face's
-                 * resource ID, as in this case it is not guaranteed to have
-                 * a type of OS2RES_FONTFACE (7).
-                 */
-                 POS2FONTDIRECTORY pFD = (POS2FONTDIRECTORY)(pBuf + lx_rte.offset);
-
-                 ulFaceCount = pFD->usnFonts;
-                 if ( pFD->usnFonts < ( ulFace + 1 )) {
-                    ulRC = ERR_NO_FONT;
-                    free( pBuf );
-                    goto done;
-                 }
-                 /* Set ulResID to the ID of the requested font number, then
-                  * continue scanning the resource table.
-                  */
-                 ulResID = pFD->fntEntry[ ulFace ].usIndex;
-                 free( pBuf );
-            }
-            else {
-                /* pBuf contains our font at the located offset.  Copy into a new
-                 * buffer which we can safely entrust to the caller, then parse it.
-                 */
-                PBYTE pReturnBuf = (PBYTE) malloc( lx_rte.cb );
-                if ( !pReturnBuf ) {
-                    ulRC = ERR_MEMORY;
-                    free( pBuf );
-                    goto done;
-                }
-                memcpy( pReturnBuf, pBuf + lx_rte.offset, lx_rte.cb );
-                free( pBuf );
-                ulRC = ParseOS2FontResource( pReturnBuf, lx_rte.cb, pFont );
-                if ( ulRC != 0 ) goto read_fail;
-                fFound = TRUE;
-                /* If we successfully read a font directory resource, we already
-                 * have the total number of fonts - we don't need to count the
-                 * remaining fonts iteratively, so we can just finish up now.
-                 */
-                if ( ulResID ) goto done;
-            }
-
-        }
-        if ( !fFound ) {
-            ulRC = ERR_NO_FONT;
-        }
-    }
-#if 0
-    else if ( strcmp( cchSig, "NE") == 0 )
-    {
-        NEHEADER    ne_hd;
-        NERTENTRY   ne_rte;
-
-        if ( DosRead( hFile, &ne_hd, sizeof( NEHEADER ), &cb )) goto read_fail;
-        if ( !ne_hd.cres ) {
-            ulRC = ERR_FILE_FORMAT;
-            goto done;
-        }
-        cb_rte = sizeof( NERTENTRY );
-        for ( i = 0; i < ne_hd.cres; i++ ) {
-            cbInc = cb_rte * i;
-            if ( DosSetFilePtr( hFile, ne_hd.res_tbl + cbInc, FILE_BEGIN, &cb )) goto read_fail;
-            if ( DosRead( hFile, &ne_rte, cb_rte, &cb )) goto read_fail;
-            if ( ne_rte.type == 7 ) ulFaceCount++;
-            else continue;
-            if ( ulFaceCount != ulFace ) continue;
-
-        }
-
-    }
-#endif
-    else {
-        ulRC = ERR_FILE_FORMAT;
-    }
-
-    goto done;
-
-read_fail:
-    ulRC = ERR_FILE_READ;
-done:
-    _FILE_CLOSE( pf );
-    *pulCount = ulFaceCount;
-    return ulRC;
-}
-
-
+/*****************************************************************************
+ *                                                                           *
+ *  gpifont.c                                                                *
+ *                                                                           *
+ *  Implementation of support for standard OS/2 PM/GPI bitmap fonts.  The    *
+ *  aim is to be as platform-independent as possible, so OS/2-specific APIs  *
+ *  are avoided.                                                             *
+ *                                                                           *
+ *  (C) 2012,2023 Alexander Taylor                                           *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+/* Uncomment to write the extracted font and fontdir to files:
+ * #define DEBUG_DUMP_RESOURCE
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "otypes.h"
+#include "gpifont.h"
+#include "pmugl.h"
+#include "os2res.h"
+
+/* Use memory-mapped file I/O where the platform supports it; otherwise
+ * OS2MapFile() falls back to reading the whole file into memory.  Likewise,
+ * object pages are only unpacked on multiple threads where POSIX threads
+ * are available (see SetOS2UnpackThreads).
+ */
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <unistd.h>
+#if defined( _POSIX_MAPPED_FILES ) && ( _POSIX_MAPPED_FILES > 0 )
+#include <fcntl.h>
+#include <sys/mman.h>
+#define HAVE_MMAP
+#endif
+#if defined( _POSIX_THREADS ) && ( _POSIX_THREADS > 0 )
+#include <pthread.h>
+#define HAVE_PTHREADS
+#endif
+#endif
+
+/* On x86 with GCC (4.9 or later) or clang, SSE2 and AVX2 versions of the glyph
+ * bitmap transpose are built, and selected at run time according to what the
+ * CPU supports (see TransposeGlyph).
+ */
+#if ( defined( __x86_64__ ) || defined( __i386__ )) && \
+    ( defined( __clang__ ) || \
+      ( defined( __GNUC__ ) && (( __GNUC__ > 4 ) || (( __GNUC__ == 4 ) && ( __GNUC_MINOR__ >= 9 )))))
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#endif
+
+
+/* File I/O routines.
+ */
+#define _FILE_OPEN( fspec )         fopen( fspec, "rb")
+#define _FILE_STAT( f, pstat )      fstat( fileno(f), pstat )
+#define _FILE_SEEK( f, ofs )        fseek( f, ofs, SEEK_SET )
+#define _FILE_READ( f, pbuf, cb )   fread( (void *) pbuf, 1, cb, f )
+#define _FILE_CLOSE( f )            fclose( f )
+
+
+/* Useful byte-manipulation macros.
+ */
+#define HIBYTE( x )                     (( x & 0xFF00 ) >> 8 )
+#define LOBYTE( x )                     ( x & 0xFF )
+#define WORDFROMBYTES( b1, b2 )         ( b1 | (b2 << 8) )
+#define LONGFROMBYTES( b1, b2, b3, b4 ) ( b1 | (b2 << 8) | (b3 << 16) | (b4 << 24) )
+
+
+/* Size of an LX object page once unpacked.
+ */
+#define LX_PAGE_SIZE                    4096
+
+
+/* Add to a statistics counter, atomically where the compiler supports it.
+ */
+#if defined( __GNUC__ )
+#define _STAT_ADD( var, n )             __atomic_fetch_add( &(var), (n), __ATOMIC_RELAXED )
+#else
+#define _STAT_ADD( var, n )             ( (var) += (n) )
+#endif
+
+
+/* Reference counting for glyph cache entries, which may be released by any
+ * thread without holding the cache lock.
+ */
+#if defined( __GNUC__ )
+#define _REF_ADD( var )                 __atomic_add_fetch( &(var), 1, __ATOMIC_ACQ_REL )
+#define _REF_RELEASE( var )             __atomic_sub_fetch( &(var), 1, __ATOMIC_ACQ_REL )
+#define _FLAG_SET( var )                __atomic_store_n( &(var), TRUE, __ATOMIC_RELAXED )
+#else
+#define _REF_ADD( var )                 ( ++(var) )
+#define _REF_RELEASE( var )             ( --(var) )
+#define _FLAG_SET( var )                ( (var) = TRUE )
+#endif
+
+
+/* Glyph cache locking: lookups share the cache, changes need it exclusively.
+ */
+#ifdef HAVE_PTHREADS
+#define _CACHE_READ( c )                pthread_rwlock_rdlock( &(c)->rwl )
+#define _CACHE_WRITE( c )               pthread_rwlock_wrlock( &(c)->rwl )
+#define _CACHE_UNLOCK( c )              pthread_rwlock_unlock( &(c)->rwl )
+#else
+#define _CACHE_READ( c )
+#define _CACHE_WRITE( c )
+#define _CACHE_UNLOCK( c )
+#endif
+
+
+/* Object cache locking: the cache is shared by every thread in the process.
+ */
+#ifdef HAVE_PTHREADS
+#define _OBJCACHE_LOCK()                pthread_mutex_lock( &object_cache.mtx )
+#define _OBJCACHE_UNLOCK()              pthread_mutex_unlock( &object_cache.mtx )
+#define _OBJPAGES_LOCK( e )             pthread_mutex_lock( &(e)->mtxPages )
+#define _OBJPAGES_UNLOCK( e )           pthread_mutex_unlock( &(e)->mtxPages )
+#else
+#define _OBJCACHE_LOCK()
+#define _OBJCACHE_UNLOCK()
+#define _OBJPAGES_LOCK( e )
+#define _OBJPAGES_UNLOCK( e )
+#endif
+
+/* Default memory budget of the object cache (see SetOS2ObjectCacheBudget).
+ */
+#define OBJECT_CACHE_BUDGET             ( 16 * 1024 * 1024 )
+
+
+/* Number of glyph bitmap columns (bytes) which DrawGlyph1bpp() shifts into
+ * place at once; with up to 7 bits of shift, these fill a 64-bit word.
+ */
+#define DRAW_GROUP_COLUMNS              7
+
+/* Number of glyph indices converted at a time by RenderOS2FontText().
+ */
+#define RENDER_CHUNK                    256
+
+
+/* Font catalog index files (see SaveOS2FontCatalog) start with this magic
+ * string and format version.  The version must be changed whenever the
+ * layout of the file, or of OS2CATALOGFACE, changes.
+ */
+#define CATALOG_MAGIC                   "OS2FCAT"
+#define CATALOG_VERSION                 1
+
+/* Number of files for which space is added to a font catalog at a time.
+ */
+#define CATALOG_GROW                    256
+
+
+/* Hash function for the kerning index.  The table size is a power of two
+ * of at least twice the number of pairs (and no less than KERN_MIN_SLOTS),
+ * so at most 2^17 slots, which the top 17 bits of the product can address.
+ */
+#define KERN_HASH( ulPair, ulMask )     (( (ULONG)(( ulPair ) * 0x9E3779B1UL ) >> 15 ) & ( ulMask ))
+#define KERN_MIN_SLOTS                  16
+
+/* Initial number of hash buckets in a glyph cache (a power of 2); the table
+ * is doubled whenever there are more glyphs than buckets.
+ */
+#define GLYPH_CACHE_BUCKETS             256
+
+/* Hash of a glyph cache key, given the number of buckets.
+ */
+#define GLYPH_CACHE_HASH( pFont, i, n ) \
+    (((((ULONG)( size_t )( pFont ) >> 4 ) * 31 ) + (( i ) * 2654435761U )) & (( n ) - 1 ))
+
+
+/* Minimum number of packed pages worth handing to the unpacking thread pool;
+ * smaller batches are unpacked on the calling thread.
+ */
+#define LX_POOL_MIN_PAGES               8
+
+/* Maximum number of unpacking threads (including the calling thread).
+ */
+#define LX_POOL_MAX_THREADS             64
+
+/* LXDecodePage2() decodes without bounds checks while this much packed input
+ * and page output remain: the most that one token can read (a 63-byte
+ * literal) or write (a 15-byte literal and a 63-byte back-reference, not
+ * counting fills, which are checked), plus the 7 bytes by which the wide
+ * copies may overrun.
+ */
+#define LX2_FAST_INPUT                  ( 1 + 63 + 8 )
+#define LX2_FAST_OUTPUT                 ( 15 + 63 + 8 )
+
+
+/* Parameters of the EXEPACK encoders (see PackOS2ObjectPage).  An EXEPACK1
+ * record costs four bytes before its data, so the fast encoder only uses
+ * runs of PACK1_MIN_RUN bytes or more; the best-ratio encoder also looks for
+ * repeated patterns of up to PACK1_MAX_PERIOD bytes, trying up to
+ * PACK1_MAX_STEPS repeat counts as well as the longest.  An EXEPACK2 fill
+ * costs three bytes, and back-references cover 3-63 bytes at a distance of
+ * up to 4095 bytes (up to 511 for the two-byte form which also carries up to
+ * 3 literals).  Back-references are found through hash chains of 3-byte
+ * sequences, of which the fast encoder follows PACK_FAST_CHAIN links and the
+ * best-ratio encoder PACK_BEST_CHAIN.
+ */
+#define PACK1_MIN_RUN                   10
+#define PACK1_MAX_PERIOD                16
+#define PACK1_MAX_STEPS                 16
+#define PACK2_MIN_RUN                   4
+#define PACK2_MAX_FILL                  0xFF
+#define PACK2_MAX_MATCH                 63
+#define PACK2_MAX_LITERALS              63
+#define PACK2_NEAR_DIST                 0x1FF
+#define PACK2_FAR_DIST                  0xFFF
+#define PACK_HASH_SIZE                  4096
+#define PACK_FAST_CHAIN                 64
+#define PACK_BEST_CHAIN                 256
+#define PACK_NO_POS                     0xFFFF
+#define PACK_NO_COST                    0xFFFF
+
+#define PACK_HASH( p ) (((( p )[ 0 ] << 7 ) ^ (( p )[ 1 ] << 3 ) ^ ( p )[ 2 ] ) & ( PACK_HASH_SIZE - 1 ))
+
+/* Size of a run of EXEPACK2 literals, split into blocks of up to 63 bytes.
+ */
+#define PACK2_LITERAL_SIZE( n )         (( n ) + ((( n ) + PACK2_MAX_LITERALS - 1 ) / PACK2_MAX_LITERALS ))
+
+/* Kinds of record chosen by the best-ratio encoders.
+ */
+#define PACK_REC_LITERALS               0   // literal bytes only
+#define PACK_REC_FILL                   1   // EXEPACK2 fill
+#define PACK_REC_NEAR                   2   // EXEPACK2 case 1 back-reference
+#define PACK_REC_SHORT                  3   // EXEPACK2 case 2 back-reference
+#define PACK_REC_LONG                   4   // EXEPACK2 case 3 back-reference
+#define PACK_REC_ITERATED               5   // EXEPACK1 repeated pattern
+
+
+/* Font modules written by BuildOS2FontModule() start with a DOS stub of this
+ * size, which just prints LX_STUB_MESSAGE if the module is run under DOS.
+ */
+#define LX_STUB_SIZE                    0x80
+#define LX_STUB_MESSAGE                 "This program cannot be run in a DOS session.\r\r\n$"
+
+
+/* An object page waiting to be unpacked (see LXDecodePages).
+ */
+typedef struct _LX_Page_Job {
+    PBYTE  pSrc;                    // page data as stored in the file
+    PBYTE  pDest;                   // 4 KiB slot for the unpacked page
+    USHORT cbSrc;                   // size of the stored page data
+    USHORT usFlags;                 // page type (OP32_*)
+} LXPAGEJOB, *PLXPAGEJOB;
+
+
+/* A key in the resource index of an LX module (see LXIndexResources).  The
+ * index is sorted by type, then name, then resource table position.
+ */
+typedef struct _LX_Resource_Key {
+    USHORT usType;                  // resource type (OS2RES_*)
+    USHORT usName;                  // resource ID
+    ULONG  ulEntry;                 // number of the resource table entry
+} LXRESKEY, *PLXRESKEY;
+
+/* The header and tables of an LX module which are needed to extract its
+ * resources from the file, each read in one go (see LXReadTables).
+ */
+typedef struct _LX_Module_Tables {
+    LXHEADER    lx_hd;              // executable header
+    ULONG       ulBase;             // file offset of the header
+    OS2FILEID   id;                 // identity of the file
+    LXRTENTRY  *paResources;        // resource table (lx_hd.cres entries)
+    PLXRESKEY   paIndex;            // resource index (lx_hd.cres entries)
+    LXOTENTRY  *paObjects;          // object table (lx_hd.objcnt entries)
+    PLXOPMENTRY paPages;            // object page map
+    ULONG       cPages;             // number of page map entries
+} LXTABLES, *PLXTABLES;
+
+/* Working storage of the best-ratio EXEPACK encoders (LXPack1Best and
+ * LXPack2Best), which find the cheapest encoding of every prefix of the
+ * page in turn.  Each array entry describes the last record of the cheapest
+ * encoding of the page up to that offset.
+ */
+typedef struct _LX_Pack_Work {
+    USHORT ausCost[ LX_PAGE_SIZE + 1 ];   // encoded size of the prefix
+    USHORT ausFrom[ LX_PAGE_SIZE + 1 ];   // where the last record starts
+    USHORT ausDist[ LX_PAGE_SIZE + 1 ];   // back-reference distance or period
+    BYTE   abLits[ LX_PAGE_SIZE + 1 ];    // literals in the record
+    BYTE   abType[ LX_PAGE_SIZE + 1 ];    // kind of record (PACK_REC_*)
+    USHORT ausPath[ LX_PAGE_SIZE + 1 ];   // record ends, last to first
+    USHORT ausHead[ PACK_HASH_SIZE ];     // latest position of each hash
+    USHORT ausPrev[ LX_PAGE_SIZE ];       // previous position, same hash
+    BYTE   abFast[ LX_PAGE_SIZE ];        // the fast encoder's output
+} LXPACKWORK, *PLXPACKWORK;
+
+
+#ifdef HAVE_PTHREADS
+/* The pool of worker threads which unpack object pages.  The caller of
+ * LXDecodePages() posts a batch of pages and then works on it alongside the
+ * workers; only one batch is in progress at any time.
+ */
+typedef struct _LX_Unpack_Pool {
+    pthread_mutex_t mtxBatch;       // held by the thread which owns the pool
+    pthread_mutex_t mtx;            // protects the fields below
+    pthread_cond_t  cvWork;         // signalled when a batch is posted
+    pthread_cond_t  cvDone;         // signalled when a batch is finished
+    pthread_t      *paThreads;      // the worker threads
+    ULONG           cWorkers;       // number of worker threads
+    PLXPAGEJOB      pJobs;          // pages in the current batch
+    ULONG           cJobs,          // number of pages in the current batch
+                    iNext,          // next page to be claimed
+                    cChunk,         // number of pages claimed at once
+                    cPending;       // number of pages not yet unpacked
+    BOOL            fStop;          // tells the workers to exit
+} LXUNPACKPOOL;
+
+static LXUNPACKPOOL unpack_pool = { PTHREAD_MUTEX_INITIALIZER,
+                                    PTHREAD_MUTEX_INITIALIZER,
+                                    PTHREAD_COND_INITIALIZER,
+                                    PTHREAD_COND_INITIALIZER,
+                                    NULL, 0, NULL, 0, 0, 0, 0, FALSE };
+#endif
+
+
+/* A glyph in a glyph cache.  The bitmap follows the structure in the same
+ * allocation.  Each entry holds one reference for as long as it is in the
+ * cache, plus one for every lookup which has not yet been released; it is
+ * freed when the last reference is dropped.  Unpinned entries are kept in a
+ * ring, which the CLOCK hand sweeps to find glyphs to evict.
+ */
+typedef struct _Glyph_Cache_Entry {
+    struct _Glyph_Cache_Entry *pNext;      // next entry in the hash chain
+    struct _Glyph_Cache_Entry *pRingNext;  // next entry in the ring
+    struct _Glyph_Cache_Entry *pRingPrev;  // previous entry in the ring
+    POS2FONTRESOURCE pFont;                // font the glyph belongs to
+    ULONG            ulIndex;              // glyph index within the font
+    ULONG            cb;                   // size of the entry and bitmap
+    ULONG            cRefs;                // references (see above)
+    BOOL             fReferenced;          // used since the hand last passed
+    BOOL             fPinned;              // never evicted (not in the ring)
+    GLYPHBITMAP      glyph;                // the glyph itself
+} GLYPHCACHEENTRY, *PGLYPHCACHEENTRY;
+
+/* A glyph cache (declared in gpifont.h).
+ */
+struct _OS2_Glyph_Cache {
+#ifdef HAVE_PTHREADS
+    pthread_rwlock_t    rwl;        // lock protecting the cache
+#endif
+    PGLYPHCACHEENTRY   *papBuckets; // hash table of all entries
+    ULONG               cBuckets;   // number of hash buckets
+    PGLYPHCACHEENTRY    pHand;      // the CLOCK hand (NULL if ring empty)
+    OS2GLYPHCACHESTATS  stats;      // counters and current usage
+};
+
+
+/* An LX object in the object cache.  The object data, followed by a flag for
+ * each page saying whether it has been unpacked, follows the structure in
+ * the same allocation.  Pages are only unpacked when a resource lying on
+ * them is used, and only they count towards the cache budget.  As with
+ * glyph cache entries, each entry holds one reference for as long as it is
+ * in the cache, plus one for every font (or other user) of the object, and
+ * is freed when the last reference is dropped.  The cached objects are kept
+ * in a list, most recently used first.
+ */
+typedef struct _Object_Cache_Entry {
+    struct _Object_Cache_Entry *pNext;     // next (less recently used) entry
+    struct _Object_Cache_Entry *pPrev;     // previous (more recently used) entry
+    OS2FILEID        id;                   // file the object belongs to
+    ULONG            ulObj;                // object number (1-based)
+    ULONG            cPages;               // number of pages in the object
+    ULONG            cb;                   // size of the entry and unpacked pages
+    ULONG            cRefs;                // references (see above)
+    BOOL             fCached;              // still in the cache
+    PBYTE            pData;                // the object
+    PBYTE            pbDone;               // flags of the unpacked pages
+#ifdef HAVE_PTHREADS
+    pthread_mutex_t  mtxPages;             // held while unpacking pages
+#endif
+} OBJCACHEENTRY, *POBJCACHEENTRY;
+
+/* The object cache (see SetOS2ObjectCacheBudget), shared by the whole
+ * process.
+ */
+typedef struct _Object_Cache {
+#ifdef HAVE_PTHREADS
+    pthread_mutex_t     mtx;        // lock protecting the cache
+#endif
+    POBJCACHEENTRY      pHead;      // most recently used object
+    POBJCACHEENTRY      pTail;      // least recently used object
+    OS2OBJECTCACHESTATS stats;      // counters and current usage
+} OBJECTCACHE;
+
+
+/* The header of a font catalog index file.  It is followed by cFiles file
+ * records, then by the cFaces face records of all the files (in the same
+ * order), and finally by cbNames bytes of null-terminated filenames.  The
+ * files are sorted by name.  All values are in native byte order.
+ */
+typedef struct _Catalog_Header {
+    CHAR     achMagic[ 8 ];         // CATALOG_MAGIC
+    ULONG    ulVersion;             // CATALOG_VERSION
+    ULONG    cbFace;                // size of each face record
+    ULONG    cFiles;                // number of file records
+    ULONG    cFaces;                // number of face records
+    ULONG    cbNames;               // size of the filenames
+} CATALOGHEADER, *PCATALOGHEADER;
+
+/* A file record in a font catalog index file.
+ */
+typedef struct _Catalog_File_Record {
+    uint64_t ullMTime;              // modification time of the file
+    uint64_t ullSize;               // size of the file in bytes
+    ULONG    ofName;                // offset of the filename in the names
+    ULONG    cFaces;                // number of faces in the file
+} CATALOGFILEREC, *PCATALOGFILEREC;
+
+/* A file in a font catalog.  A file with no faces is one which could not be
+ * parsed; it is kept so that it is not parsed again until it changes.
+ */
+typedef struct _Catalog_File {
+    PSZ             pszPath;        // filename, as it was catalogued
+    uint64_t        ullMTime;       // modification time when catalogued
+    uint64_t        ullSize;        // size when catalogued
+    POS2CATALOGFACE paFaces;        // the faces in the file (or NULL)
+    ULONG           cFaces;         // number of faces
+    BOOL            fSeen;          // updated since the catalog was opened
+} CATALOGFILE, *PCATALOGFILE;
+
+/* A font catalog (declared in gpifont.h).
+ */
+struct _OS2_Font_Catalog {
+    PSZ             pszIndex;       // name of the index file
+    PCATALOGFILE    paFiles;        // the files, sorted by name
+    ULONG           cFiles,         // number of files
+                    cAlloc;         // size of the paFiles array
+    OS2CATALOGSTATS stats;          // counters (cFiles and cFaces unused)
+    BOOL            fChanged;       // differs from the index file
+};
+
+
+/* Resource extraction statistics (see QueryOS2ExtractStats).
+ */
+static OS2EXTRACTSTATS extract_stats = {0};
+
+/* The object cache.
+ */
+static OBJECTCACHE object_cache = {
+#ifdef HAVE_PTHREADS
+    PTHREAD_MUTEX_INITIALIZER,
+#endif
+    NULL, NULL, { 0, 0, 0, 0, 0, OBJECT_CACHE_BUDGET }
+};
+
+/* Number of threads used to unpack object pages (see SetOS2UnpackThreads).
+ */
+static ULONG unpack_threads = 1;
+
+/* The SIMD instruction sets which TransposeGlyph() may use.  This is
+ * determined on first use (the initial value means "not checked yet").
+ */
+#define SIMD_UNKNOWN                    0xFFFFFFFF
+#define SIMD_NONE                       0
+#define SIMD_SSE2                       1
+#define SIMD_AVX2                       2
+static ULONG transpose_simd = SIMD_UNKNOWN;
+
+/* The start of the DOS stub (see LX_STUB_SIZE): an MZ header whose e_lfanew
+ * points to the LX header just after the stub, then the code to print the
+ * message which follows it.
+ */
+static const BYTE lx_stub[] = {
+    0x4D, 0x5A, 0x80, 0x00, 0x01, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00,
+    0xB8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00,
+    0x0E, 0x1F, 0xBA, 0x0E, 0x00, 0xB4, 0x09, 0xCD, 0x21, 0xB8, 0x01, 0x4C, 0xCD, 0x21
+};
+
+
+/* Internal function prototypes.
+ */
+BOOL   BuildKerningIndex( POS2FONTRESOURCE pFont, PBYTE pLimit );
+ULONG  CatalogFaces( PSZ pszFile, POS2CATALOGFACE *ppaFaces, PULONG pcFaces );
+ULONG  CatalogFile( POS2FONTCATALOG pCatalog, PSZ pszFile, PBOOL pfFound );
+void   CopyBackRef( PBYTE pPage, ULONG ofOut, ULONG ulDist, ULONG ulLen );
+void   CopyBackRefExact( PBYTE pPage, ULONG ofOut, ULONG ulDist, ULONG ulLen );
+void   CopyLiteral( PBYTE pDst, PBYTE pSrc, ULONG ulLen );
+void   DrawGlyph1bpp( PBYTE pSrc, PGLYPHBITMAP pGlyph, POS2TEXTSURFACE pSurface, LONG x, LONG y );
+void   DrawGlyph8bpp( PBYTE pSrc, PGLYPHBITMAP pGlyph, POS2TEXTSURFACE pSurface, LONG x, LONG y );
+void   EvictCachedGlyphs( POS2GLYPHCACHE pCache, ULONG cbNeeded );
+void   EvictCachedObjects( ULONG cbNeeded );
+PGLYPHCACHEENTRY FindCachedGlyph( POS2GLYPHCACHE pCache, ULONG ulIndex, POS2FONTRESOURCE pFont );
+void   FreeCachedObject( POBJCACHEENTRY pEntry );
+POBJCACHEENTRY GetCachedObject( POS2FILEID pID, ULONG ulObj );
+LONG   GlyphAdvance( ULONG ulIndex, POS2FONTRESOURCE pFont );
+void   GrowCachedObject( POBJCACHEENTRY pEntry, ULONG cPages );
+void   InsertCachedGlyph( POS2GLYPHCACHE pCache, PGLYPHCACHEENTRY pEntry );
+POBJCACHEENTRY InsertCachedObject( POBJCACHEENTRY pEntry );
+int    LXCompareResKeys( const void *p1, const void *p2 );
+BOOL   LXExtractResource( FILE *pf, PLXTABLES pTables, LXRTENTRY *plx_rte, PBYTE *ppBuffer, PULONG pulSize );
+POBJCACHEENTRY LXFileObject( FILE *pf, PLXTABLES pTables, ULONG ulObj, ULONG ulFirst, ULONG ulLast );
+ULONG  LXFindFontFace( PLXRESKEY paIndex, ULONG cEntries, USHORT usName );
+void   LXFreeTables( PLXTABLES pTables );
+PLXRESKEY LXIndexResources( LXRTENTRY *paEntries, ULONG cEntries );
+ULONG  LXLookupResource( PLXRESKEY paIndex, ULONG cEntries, USHORT usType, USHORT usName );
+BOOL   LXMapResource( POS2FILEMAP pMap, ULONG ulBase, LXRTENTRY *plx_rte, PBYTE *ppData, PBOOL pfCopied );
+POBJCACHEENTRY LXMappedObject( POS2FILEMAP pMap, ULONG ulBase, ULONG ulObj, ULONG ulFirst, ULONG ulLast );
+PLXOPMENTRY LXObjectPageMap( POS2FILEMAP pMap, ULONG ulBase, ULONG ulObj, PULONG pcPages );
+ULONG  LXPack1Best( PBYTE pPage, ULONG cb, PLXPACKWORK pWork, PBYTE pOut );
+ULONG  LXPack1Fast( PBYTE pPage, ULONG cb, PBYTE pOut );
+ULONG  LXPack2Best( PBYTE pPage, ULONG cb, PLXPACKWORK pWork, PBYTE pOut );
+ULONG  LXPack2Fast( PBYTE pPage, ULONG cb, PBYTE pOut );
+void   LXPackRecord( PLXPACKWORK pWork, ULONG ulEnd, ULONG ulCost, ULONG ulType, ULONG ulFrom, ULONG cLits, ULONG ulDist );
+ULONG  LXPutLiterals( PBYTE pIn, ULONG cb, PBYTE pOut );
+BOOL   LXReadPages( FILE *pf, PLXTABLES pTables, LXOTENTRY *plx_obj, ULONG ulFirst, ULONG ulLast, PBYTE pDest, PBYTE pbDone );
+ULONG  LXReadTables( FILE *pf, ULONG ulBase, PLXTABLES pTables );
+PBYTE  LXResourceInPlace( POS2FILEMAP pMap, ULONG ulBase, LXRTENTRY *plx_rte );
+ULONG  LXRunLength( PBYTE pData, ULONG cb, ULONG ulMax );
+USHORT LXUnpack1( PBYTE pBuf, USHORT cbPage );
+USHORT LXUnpack2( PBYTE pBuf, USHORT cbPage );
+void   LXDecodePage( PLXPAGEJOB pJob );
+USHORT LXDecodePage2( PBYTE pOut, PBYTE pIn, USHORT cbIn );
+void   LXDecodePages( PLXPAGEJOB pJobs, ULONG cJobs );
+#ifdef HAVE_PTHREADS
+void   LXUnpackBatch( void );
+#endif
+BOOL   LXUnpackPages( POS2FILEMAP pMap, ULONG ulBase, ULONG ulObj, ULONG ulFirst, ULONG ulLast, PBYTE pDest, PBYTE pbDone );
+#ifdef HAVE_PTHREADS
+void  *LXUnpackWorker( void *pArg );
+#endif
+ULONG  LayoutGlyphAtlas( POS2FONTRESOURCE pFont, POS2ATLASGLYPH paGlyphs );
+PBYTE  LocateFontGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph );
+PBYTE  LocateGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph );
+BOOL   NEExtractResource( FILE *pf, NEHEADER ne_hd, ULONG ulBase, ULONG ulRes, PBYTE *ppBuffer, PULONG pulSize );
+ULONG  NEIndexFaces( POS2FONTMODULE pModule );
+PBYTE  NEResourceInPlace( POS2FILEMAP pMap, ULONG ulBase, ULONG ulRes, PULONG pcb );
+PGLYPHCACHEENTRY NewCachedGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont );
+POBJCACHEENTRY NewCachedObject( ULONG cPages );
+ULONG  ObjectCacheBudget( void );
+void   ReleaseCachedObject( POBJCACHEENTRY pEntry );
+void   RemoveCachedGlyph( POS2GLYPHCACHE pCache, PGLYPHCACHEENTRY pEntry );
+void   SetFixedAdvance( POS2FONTRESOURCE pFont );
+void   SetUGLCoverage( POS2FONTRESOURCE pFont );
+void   StatFileID( struct stat *pfs, POS2FILEID pID );
+void   StoreGlyph( POS2FONTRESOURCE pFont, PBYTE pBitmap, PGLYPHBITMAP pGlyph, PBYTE pDest );
+void   TransposeGlyph( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest );
+#ifdef HAVE_X86_SIMD
+ULONG  TransposeRowsAVX2( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst );
+ULONG  TransposeRowsSSE2( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst );
+#endif
+ULONG  TransposeRowsScalar( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst );
+BOOL   UGLGlyphInFont( POS2FOCAMETRICS pMetrics, ULONG i );
+
+
+
+/* ------------------------------------------------------------------------- *
+ * BuildKerningIndex                                                         *
+ *                                                                           *
+ * Builds the kerning index (see gpifont.h) for a font which has a kerning   *
+ * table, and attaches it to the font.  Where the same pair of glyphs occurs *
+ * more than once, the first occurrence is used.  The index is freed along   *
+ * with the font by FreeOS2FontResource().                                   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont : Pointer to the parsed font, whose pKerning     *
+ *                            field points to the kerning table.        (IO) *
+ *   PBYTE            pLimit: End of the font resource data.             (I) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   FALSE if the table does not fit within the font data, or memory could   *
+ *   not be allocated (in which case the font is left without an index).     *
+ * ------------------------------------------------------------------------- */
+BOOL BuildKerningIndex( POS2FONTRESOURCE pFont, PBYTE pLimit )
+{
+    POS2KERNINDEX    pIndex;    // the new index
+    POS2KERNINGPAIRS pPairs;    // the pairs in the kerning table
+    ULONG            cPairs = (USHORT) pFont->pMetrics->usKerningPairs,
+                     cSlots,
+                     ulPair,
+                     i, j;
+
+    pPairs = (POS2KERNINGPAIRS)( (PBYTE) pFont->pKerning + sizeof( OS2KERNPAIRTABLE ));
+    if ( (PBYTE)( pPairs + cPairs ) > pLimit ) return FALSE;
+
+    for ( cSlots = KERN_MIN_SLOTS; cSlots < ( cPairs * 2 ); cSlots <<= 1 );
+    pIndex = (POS2KERNINDEX) malloc( sizeof( OS2KERNINDEX ) + ( cSlots * sizeof( OS2KERNSLOT )));
+    if ( !pIndex ) return FALSE;
+    pIndex->paPairs = pPairs;
+    pIndex->cPairs  = cPairs;
+    pIndex->ulMask  = cSlots - 1;
+    pIndex->paSlots = (POS2KERNSLOT)( pIndex + 1 );
+    for ( j = 0; j < cSlots; j++ )
+        pIndex->paSlots[ j ].ulPair = OS2KERN_NO_PAIR;
+
+    for ( i = 0; i < cPairs; i++ ) {
+        ulPair = ( (ULONG)(USHORT) pPairs[ i ].sFirstChar << 16 ) |
+                 (USHORT) pPairs[ i ].sSecondChar;
+        if ( ulPair == OS2KERN_NO_PAIR ) continue;
+        for ( j = KERN_HASH( ulPair, pIndex->ulMask );
+              ( pIndex->paSlots[ j ].ulPair != OS2KERN_NO_PAIR ) &&
+              ( pIndex->paSlots[ j ].ulPair != ulPair );
+              j = ( j + 1 ) & pIndex->ulMask );
+        if ( pIndex->paSlots[ j ].ulPair == ulPair ) continue;
+        pIndex->paSlots[ j ].ulPair  = ulPair;
+        pIndex->paSlots[ j ].lAmount = pPairs[ i ].sKerningAmount;
+    }
+    pFont->pKernIndex = pIndex;
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * BuildOS2FontModule                                                        *
+ *                                                                           *
+ * Builds a font module: an LX-format DLL holding the given fonts as         *
+ * OS2RES_FONTFACE resources (with IDs counted from 1), and a font directory *
+ * (an OS2RES_FONTDIR resource, ID 1) listing the metrics of each.  Each     *
+ * resource has an object of its own, and the module has no code, entry      *
+ * points or fixups.  Object pages may be compressed with either EXEPACK     *
+ * method (see PackOS2ObjectPage); a page is only stored packed if this      *
+ * makes it smaller.                                                         *
+ *                                                                           *
+ * The whole module is built in a single buffer, allocated by this function, *
+ * which the caller must free.                                               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE paFonts  : Array of parsed fonts to include.       (I) *
+ *   ULONG            cFonts   : Number of fonts in paFonts (1-65534).   (I) *
+ *   PSZ              pszName  : Module name (normally the filename without  *
+ *                               its extension, in upper case).          (I) *
+ *   ULONG            ulPack   : OS2PACK_* compression method for object     *
+ *                               pages, or 0 to store them unpacked.     (I) *
+ *   PBYTE           *ppModule : Pointer to the module buffer which will be  *
+ *                               created.                                (O) *
+ *   PULONG           pcbModule: Pointer to the size of the module.      (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_* otherwise (in which case ppModule is unchanged).    *
+ * ------------------------------------------------------------------------- */
+ULONG BuildOS2FontModule( POS2FONTRESOURCE paFonts, ULONG cFonts, PSZ pszName, ULONG ulPack, PBYTE *ppModule, PULONG pcbModule )
+{
+    LXHEADER          lx_hd;        // executable header
+    LXOTENTRY         lx_ote;       // object table entry
+    LXOPMENTRY        lx_opm;       // object page map entry
+    LXRTENTRY         lx_rte;       // resource table entry
+    POS2FONTDIRENTRY  pEntry;       // font directory entry
+    PBYTE             pModule,
+                      pLX,          // start of the LX header
+                      pDir,         // font directory (after the module)
+                      pObject,      // data of the current object
+                      pOut;         // where the next page is stored
+    ULONG             cObjects = cFonts + 1,
+                      cPages,
+                      cchName,
+                      cbDir,
+                      cbData,       // size of all objects, unpacked
+                      cbObject,
+                      cbPage,
+                      ofData,
+                      ulBase,
+                      ulPage,
+                      i, j;
+
+    if ( !paFonts || !cFonts ) return ERR_NO_FONT;
+    if ( cFonts > 0xFFFE ) return ERR_FILE_FORMAT;
+    for ( i = 0; i < cFonts; i++ )
+        if ( !paFonts[ i ].pSignature || !paFonts[ i ].pMetrics || !paFonts[ i ].cbSize )
+            return ERR_NO_FONT;
+    cchName = pszName ? strlen( pszName ) : 0;
+    if ( cchName > 0xFF ) cchName = 0xFF;
+
+    /* The loader section (object table, page map, resource table, resident
+     * name table and entry table) follows the LX header, then the fixup
+     * section, which here is just an empty fixup page table, and then the
+     * object pages.  Space is left after the pages for the font directory,
+     * and for the packer to write a whole page at the end.
+     */
+    cbDir  = 6 + ( cFonts * sizeof( OS2FONTDIRENTRY ));
+    cbData = cbDir;
+    cPages = ( cbDir + LX_PAGE_SIZE - 1 ) / LX_PAGE_SIZE;
+    for ( i = 0; i < cFonts; i++ ) {
+        cbData += paFonts[ i ].cbSize;
+        cPages += ( paFonts[ i ].cbSize + LX_PAGE_SIZE - 1 ) / LX_PAGE_SIZE;
+    }
+    memset( &lx_hd, 0, sizeof( lx_hd ));
+    lx_hd.magic       = MAGIC_LX;
+    lx_hd.cpu         = LX_CPU_386;
+    lx_hd.os          = LX_OS_OS2;
+    lx_hd.mflags      = LX_MOD_DLL | LX_MOD_NOINTFIX | LX_MOD_NOEXTFIX;
+    lx_hd.mpages      = cPages;
+    lx_hd.pagesize    = LX_PAGE_SIZE;
+    lx_hd.obj_tbl     = LX_HEADER_SIZE;
+    lx_hd.objcnt      = cObjects;
+    lx_hd.objmap      = lx_hd.obj_tbl + ( cObjects * sizeof( LXOTENTRY ));
+    lx_hd.res_tbl     = lx_hd.objmap + ( cPages * sizeof( LXOPMENTRY ));
+    lx_hd.cres        = cObjects;
+    lx_hd.rnam_tbl    = lx_hd.res_tbl + ( cObjects * sizeof( LXRTENTRY ));
+    lx_hd.ent_tbl     = lx_hd.rnam_tbl + cchName + 4;
+    lx_hd.ldrsize     = lx_hd.ent_tbl + 1 - lx_hd.obj_tbl;
+    lx_hd.fpage_tbl   = lx_hd.ent_tbl + 1;
+    lx_hd.frec_tbl    = lx_hd.fpage_tbl + (( cPages + 1 ) * sizeof( ULONG ));
+    lx_hd.fixupsize   = lx_hd.frec_tbl - lx_hd.fpage_tbl;
+    lx_hd.impmod_tbl  = lx_hd.frec_tbl;
+    lx_hd.impproc_tbl = lx_hd.frec_tbl;
+    ofData            = LX_STUB_SIZE + lx_hd.frec_tbl;
+    lx_hd.datapage    = ofData;
+
+    pModule = (PBYTE) malloc( ofData + cbData + LX_PAGE_SIZE + cbDir );
+    if ( !pModule ) return ERR_MEMORY;
+    memset( pModule, 0, ofData );
+    memcpy( pModule, lx_stub, sizeof( lx_stub ));
+    memcpy( pModule + sizeof( lx_stub ), LX_STUB_MESSAGE, sizeof( LX_STUB_MESSAGE ) - 1 );
+    pLX = pModule + LX_STUB_SIZE;
+    memcpy( pLX, &lx_hd, sizeof( lx_hd ));
+
+    // Resident name table: the module name (ordinal 0), then the end marker
+    pLX[ lx_hd.rnam_tbl ] = (BYTE) cchName;
+    if ( cchName ) memcpy( pLX + lx_hd.rnam_tbl + 1, pszName, cchName );
+
+    // Font directory
+    pDir = pModule + ofData + cbData + LX_PAGE_SIZE;
+    memset( pDir, 0, cbDir );
+    ((POS2FONTDIRECTORY) pDir)->usHeaderSize = 6;
+    ((POS2FONTDIRECTORY) pDir)->usnFonts     = cFonts;
+    ((POS2FONTDIRECTORY) pDir)->usiMetrics   = sizeof( OS2FONTDIRENTRY );
+    for ( i = 0; i < cFonts; i++ ) {
+        pEntry = (POS2FONTDIRENTRY)( pDir + 6 + ( i * sizeof( OS2FONTDIRENTRY )));
+        pEntry->usIndex = i + 1;
+        memcpy( &(pEntry->metrics), paFonts[ i ].pMetrics, sizeof( OS2FOCAMETRICS ));
+        if ( paFonts[ i ].pPanose )
+            memcpy( pEntry->panose, paFonts[ i ].pPanose->panose, sizeof( pEntry->panose ));
+    }
+
+    /* The font directory is object 1, followed by the fonts.  Objects are
+     * based 64 KiB apart (or more, for larger objects).
+     */
+    pOut   = pModule + ofData;
+    ulBase = 0x10000;
+    ulPage = 0;
+    for ( i = 0; i < cObjects; i++ ) {
+        pObject  = i ? (PBYTE) paFonts[ i - 1 ].pSignature : pDir;
+        cbObject = i ? paFonts[ i - 1 ].cbSize : cbDir;
+
+        lx_rte.type   = i ? OS2RES_FONTFACE : OS2RES_FONTDIR;
+        lx_rte.name   = i ? i : 1;
+        lx_rte.cb     = cbObject;
+        lx_rte.obj    = i + 1;
+        lx_rte.offset = 0;
+        memcpy( pLX + lx_hd.res_tbl + ( i * sizeof( LXRTENTRY )), &lx_rte, sizeof( LXRTENTRY ));
+
+        lx_ote.size     = cbObject;
+        lx_ote.base     = ulBase;
+        lx_ote.flags    = OBJ32_READ | OBJ32_RESOURCE | OBJ32_DISCARD | OBJ32_SHARED | OBJ32_BIGDEF;
+        lx_ote.pagemap  = ulPage + 1;
+        lx_ote.mapsize  = ( cbObject + LX_PAGE_SIZE - 1 ) / LX_PAGE_SIZE;
+        lx_ote.reserved = 0;
+        memcpy( pLX + lx_hd.obj_tbl + ( i * sizeof( LXOTENTRY )), &lx_ote, sizeof( LXOTENTRY ));
+        ulBase += ( cbObject + 0xFFFF ) & ~0xFFFF;
+
+        /* Each page is packed straight into place, and overwritten with the
+         * original data if packing it does not save anything.
+         */
+        for ( j = 0; j < lx_ote.mapsize; j++, ulPage++ ) {
+            cbPage = cbObject - ( j * LX_PAGE_SIZE );
+            if ( cbPage > LX_PAGE_SIZE ) cbPage = LX_PAGE_SIZE;
+            lx_opm.dataoffset = pOut - ( pModule + ofData );
+            lx_opm.size       = ulPack ? PackOS2ObjectPage( pObject + ( j * LX_PAGE_SIZE ),
+                                                            cbPage, ulPack, pOut ) : 0;
+            if ( lx_opm.size && ( lx_opm.size < cbPage ))
+                lx_opm.flags = ( ulPack & OS2PACK_EXEPACK1 ) ? OP32_ITERDATA : OP32_ITERDATA2;
+            else {
+                memcpy( pOut, pObject + ( j * LX_PAGE_SIZE ), cbPage );
+                lx_opm.size  = cbPage;
+                lx_opm.flags = OP32_VALID;
+            }
+            memcpy( pLX + lx_hd.objmap + ( ulPage * sizeof( LXOPMENTRY )), &lx_opm, sizeof( LXOPMENTRY ));
+            pOut += lx_opm.size;
+        }
+    }
+
+    *ppModule  = pModule;
+    *pcbModule = pOut - pModule;
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * BuildOS2GlyphAtlas                                                        *
+ *                                                                           *
+ * Converts every glyph in a font into a glyph atlas (see gpifont.h), which  *
+ * is then attached to the font.  From then on, GetOS2AtlasGlyph() can look  *
+ * up any glyph without converting it, and the glyph extraction functions    *
+ * simply copy the already converted bitmaps.  The atlas is freed along with *
+ * the font by FreeOS2FontResource().                                        *
+ *                                                                           *
+ * This trades memory for speed, so it is best suited to fonts which will be *
+ * used for a long time; QueryOS2GlyphAtlasSize() reports how much memory    *
+ * the atlas would take, so that the caller can decide whether to build it.  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont: Pointer to the font resource data.         (IO) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success (or if the font already has an atlas), ERR_* otherwise.    *
+ * ------------------------------------------------------------------------- */
+ULONG BuildOS2GlyphAtlas( POS2FONTRESOURCE pFont )
+{
+    POS2GLYPHATLAS pAtlas;      // the new atlas
+    GLYPHBITMAP    glyph;       // glyph information
+    PBYTE          pBitmap;     // pointer to bitmap within the font data
+    ULONG          cGlyphs,     // number of glyphs in the font
+                   cbData,      // size of the bitmap data
+                   cbTotal,     // size of the whole atlas
+                   i;
+
+
+    if ( pFont->pAtlas ) return 0;
+    if ( pFont->pMetrics->usLastChar < 0 ) return ERR_NO_FONT;
+
+    cGlyphs = pFont->pMetrics->usLastChar + 1;
+    cbData  = LayoutGlyphAtlas( pFont, NULL );
+    cbTotal = sizeof( OS2GLYPHATLAS ) + ( cGlyphs * sizeof( OS2ATLASGLYPH )) +
+              ( OS2ATLAS_ALIGN - 1 ) + cbData;
+    pAtlas  = (POS2GLYPHATLAS) malloc( cbTotal );
+    if ( !pAtlas ) return ERR_MEMORY;
+
+    pAtlas->ulFirstChar = pFont->pMetrics->usFirstChar;
+    pAtlas->cGlyphs     = cGlyphs;
+    pAtlas->cRows       = pFont->pFontDef->yCellHeight;
+    pAtlas->sBearingY   = pFont->pMetrics->yExternalLeading;
+    pAtlas->sAdvanceY   = pFont->pFontDef->yCellHeight + pFont->pMetrics->yExternalLeading;
+    pAtlas->paGlyphs    = (POS2ATLASGLYPH)( pAtlas + 1 );
+    pAtlas->pData       = (PBYTE)((( (size_t)( pAtlas->paGlyphs + cGlyphs )) +
+                                   ( OS2ATLAS_ALIGN - 1 )) & ~((size_t) OS2ATLAS_ALIGN - 1 ));
+    pAtlas->cbData      = cbData;
+    pAtlas->cbTotal     = cbTotal;
+    LayoutGlyphAtlas( pFont, pAtlas->paGlyphs );
+
+    for ( i = 0; i < cGlyphs; i++ ) {
+        if ( pAtlas->paGlyphs[ i ].ulOffset == OS2ATLAS_NO_GLYPH ) continue;
+        pBitmap = LocateGlyph( pAtlas->ulFirstChar + i, pFont, &glyph );
+        TransposeGlyph( pBitmap, glyph.rows, glyph.pitch,
+                        pAtlas->pData + pAtlas->paGlyphs[ i ].ulOffset );
+    }
+    pFont->pAtlas = pAtlas;
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * CatalogFaces                                                              *
+ *                                                                           *
+ * Opens a font file and builds the catalog record of each of its faces.     *
+ * Faces which cannot be parsed are left out.                                *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PSZ              pszFile : Name of the font file.                   (I) *
+ *   POS2CATALOGFACE *ppaFaces: Pointer to the returned (allocated) array    *
+ *                              of face records.                         (O) *
+ *   PULONG           pcFaces : Number of face records returned.         (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_* otherwise (ERR_NO_FONT if no face could be parsed). *
+ * ------------------------------------------------------------------------- */
+ULONG CatalogFaces( PSZ pszFile, POS2CATALOGFACE *ppaFaces, PULONG pcFaces )
+{
+    OS2FONTRESOURCE font;
+    POS2FONTMODULE  pModule;
+    POS2CATALOGFACE paFaces,
+                    pFace;
+    LXHEADER       *plx_hd;     // executable header
+    LXRTENTRY      *prtes;      // resource table
+    PNEHEADER       pne_hd;     // 16-bit executable header
+    PNERTENTRY      pnrtes;     // 16-bit resource table
+    ULONG           cFaces,     // number of faces in the module
+                    n,          // number of faces catalogued
+                    ulRC,
+                    c,
+                    i;
+
+
+    ulRC = OpenOS2FontModule( pszFile, &pModule );
+    if ( ulRC != 0 ) return ulRC;
+    cFaces  = QueryOS2FontModuleFaces( pModule );
+    paFaces = (POS2CATALOGFACE) calloc( cFaces ? cFaces : 1, sizeof( OS2CATALOGFACE ));
+    if ( !paFaces ) {
+        CloseOS2FontModule( pModule );
+        return ERR_MEMORY;
+    }
+
+    for ( i = 0, n = 0; i < cFaces; i++ ) {
+        if ( GetOS2FontModuleFace( pModule, i, &font ) != 0 ) continue;
+        pFace = paFaces + n++;
+        pFace->usFace = i;
+        if ( pModule->usMagic == MAGIC_LX ) {
+            plx_hd = (LXHEADER *)( pModule->pMap->pData + pModule->ulBase );
+            prtes  = (LXRTENTRY *)( pModule->pMap->pData + pModule->ulBase + plx_hd->res_tbl );
+            pFace->usResourceID = prtes[ pModule->paulFaceRes[ i ] ].name;
+        }
+        else if ( pModule->usMagic == MAGIC_NE ) {
+            pne_hd = (PNEHEADER)( pModule->pMap->pData + pModule->ulBase );
+            pnrtes = (PNERTENTRY)( pModule->pMap->pData + pModule->ulBase + pne_hd->res_tbl );
+            pFace->usResourceID = pnrtes[ pModule->paulFaceRes[ i ] ].ename;
+        }
+        memcpy( pFace->szFamilyname, font.pMetrics->szFamilyname, sizeof( pFace->szFamilyname ));
+        memcpy( pFace->szFacename, font.pMetrics->szFacename, sizeof( pFace->szFacename ));
+        pFace->szFamilyname[ sizeof( pFace->szFamilyname ) - 1 ] = 0;
+        pFace->szFacename[ sizeof( pFace->szFacename ) - 1 ]     = 0;
+        pFace->usCodePage    = font.pMetrics->usCodePage;
+        pFace->usPointSize   = font.pMetrics->usNominalPointSize;
+        pFace->xDeviceRes    = font.pMetrics->xDeviceRes;
+        pFace->yDeviceRes    = font.pMetrics->yDeviceRes;
+        pFace->usWeightClass = font.pMetrics->usWeightClass;
+        pFace->usWidthClass  = font.pMetrics->usWidthClass;
+        pFace->fsSelection   = font.pMetrics->fsSelectionFlags;
+        pFace->usFirstChar   = font.pMetrics->usFirstChar;
+        pFace->usLastChar    = font.pMetrics->usFirstChar + font.pMetrics->usLastChar;
+        pFace->yCellHeight   = font.pFontDef->yCellHeight;
+        pFace->xAveCharWidth = font.pMetrics->xAveCharWidth;
+        pFace->fUGL          = (BYTE) font.fUGL;
+
+        // A font which is not UGL-encoded covers its own range of codepoints
+        if ( font.fUGL )
+            memcpy( pFace->abCoverage, font.abCoverage, OS2FONT_COVERAGE_SIZE );
+        else {
+            for ( c = pFace->usFirstChar;
+                  ( c <= pFace->usLastChar ) && ( c < ( OS2FONT_COVERAGE_SIZE * 8 )); c++ )
+                pFace->abCoverage[ c >> 3 ] |= ( 1 << ( c & 7 ));
+        }
+        FreeOS2FontResource( &font );
+    }
+    CloseOS2FontModule( pModule );
+
+    if ( !n ) {
+        free( paFaces );
+        return ERR_NO_FONT;
+    }
+    *ppaFaces = paFaces;
+    *pcFaces  = n;
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * CatalogFile                                                               *
+ *                                                                           *
+ * Finds a file in a font catalog by name.  The files are kept sorted by     *
+ * name, so this is a binary search.                                         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTCATALOG pCatalog: The font catalog.                         (I) *
+ *   PSZ             pszFile : Name of the file to find.                 (I) *
+ *   PBOOL           pfFound : Set to TRUE if the file was found.        (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The position of the file in the catalog or, if it is not there, the     *
+ *   position at which it belongs.                                           *
+ * ------------------------------------------------------------------------- */
+ULONG CatalogFile( POS2FONTCATALOG pCatalog, PSZ pszFile, PBOOL pfFound )
+{
+    ULONG ulLow  = 0,
+          ulHigh = pCatalog->cFiles,
+          ulMid;
+    int   iCmp;
+
+    *pfFound = FALSE;
+    while ( ulLow < ulHigh ) {
+        ulMid = ( ulLow + ulHigh ) / 2;
+        iCmp  = strcmp( pszFile, pCatalog->paFiles[ ulMid ].pszPath );
+        if ( iCmp == 0 ) {
+            *pfFound = TRUE;
+            return ulMid;
+        }
+        if ( iCmp < 0 ) ulHigh = ulMid;
+        else            ulLow  = ulMid + 1;
+    }
+    return ulLow;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * CloseOS2FontCatalog                                                       *
+ *                                                                           *
+ * Frees a font catalog opened with OpenOS2FontCatalog().  Any changes which *
+ * have not been saved with SaveOS2FontCatalog() are lost.                   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTCATALOG pCatalog: The font catalog to be closed.            (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void CloseOS2FontCatalog( POS2FONTCATALOG pCatalog )
+{
+    ULONG i;
+
+    if ( !pCatalog ) return;
+    for ( i = 0; i < pCatalog->cFiles; i++ ) {
+        free( pCatalog->paFiles[ i ].pszPath );
+        free( pCatalog->paFiles[ i ].paFaces );
+    }
+    free( pCatalog->paFiles );
+    free( pCatalog->pszIndex );
+    free( pCatalog );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * CloseOS2FontModule                                                        *
+ *                                                                           *
+ * Closes a font module opened by OpenOS2FontModule().  The module data is   *
+ * actually released only once every face which still points into it has     *
+ * been freed as well (using FreeOS2FontResource).                           *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTMODULE pModule: The font module to close.                  (IO) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void CloseOS2FontModule( POS2FONTMODULE pModule )
+{
+    ULONG i;
+
+    if ( !pModule || --pModule->cRefs ) return;
+    if ( pModule->papObjects ) {
+        for ( i = 0; i < pModule->cObjects; i++ )
+            free( pModule->papObjects[ i ] );
+        free( pModule->papObjects );
+    }
+    if ( pModule->papPagesDone ) {
+        for ( i = 0; i < pModule->cObjects; i++ )
+            free( pModule->papPagesDone[ i ] );
+        free( pModule->papPagesDone );
+    }
+    free( pModule->paulFaceRes );
+    OS2ReleaseFileMap( pModule->pMap );
+    free( pModule );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * CopyBackRef                                                               *
+ *                                                                           *
+ * Resolves an EXEPACK2 back-reference by copying ulLen bytes, starting      *
+ * ulDist bytes before the current output offset, to the current output      *
+ * offset within a 4 KiB page.  Used by LXDecodePage2() away from the end of *
+ * the page.  The source and target may overlap (the end of the source       *
+ * sequence may extend into the start of the target sequence, thus repeating *
+ * bytes which were written by the same copy), so memcpy() cannot simply be  *
+ * used for the whole run.                                                   *
+ *                                                                           *
+ * Instead, if the distance is at least 8 bytes the run is copied 8 bytes at *
+ * a time (each chunk then only reads bytes which were already written).     *
+ * A shorter distance is a repeating pattern: 8 bytes of it are built, and   *
+ * then stored 8 bytes at a time at steps of the largest multiple of the     *
+ * distance which fits in 8 bytes, so that each store carries on the pattern *
+ * where the last one left off.  These copies may write up to 7 bytes beyond *
+ * the end of the run, so the caller must make sure that those bytes still   *
+ * lie within the page; they are overwritten (or zeroed) later in the        *
+ * decoding process.  Near the end of the page, CopyBackRefExact() is used.  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pPage : The output page.                                     (IO) *
+ *   ULONG ofOut : Current output offset within the page.                (I) *
+ *   ULONG ulDist: Distance back to the start of the source sequence.    (I) *
+ *   ULONG ulLen : Number of bytes to copy.                              (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void CopyBackRef( PBYTE pPage, ULONG ofOut, ULONG ulDist, ULONG ulLen )
+{
+    static const BYTE abStep[ 8 ] = { 0, 8, 8, 6, 8, 5, 6, 7 };
+    static const BYTE abIndex[ 8 ][ 8 ] = {
+        { 0, 0, 0, 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0, 0, 0, 0 },
+        { 0, 1, 0, 1, 0, 1, 0, 1 }, { 0, 1, 2, 0, 1, 2, 0, 1 },
+        { 0, 1, 2, 3, 0, 1, 2, 3 }, { 0, 1, 2, 3, 4, 0, 1, 2 },
+        { 0, 1, 2, 3, 4, 5, 0, 1 }, { 0, 1, 2, 3, 4, 5, 6, 0 }
+    };
+    PBYTE pDst = pPage + ofOut,
+          pSrc = pDst - ulDist;
+    BYTE  abPattern[ 8 ];
+    ULONG ulStep,
+          i;
+
+    if ( ulDist >= 8 ) {
+        // Most runs are short enough for the first two chunks
+        memcpy( pDst, pSrc, 8 );
+        memcpy( pDst + 8, pSrc + 8, 8 );
+        for ( i = 16; i < ulLen; i += 8 )
+            memcpy( pDst + i, pSrc + i, 8 );
+    }
+    else if ( ulDist > 1 ) {
+        for ( i = 0; i < 8; i++ )
+            abPattern[ i ] = pSrc[ abIndex[ ulDist ][ i ]];
+        ulStep = abStep[ ulDist ];
+        for ( i = 0; i < ulLen; i += ulStep )
+            memcpy( pDst + i, abPattern, 8 );
+    }
+    else if ( ulDist == 1 )
+        memset( pDst, *pSrc, ulLen );
+    else
+        // Each (as yet unwritten, hence 0) byte is copied onto itself
+        memset( pDst, 0, ulLen );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * CopyBackRefExact                                                          *
+ *                                                                           *
+ * Resolves an EXEPACK2 back-reference like CopyBackRef(), but one byte at a *
+ * time, so that nothing beyond the end of the run is written.  Used by      *
+ * LXDecodePage2() near the end of the page.                                 *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pPage : The output page.                                     (IO) *
+ *   ULONG ofOut : Current output offset within the page.                (I) *
+ *   ULONG ulDist: Distance back to the start of the source sequence.    (I) *
+ *   ULONG ulLen : Number of bytes to copy.                              (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void CopyBackRefExact( PBYTE pPage, ULONG ofOut, ULONG ulDist, ULONG ulLen )
+{
+    PBYTE pDst = pPage + ofOut,
+          pSrc = pDst - ulDist;
+    ULONG i;
+
+    if ( ulDist == 0 )
+        memset( pDst, 0, ulLen );
+    else
+        for ( i = 0; i < ulLen; i++ ) pDst[ i ] = pSrc[ i ];
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * CopyLiteral                                                               *
+ *                                                                           *
+ * Copies a literal sequence of ulLen bytes from the packed input to the     *
+ * output page.  Used by LXDecodePage2() away from the ends of the input and *
+ * the page.  Literal sequences are short (at most 63 bytes), so they are    *
+ * copied 8 bytes at a time; this may read and write up to 7 bytes past the  *
+ * end of the sequence, so the caller must make sure that both buffers have  *
+ * room for that.  The extra output is overwritten later.                    *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pDst : Output position within the page.                       (O) *
+ *   PBYTE pSrc : Start of the literal sequence within the packed input. (I) *
+ *   ULONG ulLen: Number of bytes to copy.                               (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void CopyLiteral( PBYTE pDst, PBYTE pSrc, ULONG ulLen )
+{
+    ULONG i;
+
+    memcpy( pDst, pSrc, 8 );
+    memcpy( pDst + 8, pSrc + 8, 8 );
+    for ( i = 16; i < ulLen; i += 8 )
+        memcpy( pDst + i, pSrc + i, 8 );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * CreateOS2GlyphCache                                                       *
+ *                                                                           *
+ * Creates a cache of extracted glyphs, so that frequently used glyphs do    *
+ * not have to be located, converted and allocated again every time they are *
+ * needed.  Glyphs are cached by font and glyph index, so one cache can be   *
+ * shared by any number of fonts.                                            *
+ *                                                                           *
+ * The memory used by the cached glyphs is kept within the given budget by   *
+ * evicting the least recently used glyphs, as approximated by the CLOCK     *
+ * algorithm: every glyph has a "referenced" flag which is set when it is    *
+ * looked up, and a hand sweeps round the glyphs clearing the flags, until   *
+ * it finds one which has not been used since the hand last passed.  This    *
+ * means that lookups never need to reorder anything, so any number of       *
+ * threads can look up glyphs at the same time.  Glyphs which are pinned     *
+ * (see PinOS2CachedGlyphs) are never evicted.                               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG           cbBudget: Maximum memory for glyphs, in bytes.      (I) *
+ *   POS2GLYPHCACHE *ppCache : Pointer to the returned cache.            (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_* otherwise.                                          *
+ * ------------------------------------------------------------------------- */
+ULONG CreateOS2GlyphCache( ULONG cbBudget, POS2GLYPHCACHE *ppCache )
+{
+    POS2GLYPHCACHE pCache;
+
+    pCache = (POS2GLYPHCACHE) calloc( 1, sizeof( OS2GLYPHCACHE ));
+    if ( !pCache ) return ERR_MEMORY;
+    pCache->papBuckets = (PGLYPHCACHEENTRY *) calloc( GLYPH_CACHE_BUCKETS, sizeof( PGLYPHCACHEENTRY ));
+    if ( !pCache->papBuckets ) {
+        free( pCache );
+        return ERR_MEMORY;
+    }
+#ifdef HAVE_PTHREADS
+    if ( pthread_rwlock_init( &pCache->rwl, NULL )) {
+        free( pCache->papBuckets );
+        free( pCache );
+        return ERR_MEMORY;
+    }
+#endif
+    pCache->cBuckets       = GLYPH_CACHE_BUCKETS;
+    pCache->stats.cbBudget = cbBudget;
+    *ppCache = pCache;
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * DestroyOS2GlyphCache                                                      *
+ *                                                                           *
+ * Frees a glyph cache created by CreateOS2GlyphCache(), along with all the  *
+ * glyphs in it.  Every glyph looked up from the cache must be released      *
+ * (using ReleaseOS2CachedGlyph) before this is called.                      *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2GLYPHCACHE pCache: The glyph cache.                            (IO) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void DestroyOS2GlyphCache( POS2GLYPHCACHE pCache )
+{
+    if ( !pCache ) return;
+    PurgeOS2GlyphCache( pCache, NULL );
+#ifdef HAVE_PTHREADS
+    pthread_rwlock_destroy( &pCache->rwl );
+#endif
+    free( pCache->papBuckets );
+    free( pCache );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * DrawGlyph1bpp                                                             *
+ *                                                                           *
+ * Draws a glyph onto a 1 bit per pel surface, straight from the column-     *
+ * major bitmap in the font (see TransposeGlyph), clipping it to the         *
+ * surface.  Each row of up to DRAW_GROUP_COLUMNS columns is gathered into   *
+ * one 64-bit word, masked to the visible pels and shifted into line with    *
+ * the surface bytes all at once, and then ORed into the surface a byte at a *
+ * time (skipping empty bytes, so that no byte outside the visible area is   *
+ * ever touched).                                                            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE           pSrc    : The glyph bitmap, in OS/2 font format.    (I) *
+ *   PGLYPHBITMAP    pGlyph  : The glyph information (from LocateGlyph). (I) *
+ *   POS2TEXTSURFACE pSurface: The surface to draw on.                  (IO) *
+ *   LONG            x       : Surface column of bitmap's left edge.     (I) *
+ *   LONG            y       : Surface row of the bitmap's top row.      (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void DrawGlyph1bpp( PBYTE pSrc, PGLYPHBITMAP pGlyph, POS2TEXTSURFACE pSurface, LONG x, LONG y )
+{
+    uint64_t ullMask,           // visible pels of the current group of columns
+             ullRow;            // one row of the current group of columns
+    PBYTE    pDest;             // current surface row
+    LONG     xLeft, xRight,     // visible range of pels within the glyph
+             yTop, yBottom,     // visible range of rows within the glyph
+             xGroup,            // surface position of the current group
+             iByte,             // surface byte containing the group's first pel
+             lo, hi;            // visible range of pels within the group
+    ULONG    cy = pGlyph->rows,
+             ulShift,           // bit position of the group's first pel
+             cBytes,            // number of surface bytes the group covers
+             cCols,             // number of columns in the group
+             kFirst,            // first group byte which lies on the surface
+             c, r, k;
+    BYTE     b;
+
+
+    // Clip the glyph to the surface
+    xLeft   = ( x < 0 ) ? -x : 0;
+    xRight  = (LONG) pSurface->cx - x;
+    if ( xRight > (LONG) pGlyph->width ) xRight = pGlyph->width;
+    yTop    = ( y < 0 ) ? -y : 0;
+    yBottom = (LONG) pSurface->cy - y;
+    if ( yBottom > (LONG) cy ) yBottom = cy;
+    if (( xLeft >= xRight ) || ( yTop >= yBottom )) return;
+
+    for ( c = xLeft / 8; ( c * 8 ) < (ULONG) xRight; c += cCols ) {
+        cCols = pGlyph->pitch - c;
+        if ( cCols > DRAW_GROUP_COLUMNS ) cCols = DRAW_GROUP_COLUMNS;
+        lo = ( xLeft > (LONG)( c * 8 )) ? xLeft - ( c * 8 ) : 0;
+        hi = xRight - ( c * 8 );
+        if ( hi > (LONG)( cCols * 8 )) hi = cCols * 8;
+        ullMask = ( ~(uint64_t) 0 >> lo ) & ~( ~(uint64_t) 0 >> hi );
+
+        xGroup  = x + ( c * 8 );
+        ulShift = xGroup & 7;
+        iByte   = ( xGroup - (LONG) ulShift ) / 8;
+        cBytes  = ( ulShift + ( cCols * 8 ) + 7 ) / 8;
+        kFirst  = ( iByte < 0 ) ? -iByte : 0;
+        ullMask >>= ulShift;
+
+        for ( r = yTop; r < (ULONG) yBottom; r++ ) {
+            ullRow = 0;
+            for ( k = 0; k < cCols; k++ )
+                ullRow |= (uint64_t) pSrc[ (( c + k ) * cy ) + r ] << ( 56 - ( k * 8 ));
+            ullRow = ( ullRow >> ulShift ) & ullMask;
+            if ( !ullRow ) continue;
+            // Bytes left of the surface are masked out, so start past them
+            pDest = pSurface->pBits + (( y + r ) * pSurface->ulPitch ) + ( iByte + (LONG) kFirst );
+            for ( k = kFirst; k < cBytes; k++ ) {
+                b = (BYTE)( ullRow >> ( 56 - ( k * 8 )));
+                if ( b ) pDest[ k - kFirst ] |= b;
+            }
+        }
+    }
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * DrawGlyph8bpp                                                             *
+ *                                                                           *
+ * Draws a glyph onto an 8 bits per pel surface, straight from the column-   *
+ * major bitmap in the font (see TransposeGlyph), clipping it to the         *
+ * surface.  The surface colour is written to every set pel of the glyph,    *
+ * a byte (eight pels) of each column at a time; empty bytes are skipped.    *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE           pSrc    : The glyph bitmap, in OS/2 font format.    (I) *
+ *   PGLYPHBITMAP    pGlyph  : The glyph information (from LocateGlyph). (I) *
+ *   POS2TEXTSURFACE pSurface: The surface to draw on.                  (IO) *
+ *   LONG            x       : Surface column of bitmap's left edge.     (I) *
+ *   LONG            y       : Surface row of the bitmap's top row.      (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void DrawGlyph8bpp( PBYTE pSrc, PGLYPHBITMAP pGlyph, POS2TEXTSURFACE pSurface, LONG x, LONG y )
+{
+    PBYTE pDest;                // surface position of the current byte
+    LONG  xLeft, xRight,        // visible range of pels within the glyph
+          yTop, yBottom,        // visible range of rows within the glyph
+          lo, hi;               // visible range of pels within the column
+    ULONG cy = pGlyph->rows,
+          c, r, k;
+    BYTE  bMask,                // visible pels of the current column
+          b;
+
+
+    // Clip the glyph to the surface
+    xLeft   = ( x < 0 ) ? -x : 0;
+    xRight  = (LONG) pSurface->cx - x;
+    if ( xRight > (LONG) pGlyph->width ) xRight = pGlyph->width;
+    yTop    = ( y < 0 ) ? -y : 0;
+    yBottom = (LONG) pSurface->cy - y;
+    if ( yBottom > (LONG) cy ) yBottom = cy;
+    if (( xLeft >= xRight ) || ( yTop >= yBottom )) return;
+
+    for ( c = xLeft / 8; ( c * 8 ) < (ULONG) xRight; c++ ) {
+        lo = ( xLeft > (LONG)( c * 8 )) ? xLeft - ( c * 8 ) : 0;
+        hi = xRight - ( c * 8 );
+        if ( hi > 8 ) hi = 8;
+        bMask = ( 0xFF >> lo ) & ( 0xFF << ( 8 - hi ));
+        for ( r = yTop; r < (ULONG) yBottom; r++ ) {
+            b = pSrc[ ( c * cy ) + r ] & bMask;
+            if ( !b ) continue;
+            // Start at the first visible pel, which is never left of the row
+            pDest = pSurface->pBits + (( y + r ) * pSurface->ulPitch ) +
+                    ( x + (LONG)( c * 8 ) + lo );
+            for ( k = lo; k < (ULONG) hi; k++ )
+                if ( b & ( 0x80 >> k )) pDest[ k - lo ] = pSurface->bColor;
+        }
+    }
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * EvictCachedGlyphs                                                         *
+ *                                                                           *
+ * Evicts unpinned glyphs from a glyph cache, using the CLOCK algorithm (see *
+ * CreateOS2GlyphCache), until the given number of bytes can be added        *
+ * without going over budget or there is nothing left to evict.  The cache   *
+ * must be locked exclusively.                                               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2GLYPHCACHE pCache  : The glyph cache.                          (IO) *
+ *   ULONG          cbNeeded: Number of bytes about to be added.         (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void EvictCachedGlyphs( POS2GLYPHCACHE pCache, ULONG cbNeeded )
+{
+    PGLYPHCACHEENTRY pVictim;
+
+    while ( pCache->pHand &&
+            (( pCache->stats.cbUsed + cbNeeded ) > pCache->stats.cbBudget )) {
+        if ( pCache->pHand->fReferenced ) {
+            pCache->pHand->fReferenced = FALSE;
+            pCache->pHand = pCache->pHand->pRingNext;
+            continue;
+        }
+        pVictim = pCache->pHand;
+        RemoveCachedGlyph( pCache, pVictim );
+        pCache->stats.ulEvictions++;
+    }
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * EvictCachedObjects                                                        *
+ *                                                                           *
+ * Evicts the least recently used objects from the object cache until the    *
+ * given number of bytes can be added without going over budget, or there    *
+ * is nothing left to evict.  Objects which are still in use by a font are   *
+ * freed once it releases them.  The object cache must be locked.            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG cbNeeded: Number of bytes about to be added.                  (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void EvictCachedObjects( ULONG cbNeeded )
+{
+    POBJCACHEENTRY pVictim;
+
+    while ( object_cache.pTail &&
+            (( object_cache.stats.cbUsed + cbNeeded ) > object_cache.stats.cbBudget )) {
+        pVictim = object_cache.pTail;
+        object_cache.pTail = pVictim->pPrev;
+        if ( object_cache.pTail ) object_cache.pTail->pNext = NULL;
+        else                      object_cache.pHead = NULL;
+        pVictim->fCached = FALSE;
+        object_cache.stats.cbUsed -= pVictim->cb;
+        object_cache.stats.cEntries--;
+        object_cache.stats.ulEvictions++;
+        if ( --pVictim->cRefs == 0 ) FreeCachedObject( pVictim );
+    }
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * ExtractOS2FontGlyph                                                       *
+ *                                                                           *
+ * Extracts the bitmap data for the OS/2 font glyph at the given index, and  *
+ * converts it into standard bitmap format.  The bitmap will be written into *
+ * the buffer field of the provided glyph information structure; the buffer  *
+ * will be allocated by this function and should be freed by the caller when *
+ * no longer needed.                                                         *
+ *                                                                           *
+ * The bitmap has to be converted manually by this function because the      *
+ * standard OS/2 font format stores bitmap data with consecutive bytes       *
+ * representing vertical columns, rather than rows as with standard bitmaps. *
+ *                                                                           *
+ * The written bitmap buffer contains the image bits only, no header         *
+ * information is included.  The image format is 1 bit per pixel.            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *   PGLYPHBITMAP     pGlyph : Pointer to the glyph information.         (O) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ * ------------------------------------------------------------------------- */
+BOOL ExtractOS2FontGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph )
+{
+    GLYPHBITMAP glyph;          // glyph information
+    PBYTE       pBitmap,        // pointer to bitmap within the font data
+                pBuffer;        // new buffer to receive the glyph bitmap
+
+
+    pBitmap = LocateGlyph( ulIndex, pFont, &glyph );
+    if ( !pBitmap ) return FALSE;
+
+    pBuffer = (PBYTE) calloc( glyph.rows, glyph.pitch );
+    if ( !pBuffer ) return FALSE;
+
+    // Now convert the bitmap
+    StoreGlyph( pFont, pBitmap, &glyph, pBuffer );
+    glyph.buffer = pBuffer;
+    *pGlyph = glyph;
+    return TRUE;
+}
+
+/* ------------------------------------------------------------------------- *
+ * ExtractOS2FontGlyphInto                                                   *
+ *                                                                           *
+ * Extracts the bitmap data for the OS/2 font glyph at the given index, as   *
+ * with ExtractOS2FontGlyph(), but writes it into a buffer supplied by the   *
+ * caller instead of allocating one.  The buffer must be large enough to     *
+ * hold the bitmap (see OS2FontGlyphSize); it is not freed by this function, *
+ * and the buffer field of the glyph information structure is set to point   *
+ * to it.  This allows many glyphs to be extracted into a single buffer or   *
+ * arena without any memory being allocated.                                 *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG            ulIndex : Glyph index (codepoint) within the font. (I) *
+ *   POS2FONTRESOURCE pFont   : Pointer to the font resource data.       (I) *
+ *   PGLYPHBITMAP     pGlyph  : Pointer to the glyph information.        (O) *
+ *   PBYTE            pBuffer : Buffer to receive the glyph bitmap.      (O) *
+ *   ULONG            cbBuffer: Size of pBuffer in bytes.                (I) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   FALSE if the glyph does not exist or the buffer is too small.           *
+ * ------------------------------------------------------------------------- */
+BOOL ExtractOS2FontGlyphInto( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph, PBYTE pBuffer, ULONG cbBuffer )
+{
+    GLYPHBITMAP glyph;          // glyph information
+    PBYTE       pBitmap;        // pointer to bitmap within the font data
+
+
+    pBitmap = LocateGlyph( ulIndex, pFont, &glyph );
+    if ( !pBitmap || ( glyph.cbBuffer > cbBuffer )) return FALSE;
+
+    StoreGlyph( pFont, pBitmap, &glyph, pBuffer );
+    glyph.buffer = pBuffer;
+    *pGlyph = glyph;
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * ExtractOS2FontGlyphs                                                      *
+ *                                                                           *
+ * Extracts the bitmaps of a list of glyphs back-to-back into one contiguous *
+ * slab of memory supplied by the caller.  The offset of each glyph's bitmap *
+ * within the slab is written to an offset table, which has one more entry   *
+ * than the number of glyphs; the size of glyph n is therefore given by      *
+ * (paulOffsets[n+1] - paulOffsets[n]).  Glyphs which do not exist in the    *
+ * font take up no space (and their glyph information, if requested, is      *
+ * zeroed).                                                                  *
+ *                                                                           *
+ * The return value is the total slab size which the glyphs require.  If     *
+ * pSlab is NULL or cbSlab is less than this, nothing is extracted (although *
+ * the offset table is still filled in); so the function can be called       *
+ * first with a NULL slab to find out how large it needs to be.              *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont      : Pointer to the font resource data.    (I) *
+ *   PULONG           pulIndices : Array of glyph indices to extract.    (I) *
+ *   ULONG            cGlyphs    : Number of glyph indices.              (I) *
+ *   PBYTE            pSlab      : Buffer to receive the bitmaps.        (O) *
+ *   ULONG            cbSlab     : Size of pSlab in bytes.               (I) *
+ *   PULONG           paulOffsets: Offset table (cGlyphs+1 entries).     (O) *
+ *   PGLYPHBITMAP     paGlyphs   : Optional array of glyph information       *
+ *                                 (cGlyphs entries), or NULL.           (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The number of bytes of slab required by (or used for) the glyphs.       *
+ * ------------------------------------------------------------------------- */
+ULONG ExtractOS2FontGlyphs( POS2FONTRESOURCE pFont, PULONG pulIndices, ULONG cGlyphs, PBYTE pSlab, ULONG cbSlab, PULONG paulOffsets, PGLYPHBITMAP paGlyphs )
+{
+    GLYPHBITMAP glyph;          // glyph information
+    PBYTE       pBitmap;        // pointer to bitmap within the font data
+    ULONG       cbTotal,        // total slab size required
+                i;
+    BOOL        fExtract;       // whether to extract the bitmaps
+
+
+    // Work out the layout of the slab
+    cbTotal = 0;
+    for ( i = 0; i < cGlyphs; i++ ) {
+        paulOffsets[ i ] = cbTotal;
+        if ( LocateGlyph( pulIndices[ i ], pFont, &glyph ))
+            cbTotal += glyph.cbBuffer;
+    }
+    paulOffsets[ cGlyphs ] = cbTotal;
+    fExtract = ( pSlab && ( cbTotal <= cbSlab ));
+
+    // Now extract the glyphs (if there is room)
+    for ( i = 0; ( fExtract || paGlyphs ) && ( i < cGlyphs ); i++ ) {
+        pBitmap = LocateGlyph( pulIndices[ i ], pFont, &glyph );
+        if ( !pBitmap ) {
+            if ( paGlyphs ) memset( paGlyphs + i, 0, sizeof( GLYPHBITMAP ));
+            continue;
+        }
+        if ( fExtract ) {
+            glyph.buffer = pSlab + paulOffsets[ i ];
+            StoreGlyph( pFont, pBitmap, &glyph, glyph.buffer );
+        }
+        if ( paGlyphs ) paGlyphs[ i ] = glyph;
+    }
+    return cbTotal;
+}
+
+
+
+/* ------------------------------------------------------------------------- *
+ * FindCachedGlyph                                                           *
+ *                                                                           *
+ * Looks up a glyph in a glyph cache.  The cache must be locked.             *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2GLYPHCACHE   pCache : The glyph cache.                          (I) *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *                                                                           *
+ * RETURNS: PGLYPHCACHEENTRY                                                 *
+ *   The cache entry of the glyph, or NULL if it is not in the cache.        *
+ * ------------------------------------------------------------------------- */
+PGLYPHCACHEENTRY FindCachedGlyph( POS2GLYPHCACHE pCache, ULONG ulIndex, POS2FONTRESOURCE pFont )
+{
+    PGLYPHCACHEENTRY pEntry;
+
+    pEntry = pCache->papBuckets[ GLYPH_CACHE_HASH( pFont, ulIndex, pCache->cBuckets ) ];
+    while ( pEntry && (( pEntry->pFont != pFont ) || ( pEntry->ulIndex != ulIndex )))
+        pEntry = pEntry->pNext;
+    return pEntry;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * FreeCachedObject                                                          *
+ *                                                                           *
+ * Frees an object cache entry (see NewCachedObject) whose last reference    *
+ * has been dropped.                                                         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POBJCACHEENTRY pEntry: The entry to free.                           (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void FreeCachedObject( POBJCACHEENTRY pEntry )
+{
+#ifdef HAVE_PTHREADS
+    pthread_mutex_destroy( &pEntry->mtxPages );
+#endif
+    free( pEntry );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * FreeOS2FontResource                                                       *
+ *                                                                           *
+ * Releases the data held by a font which was returned by either             *
+ * ReadOS2FontResource(), MapOS2FontResource() or GetOS2FontModuleFace().    *
+ * Fonts whose data was allocated are freed, while fonts which point into a  *
+ * mapped file or font module simply drop their reference to it.  The        *
+ * structure is cleared on return.                                           *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont: Pointer to the font to be released.        (IO) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void FreeOS2FontResource( POS2FONTRESOURCE pFont )
+{
+    if ( !pFont ) return;
+    free( pFont->pAtlas );
+    free( pFont->pKernIndex );
+    switch ( pFont->ulStorage ) {
+        case OS2FONT_STORE_MAPPED:
+            OS2ReleaseFileMap( (POS2FILEMAP) pFont->pStorage );
+            break;
+        case OS2FONT_STORE_MODULE:
+            CloseOS2FontModule( (POS2FONTMODULE) pFont->pStorage );
+            break;
+        case OS2FONT_STORE_OBJECT:
+            ReleaseCachedObject( (POBJCACHEENTRY) pFont->pStorage );
+            break;
+        default:
+            free( pFont->pSignature );
+            break;
+    }
+    memset( pFont, 0, sizeof( OS2FONTRESOURCE ));
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * GetCachedObject                                                           *
+ *                                                                           *
+ * Looks up an LX object in the object cache.  If it is there, it becomes    *
+ * the most recently used object, and the caller gets a reference to it      *
+ * which must be released with ReleaseCachedObject().  The lookup is counted *
+ * as a hit or a miss by GrowCachedObject(), once it is known whether any    *
+ * pages had to be unpacked.                                                 *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FILEID pID  : Identity of the module file.                      (I) *
+ *   ULONG      ulObj: Object number (1-based).                          (I) *
+ *                                                                           *
+ * RETURNS: POBJCACHEENTRY                                                   *
+ *   The cached object, or NULL if it is not in the cache.                   *
+ * ------------------------------------------------------------------------- */
+POBJCACHEENTRY GetCachedObject( POS2FILEID pID, ULONG ulObj )
+{
+    POBJCACHEENTRY pEntry;
+
+    _OBJCACHE_LOCK();
+    for ( pEntry = object_cache.pHead; pEntry; pEntry = pEntry->pNext ) {
+        if (( pEntry->ulObj == ulObj ) &&
+            !memcmp( &pEntry->id, pID, sizeof( OS2FILEID )))
+            break;
+    }
+    if ( pEntry ) {
+        // Move it to the front of the list
+        if ( pEntry->pPrev ) {
+            pEntry->pPrev->pNext = pEntry->pNext;
+            if ( pEntry->pNext ) pEntry->pNext->pPrev = pEntry->pPrev;
+            else                 object_cache.pTail   = pEntry->pPrev;
+            pEntry->pPrev = NULL;
+            pEntry->pNext = object_cache.pHead;
+            object_cache.pHead->pPrev = pEntry;
+            object_cache.pHead = pEntry;
+        }
+        pEntry->cRefs++;
+    }
+    _OBJCACHE_UNLOCK();
+    return pEntry;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * GetOS2AtlasGlyph                                                          *
+ *                                                                           *
+ * Looks up the OS/2 font glyph at the given index in the font's glyph atlas *
+ * (see BuildOS2GlyphAtlas).  The glyph information is filled in as with     *
+ * ExtractOS2FontGlyph(), except that the buffer field points directly to    *
+ * the bitmap within the atlas; it must not be modified or freed, and        *
+ * remains valid until the font is freed.                                    *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *   PGLYPHBITMAP     pGlyph : Pointer to the glyph information.         (O) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   FALSE if the font has no atlas or the glyph does not exist.             *
+ * ------------------------------------------------------------------------- */
+BOOL GetOS2AtlasGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph )
+{
+    POS2GLYPHATLAS pAtlas = pFont->pAtlas;
+    POS2ATLASGLYPH pEntry;
+
+
+    if ( !pAtlas ) return FALSE;
+
+    // Map index 0 to the default/substitution glyph
+    if ( ulIndex == 0 )
+        ulIndex = pAtlas->ulFirstChar + pFont->pMetrics->usDefaultChar;
+
+    ulIndex -= pAtlas->ulFirstChar;
+    if ( ulIndex >= pAtlas->cGlyphs ) return FALSE;
+    pEntry = pAtlas->paGlyphs + ulIndex;
+    if ( pEntry->ulOffset == OS2ATLAS_NO_GLYPH ) return FALSE;
+
+    pGlyph->rows         = pAtlas->cRows;
+    pGlyph->width        = pEntry->usWidth;
+    pGlyph->pitch        = pEntry->usPitch;
+    pGlyph->buffer       = pAtlas->pData + pEntry->ulOffset;
+    pGlyph->cbBuffer     = pAtlas->cRows * pEntry->usPitch;
+    pGlyph->horiBearingX = pEntry->sBearingX;
+    pGlyph->horiAdvance  = pEntry->sAdvance;
+    pGlyph->vertBearingY = pAtlas->sBearingY;
+    pGlyph->vertAdvance  = pAtlas->sAdvanceY;
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * GetOS2CachedGlyph                                                         *
+ *                                                                           *
+ * Looks up the OS/2 font glyph at the given index in a glyph cache.  If it  *
+ * is not already there, it is extracted from the font (as with              *
+ * ExtractOS2FontGlyph) and added to the cache, evicting other glyphs if     *
+ * necessary.  This may be called by several threads at once.                *
+ *                                                                           *
+ * The buffer field of the returned glyph information points into the        *
+ * cache; it must not be modified or freed.  Instead, the glyph must be      *
+ * released with ReleaseOS2CachedGlyph() once no longer needed, until which  *
+ * time the bitmap remains valid (even if the glyph is evicted meanwhile).   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2GLYPHCACHE   pCache : The glyph cache.                         (IO) *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *   PGLYPHBITMAP     pGlyph : Pointer to the glyph information.         (O) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   FALSE if the glyph does not exist or could not be extracted.            *
+ * ------------------------------------------------------------------------- */
+BOOL GetOS2CachedGlyph( POS2GLYPHCACHE pCache, ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph )
+{
+    PGLYPHCACHEENTRY pEntry,
+                     pNew;
+
+
+    // Map index 0 to the default/substitution glyph
+    if ( ulIndex == 0 )
+        ulIndex = pFont->pMetrics->usFirstChar + pFont->pMetrics->usDefaultChar;
+
+    _CACHE_READ( pCache );
+    pEntry = FindCachedGlyph( pCache, ulIndex, pFont );
+    if ( pEntry ) {
+        _REF_ADD( pEntry->cRefs );
+        _FLAG_SET( pEntry->fReferenced );
+        _STAT_ADD( pCache->stats.ulHits, 1 );
+        _CACHE_UNLOCK( pCache );
+        *pGlyph = pEntry->glyph;
+        return TRUE;
+    }
+    _STAT_ADD( pCache->stats.ulMisses, 1 );
+    _CACHE_UNLOCK( pCache );
+
+    // Extract the glyph without holding the lock
+    pNew = NewCachedGlyph( ulIndex, pFont );
+    if ( !pNew ) return FALSE;
+
+    // Another thread may have added the same glyph in the meantime
+    _CACHE_WRITE( pCache );
+    pEntry = FindCachedGlyph( pCache, ulIndex, pFont );
+    if ( pEntry )
+        free( pNew );
+    else {
+        InsertCachedGlyph( pCache, pNew );
+        pEntry = pNew;
+    }
+    _REF_ADD( pEntry->cRefs );
+    pEntry->fReferenced = TRUE;
+    _CACHE_UNLOCK( pCache );
+    *pGlyph = pEntry->glyph;
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * GetOS2FontModuleFace                                                      *
+ *                                                                           *
+ * Retrieves and parses a single font face from an opened font module.  The  *
+ * face is located using the index built by OpenOS2FontModule(), so no part  *
+ * of the resource table or font directory is read again.  If the face is    *
+ * stored uncompressed it refers directly into the file mapping; otherwise   *
+ * it refers into the object in the object cache, which is shared with every *
+ * other face, module or file using the same object (see                     *
+ * SetOS2ObjectCacheBudget), or into the module's own copy of the object if  *
+ * the object cache is disabled.  Either way only the pages covering the     *
+ * face are unpacked, and pages shared with a face which was already         *
+ * retrieved are not unpacked again.                                         *
+ *                                                                           *
+ * The returned font must be released using FreeOS2FontResource().           *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTMODULE   pModule: The opened font module.                   (I) *
+ *   ULONG            ulFace : Face number (where 0 is the first font).  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to an OS2FONTRESOURCE structure       *
+ *                             which will receive the parsed font data.  (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 if the font was successfully located and parsed, ERR_* otherwise.     *
+ * ------------------------------------------------------------------------- */
+ULONG GetOS2FontModuleFace( POS2FONTMODULE pModule, ULONG ulFace, POS2FONTRESOURCE pFont )
+{
+    LXHEADER      *plx_hd;      // executable header
+    LXRTENTRY     *plx_rte;     // resource table entry of the face
+    PBYTE          pRes;        // resource data
+    POBJCACHEENTRY pEntry;      // the object, if cached
+    ULONG          cbRes,       // size of the resource (NE modules)
+                   cPages,      // number of pages in the object
+                   ulFirst,     // first page covering the resource
+                   ulLast,      // last page covering the resource
+                   i,
+                   ulRC;
+
+
+    if ( ulFace >= pModule->cFaces )
+        return ERR_NO_FONT;
+
+    // A plain font file is its own (single) face
+    if ( !pModule->usMagic ) {
+        ulRC = ParseOS2FontResource( pModule->pMap->pData, pModule->pMap->cbData, pFont );
+        if ( ulRC == 0 ) {
+            pFont->ulStorage = OS2FONT_STORE_MAPPED;
+            pFont->pStorage  = pModule->pMap;
+            pModule->pMap->cRefs++;
+        }
+        return ulRC;
+    }
+
+    if ( pModule->paulFaceRes[ ulFace ] == (ULONG) -1 )
+        return ERR_NO_FONT;
+
+    // NE resources are never compressed, so they are always used in place
+    if ( pModule->usMagic == MAGIC_NE ) {
+        pRes = NEResourceInPlace( pModule->pMap, pModule->ulBase,
+                                  pModule->paulFaceRes[ ulFace ], &cbRes );
+        if ( !pRes ) return ERR_FILE_READ;
+        ulRC = ParseOS2FontResource( pRes, cbRes, pFont );
+        if ( ulRC == 0 ) {
+            pFont->ulStorage = OS2FONT_STORE_MAPPED;
+            pFont->pStorage  = pModule->pMap;
+            pModule->pMap->cRefs++;
+        }
+        return ulRC;
+    }
+
+    plx_hd  = (LXHEADER *)( pModule->pMap->pData + pModule->ulBase );
+    plx_rte = (LXRTENTRY *)( pModule->pMap->pData + pModule->ulBase + plx_hd->res_tbl ) +
+              pModule->paulFaceRes[ ulFace ];
+
+    // Reference the font in place if possible
+    pRes = LXResourceInPlace( pModule->pMap, pModule->ulBase, plx_rte );
+    if ( pRes ) {
+        ulRC = ParseOS2FontResource( pRes, plx_rte->cb, pFont );
+        if ( ulRC == 0 ) {
+            pFont->ulStorage = OS2FONT_STORE_MAPPED;
+            pFont->pStorage  = pModule->pMap;
+            pModule->pMap->cRefs++;
+        }
+        return ulRC;
+    }
+
+    if (( plx_rte->obj == 0 ) || ( plx_rte->obj > pModule->cObjects ) ||
+        !LXObjectPageMap( pModule->pMap, pModule->ulBase, plx_rte->obj, &cPages ))
+        return ERR_FILE_FORMAT;
+    ulFirst = plx_rte->offset / LX_PAGE_SIZE;
+    ulLast  = ( plx_rte->offset + plx_rte->cb - 1 ) / LX_PAGE_SIZE;
+    if (( plx_rte->cb == 0 ) || ( ulLast >= cPages ))
+        return ERR_FILE_FORMAT;
+
+    /* Otherwise unpack the pages of the object which cover it, in the object
+     * cache (so that they are shared with every other face and module using
+     * the object)...
+     */
+    if ( ObjectCacheBudget() ) {
+        pEntry = LXMappedObject( pModule->pMap, pModule->ulBase, plx_rte->obj, ulFirst, ulLast );
+        if ( !pEntry ) return ERR_FILE_READ;
+        ulRC = ParseOS2FontResource( pEntry->pData + plx_rte->offset, plx_rte->cb, pFont );
+        if ( ulRC == 0 ) {
+            pFont->ulStorage = OS2FONT_STORE_OBJECT;
+            pFont->pStorage  = pEntry;
+        }
+        else ReleaseCachedObject( pEntry );
+        return ulRC;
+    }
+
+    /* ...or, if the cache is disabled, in the module's own copy of the
+     * object.  Pages which were already unpacked for another face are not
+     * unpacked again.
+     */
+    i = plx_rte->obj - 1;
+    if ( !pModule->papObjects[ i ] ) {
+        pModule->papObjects[ i ]   = (PBYTE) calloc( cPages, LX_PAGE_SIZE );
+        pModule->papPagesDone[ i ] = (PBYTE) calloc( cPages, 1 );
+        if ( !pModule->papObjects[ i ] || !pModule->papPagesDone[ i ] ) {
+            free( pModule->papObjects[ i ] );
+            free( pModule->papPagesDone[ i ] );
+            pModule->papObjects[ i ]   = NULL;
+            pModule->papPagesDone[ i ] = NULL;
+            return ERR_MEMORY;
+        }
+    }
+    if ( !LXUnpackPages( pModule->pMap, pModule->ulBase, plx_rte->obj, ulFirst, ulLast,
+                         pModule->papObjects[ i ] + ( ulFirst * LX_PAGE_SIZE ),
+                         pModule->papPagesDone[ i ] + ulFirst ))
+        return ERR_FILE_READ;
+
+    ulRC = ParseOS2FontResource( pModule->papObjects[ plx_rte->obj - 1 ] + plx_rte->offset,
+                                 plx_rte->cb, pFont );
+    if ( ulRC == 0 ) {
+        pFont->ulStorage = OS2FONT_STORE_MODULE;
+        pFont->pStorage  = pModule;
+        pModule->cRefs++;
+    }
+    return ulRC;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * GlyphAdvance                                                              *
+ *                                                                           *
+ * Returns the horizontal advance of the OS/2 font glyph at the given index, *
+ * as RenderOS2FontText() would move the pen for it.  The glyph is checked   *
+ * by LocateFontGlyph(), so a glyph whose bitmap lies outside the font data  *
+ * has no advance here either, but the bitmap itself is not touched.         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *                                                                           *
+ * RETURNS: LONG                                                             *
+ *   The advance in pels, or 0 if the glyph does not exist.                  *
+ * ------------------------------------------------------------------------- */
+LONG GlyphAdvance( ULONG ulIndex, POS2FONTRESOURCE pFont )
+{
+    GLYPHBITMAP glyph;          // glyph information
+
+    if ( !LocateFontGlyph( ulIndex, pFont, &glyph )) return 0;
+    return glyph.horiAdvance;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * GrowCachedObject                                                          *
+ *                                                                           *
+ * Counts a lookup of an object cache entry, and charges the cache for any   *
+ * pages of the object which were unpacked by it, evicting other objects as  *
+ * needed to stay within the budget.  If the object itself has to be         *
+ * evicted it can still be used by the caller.                               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POBJCACHEENTRY pEntry: The cached object.                           (I) *
+ *   ULONG          cPages: Number of pages newly unpacked.              (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void GrowCachedObject( POBJCACHEENTRY pEntry, ULONG cPages )
+{
+    ULONG cb = cPages * LX_PAGE_SIZE;
+
+    _OBJCACHE_LOCK();
+    if ( cPages ) {
+        object_cache.stats.ulMisses++;
+        if ( pEntry->fCached ) EvictCachedObjects( cb );
+        pEntry->cb += cb;
+        if ( pEntry->fCached ) object_cache.stats.cbUsed += cb;
+    }
+    else object_cache.stats.ulHits++;
+    _OBJCACHE_UNLOCK();
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * InsertCachedGlyph                                                         *
+ *                                                                           *
+ * Adds a new entry to a glyph cache.  Unless the entry is pinned, enough    *
+ * glyphs are first evicted to make room for it, and it is then added to     *
+ * the ring just behind the CLOCK hand (so that it is the last glyph the     *
+ * hand reaches).  The hash table is doubled in size if it has become too    *
+ * full; if that fails, the existing table simply carries on being used.     *
+ * The cache must be locked exclusively.                                     *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2GLYPHCACHE   pCache: The glyph cache.                          (IO) *
+ *   PGLYPHCACHEENTRY pEntry: The new cache entry.                       (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void InsertCachedGlyph( POS2GLYPHCACHE pCache, PGLYPHCACHEENTRY pEntry )
+{
+    PGLYPHCACHEENTRY *papBuckets,
+                      pMove;
+    ULONG             cBuckets,
+                      ulHash,
+                      i;
+
+
+    if ( !pEntry->fPinned ) EvictCachedGlyphs( pCache, pEntry->cb );
+
+    if ( pCache->stats.cEntries >= pCache->cBuckets ) {
+        cBuckets   = pCache->cBuckets * 2;
+        papBuckets = (PGLYPHCACHEENTRY *) calloc( cBuckets, sizeof( PGLYPHCACHEENTRY ));
+        if ( papBuckets ) {
+            for ( i = 0; i < pCache->cBuckets; i++ ) {
+                while ( pCache->papBuckets[ i ] ) {
+                    pMove = pCache->papBuckets[ i ];
+                    pCache->papBuckets[ i ] = pMove->pNext;
+                    ulHash = GLYPH_CACHE_HASH( pMove->pFont, pMove->ulIndex, cBuckets );
+                    pMove->pNext = papBuckets[ ulHash ];
+                    papBuckets[ ulHash ] = pMove;
+                }
+            }
+            free( pCache->papBuckets );
+            pCache->papBuckets = papBuckets;
+            pCache->cBuckets   = cBuckets;
+        }
+    }
+    ulHash = GLYPH_CACHE_HASH( pEntry->pFont, pEntry->ulIndex, pCache->cBuckets );
+    pEntry->pNext = pCache->papBuckets[ ulHash ];
+    pCache->papBuckets[ ulHash ] = pEntry;
+
+    if ( pEntry->fPinned )
+        pCache->stats.cPinned++;
+    else if ( pCache->pHand ) {
+        pEntry->pRingNext = pCache->pHand;
+        pEntry->pRingPrev = pCache->pHand->pRingPrev;
+        pEntry->pRingPrev->pRingNext = pEntry;
+        pCache->pHand->pRingPrev = pEntry;
+    }
+    else {
+        pEntry->pRingNext = pEntry;
+        pEntry->pRingPrev = pEntry;
+        pCache->pHand = pEntry;
+    }
+    pCache->stats.cEntries++;
+    pCache->stats.cbUsed += pEntry->cb;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * InsertCachedObject                                                        *
+ *                                                                           *
+ * Adds a new LX object entry (see NewCachedObject) to the object cache, as  *
+ * the most recently used object, evicting others as needed to stay within   *
+ * the budget.  If another thread has already added the same object in the   *
+ * meantime, the new one is freed and the existing one is used instead.  An  *
+ * object larger than the whole budget is not cached, but can still be used  *
+ * by the caller.                                                            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POBJCACHEENTRY pEntry: The unpacked object, with its identity and       *
+ *                          object number set.                           (I) *
+ *                                                                           *
+ * RETURNS: POBJCACHEENTRY                                                   *
+ *   The cached object, to which the caller holds a reference (to be         *
+ *   released with ReleaseCachedObject).                                     *
+ * ------------------------------------------------------------------------- */
+POBJCACHEENTRY InsertCachedObject( POBJCACHEENTRY pEntry )
+{
+    POBJCACHEENTRY pOther;
+
+    _OBJCACHE_LOCK();
+    for ( pOther = object_cache.pHead; pOther; pOther = pOther->pNext ) {
+        if (( pOther->ulObj == pEntry->ulObj ) &&
+            !memcmp( &pOther->id, &pEntry->id, sizeof( OS2FILEID ))) {
+            pOther->cRefs++;
+            _OBJCACHE_UNLOCK();
+            FreeCachedObject( pEntry );
+            return pOther;
+        }
+    }
+    pEntry->cRefs = 1;
+    if ( pEntry->cb <= object_cache.stats.cbBudget ) {
+        EvictCachedObjects( pEntry->cb );
+        pEntry->pPrev   = NULL;
+        pEntry->pNext   = object_cache.pHead;
+        pEntry->fCached = TRUE;
+        pEntry->cRefs++;
+        if ( object_cache.pHead ) object_cache.pHead->pPrev = pEntry;
+        else                      object_cache.pTail = pEntry;
+        object_cache.pHead = pEntry;
+        object_cache.stats.cbUsed += pEntry->cb;
+        object_cache.stats.cEntries++;
+    }
+    _OBJCACHE_UNLOCK();
+    return pEntry;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXCompareResKeys                                                          *
+ *                                                                           *
+ * qsort() comparison function for LX resource index keys: orders them by    *
+ * resource type, then by name (ID), then by position in the resource table. *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   const void *p1: The first key (PLXRESKEY).                          (I) *
+ *   const void *p2: The second key (PLXRESKEY).                         (I) *
+ *                                                                           *
+ * RETURNS: int                                                              *
+ *   Less than, equal to or greater than 0 as the first key sorts before,    *
+ *   with or after the second.                                               *
+ * ------------------------------------------------------------------------- */
+int LXCompareResKeys( const void *p1, const void *p2 )
+{
+    PLXRESKEY pKey1 = (PLXRESKEY) p1,
+              pKey2 = (PLXRESKEY) p2;
+
+    if ( pKey1->usType != pKey2->usType )
+        return ( pKey1->usType < pKey2->usType ) ? -1 : 1;
+    if ( pKey1->usName != pKey2->usName )
+        return ( pKey1->usName < pKey2->usName ) ? -1 : 1;
+    if ( pKey1->ulEntry != pKey2->ulEntry )
+        return ( pKey1->ulEntry < pKey2->ulEntry ) ? -1 : 1;
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXDecodePage                                                              *
+ *                                                                           *
+ * Unpacks a single object page into its output slot, according to the way   *
+ * it is stored.  Uncompressed pages are simply copied (unless they have     *
+ * already been read into the slot).                                         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PLXPAGEJOB pJob: The page to unpack.                                (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void LXDecodePage( PLXPAGEJOB pJob )
+{
+    if ( pJob->usFlags == OP32_ITERDATA2 ) {
+        LXDecodePage2( pJob->pDest, pJob->pSrc, pJob->cbSrc );
+        return;
+    }
+    if ( pJob->pDest != pJob->pSrc )
+        memcpy( pJob->pDest, pJob->pSrc, pJob->cbSrc );
+    if ( pJob->usFlags == OP32_ITERDATA )
+        LXUnpack1( pJob->pDest, pJob->cbSrc );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXDecodePage2                                                             *
+ *                                                                           *
+ * Decodes a (max 4096-byte) page which has been compressed using the OS/2   *
+ * /EXEPACK2 method (which is apparently a modified Lempel-Ziv algorithm).   *
+ * The data is decoded straight into the output page, which must provide     *
+ * 4096 bytes and must not overlap the input.  Output beyond the end of the  *
+ * decoded data is zero-filled.  Malformed data (references or runs which    *
+ * would fall outside the page) ends decoding at that point.                 *
+ *                                                                           *
+ * Most of the page is decoded by a loop which does not check each token     *
+ * against the ends of the input and the page, since it stops while there    *
+ * is still room for the largest token, and which copies in 8-byte chunks    *
+ * (see CopyLiteral and CopyBackRef).  The rest is decoded with every token  *
+ * checked, and copied exactly.                                              *
+ *                                                                           *
+ * This algorithm was derived from public-domain Pascal-and-x86-assembly     *
+ * code by Veit Kannegieser (based on previous work by Max Alekseyev).       *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE  pOut: Buffer to receive the unpacked page (4096 bytes).      (O) *
+ *   PBYTE  pIn : Buffer containing the packed page data.                (I) *
+ *   USHORT cbIn: The size of the packed page data.                      (I) *
+ *                                                                           *
+ * RETURNS: USHORT                                                           *
+ *   The number of output bytes written (always 4096), or 0 if the packed    *
+ *   data is larger than a page.                                             *
+ * ------------------------------------------------------------------------- */
+USHORT LXDecodePage2( PBYTE pOut, PBYTE pIn, USHORT cbIn )
+{
+    ULONG  ofIn,                    // current input buffer offset
+           ofOut,                   // current output buffer offset
+           ulControl,               // control word(s)
+           ulLen,                   // length of current sequence
+           ulDist;                  // distance of current back-reference
+
+
+    if ( cbIn > LX_PAGE_SIZE ) return 0;
+    ofIn  = 0;
+    ofOut = 0;
+
+    /* While any token (and the overrun of the wide copies) is sure to fit in
+     * what is left of the input and the page, only the things which the
+     * token size does not limit (fill lengths and back-reference distances)
+     * need checking.
+     */
+    while ((( ofIn + LX2_FAST_INPUT ) <= cbIn ) &&
+           (( ofOut + LX2_FAST_OUTPUT ) <= LX_PAGE_SIZE )) {
+        ulControl = pIn[ ofIn ] | ( pIn[ ofIn + 1 ] << 8 );
+        switch ( ulControl & 0x3 ) {
+            case 0:
+                if ( LOBYTE( ulControl ) == 0 ) {
+                    ulLen = HIBYTE( ulControl );
+                    if ( !ulLen || (( ofOut + ulLen ) > LX_PAGE_SIZE ))
+                        goto done;
+                    memset( pOut + ofOut, pIn[ ofIn + 2 ], ulLen );
+                    ofIn  += 3;
+                    ofOut += ulLen;
+                }
+                else {
+                    ulLen = ( LOBYTE( ulControl ) >> 2 );
+                    CopyLiteral( pOut + ofOut, pIn + ofIn + 1, ulLen );
+                    ofIn  += ( ulLen + 1 );
+                    ofOut += ulLen;
+                }
+                break;
+
+            case 1:
+                ulLen = ( ulControl >> 2 ) & 0x3;
+                memcpy( pOut + ofOut, pIn + ofIn + 2, 4 );
+                ofIn  += ulLen + 2;
+                ofOut += ulLen;
+                ulLen  = (( ulControl >> 4 ) & 0x7 ) + 3;
+                ulDist = ( ulControl >> 7 ) & 0x1FF;
+                if ( ulDist > ofOut ) goto done;
+                CopyBackRef( pOut, ofOut, ulDist, ulLen );
+                ofOut += ulLen;
+                break;
+
+            case 2:
+                ulLen  = (( ulControl >> 2 ) & 0x3 ) + 3;
+                ulDist = ( ulControl >> 4 ) & 0xFFF;
+                if ( ulDist > ofOut ) goto done;
+                CopyBackRef( pOut, ofOut, ulDist, ulLen );
+                ofIn  += 2;
+                ofOut += ulLen;
+                break;
+
+            case 3:
+                ulControl |= pIn[ ofIn + 2 ] << 16;
+                ulLen = ( ulControl >> 2 ) & 0xF;
+                memcpy( pOut + ofOut, pIn + ofIn + 3, 8 );
+                memcpy( pOut + ofOut + 8, pIn + ofIn + 11, 8 );
+                ofIn  += ulLen + 3;
+                ofOut += ulLen;
+                ulLen  = ( ulControl >> 6 ) & 0x3F;
+                ulDist = ( ulControl >> 12 ) & 0xFFF;
+                if ( ulDist > ofOut ) goto done;
+                CopyBackRef( pOut, ofOut, ulDist, ulLen );
+                ofOut += ulLen;
+                break;
+        }
+    }
+
+    // Decode the rest of the page, checking each token against both ends
+    while ( ofIn < cbIn ) {
+        ulControl = pIn[ ofIn ];
+        if (( ofIn + 1 ) < cbIn )
+            ulControl |= pIn[ ofIn + 1 ] << 8;
+
+        /* Bits 1 & 0 hold the case flag (0-3); the interpretation of the
+         * remaining bits depend on the flag value.
+         */
+        switch ( ulControl & 0x3 ) {
+            case 0:
+                /* bits 15..8  = length2
+                 * bits  7..2  = length1
+                 */
+                if ( LOBYTE( ulControl ) == 0 ) {
+                    /* When length1 == 0, fill (length2) bytes with the byte
+                     * value following ulControl; if length2 is 0 we're done.
+                     */
+                    ulLen = HIBYTE( ulControl );
+                    if ( !ulLen ) goto done;
+                    if ((( ofIn + 3 ) > cbIn ) || (( ofOut + ulLen ) > LX_PAGE_SIZE ))
+                        goto done;
+                    memset( pOut + ofOut, pIn[ ofIn + 2 ], ulLen );
+                    ofIn  += 3;
+                    ofOut += ulLen;
+                }
+                else {
+                    // block copy (length1) bytes from after ulControl
+                    ulLen = ( LOBYTE( ulControl ) >> 2 );
+                    if ((( ofIn + 1 + ulLen ) > cbIn ) || (( ofOut + ulLen ) > LX_PAGE_SIZE ))
+                        goto done;
+                    memcpy( pOut + ofOut, pIn + ofIn + 1, ulLen );
+                    ofIn  += (ulLen + 1);
+                    ofOut += ulLen;
+                }
+                break;
+
+            case 1:
+                /* bits 15..7     = backwards reference
+                 * bits  6..4  +3 = length2
+                 * bits  3..2     = length1
+                 */
+                // copy length1 bytes following ulControl
+                ulLen = ( ulControl >> 2 ) & 0x3;
+                if ((( ofIn + 2 + ulLen ) > cbIn ) || (( ofOut + ulLen ) > LX_PAGE_SIZE ))
+                    goto done;
+                memcpy( pOut + ofOut, pIn + ofIn + 2, ulLen );
+                ofIn  += ulLen + 2;
+                ofOut += ulLen;
+                // get length2 from what's been unpacked already
+                ulLen  = (( ulControl >> 4 ) & 0x7 ) + 3;
+                ulDist = ( ulControl >> 7 ) & 0x1FF;
+                if (( ulDist > ofOut ) || (( ofOut + ulLen ) > LX_PAGE_SIZE ))
+                    goto done;
+                CopyBackRefExact( pOut, ofOut, ulDist, ulLen );
+                ofOut += ulLen;
+                break;
+
+            case 2:
+                /* bits 15.. 4     = backwards reference
+                 * bits  3.. 2  +3 = length
+                 */
+                ulLen  = (( ulControl >> 2 ) & 0x3 ) + 3;
+                ulDist = ( ulControl >> 4 ) & 0xFFF;
+                if ((( ofIn + 2 ) > cbIn ) || ( ulDist > ofOut ) ||
+                    (( ofOut + ulLen ) > LX_PAGE_SIZE ))
+                    goto done;
+                CopyBackRefExact( pOut, ofOut, ulDist, ulLen );
+                ofIn  += 2;
+                ofOut += ulLen;
+                break;
+
+            case 3:
+                if (( ofIn + 3 ) > cbIn ) goto done;
+                ulControl |= pIn[ ofIn + 2 ] << 16;
+                /* bits 23..21  = ?
+                 * bits 20..12  = backwards reference
+                 * bits 11.. 6  = length2
+                 * bits  5.. 2  = length1
+                 */
+                // block copy (length1) bytes
+                ulLen = ( ulControl >> 2 ) & 0xF;
+                if ((( ofIn + 3 + ulLen ) > cbIn ) || (( ofOut + ulLen ) > LX_PAGE_SIZE ))
+                    goto done;
+                memcpy( pOut + ofOut, pIn + ofIn + 3, ulLen );
+                ofIn  += ulLen + 3;
+                ofOut += ulLen;
+                // copy (length2) bytes from previously-unpacked data
+                ulLen  = ( ulControl >> 6 ) & 0x3F;
+                ulDist = ( ulControl >> 12 ) & 0xFFF;
+                if (( ulDist > ofOut ) || (( ofOut + ulLen ) > LX_PAGE_SIZE ))
+                    goto done;
+                CopyBackRefExact( pOut, ofOut, ulDist, ulLen );
+                ofOut += ulLen;
+                break;
+
+        }
+    }
+
+done:
+    /* It seems that the unpacked data will always be 4096 bytes, except for
+     * the final page (which will be taken care of when the caller uses the
+     * total object length to read the concatenated buffer).
+     */
+    if ( ofOut < LX_PAGE_SIZE )
+        memset( pOut + ofOut, 0, LX_PAGE_SIZE - ofOut );
+    return LX_PAGE_SIZE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXDecodePages                                                             *
+ *                                                                           *
+ * Unpacks a batch of object pages.  Since each page is packed independently *
+ * of the others and has its own output slot, the pages can be unpacked in   *
+ * any order; if more than one unpacking thread has been configured (see     *
+ * SetOS2UnpackThreads) and the batch is large enough, the pages are shared  *
+ * out between the calling thread and the thread pool.  Either way the       *
+ * output is the same.                                                       *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PLXPAGEJOB pJobs: Array of pages to unpack.                         (I) *
+ *   ULONG      cJobs: Number of pages in the array.                     (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void LXDecodePages( PLXPAGEJOB pJobs, ULONG cJobs )
+{
+    ULONG i;
+
+#ifdef HAVE_PTHREADS
+    if (( unpack_threads > 1 ) && ( cJobs >= LX_POOL_MIN_PAGES )) {
+        pthread_mutex_lock( &unpack_pool.mtxBatch );
+        if ( unpack_pool.cWorkers ) {
+            pthread_mutex_lock( &unpack_pool.mtx );
+            unpack_pool.pJobs    = pJobs;
+            unpack_pool.cJobs    = cJobs;
+            unpack_pool.iNext    = 0;
+            unpack_pool.cPending = cJobs;
+            unpack_pool.cChunk   = cJobs / ( 4 * ( unpack_pool.cWorkers + 1 ));
+            if ( !unpack_pool.cChunk ) unpack_pool.cChunk = 1;
+            pthread_cond_broadcast( &unpack_pool.cvWork );
+            LXUnpackBatch();
+            while ( unpack_pool.cPending )
+                pthread_cond_wait( &unpack_pool.cvDone, &unpack_pool.mtx );
+            unpack_pool.pJobs = NULL;
+            pthread_mutex_unlock( &unpack_pool.mtx );
+            pthread_mutex_unlock( &unpack_pool.mtxBatch );
+            return;
+        }
+        pthread_mutex_unlock( &unpack_pool.mtxBatch );
+    }
+#endif
+    for ( i = 0; i < cJobs; i++ )
+        LXDecodePage( pJobs + i );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXExtractResource                                                         *
+ *                                                                           *
+ * Extracts a binary resource from an LX-format (32-bit OS/2) module.  The   *
+ * function takes a pointer to a buffer which will receive the extracted     *
+ * resource data.  The buffer is allocated by this function on successful    *
+ * return, contains exactly plx_rte->cb bytes of resource data, and must be  *
+ * freed once no longer needed.                                              *
+ *                                                                           *
+ * Only the object pages which cover the resource are read (and unpacked if  *
+ * necessary); the remaining pages of the object are skipped.  If the object *
+ * has compressed pages, and the object cache is enabled (see                *
+ * SetOS2ObjectCacheBudget), the pages are unpacked into the object in the   *
+ * cache and the resource is copied from there, so that pages shared with    *
+ * other resources only have to be unpacked once.                            *
+ *                                                                           *
+ * This routine is based on information made available by Martin Lafaix,     *
+ * Veit Kannegieser and Max Alekseyev.                                       *
+ *                                                                           *
+ * The module's header, object table and page map are taken from pTables     *
+ * (see LXReadTables), so only the pages themselves are read from the file.  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   FILE      *pf      : Pointer to the open file.                      (I) *
+ *   PLXTABLES  pTables : The module's header and tables.                (I) *
+ *   LXRTENTRY *plx_rte : Resource-table entry of the requested resource (I) *
+ *   PBYTE     *ppBuffer: Pointer to a buffer for the resource data      (O) *
+ *   PULONG     pulSize : Pointer to the returned resource size          (O) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   FALSE: Failed to extract object data; ppBuffer & pulSize are unchanged. *
+ *   TRUE: Data extracted successfully, ppBuffer points to allocated buffer. *
+ * ------------------------------------------------------------------------- */
+BOOL LXExtractResource( FILE *pf, PLXTABLES pTables, LXRTENTRY *plx_rte, PBYTE *ppBuffer, PULONG pulSize )
+{
+    LXOTENTRY     *plx_obj;     // object table entry
+    PLXOPMENTRY    plxpages;    // page map entries of the object
+    POBJCACHEENTRY pEntry;      // the object, if cached
+    ULONG          ulFirst,     // first page covering the resource
+                   ulLast,      // last page covering the resource
+                   cPages,      // number of pages covering the resource
+                   i;
+    PBYTE          pBuf,
+                   pBufOff;
+
+//printf("Extracting resource %u (%u bytes from %u) from object %u\n", plx_rte->name, plx_rte->cb, plx_rte->offset, plx_rte->obj );
+
+    // Locate the object table entry for this resource
+    if (( plx_rte->obj == 0 ) || ( plx_rte->obj > pTables->lx_hd.objcnt ) ||
+        ( plx_rte->cb == 0 ))
+        return FALSE;
+    plx_obj = pTables->paObjects + ( plx_rte->obj - 1 );
+
+    // Work out which pages of the object the resource lies within
+    ulFirst = plx_rte->offset / LX_PAGE_SIZE;
+    ulLast  = ( plx_rte->offset + plx_rte->cb - 1 ) / LX_PAGE_SIZE;
+    if (( ulLast >= plx_obj->mapsize ) || ( plx_obj->pagemap == 0 )) return FALSE;
+    cPages = ulLast - ulFirst + 1;
+
+    // Unpack the pages in the cached object if it needs unpacking at all
+    if ( ObjectCacheBudget() ) {
+        plxpages = pTables->paPages + ( plx_obj->pagemap - 1 );
+        for ( i = 0; i < plx_obj->mapsize; i++ )
+            if (( plxpages[ i ].flags == OP32_ITERDATA ) ||
+                ( plxpages[ i ].flags == OP32_ITERDATA2 ))
+                break;
+        if ( i < plx_obj->mapsize ) {
+            pEntry = LXFileObject( pf, pTables, plx_rte->obj, ulFirst, ulLast );
+            if ( !pEntry ) return FALSE;
+            pBuf = (PBYTE) malloc( plx_rte->cb );
+            if ( pBuf ) memcpy( pBuf, pEntry->pData + plx_rte->offset, plx_rte->cb );
+            ReleaseCachedObject( pEntry );
+            if ( !pBuf ) return FALSE;
+            *ppBuffer = pBuf;
+            *pulSize  = plx_rte->cb;
+            return TRUE;
+        }
+    }
+
+    // Otherwise read just the pages covering the resource
+    pBuf = (PBYTE) calloc( cPages, LX_PAGE_SIZE );
+    if ( !pBuf ) return FALSE;
+    if ( !LXReadPages( pf, pTables, plx_obj, ulFirst, ulLast, pBuf, NULL )) {
+        free( pBuf );
+        return FALSE;
+    }
+
+    // Move the resource data to the start of the buffer and trim it
+    memmove( pBuf, pBuf + ( plx_rte->offset % LX_PAGE_SIZE ), plx_rte->cb );
+    pBufOff = (PBYTE) realloc( pBuf, plx_rte->cb );
+    *ppBuffer = pBufOff ? pBufOff : pBuf;
+    *pulSize  = plx_rte->cb;
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXFileObject                                                              *
+ *                                                                           *
+ * Gets an object of an LX-format module file from the object cache, adding  *
+ * it if it is not already cached, with (at least) the given range of pages  *
+ * read and unpacked; any of those pages which were not already unpacked     *
+ * are read from the file (see LXReadPages).  The caller gets a reference to *
+ * the object, which must be released with ReleaseCachedObject().            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   FILE      *pf     : Pointer to the open file.                       (I) *
+ *   PLXTABLES  pTables: The module's header and tables.                 (I) *
+ *   ULONG      ulObj  : Object number (1-based).                        (I) *
+ *   ULONG      ulFirst: First page (0-based) needed.                    (I) *
+ *   ULONG      ulLast : Last page (0-based) needed.                     (I) *
+ *                                                                           *
+ * RETURNS: POBJCACHEENTRY                                                   *
+ *   The object, or NULL if it could not be read.                            *
+ * ------------------------------------------------------------------------- */
+POBJCACHEENTRY LXFileObject( FILE *pf, PLXTABLES pTables, ULONG ulObj, ULONG ulFirst, ULONG ulLast )
+{
+    POBJCACHEENTRY pEntry;
+    LXOTENTRY     *plx_obj;     // object table entry
+    ULONG          cNew,        // number of pages newly unpacked
+                   i;
+    BOOL           fOK;
+
+    if (( ulObj == 0 ) || ( ulObj > pTables->lx_hd.objcnt )) return NULL;
+    plx_obj = pTables->paObjects + ( ulObj - 1 );
+    if (( plx_obj->mapsize == 0 ) || ( plx_obj->pagemap == 0 ) ||
+        ( ulFirst > ulLast ) || ( ulLast >= plx_obj->mapsize ))
+        return NULL;
+
+    pEntry = GetCachedObject( &(pTables->id), ulObj );
+    if ( !pEntry ) {
+        pEntry = NewCachedObject( plx_obj->mapsize );
+        if ( !pEntry ) return NULL;
+        pEntry->id    = pTables->id;
+        pEntry->ulObj = ulObj;
+        pEntry = InsertCachedObject( pEntry );
+    }
+    if ( pEntry->cPages != plx_obj->mapsize ) {
+        // Not the same file after all
+        ReleaseCachedObject( pEntry );
+        return NULL;
+    }
+
+    _OBJPAGES_LOCK( pEntry );
+    for ( cNew = 0, i = ulFirst; i <= ulLast; i++ )
+        if ( !pEntry->pbDone[ i ] ) cNew++;
+    fOK = LXReadPages( pf, pTables, plx_obj, ulFirst, ulLast,
+                       pEntry->pData + ( ulFirst * LX_PAGE_SIZE ), pEntry->pbDone + ulFirst );
+    _OBJPAGES_UNLOCK( pEntry );
+    if ( !fOK ) {
+        ReleaseCachedObject( pEntry );
+        return NULL;
+    }
+    GrowCachedObject( pEntry, cNew );
+    return pEntry;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXFindFontFace                                                            *
+ *                                                                           *
+ * Finds the resource which holds a font named in an LX module's font        *
+ * directory.  This is normally an OS2RES_FONTFACE resource, which is found  *
+ * by a binary search of the resource index; failing that, the first         *
+ * resource of any other type (except a font directory) with the same ID is  *
+ * used, as the type is not guaranteed.                                      *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PLXRESKEY paIndex : The module's resource index.                    (I) *
+ *   ULONG     cEntries: Number of entries in the resource index.        (I) *
+ *   USHORT    usName  : Resource ID of the font.                        (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The resource table entry number of the font, or (ULONG) -1 if there is  *
+ *   no such resource.                                                       *
+ * ------------------------------------------------------------------------- */
+ULONG LXFindFontFace( PLXRESKEY paIndex, ULONG cEntries, USHORT usName )
+{
+    ULONG i;
+
+    i = LXLookupResource( paIndex, cEntries, OS2RES_FONTFACE, usName );
+    if (( i < cEntries ) &&
+        ( paIndex[ i ].usType == OS2RES_FONTFACE ) &&
+        ( paIndex[ i ].usName == usName ))
+        return paIndex[ i ].ulEntry;
+
+    for ( i = 0; i < cEntries; i++ ) {
+        if (( paIndex[ i ].usType != OS2RES_FONTDIR ) &&
+            ( paIndex[ i ].usName == usName ))
+            return paIndex[ i ].ulEntry;
+    }
+    return (ULONG) -1;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXFreeTables                                                              *
+ *                                                                           *
+ * Frees the tables read by LXReadTables().                                  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PLXTABLES pTables: The module tables.                              (IO) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void LXFreeTables( PLXTABLES pTables )
+{
+    free( pTables->paResources );
+    free( pTables->paIndex );
+    free( pTables->paObjects );
+    free( pTables->paPages );
+    pTables->paResources = NULL;
+    pTables->paIndex     = NULL;
+    pTables->paObjects   = NULL;
+    pTables->paPages     = NULL;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXIndexResources                                                          *
+ *                                                                           *
+ * Builds the resource index of an LX module: a key for every entry in the   *
+ * resource table, sorted by type and name (see LXCompareResKeys) so that    *
+ * resources can be looked up with a binary search (see LXLookupResource).   *
+ * The index is allocated by this function and must be freed once no         *
+ * longer needed.                                                            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   LXRTENTRY *paEntries: The resource table.                           (I) *
+ *   ULONG      cEntries : Number of entries in the resource table.      (I) *
+ *                                                                           *
+ * RETURNS: PLXRESKEY                                                        *
+ *   The resource index, or NULL if memory could not be allocated.           *
+ * ------------------------------------------------------------------------- */
+PLXRESKEY LXIndexResources( LXRTENTRY *paEntries, ULONG cEntries )
+{
+    PLXRESKEY paIndex;
+    ULONG     i;
+
+    paIndex = (PLXRESKEY) calloc( cEntries + 1, sizeof( LXRESKEY ));
+    if ( !paIndex ) return NULL;
+    for ( i = 0; i < cEntries; i++ ) {
+        paIndex[ i ].usType  = paEntries[ i ].type;
+        paIndex[ i ].usName  = paEntries[ i ].name;
+        paIndex[ i ].ulEntry = i;
+    }
+    qsort( paIndex, cEntries, sizeof( LXRESKEY ), LXCompareResKeys );
+    return paIndex;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXLookupResource                                                          *
+ *                                                                           *
+ * Searches an LX module's resource index for a resource of the given type   *
+ * and name.  Where there is more than one such resource, the first one in   *
+ * the resource table is found.                                              *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PLXRESKEY paIndex : The module's resource index.                    (I) *
+ *   ULONG     cEntries: Number of entries in the resource index.        (I) *
+ *   USHORT    usType  : Resource type (OS2RES_*).                       (I) *
+ *   USHORT    usName  : Resource ID.                                    (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The position in the index of the first key which does not sort before   *
+ *   (usType, usName), or cEntries if there is none.  The caller must check  *
+ *   whether the key found actually matches.                                 *
+ * ------------------------------------------------------------------------- */
+ULONG LXLookupResource( PLXRESKEY paIndex, ULONG cEntries, USHORT usType, USHORT usName )
+{
+    ULONG ulLow  = 0,
+          ulHigh = cEntries,
+          ulMid;
+
+    while ( ulLow < ulHigh ) {
+        ulMid = ( ulLow + ulHigh ) / 2;
+        if (( paIndex[ ulMid ].usType < usType ) ||
+            (( paIndex[ ulMid ].usType == usType ) && ( paIndex[ ulMid ].usName < usName )))
+            ulLow  = ulMid + 1;
+        else
+            ulHigh = ulMid;
+    }
+    return ulLow;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXMapResource                                                             *
+ *                                                                           *
+ * Locates a binary resource within an LX-format module which has been       *
+ * mapped into memory.  If the resource can be referenced in place (see      *
+ * LXResourceInPlace) then the returned pointer refers directly into the     *
+ * mapping and no data is copied.  Otherwise the pages of the object which   *
+ * cover the resource are unpacked into an allocated buffer, which is then   *
+ * trimmed down to the resource data; the caller must free it once no        *
+ * longer needed.                                                            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FILEMAP pMap     : The mapped module file.                      (I) *
+ *   ULONG       ulBase   : File offset of the LX-format header.         (I) *
+ *   LXRTENTRY  *plx_rte  : Resource-table entry of the resource.        (I) *
+ *   PBYTE      *ppData   : Pointer to the start of the resource data.   (O) *
+ *   PBOOL       pfCopied : TRUE if *ppData was allocated by this call.  (O) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   FALSE: Failed to locate the resource; ppData & pfCopied are unchanged.  *
+ *   TRUE: Resource located successfully.                                    *
+ * ------------------------------------------------------------------------- */
+BOOL LXMapResource( POS2FILEMAP pMap, ULONG ulBase, LXRTENTRY *plx_rte, PBYTE *ppData, PBOOL pfCopied )
+{
+    PBYTE pBuf,
+          pRes;
+    ULONG cPages,       // number of pages in the object
+          ulFirst,      // first page covering the resource
+          ulLast;       // last page covering the resource
+
+
+    pRes = LXResourceInPlace( pMap, ulBase, plx_rte );
+    if ( pRes ) {
+        *ppData   = pRes;
+        *pfCopied = FALSE;
+        return TRUE;
+    }
+
+    // Otherwise unpack only the pages which cover the resource
+    if (( plx_rte->cb == 0 ) ||
+        !LXObjectPageMap( pMap, ulBase, plx_rte->obj, &cPages ))
+        return FALSE;
+    ulFirst = plx_rte->offset / LX_PAGE_SIZE;
+    ulLast  = ( plx_rte->offset + plx_rte->cb - 1 ) / LX_PAGE_SIZE;
+    if ( ulLast >= cPages ) return FALSE;
+    pBuf = (PBYTE) calloc( ulLast - ulFirst + 1, LX_PAGE_SIZE );
+    if ( !pBuf ) return FALSE;
+    if ( !LXUnpackPages( pMap, ulBase, plx_rte->obj, ulFirst, ulLast, pBuf, NULL )) {
+        free( pBuf );
+        return FALSE;
+    }
+
+    // Move the resource data to the start of the buffer and trim it
+    memmove( pBuf, pBuf + ( plx_rte->offset % LX_PAGE_SIZE ), plx_rte->cb );
+    pRes = (PBYTE) realloc( pBuf, plx_rte->cb );
+    *ppData   = pRes ? pRes : pBuf;
+    *pfCopied = TRUE;
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXMappedObject                                                            *
+ *                                                                           *
+ * Gets an object of a mapped LX-format module from the object cache,        *
+ * adding it if it is not already cached, with (at least) the given range of *
+ * pages unpacked; any of those pages which were not already unpacked are    *
+ * unpacked now (see LXUnpackPages).  The caller gets a reference to the     *
+ * object, which must be released with ReleaseCachedObject().                *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FILEMAP pMap   : The mapped module file.                        (I) *
+ *   ULONG       ulBase : File offset of the LX-format header.           (I) *
+ *   ULONG       ulObj  : Object number (1-based).                       (I) *
+ *   ULONG       ulFirst: First page (0-based) needed.                   (I) *
+ *   ULONG       ulLast : Last page (0-based) needed.                    (I) *
+ *                                                                           *
+ * RETURNS: POBJCACHEENTRY                                                   *
+ *   The object, or NULL if it could not be unpacked.                        *
+ * ------------------------------------------------------------------------- */
+POBJCACHEENTRY LXMappedObject( POS2FILEMAP pMap, ULONG ulBase, ULONG ulObj, ULONG ulFirst, ULONG ulLast )
+{
+    POBJCACHEENTRY pEntry;
+    ULONG          cPages,      // number of pages in the object
+                   cNew,        // number of pages newly unpacked
+                   i;
+    BOOL           fOK;
+
+    if ( !LXObjectPageMap( pMap, ulBase, ulObj, &cPages ) ||
+         ( ulFirst > ulLast ) || ( ulLast >= cPages ))
+        return NULL;
+
+    pEntry = GetCachedObject( &(pMap->id), ulObj );
+    if ( !pEntry ) {
+        pEntry = NewCachedObject( cPages );
+        if ( !pEntry ) return NULL;
+        pEntry->id    = pMap->id;
+        pEntry->ulObj = ulObj;
+        pEntry = InsertCachedObject( pEntry );
+    }
+    if ( pEntry->cPages != cPages ) {
+        // Not the same file after all
+        ReleaseCachedObject( pEntry );
+        return NULL;
+    }
+
+    _OBJPAGES_LOCK( pEntry );
+    for ( cNew = 0, i = ulFirst; i <= ulLast; i++ )
+        if ( !pEntry->pbDone[ i ] ) cNew++;
+    fOK = LXUnpackPages( pMap, ulBase, ulObj, ulFirst, ulLast,
+                         pEntry->pData + ( ulFirst * LX_PAGE_SIZE ), pEntry->pbDone + ulFirst );
+    _OBJPAGES_UNLOCK( pEntry );
+    if ( !fOK ) {
+        ReleaseCachedObject( pEntry );
+        return NULL;
+    }
+    GrowCachedObject( pEntry, cNew );
+    return pEntry;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXObjectPageMap                                                           *
+ *                                                                           *
+ * Returns a pointer to the object page map entries for the given object of  *
+ * a mapped LX-format module, after checking that the object table entry and *
+ * page map both lie within the file.                                        *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FILEMAP pMap   : The mapped module file.                        (I) *
+ *   ULONG       ulBase : File offset of the LX-format header.           (I) *
+ *   ULONG       ulObj  : Object number (1-based).                       (I) *
+ *   PULONG      pcPages: Number of pages in the object.                 (O) *
+ *                                                                           *
+ * RETURNS: PLXOPMENTRY                                                      *
+ *   Pointer to the first page map entry, or NULL if the object is invalid.  *
+ * ------------------------------------------------------------------------- */
+PLXOPMENTRY LXObjectPageMap( POS2FILEMAP pMap, ULONG ulBase, ULONG ulObj, PULONG pcPages )
+{
+    LXHEADER  *plx_hd;      // executable header
+    LXOTENTRY *plx_obj;     // object table entry
+
+    plx_hd = (LXHEADER *)( pMap->pData + ulBase );
+    if (( ulObj == 0 ) ||
+        (( ulBase + plx_hd->obj_tbl + ( sizeof( LXOTENTRY ) * ulObj )) > pMap->cbData ))
+        return NULL;
+    plx_obj = (LXOTENTRY *)( pMap->pData + ulBase + plx_hd->obj_tbl +
+                             ( sizeof( LXOTENTRY ) * ( ulObj - 1 )));
+    if (( plx_obj->pagemap == 0 ) ||
+        (( ulBase + plx_hd->objmap + ( sizeof( LXOPMENTRY ) *
+           ( plx_obj->pagemap - 1 + plx_obj->mapsize ))) > pMap->cbData ))
+        return NULL;
+    *pcPages = plx_obj->mapsize;
+    return (PLXOPMENTRY)( pMap->pData + ulBase + plx_hd->objmap +
+                          ( sizeof( LXOPMENTRY ) * ( plx_obj->pagemap - 1 )));
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXPack1Best                                                               *
+ *                                                                           *
+ * Compresses a page using the EXEPACK1 method, searching for the smallest   *
+ * encoding.  Each record either holds literal data, or a pattern of up to   *
+ * PACK1_MAX_PERIOD bytes and the number of times it is repeated.  The page  *
+ * is encoded from start to end, and the cheapest encoding of each prefix    *
+ * is found from those of the shorter prefixes; since every literal record   *
+ * costs the same four bytes, the best place for one to start is simply the  *
+ * prefix with the lowest cost less its length.                              *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE       pPage: The page data.                                   (I) *
+ *   ULONG       cb   : Size of the page data (1-4096 bytes).            (I) *
+ *   PLXPACKWORK pWork: Working storage.                                 (-) *
+ *   PBYTE       pOut : Buffer for the packed data (4096 bytes).         (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The size of the packed data, or 0 if it would not fit in a page.        *
+ * ------------------------------------------------------------------------- */
+ULONG LXPack1Best( PBYTE pPage, ULONG cb, PLXPACKWORK pWork, PBYTE pOut )
+{
+    ULONG aulEnd[ PACK1_MAX_PERIOD + 1 ];  // end of the repeat at each period
+    ULONG ulFrom,                           // start of the cheapest literal record
+          ulReps,                           // times a pattern is repeated
+          ulStep,                           // repeat count being tried
+          ofOut,
+          cPath,
+          ulLen,
+          i, j, p;
+    LONG  lBase;                            // cost of ulFrom less its offset
+
+    for ( i = 0; i <= cb; i++ ) pWork->ausCost[ i ] = PACK_NO_COST;
+    for ( p = 1; p <= PACK1_MAX_PERIOD; p++ ) aulEnd[ p ] = 0;
+    pWork->ausCost[ 0 ] = 0;
+    lBase  = 0;
+    ulFrom = 0;
+
+    for ( j = 0; j <= cb; j++ ) {
+        if (( j > ulFrom ) && (( lBase + (LONG) j + 4 ) < (LONG) pWork->ausCost[ j ] ))
+            LXPackRecord( pWork, j, lBase + j + 4, PACK_REC_LITERALS, ulFrom, 0, 0 );
+        if ( j == cb ) break;
+        if (( (LONG) pWork->ausCost[ j ] - (LONG) j ) < lBase ) {
+            lBase  = (LONG) pWork->ausCost[ j ] - (LONG) j;
+            ulFrom = j;
+        }
+
+        /* For each period, the bytes from j up to aulEnd[ p ] equal those p
+         * bytes further on, so the pattern at j is repeated that far.
+         */
+        for ( p = 1; ( p <= PACK1_MAX_PERIOD ) && (( j + ( p * 2 )) <= cb ); p++ ) {
+            if ( aulEnd[ p ] < j ) aulEnd[ p ] = j;
+            while ((( aulEnd[ p ] + p ) < cb ) && ( pPage[ aulEnd[ p ]] == pPage[ aulEnd[ p ] + p ] ))
+                aulEnd[ p ]++;
+            ulReps = ( aulEnd[ p ] - j + p ) / p;
+            for ( ulStep = 2; ulStep <= ulReps; ulStep++ ) {
+                if (( ulStep > PACK1_MAX_STEPS ) && ( ulStep < ulReps ))
+                    ulStep = ulReps;
+                LXPackRecord( pWork, j + ( ulStep * p ), pWork->ausCost[ j ] + 4 + p,
+                              PACK_REC_ITERATED, j, 0, p );
+            }
+        }
+    }
+    if (( pWork->ausCost[ cb ] + 2 ) > LX_PAGE_SIZE ) return 0;
+
+    // Follow the records back from the end, then write them out in order
+    for ( cPath = 0, i = cb; i; i = pWork->ausFrom[ i ] )
+        pWork->ausPath[ cPath++ ] = i;
+    ofOut = 0;
+    for ( i = 0; cPath--; i = j ) {
+        j = pWork->ausPath[ cPath ];
+        if ( pWork->abType[ j ] == PACK_REC_ITERATED ) {
+            p = pWork->ausDist[ j ];
+            ulReps = ( j - i ) / p;
+            pOut[ ofOut++ ] = LOBYTE( ulReps );
+            pOut[ ofOut++ ] = HIBYTE( ulReps );
+            pOut[ ofOut++ ] = p;
+            pOut[ ofOut++ ] = 0;
+            memcpy( pOut + ofOut, pPage + i, p );
+            ofOut += p;
+        }
+        else {
+            ulLen = j - i;
+            pOut[ ofOut++ ] = 1;
+            pOut[ ofOut++ ] = 0;
+            pOut[ ofOut++ ] = LOBYTE( ulLen );
+            pOut[ ofOut++ ] = HIBYTE( ulLen );
+            memcpy( pOut + ofOut, pPage + i, ulLen );
+            ofOut += ulLen;
+        }
+    }
+    pOut[ ofOut++ ] = 0;
+    pOut[ ofOut++ ] = 0;
+    return ofOut;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXPack1Fast                                                               *
+ *                                                                           *
+ * Compresses a page using the EXEPACK1 method, as quickly as possible.      *
+ * Runs of at least PACK1_MIN_RUN identical bytes become iterated records,   *
+ * and everything between them is stored as literal records.                 *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pPage: The page data.                                         (I) *
+ *   ULONG cb   : Size of the page data (1-4096 bytes).                  (I) *
+ *   PBYTE pOut : Buffer for the packed data (4096 bytes).               (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The size of the packed data, or 0 if it would not fit in a page.        *
+ * ------------------------------------------------------------------------- */
+ULONG LXPack1Fast( PBYTE pPage, ULONG cb, PBYTE pOut )
+{
+    ULONG ofIn  = 0,                // current input offset
+          ofOut = 0,                // current output offset
+          ulRun,                    // length of the run at ofIn
+          ulLen;                    // length of a literal record
+
+    while ( ofIn < cb ) {
+        ulRun = LXRunLength( pPage + ofIn, cb - ofIn, 0xFFFF );
+        if ( ulRun >= PACK1_MIN_RUN ) {
+            if (( ofOut + 5 + 2 ) > LX_PAGE_SIZE ) return 0;
+            pOut[ ofOut++ ] = LOBYTE( ulRun );
+            pOut[ ofOut++ ] = HIBYTE( ulRun );
+            pOut[ ofOut++ ] = 1;
+            pOut[ ofOut++ ] = 0;
+            pOut[ ofOut++ ] = pPage[ ofIn ];
+            ofIn += ulRun;
+            continue;
+        }
+        // Everything up to the next run is one literal record
+        for ( ulLen = ulRun; ( ofIn + ulLen ) < cb; ulLen++ )
+            if ( LXRunLength( pPage + ofIn + ulLen, cb - ofIn - ulLen, PACK1_MIN_RUN ) >= PACK1_MIN_RUN )
+                break;
+        if (( ofOut + 4 + ulLen + 2 ) > LX_PAGE_SIZE ) return 0;
+        pOut[ ofOut++ ] = 1;
+        pOut[ ofOut++ ] = 0;
+        pOut[ ofOut++ ] = LOBYTE( ulLen );
+        pOut[ ofOut++ ] = HIBYTE( ulLen );
+        memcpy( pOut + ofOut, pPage + ofIn, ulLen );
+        ofOut += ulLen;
+        ofIn  += ulLen;
+    }
+    pOut[ ofOut++ ] = 0;
+    pOut[ ofOut++ ] = 0;
+    return ofOut;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXPack2Best                                                               *
+ *                                                                           *
+ * Compresses a page using the EXEPACK2 method, searching for the smallest   *
+ * encoding.  The page is encoded from start to end, and the cheapest        *
+ * encoding of each prefix is found by extending the shorter prefixes with   *
+ * every kind of record which fits: a literal (added to the literal block    *
+ * which ends there if it has room), fills, and the longest back-references  *
+ * to be found (both near enough for the two-byte form, and overall) at each *
+ * position, along with any shorter lengths.  The up to 3 or 15 literals     *
+ * which can go with a back-reference are accounted for by starting it from  *
+ * the cheapest of the preceding prefixes.                                   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE       pPage: The page data.                                   (I) *
+ *   ULONG       cb   : Size of the page data (1-4096 bytes).            (I) *
+ *   PLXPACKWORK pWork: Working storage.                                 (-) *
+ *   PBYTE       pOut : Buffer for the packed data (4096 bytes).         (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The size of the packed data, or 0 if it would not fit in a page.        *
+ * ------------------------------------------------------------------------- */
+ULONG LXPack2Best( PBYTE pPage, ULONG cb, PLXPACKWORK pWork, PBYTE pOut )
+{
+    ULONG ulFar,                    // longest back-reference at j
+          ulFarDist,                // ... and its distance
+          ulNear,                   // longest within PACK2_NEAR_DIST
+          ulNearDist,               // ... and its distance
+          ulFrom1,                  // cheapest start with 0-3 literals
+          ulFrom3,                  // cheapest start with 0-15 literals
+          ulMax,
+          ulLen,
+          ulCost,
+          ulControl,
+          cLits,
+          cChain,
+          cPath,
+          ofOut,
+          i, j, k, n;
+
+    for ( i = 0; i <= cb; i++ ) pWork->ausCost[ i ] = PACK_NO_COST;
+    for ( i = 0; i < PACK_HASH_SIZE; i++ ) pWork->ausHead[ i ] = PACK_NO_POS;
+    pWork->ausCost[ 0 ] = 0;
+
+    for ( j = 0; j < cb; j++ ) {
+        // A literal extends the block which ends here, if there is room in it
+        if (( j > 0 ) && ( pWork->abType[ j ] == PACK_REC_LITERALS ) &&
+            ( pWork->abLits[ j ] < PACK2_MAX_LITERALS ))
+            LXPackRecord( pWork, j + 1, pWork->ausCost[ j ] + 1, PACK_REC_LITERALS,
+                          pWork->ausFrom[ j ], pWork->abLits[ j ] + 1, 0 );
+        else
+            LXPackRecord( pWork, j + 1, pWork->ausCost[ j ] + 2, PACK_REC_LITERALS, j, 1, 0 );
+
+        /* A fill from the previous byte (if the same, and no dearer to reach)
+         * ends everywhere this one could, except one byte further if both
+         * are at the length limit.
+         */
+        ulLen = LXRunLength( pPage + j, cb - j, PACK2_MAX_FILL );
+        n = 3;
+        if (( j > 0 ) && ( pPage[ j - 1 ] == pPage[ j ] ) &&
+            ( pWork->ausCost[ j - 1 ] <= pWork->ausCost[ j ] ))
+            n = ( ulLen == PACK2_MAX_FILL ) ? ulLen : ulLen + 1;
+        for ( ; n <= ulLen; n++ )
+            LXPackRecord( pWork, j + n, pWork->ausCost[ j ] + 3, PACK_REC_FILL, j, 0, 0 );
+        if (( j + 3 ) > cb ) continue;
+
+        // Find the longest back-references, then add this position
+        ulMax  = ( cb - j ) < PACK2_MAX_MATCH ? cb - j : PACK2_MAX_MATCH;
+        ulFar  = ulNear = 0;
+        ulFarDist = ulNearDist = 0;
+        for ( i = pWork->ausHead[ PACK_HASH( pPage + j ) ], cChain = 0;
+              ( i != PACK_NO_POS ) && ( cChain < PACK_BEST_CHAIN );
+              i = pWork->ausPrev[ i ], cChain++ )
+        {
+            // Only compare in full if this could be longer than those found so far
+            if ((( ulFar == ulMax ) || ( pPage[ i + ulFar ] != pPage[ j + ulFar ] )) &&
+                ((( j - i ) > PACK2_NEAR_DIST ) || ( ulNear >= 10 ) || ( ulNear == ulMax ) ||
+                 ( pPage[ i + ulNear ] != pPage[ j + ulNear ] )))
+                continue;
+            for ( ulLen = 0; ( ulLen < ulMax ) && ( pPage[ i + ulLen ] == pPage[ j + ulLen ] ); ulLen++ );
+            if ( ulLen > ulFar ) {
+                ulFar     = ulLen;
+                ulFarDist = j - i;
+            }
+            if (( ulLen > ulNear ) && (( j - i ) <= PACK2_NEAR_DIST )) {
+                ulNear     = ulLen;
+                ulNearDist = j - i;
+            }
+            if (( ulFar == ulMax ) &&
+                (( ulNear >= 10 ) || ( ulNear == ulMax ) || (( j - i ) > PACK2_NEAR_DIST )))
+                break;
+        }
+        pWork->ausPrev[ j ] = pWork->ausHead[ PACK_HASH( pPage + j ) ];
+        pWork->ausHead[ PACK_HASH( pPage + j ) ] = j;
+        if ( ulFar < 3 ) continue;
+
+        for ( ulFrom1 = ulFrom3 = j, k = 1; ( k <= 15 ) && ( k <= j ); k++ ) {
+            ulCost = pWork->ausCost[ j - k ] + k;
+            if (( k <= 3 ) && ( ulCost < ( pWork->ausCost[ ulFrom1 ] + j - ulFrom1 )))
+                ulFrom1 = j - k;
+            if ( ulCost < ( pWork->ausCost[ ulFrom3 ] + j - ulFrom3 ))
+                ulFrom3 = j - k;
+        }
+        for ( ulLen = 3; ulLen <= ulFar; ulLen++ ) {
+            LXPackRecord( pWork, j + ulLen, pWork->ausCost[ ulFrom3 ] + ( j - ulFrom3 ) + 3,
+                          PACK_REC_LONG, ulFrom3, j - ulFrom3, ulFarDist );
+            if (( ulLen <= 6 ) && ( ulLen > ulNear ))
+                LXPackRecord( pWork, j + ulLen, pWork->ausCost[ j ] + 2,
+                              PACK_REC_SHORT, j, 0, ulFarDist );
+            if (( ulLen <= 10 ) && ( ulLen <= ulNear ))
+                LXPackRecord( pWork, j + ulLen, pWork->ausCost[ ulFrom1 ] + ( j - ulFrom1 ) + 2,
+                              PACK_REC_NEAR, ulFrom1, j - ulFrom1, ulNearDist );
+        }
+    }
+    if (( pWork->ausCost[ cb ] + 2 ) > LX_PAGE_SIZE ) return 0;
+
+    // Follow the records back from the end, then write them out in order
+    for ( cPath = 0, i = cb; i; i = pWork->ausFrom[ i ] )
+        pWork->ausPath[ cPath++ ] = i;
+    ofOut = 0;
+    for ( i = 0; cPath--; i = j ) {
+        j     = pWork->ausPath[ cPath ];
+        cLits = pWork->abLits[ j ];
+        ulLen = j - i - cLits;
+        switch ( pWork->abType[ j ] ) {
+            case PACK_REC_LITERALS:
+                ofOut += LXPutLiterals( pPage + i, cLits, pOut + ofOut );
+                continue;
+            case PACK_REC_FILL:
+                pOut[ ofOut++ ] = 0;
+                pOut[ ofOut++ ] = ulLen;
+                pOut[ ofOut++ ] = pPage[ i ];
+                continue;
+            case PACK_REC_NEAR:
+                ulControl = ( pWork->ausDist[ j ] << 7 ) | (( ulLen - 3 ) << 4 ) | ( cLits << 2 ) | 1;
+                pOut[ ofOut++ ] = LOBYTE( ulControl );
+                pOut[ ofOut++ ] = HIBYTE( ulControl );
+                break;
+            case PACK_REC_SHORT:
+                ulControl = ( pWork->ausDist[ j ] << 4 ) | (( ulLen - 3 ) << 2 ) | 2;
+                pOut[ ofOut++ ] = LOBYTE( ulControl );
+                pOut[ ofOut++ ] = HIBYTE( ulControl );
+                break;
+            default:
+                ulControl = ( pWork->ausDist[ j ] << 12 ) | ( ulLen << 6 ) | ( cLits << 2 ) | 3;
+                pOut[ ofOut++ ] = LOBYTE( ulControl );
+                pOut[ ofOut++ ] = HIBYTE( ulControl );
+                pOut[ ofOut++ ] = ( ulControl >> 16 ) & 0xFF;
+                break;
+        }
+        memcpy( pOut + ofOut, pPage + i, cLits );
+        ofOut += cLits;
+    }
+    pOut[ ofOut++ ] = 0;
+    pOut[ ofOut++ ] = 0;
+    return ofOut;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXPack2Fast                                                               *
+ *                                                                           *
+ * Compresses a page using the EXEPACK2 method, as quickly as possible.      *
+ * At each position, the longer of the run of identical bytes there and the  *
+ * longest back-reference found in the first PACK_FAST_CHAIN links of its    *
+ * hash chain is taken (runs become fills, and back-references use the       *
+ * smallest form which fits); otherwise the byte becomes a literal, which is *
+ * carried along with the next back-reference where possible.                *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pPage: The page data.                                         (I) *
+ *   ULONG cb   : Size of the page data (1-4096 bytes).                  (I) *
+ *   PBYTE pOut : Buffer for the packed data (4096 bytes).               (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The size of the packed data, or 0 if it would not fit in a page.        *
+ * ------------------------------------------------------------------------- */
+ULONG LXPack2Fast( PBYTE pPage, ULONG cb, PBYTE pOut )
+{
+    USHORT ausHead[ PACK_HASH_SIZE ],   // latest position of each hash
+           ausPrev[ LX_PAGE_SIZE ];     // previous position with the same hash
+    ULONG  ofIn  = 0,                   // current input offset
+           ofLit = 0,                   // start of the pending literals
+           ofOut = 0,                   // current output offset
+           ulRun,                       // length of the run at ofIn
+           ulBest,                      // longest back-reference at ofIn
+           ulDist,                      // ... and its distance
+           ulControl,
+           ulPos,
+           cbNeed,
+           cLit,
+           cChain,
+           ulLen,
+           n;
+
+    for ( n = 0; n < PACK_HASH_SIZE; n++ ) ausHead[ n ] = PACK_NO_POS;
+    while ( ofIn < cb ) {
+        ulRun  = LXRunLength( pPage + ofIn, cb - ofIn, PACK2_MAX_FILL );
+        ulBest = 0;
+        ulDist = 0;
+        if (( ofIn + 3 ) <= cb ) {
+            for ( ulPos = ausHead[ PACK_HASH( pPage + ofIn ) ], cChain = 0;
+                  ( ulPos != PACK_NO_POS ) && ( cChain < PACK_FAST_CHAIN );
+                  ulPos = ausPrev[ ulPos ], cChain++ )
+            {
+                for ( ulLen = 0; ( ulLen < PACK2_MAX_MATCH ) && (( ofIn + ulLen ) < cb ) &&
+                                 ( pPage[ ulPos + ulLen ] == pPage[ ofIn + ulLen ] ); ulLen++ );
+                if ( ulLen > ulBest ) {
+                    ulBest = ulLen;
+                    ulDist = ofIn - ulPos;
+                }
+            }
+        }
+
+        cLit = ofIn - ofLit;
+        if (( ulRun >= PACK2_MIN_RUN ) && ( ulRun >= ulBest )) {
+            cbNeed = PACK2_LITERAL_SIZE( cLit ) + 3;
+            if (( ofOut + cbNeed + 2 ) > LX_PAGE_SIZE ) return 0;
+            ofOut += LXPutLiterals( pPage + ofLit, cLit, pOut + ofOut );
+            pOut[ ofOut++ ] = 0;
+            pOut[ ofOut++ ] = ulRun;
+            pOut[ ofOut++ ] = pPage[ ofIn ];
+            n = ulRun;
+        }
+        else if ( ulBest >= 3 ) {
+            if (( cLit <= 3 ) && ( ulBest <= 10 ) && ( ulDist <= PACK2_NEAR_DIST ))
+                cbNeed = 2 + cLit;
+            else if (( cLit == 0 ) && ( ulBest <= 6 ))
+                cbNeed = 2;
+            else if ( cLit > 15 )
+                cbNeed = PACK2_LITERAL_SIZE( cLit - 15 ) + 3 + 15;
+            else
+                cbNeed = 3 + cLit;
+            if (( ofOut + cbNeed + 2 ) > LX_PAGE_SIZE ) return 0;
+
+            if (( cLit <= 3 ) && ( ulBest <= 10 ) && ( ulDist <= PACK2_NEAR_DIST )) {
+                ulControl = ( ulDist << 7 ) | (( ulBest - 3 ) << 4 ) | ( cLit << 2 ) | 1;
+                pOut[ ofOut++ ] = LOBYTE( ulControl );
+                pOut[ ofOut++ ] = HIBYTE( ulControl );
+            }
+            else if (( cLit == 0 ) && ( ulBest <= 6 )) {
+                ulControl = ( ulDist << 4 ) | (( ulBest - 3 ) << 2 ) | 2;
+                pOut[ ofOut++ ] = LOBYTE( ulControl );
+                pOut[ ofOut++ ] = HIBYTE( ulControl );
+            }
+            else {
+                // Up to 15 literals can go with the back-reference, the rest before it
+                if ( cLit > 15 ) {
+                    ofOut += LXPutLiterals( pPage + ofLit, cLit - 15, pOut + ofOut );
+                    ofLit += cLit - 15;
+                    cLit   = 15;
+                }
+                ulControl = ( ulDist << 12 ) | ( ulBest << 6 ) | ( cLit << 2 ) | 3;
+                pOut[ ofOut++ ] = LOBYTE( ulControl );
+                pOut[ ofOut++ ] = HIBYTE( ulControl );
+                pOut[ ofOut++ ] = ( ulControl >> 16 ) & 0xFF;
+            }
+            memcpy( pOut + ofOut, pPage + ofLit, cLit );
+            ofOut += cLit;
+            n = ulBest;
+        }
+        else n = 0;
+
+        // Index the positions being passed over
+        do {
+            if (( ofIn + 3 ) <= cb ) {
+                ausPrev[ ofIn ] = ausHead[ PACK_HASH( pPage + ofIn ) ];
+                ausHead[ PACK_HASH( pPage + ofIn ) ] = ofIn;
+            }
+            ofIn++;
+        } while ( n && --n );
+        if (( ulRun >= PACK2_MIN_RUN ) || ( ulBest >= 3 )) ofLit = ofIn;
+    }
+    cLit = ofIn - ofLit;
+    if (( ofOut + PACK2_LITERAL_SIZE( cLit ) + 2 ) > LX_PAGE_SIZE ) return 0;
+    ofOut += LXPutLiterals( pPage + ofLit, cLit, pOut + ofOut );
+    pOut[ ofOut++ ] = 0;
+    pOut[ ofOut++ ] = 0;
+    return ofOut;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXPackRecord                                                              *
+ *                                                                           *
+ * Used by the best-ratio EXEPACK encoders to offer a record ending at the   *
+ * given offset; if the encoding it completes is cheaper than the cheapest   *
+ * one known for that prefix of the page, the record is kept in its place.   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PLXPACKWORK pWork : Working storage of the encoder.                (IO) *
+ *   ULONG       ulEnd : Page offset at which the record ends.           (I) *
+ *   ULONG       ulCost: Size of the encoding up to ulEnd.               (I) *
+ *   ULONG       ulType: Kind of record (PACK_REC_*).                    (I) *
+ *   ULONG       ulFrom: Page offset at which the record starts.         (I) *
+ *   ULONG       cLits : Number of literals which the record begins with.(I) *
+ *   ULONG       ulDist: Back-reference distance, or period of a repeated    *
+ *                       pattern.                                        (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void LXPackRecord( PLXPACKWORK pWork, ULONG ulEnd, ULONG ulCost, ULONG ulType, ULONG ulFrom, ULONG cLits, ULONG ulDist )
+{
+    if ( ulCost >= pWork->ausCost[ ulEnd ] ) return;
+    pWork->ausCost[ ulEnd ] = ulCost;
+    pWork->ausFrom[ ulEnd ] = ulFrom;
+    pWork->ausDist[ ulEnd ] = ulDist;
+    pWork->abLits[ ulEnd ]  = cLits;
+    pWork->abType[ ulEnd ]  = ulType;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXPutLiterals                                                             *
+ *                                                                           *
+ * Writes a run of literal bytes in the EXEPACK2 format, as blocks of up to  *
+ * 63 bytes each.                                                            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pIn : The literal bytes.                                      (I) *
+ *   ULONG cb  : Number of literal bytes.                                (I) *
+ *   PBYTE pOut: Output buffer.                                          (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The number of bytes written (see PACK2_LITERAL_SIZE).                   *
+ * ------------------------------------------------------------------------- */
+ULONG LXPutLiterals( PBYTE pIn, ULONG cb, PBYTE pOut )
+{
+    ULONG ofOut = 0,
+          ulLen;
+
+    while ( cb ) {
+        ulLen = ( cb > PACK2_MAX_LITERALS ) ? PACK2_MAX_LITERALS : cb;
+        pOut[ ofOut++ ] = ulLen << 2;
+        memcpy( pOut + ofOut, pIn, ulLen );
+        ofOut += ulLen;
+        pIn   += ulLen;
+        cb    -= ulLen;
+    }
+    return ofOut;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXReadPages                                                               *
+ *                                                                           *
+ * Reads (and if necessary unpacks) a range of pages of an object within an  *
+ * LX-format module file.  Each page is written to its own 4 KiB slot in the *
+ * destination buffer, starting with page ulFirst at pDest; short or         *
+ * zero-filled pages are left as they are (the caller should supply a        *
+ * zeroed buffer).  Uncompressed and EXEPACK1 pages are read straight into   *
+ * their slots, while EXEPACK2 pages (which can't be unpacked in place) are  *
+ * read into a separate buffer.  All reading is done first, and the packed   *
+ * pages are then unpacked together (possibly in parallel).                  *
+ *                                                                           *
+ * If pbDone is not NULL, it points to an array of flags (one per page,      *
+ * starting with page ulFirst) indicating which pages have already been      *
+ * read; such pages are not read again, and the flags of the pages which     *
+ * are read get set.                                                         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   FILE       *pf     : Pointer to the open file.                      (I) *
+ *   PLXTABLES   pTables: The module's header and tables.                (I) *
+ *   LXOTENTRY  *plx_obj: Object table entry of the object.              (I) *
+ *   ULONG       ulFirst: First page (0-based) to read.                  (I) *
+ *   ULONG       ulLast : Last page (0-based) to read.                   (I) *
+ *   PBYTE       pDest  : Buffer for the pages (4 KiB per page).         (O) *
+ *   PBYTE       pbDone : Optional array of page-read flags.            (IO) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   TRUE if the pages were read, FALSE if they could not be.                *
+ * ------------------------------------------------------------------------- */
+BOOL LXReadPages( FILE *pf, PLXTABLES pTables, LXOTENTRY *plx_obj, ULONG ulFirst, ULONG ulLast, PBYTE pDest, PBYTE pbDone )
+{
+    PLXOPMENTRY plxpages;    // page map entries of the pages to be read
+    ULONG       cPages,      // number of pages in the range
+                cRead,       // number of pages read by this call
+                cbPageAddr,  // address of an individual object page
+                i;
+    ULONG       cJobs,       // number of pages which need unpacking
+                cbPacked;    // size of the stored EXEPACK2 page data
+    PLXPAGEJOB  pJobs;       // pages which need unpacking
+    PBYTE       pBufOff,
+                pPacked,     // stored EXEPACK2 page data
+                pRead;       // where the raw page data is read to
+    BOOL        fOK = FALSE;
+
+    if (( ulFirst > ulLast ) || ( ulLast >= plx_obj->mapsize ) || ( plx_obj->pagemap == 0 ))
+        return FALSE;
+    cPages   = ulLast - ulFirst + 1;
+    plxpages = pTables->paPages + ( plx_obj->pagemap - 1 + ulFirst );
+
+    pJobs  = (PLXPAGEJOB) calloc( cPages, sizeof( LXPAGEJOB ));
+    cbPacked = 0;
+    cRead    = 0;
+    for ( i = 0; i < cPages; i++ ) {
+        if ( pbDone && pbDone[ i ] ) continue;
+        if ( plxpages[ i ].flags == OP32_ITERDATA2 )
+            cbPacked += plxpages[ i ].size;
+        cRead++;
+    }
+    pPacked = cbPacked ? (PBYTE) malloc( cbPacked ) : NULL;
+    if ( !pJobs || ( cbPacked && !pPacked )) goto cleanup;
+
+    cJobs    = 0;
+    cbPacked = 0;
+    for ( i = 0; i < cPages; i++ ) {
+        if ( pbDone && pbDone[ i ] ) continue;
+        if (( plxpages[ i ].flags != OP32_VALID ) &&
+            ( plxpages[ i ].flags != OP32_ITERDATA ) &&
+            ( plxpages[ i ].flags != OP32_ITERDATA2 ))
+            continue;
+        if ( plxpages[ i ].size > LX_PAGE_SIZE ) break;
+        pBufOff = pDest + ( i * LX_PAGE_SIZE );
+        cbPageAddr = pTables->lx_hd.datapage +
+                     ( plxpages[ i ].dataoffset << pTables->lx_hd.pageshift );
+        pRead = ( plxpages[ i ].flags == OP32_ITERDATA2 ) ? pPacked + cbPacked : pBufOff;
+        if (( _FILE_SEEK( pf, cbPageAddr )) ||
+            ( ! _FILE_READ( pf, pRead, plxpages[ i ].size )))
+            break;
+//printf(" - page %u [flags 0x%x] size is %u\n", ulFirst + i, plxpages[ i ].flags, plxpages[ i ].size );
+        if ( plxpages[ i ].flags == OP32_VALID ) continue;
+        pJobs[ cJobs ].pSrc    = pRead;
+        pJobs[ cJobs ].pDest   = pBufOff;
+        pJobs[ cJobs ].cbSrc   = plxpages[ i ].size;
+        pJobs[ cJobs ].usFlags = plxpages[ i ].flags;
+        cJobs++;
+        if ( plxpages[ i ].flags == OP32_ITERDATA2 )
+            cbPacked += plxpages[ i ].size;
+    }
+    if ( i < cPages ) goto cleanup;
+    LXDecodePages( pJobs, cJobs );
+    if ( pbDone ) memset( pbDone, TRUE, cPages );
+    _STAT_ADD( extract_stats.ulPagesUnpacked, cRead );
+    _STAT_ADD( extract_stats.ulPagesSkipped, plx_obj->mapsize - cPages );
+    fOK = TRUE;
+
+cleanup:
+    free( pJobs );
+    free( pPacked );
+    return ( fOK );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXReadTables                                                              *
+ *                                                                           *
+ * Reads the header of an LX-format module, together with the tables which   *
+ * are needed to locate and extract its resources: the resource table, the   *
+ * object table and the object page map.  Each table is read in a single     *
+ * read, and the resource index (see LXIndexResources) is built from the     *
+ * resource table.  The tables must be freed with LXFreeTables() once no     *
+ * longer needed (this function frees them itself if it fails).              *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   FILE      *pf     : Pointer to the open file.                       (I) *
+ *   ULONG      ulBase : File offset of the LX-format header.            (I) *
+ *   PLXTABLES  pTables: Receives the header and tables.                 (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success or ERR_* on error                                          *
+ * ------------------------------------------------------------------------- */
+ULONG LXReadTables( FILE *pf, ULONG ulBase, PLXTABLES pTables )
+{
+    struct stat fs;
+    LXHEADER   *plx_hd;     // executable header
+    uint64_t    cbFile;     // size of the file
+    ULONG       ulEnd,      // last page map entry used by an object
+                i;
+
+
+    memset( pTables, 0, sizeof( LXTABLES ));
+    pTables->ulBase = ulBase;
+    plx_hd = &(pTables->lx_hd);
+    if ( _FILE_STAT( pf, &fs ) ||
+         _FILE_SEEK( pf, ulBase ) ||
+         ( _FILE_READ( pf, plx_hd, sizeof( LXHEADER )) != sizeof( LXHEADER )))
+        return ERR_FILE_READ;
+    cbFile = fs.st_size;
+    StatFileID( &fs, &(pTables->id) );
+
+    // Make sure the resource and object tables lie within the file
+    if ((( (uint64_t) ulBase + plx_hd->res_tbl +
+           ( (uint64_t) plx_hd->cres * sizeof( LXRTENTRY ))) > cbFile ) ||
+        (( (uint64_t) ulBase + plx_hd->obj_tbl +
+           ( (uint64_t) plx_hd->objcnt * sizeof( LXOTENTRY ))) > cbFile ))
+        return ERR_FILE_FORMAT;
+
+    pTables->paResources = (LXRTENTRY *) calloc( plx_hd->cres + 1, sizeof( LXRTENTRY ));
+    pTables->paObjects   = (LXOTENTRY *) calloc( plx_hd->objcnt + 1, sizeof( LXOTENTRY ));
+    if ( !pTables->paResources || !pTables->paObjects ) goto no_memory;
+    if ( _FILE_SEEK( pf, ulBase + plx_hd->res_tbl ) ||
+         ( _FILE_READ( pf, pTables->paResources, plx_hd->cres * sizeof( LXRTENTRY ))
+           != plx_hd->cres * sizeof( LXRTENTRY )) ||
+         _FILE_SEEK( pf, ulBase + plx_hd->obj_tbl ) ||
+         ( _FILE_READ( pf, pTables->paObjects, plx_hd->objcnt * sizeof( LXOTENTRY ))
+           != plx_hd->objcnt * sizeof( LXOTENTRY )))
+        goto read_fail;
+
+    // The page map must be long enough for every object which uses it
+    for ( i = 0; i < plx_hd->objcnt; i++ ) {
+        if ( !pTables->paObjects[ i ].pagemap ) continue;
+        ulEnd = pTables->paObjects[ i ].pagemap - 1 + pTables->paObjects[ i ].mapsize;
+        if ( ulEnd < pTables->paObjects[ i ].mapsize ) goto bad_format;
+        if ( ulEnd > pTables->cPages ) pTables->cPages = ulEnd;
+    }
+    if (( (uint64_t) ulBase + plx_hd->objmap +
+          ( (uint64_t) pTables->cPages * sizeof( LXOPMENTRY ))) > cbFile )
+        goto bad_format;
+    pTables->paPages = (PLXOPMENTRY) calloc( pTables->cPages + 1, sizeof( LXOPMENTRY ));
+    if ( !pTables->paPages ) goto no_memory;
+    if ( _FILE_SEEK( pf, ulBase + plx_hd->objmap ) ||
+         ( _FILE_READ( pf, pTables->paPages, pTables->cPages * sizeof( LXOPMENTRY ))
+           != pTables->cPages * sizeof( LXOPMENTRY )))
+        goto read_fail;
+
+    pTables->paIndex = LXIndexResources( pTables->paResources, plx_hd->cres );
+    if ( !pTables->paIndex ) goto no_memory;
+    return 0;
+
+no_memory:
+    LXFreeTables( pTables );
+    return ERR_MEMORY;
+bad_format:
+    LXFreeTables( pTables );
+    return ERR_FILE_FORMAT;
+read_fail:
+    LXFreeTables( pTables );
+    return ERR_FILE_READ;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXResourceInPlace                                                         *
+ *                                                                           *
+ * Determines whether a resource within a mapped LX-format module can be     *
+ * referenced directly within the mapping.  This is the case if every page   *
+ * covering the resource is stored uncompressed (OP32_VALID), full-sized     *
+ * (except for the last one) and adjacent to the previous page in the file.  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FILEMAP pMap     : The mapped module file.                      (I) *
+ *   ULONG       ulBase   : File offset of the LX-format header.         (I) *
+ *   LXRTENTRY  *plx_rte  : Resource-table entry of the resource.        (I) *
+ *                                                                           *
+ * RETURNS: PBYTE                                                            *
+ *   Pointer to the resource data within the mapping, or NULL if it cannot   *
+ *   be referenced in place.                                                 *
+ * ------------------------------------------------------------------------- */
+PBYTE LXResourceInPlace( POS2FILEMAP pMap, ULONG ulBase, LXRTENTRY *plx_rte )
+{
+    LXHEADER    *plx_hd;     // executable header
+    PLXOPMENTRY  plxpages;   // array of individual object page information
+    ULONG        cPages,     // number of pages in the object
+                 ulFirst,    // first page covering the resource
+                 ulLast,     // last page covering the resource
+                 cbPageAddr, // file offset of an individual object page
+                 cbPrevAddr, // file offset of the previous page
+                 i;
+
+
+    if ( plx_rte->cb == 0 ) return NULL;
+    plx_hd   = (LXHEADER *)( pMap->pData + ulBase );
+    plxpages = LXObjectPageMap( pMap, ulBase, plx_rte->obj, &cPages );
+    if ( !plxpages ) return NULL;
+
+    ulFirst = plx_rte->offset / LX_PAGE_SIZE;
+    ulLast  = ( plx_rte->offset + plx_rte->cb - 1 ) / LX_PAGE_SIZE;
+    if ( ulLast >= cPages ) return NULL;
+
+    cbPrevAddr = 0;
+    for ( i = ulFirst; i <= ulLast; i++ ) {
+        cbPageAddr = plx_hd->datapage + ( plxpages[ i ].dataoffset << plx_hd->pageshift );
+        if (( plxpages[ i ].flags != OP32_VALID ) ||
+            (( i > ulFirst ) && ( cbPageAddr != cbPrevAddr + LX_PAGE_SIZE )) ||
+            (( i < ulLast ) && ( plxpages[ i ].size != LX_PAGE_SIZE )) ||
+            (( cbPageAddr + plxpages[ i ].size ) > pMap->cbData ))
+            return NULL;
+        cbPrevAddr = cbPageAddr;
+    }
+    if ( plxpages[ ulLast ].size < (( plx_rte->offset + plx_rte->cb ) - ( ulLast * LX_PAGE_SIZE )))
+        return NULL;
+
+    return pMap->pData + plx_hd->datapage +
+           ( plxpages[ ulFirst ].dataoffset << plx_hd->pageshift ) +
+           ( plx_rte->offset % LX_PAGE_SIZE );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXRunLength                                                               *
+ *                                                                           *
+ * Counts the number of times (up to ulMax) that the first byte of the data  *
+ * is repeated at its start.  Used by the EXEPACK encoders.                  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pData: The data.                                              (I) *
+ *   ULONG cb   : Size of the data (at least 1 byte).                    (I) *
+ *   ULONG ulMax: Maximum run length of interest.                        (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The length of the run (at least 1).                                     *
+ * ------------------------------------------------------------------------- */
+ULONG LXRunLength( PBYTE pData, ULONG cb, ULONG ulMax )
+{
+    ULONG ulRun = 1;
+
+    while (( ulRun < cb ) && ( ulRun < ulMax ) && ( pData[ ulRun ] == pData[ 0 ] ))
+        ulRun++;
+    return ulRun;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXUnpack1                                                                 *
+ *                                                                           *
+ * Unpacks a (max 4096-byte) page which has been compressed using the OS/2   *
+ * /EXEPACK1 method (a simple form of run-length encoding).  The unpacked    *
+ * data (max 4096 bytes) is written back into the input buffer.  The input   *
+ * buffer must therefore provide at least 4096 bytes.                        *
+ *                                                                           *
+ * This algorithm was derived from public-domain Pascal code by Veit         *
+ * Kannegieser (based on previous work by Max Alekseyev).                    *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE  pBuf  : Buffer containing the page data.                    (IO) *
+ *   USHORT cbPage: The size of the input page data.                     (I) *
+ *                                                                           *
+ * RETURNS: USHORT                                                           *
+ *   The number of output bytes written back to the buffer.                  *
+ * ------------------------------------------------------------------------- */
+USHORT LXUnpack1( PBYTE pBuf, USHORT cbPage )
+{
+    BYTE   abOut[ 4096 ] = {0};     // temporary output buffer
+    USHORT ofIn,                    // current input buffer offset
+           ofOut,                   // current output buffer offset
+           usReps,                  // number of repetitions of current sequence
+           usLen;                   // length of current sequence
+
+    if ( cbPage > 4096 ) return cbPage;
+    ofIn  = 0;
+    ofOut = 0;
+    do {
+        usReps = (USHORT)( pBuf[ofIn] | (pBuf[ofIn+1] << 8 ));
+        if ( !usReps ) break;
+        ofIn += 2;
+        usLen = (USHORT)( pBuf[ofIn] | (pBuf[ofIn+1] << 8 ));
+        ofIn += 2;
+        if (( ofOut + ( usReps * usLen )) > 4096 ) break;
+        while ( usReps ) {
+            memcpy( abOut + ofOut, pBuf + ofIn, usLen );
+            usReps--;
+            ofOut += usLen;
+        }
+        ofIn += usLen;
+    } while ( ofIn <= cbPage );
+
+    memcpy( pBuf, abOut, ofOut );
+    return ofOut;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LXUnpack2                                                                 *
+ *                                                                           *
+ * Unpacks a (max 4096-byte) page which has been compressed using the OS/2   *
+ * /EXEPACK2 method.  The unpacked data (max 4096 bytes) is written back     *
+ * into the input buffer.  The input buffer must therefore provide at least  *
+ * 4096 bytes.  This is a wrapper around LXDecodePage2() for callers which   *
+ * have the packed data in the page buffer already.                          *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE  pBuf  : Buffer containing the page data.                    (IO) *
+ *   USHORT cbPage: The size of the input page data.                     (I) *
+ *                                                                           *
+ * RETURNS: USHORT                                                           *
+ *   The number of output bytes written back to the buffer.                  *
+ * ------------------------------------------------------------------------- */
+USHORT LXUnpack2( PBYTE pBuf, USHORT cbPage )
+{
+    BYTE abIn[ LX_PAGE_SIZE ];      // copy of the packed input data
+
+    if ( cbPage > LX_PAGE_SIZE ) return cbPage;
+    memcpy( abIn, pBuf, cbPage );
+    return LXDecodePage2( pBuf, abIn, cbPage );
+}
+
+
+#ifdef HAVE_PTHREADS
+/* ------------------------------------------------------------------------- *
+ * LXUnpackBatch                                                             *
+ *                                                                           *
+ * Claims and unpacks pages from the thread pool's current batch, a chunk at *
+ * a time, until none are left to claim.  Called by both the worker threads  *
+ * and the thread which posted the batch.  The pool mutex must be held on    *
+ * entry; it is released while pages are being unpacked, and held again on   *
+ * return.                                                                   *
+ *                                                                           *
+ * ARGUMENTS: N/A                                                            *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void LXUnpackBatch( void )
+{
+    PLXPAGEJOB pJobs;
+    ULONG      iFirst,
+               iEnd,
+               i;
+
+    while ( unpack_pool.pJobs && ( unpack_pool.iNext < unpack_pool.cJobs )) {
+        pJobs  = unpack_pool.pJobs;
+        iFirst = unpack_pool.iNext;
+        iEnd   = iFirst + unpack_pool.cChunk;
+        if ( iEnd > unpack_pool.cJobs ) iEnd = unpack_pool.cJobs;
+        unpack_pool.iNext = iEnd;
+        pthread_mutex_unlock( &unpack_pool.mtx );
+
+        for ( i = iFirst; i < iEnd; i++ )
+            LXDecodePage( pJobs + i );
+
+        pthread_mutex_lock( &unpack_pool.mtx );
+        unpack_pool.cPending -= ( iEnd - iFirst );
+        if ( !unpack_pool.cPending )
+            pthread_cond_broadcast( &unpack_pool.cvDone );
+    }
+}
+#endif
+
+
+/* ------------------------------------------------------------------------- *
+ * LXUnpackPages                                                             *
+ *                                                                           *
+ * Reads (and if necessary unpacks) a range of pages of an object within a   *
+ * mapped LX-format module.  Each page is written to its own 4 KiB slot in   *
+ * the destination buffer, starting with page ulFirst at pDest; short or     *
+ * zero-filled pages are left as they are (the caller should supply a        *
+ * zeroed buffer).  The other pages of the object are not touched, and are   *
+ * counted as skipped in the extraction statistics.                          *
+ *                                                                           *
+ * If pbDone is not NULL, it points to an array of flags (one per page,      *
+ * starting with page ulFirst) indicating which pages have already been      *
+ * unpacked; such pages are not unpacked again, and the flags of the pages   *
+ * which are unpacked get set.                                               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FILEMAP pMap   : The mapped module file.                        (I) *
+ *   ULONG       ulBase : File offset of the LX-format header.           (I) *
+ *   ULONG       ulObj  : Object number (1-based).                       (I) *
+ *   ULONG       ulFirst: First page (0-based) to unpack.                (I) *
+ *   ULONG       ulLast : Last page (0-based) to unpack.                 (I) *
+ *   PBYTE       pDest  : Buffer for the pages (4 KiB per page).         (O) *
+ *   PBYTE       pbDone : Optional array of page-unpacked flags.        (IO) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   TRUE if the pages were unpacked, FALSE if the object data is invalid.   *
+ * ------------------------------------------------------------------------- */
+BOOL LXUnpackPages( POS2FILEMAP pMap, ULONG ulBase, ULONG ulObj, ULONG ulFirst, ULONG ulLast, PBYTE pDest, PBYTE pbDone )
+{
+    LXHEADER    *plx_hd;     // executable header
+    PLXOPMENTRY  plxpages;   // array of individual object page information
+    PLXPAGEJOB   pJobs;      // pages to be unpacked
+    ULONG        cPages,     // number of pages in the object
+                 cJobs,      // number of pages unpacked by this call
+                 cbPageAddr, // file offset of an individual object page
+                 i;
+
+
+    plx_hd   = (LXHEADER *)( pMap->pData + ulBase );
+    plxpages = LXObjectPageMap( pMap, ulBase, ulObj, &cPages );
+    if ( !plxpages || ( ulFirst > ulLast ) || ( ulLast >= cPages ))
+        return FALSE;
+    pJobs = (PLXPAGEJOB) calloc( ulLast - ulFirst + 1, sizeof( LXPAGEJOB ));
+    if ( !pJobs ) return FALSE;
+
+    // Check all the pages before unpacking any of them
+    cJobs = 0;
+    for ( i = ulFirst; i <= ulLast; i++ ) {
+        if ( pbDone && pbDone[ i - ulFirst ] ) continue;
+        if (( plxpages[ i ].flags != OP32_VALID ) &&
+            ( plxpages[ i ].flags != OP32_ITERDATA ) &&
+            ( plxpages[ i ].flags != OP32_ITERDATA2 ))
+            continue;
+        cbPageAddr = plx_hd->datapage + ( plxpages[ i ].dataoffset << plx_hd->pageshift );
+        if (( plxpages[ i ].size > LX_PAGE_SIZE ) ||
+            (( cbPageAddr + plxpages[ i ].size ) > pMap->cbData ))
+        {
+            free( pJobs );
+            return FALSE;
+        }
+        pJobs[ cJobs ].pSrc    = pMap->pData + cbPageAddr;
+        pJobs[ cJobs ].pDest   = pDest + (( i - ulFirst ) * LX_PAGE_SIZE );
+        pJobs[ cJobs ].cbSrc   = plxpages[ i ].size;
+        pJobs[ cJobs ].usFlags = plxpages[ i ].flags;
+        cJobs++;
+    }
+    LXDecodePages( pJobs, cJobs );
+    free( pJobs );
+
+    if ( pbDone ) memset( pbDone, TRUE, ulLast - ulFirst + 1 );
+    _STAT_ADD( extract_stats.ulPagesUnpacked, cJobs );
+    _STAT_ADD( extract_stats.ulPagesSkipped, cPages - ( ulLast - ulFirst + 1 ));
+    return TRUE;
+}
+
+
+#ifdef HAVE_PTHREADS
+/* ------------------------------------------------------------------------- *
+ * LXUnpackWorker                                                            *
+ *                                                                           *
+ * Thread function of the unpacking thread pool workers.  Waits for batches  *
+ * of pages to be posted by LXDecodePages() and helps to unpack them, until  *
+ * told to stop by SetOS2UnpackThreads().                                    *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   void *pArg: Not used.                                               (I) *
+ *                                                                           *
+ * RETURNS: void *                                                           *
+ *   Always NULL.                                                            *
+ * ------------------------------------------------------------------------- */
+void *LXUnpackWorker( void *pArg )
+{
+    (void) pArg;
+
+    pthread_mutex_lock( &unpack_pool.mtx );
+    while ( !unpack_pool.fStop ) {
+        if ( unpack_pool.pJobs && ( unpack_pool.iNext < unpack_pool.cJobs ))
+            LXUnpackBatch();
+        else
+            pthread_cond_wait( &unpack_pool.cvWork, &unpack_pool.mtx );
+    }
+    pthread_mutex_unlock( &unpack_pool.mtx );
+    return NULL;
+}
+#endif
+
+
+/* ------------------------------------------------------------------------- *
+ * LayoutGlyphAtlas                                                          *
+ *                                                                           *
+ * Works out where each glyph bitmap of a font goes in its glyph atlas (see  *
+ * gpifont.h for the rules), and returns the total size of the bitmap data.  *
+ * If an array of atlas glyph entries is given, it is filled in as well.     *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont   : Pointer to the font resource data.       (I) *
+ *   POS2ATLASGLYPH   paGlyphs: Array to receive the glyph entries (one      *
+ *                              per glyph in the font), or NULL.         (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The size of the atlas bitmap data in bytes.                             *
+ * ------------------------------------------------------------------------- */
+ULONG LayoutGlyphAtlas( POS2FONTRESOURCE pFont, POS2ATLASGLYPH paGlyphs )
+{
+    GLYPHBITMAP glyph;          // glyph information
+    ULONG       cGlyphs,        // number of glyphs in the font
+                ulOffset,       // offset of the current bitmap
+                ulLine,         // offset of the bitmap within its cache line
+                i;
+
+    cGlyphs  = pFont->pMetrics->usLastChar + 1;
+    ulOffset = 0;
+    for ( i = 0; i < cGlyphs; i++ ) {
+        if ( !LocateGlyph( pFont->pMetrics->usFirstChar + i, pFont, &glyph )) {
+            if ( paGlyphs ) paGlyphs[ i ].ulOffset = OS2ATLAS_NO_GLYPH;
+            continue;
+        }
+        ulLine = ulOffset % OS2ATLAS_ALIGN;
+        if ( ulLine && (( glyph.cbBuffer > OS2ATLAS_ALIGN ) ||
+                        (( ulLine + glyph.cbBuffer ) > OS2ATLAS_ALIGN )))
+            ulOffset += OS2ATLAS_ALIGN - ulLine;
+        if ( paGlyphs ) {
+            paGlyphs[ i ].ulOffset  = ulOffset;
+            paGlyphs[ i ].usWidth   = glyph.width;
+            paGlyphs[ i ].usPitch   = glyph.pitch;
+            paGlyphs[ i ].sBearingX = glyph.horiBearingX;
+            paGlyphs[ i ].sAdvance  = glyph.horiAdvance;
+        }
+        ulOffset += glyph.cbBuffer;
+    }
+    return ulOffset;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LocateFontGlyph                                                           *
+ *                                                                           *
+ * Finds the bitmap data for the OS/2 font glyph at the given index within   *
+ * the font data, and fills in the glyph information (apart from the buffer  *
+ * pointer, which is set to NULL).  The bitmap is left in the font's own     *
+ * format, with consecutive bytes representing vertical columns (see         *
+ * TransposeGlyph), whether or not the font has a glyph atlas.               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *   PGLYPHBITMAP     pGlyph : Pointer to the glyph information.         (O) *
+ *                                                                           *
+ * RETURNS: PBYTE                                                            *
+ *   Pointer to the glyph bitmap within the font data, or NULL if the glyph  *
+ *   does not exist (or its bitmap lies outside the font data).              *
+ * ------------------------------------------------------------------------- */
+PBYTE LocateFontGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph )
+{
+    USHORT       cx, cy,        // size of the character bitmap in pels
+                 bearingL,      // left side-bearing (a_space) in pels
+                 bearingR,      // right side-bearing (c_space) in pels
+                 usWidth;       // number of bytes in each row
+    PBYTE        pBitmap;       // pointer to bitmap within the font data
+    POS2CHARDEF1 pChar1;        // pointer to type 1/2 glyph definition
+    POS2CHARDEF3 pChar3;        // pointer to type 3 glyph definition
+
+
+    // Map index 0 to the default/substitution glyph
+    if ( ulIndex == 0 )
+        ulIndex = pFont->pMetrics->usFirstChar + pFont->pMetrics->usDefaultChar;
+
+    // Make sure our index actually falls within the range contained in the font
+    if (( ulIndex < pFont->pMetrics->usFirstChar ) ||
+        ( ulIndex > ( pFont->pMetrics->usFirstChar +
+                       pFont->pMetrics->usLastChar )))
+        return NULL;
+
+    ulIndex -= pFont->pMetrics->usFirstChar;
+
+    // Find the character data for the given offset
+    if ( pFont->pFontDef->fsChardef == OS2FONTDEF_CHAR3 ) {
+        pChar3 = (POS2CHARDEF3) ( (PBYTE) pFont->data.pABC +
+                                  ( ulIndex * pFont->pFontDef->usCellSize ));
+        if ( pChar3->ulOffset == 0 ) return NULL;
+        pBitmap = (PBYTE) pFont->pSignature + pChar3->ulOffset;
+        cx = pChar3->bSpace;
+        bearingL = pChar3->aSpace;
+        bearingR = pChar3->cSpace;
+    }
+    else {
+        pChar1 = (POS2CHARDEF1) ( (PBYTE) pFont->data.pABC +
+                                  ( ulIndex * pFont->pFontDef->usCellSize ));
+        if ( pChar1->ulOffset == 0 ) return NULL;
+        pBitmap = (PBYTE) pFont->pSignature + pChar1->ulOffset;
+        cx = pChar1->ulWidth;
+        bearingL = 0;
+        bearingR = 0;
+    }
+    cy = pFont->pFontDef->yCellHeight;
+    usWidth = cx / 8;
+    if ( cx % 8 ) usWidth++;
+
+    pGlyph->rows         = cy;
+    pGlyph->width        = cx;
+    pGlyph->pitch        = usWidth;
+    pGlyph->buffer       = NULL;
+    pGlyph->cbBuffer     = cy * usWidth;
+    pGlyph->horiBearingX = bearingL;
+    pGlyph->horiAdvance  = bearingL + cx + bearingR;
+    pGlyph->vertBearingY = pFont->pMetrics->yExternalLeading;
+    pGlyph->vertAdvance  = cy + pFont->pMetrics->yExternalLeading;
+
+    // Reject a bitmap which extends beyond the end of the font data
+    if (( (ULONG)( pBitmap - (PBYTE) pFont->pSignature ) + pGlyph->cbBuffer ) > pFont->cbSize )
+        return NULL;
+    return pBitmap;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * LocateGlyph                                                               *
+ *                                                                           *
+ * Finds the bitmap data for the OS/2 font glyph at the given index, as with *
+ * LocateFontGlyph(), except that if the font has a glyph atlas the bitmap   *
+ * within the atlas (already in row-major format) is returned instead.  Use  *
+ * StoreGlyph() to write out the bitmap in either case.                      *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *   PGLYPHBITMAP     pGlyph : Pointer to the glyph information.         (O) *
+ *                                                                           *
+ * RETURNS: PBYTE                                                            *
+ *   Pointer to the glyph bitmap, or NULL if the glyph does not exist.       *
+ * ------------------------------------------------------------------------- */
+PBYTE LocateGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph )
+{
+    PBYTE pBitmap;
+
+    if ( pFont->pAtlas ) {
+        if ( !GetOS2AtlasGlyph( ulIndex, pFont, pGlyph )) return NULL;
+        pBitmap = pGlyph->buffer;
+        pGlyph->buffer = NULL;
+        return pBitmap;
+    }
+    return LocateFontGlyph( ulIndex, pFont, pGlyph );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * MapOS2FontResource                                                        *
+ *                                                                           *
+ * Locates and parses a font face from the specified file, as with           *
+ * ReadOS2FontResource().  The difference is that the file is memory-mapped  *
+ * (where supported) and the executable headers, resource table and object   *
+ * page map are all parsed directly out of the mapping.  Wherever the font   *
+ * data is stored uncompressed the returned font refers directly into the    *
+ * mapping, without copying it.                                              *
+ *                                                                           *
+ * This is a convenience wrapper around OpenOS2FontModule() for callers      *
+ * which only want a single face; to read several faces from the same file,  *
+ * use the font module functions directly.                                   *
+ *                                                                           *
+ * The returned font must be released using FreeOS2FontResource() (rather    *
+ * than by freeing pSignature directly) once no longer needed.               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PSZ              pszFile : Fully-qualified name of the font file.   (I) *
+ *   ULONG            ulFace  : Font (face) number within the file to        *
+ *                              retrieve (where 0 is the first font).    (I) *
+ *   PULONG           pulCount: Total number of faces found in file.     (O) *
+ *   POS2FONTRESOURCE pFont   : Pointer to an OS2FONTRESOURCE structure      *
+ *                              which will receive the parsed font data. (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 if the font was successfully read and parsed, ERR_* otherwise.        *
+ * ------------------------------------------------------------------------- */
+ULONG MapOS2FontResource( PSZ pszFile, ULONG ulFace, PULONG pulCount, POS2FONTRESOURCE pFont )
+{
+    POS2FONTMODULE pModule;
+    ULONG          ulRC;
+
+
+    *pulCount = 0;
+    ulRC = OpenOS2FontModule( pszFile, &pModule );
+    if ( ulRC != 0 ) return ulRC;
+    *pulCount = pModule->cFaces;
+    ulRC = GetOS2FontModuleFace( pModule, ulFace, pFont );
+    CloseOS2FontModule( pModule );
+    return ulRC;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * MeasureOS2FontGlyphs                                                      *
+ *                                                                           *
+ * Returns the total width of a run of OS/2 font glyphs: the sum of their    *
+ * horizontal advances, which is how far RenderOS2FontText() would move the  *
+ * pen when drawing them.  Only the character definitions are read; no       *
+ * bitmaps are touched.  In a fixed-pitch font every glyph has the same      *
+ * advance (see SetFixedAdvance), so the width is simply that advance times  *
+ * the number of glyphs which exist.                                         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont    : Pointer to the font resource data.      (I) *
+ *   PULONG           pulGlyphs: Glyph indices (see OS2FontGlyphIndices).(I) *
+ *   ULONG            cGlyphs  : Number of glyph indices.                (I) *
+ *                                                                           *
+ * RETURNS: LONG                                                             *
+ *   The total advance in pels.                                              *
+ * ------------------------------------------------------------------------- */
+LONG MeasureOS2FontGlyphs( POS2FONTRESOURCE pFont, PULONG pulGlyphs, ULONG cGlyphs )
+{
+    ULONG ulFirst = pFont->pMetrics->usFirstChar,
+          ulLast  = ulFirst + pFont->pMetrics->usLastChar,
+          cExist,
+          i;
+    LONG  lWidth;
+
+    if ( pFont->lFixedAdvance ) {
+        // Every glyph in range exists (SetFixedAdvance checked each one's
+        // bitmap as GlyphAdvance does), and index 0 is the default glyph
+        for ( i = 0, cExist = 0; i < cGlyphs; i++ )
+            if (( pulGlyphs[ i ] == 0 ) ||
+                (( pulGlyphs[ i ] >= ulFirst ) && ( pulGlyphs[ i ] <= ulLast )))
+                cExist++;
+        return (LONG) cExist * pFont->lFixedAdvance;
+    }
+    for ( i = 0, lWidth = 0; i < cGlyphs; i++ )
+        lWidth += GlyphAdvance( pulGlyphs[ i ], pFont );
+    return lWidth;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * MeasureOS2FontText                                                        *
+ *                                                                           *
+ * Returns the width of a string of UTF-8 or UTF-16 text in an OS/2 font,    *
+ * that is, how far RenderOS2FontText() would move the pen when drawing it.  *
+ * This converts the text as OS2FontGlyphIndices() does and then adds up     *
+ * the advances as MeasureOS2FontGlyphs() does, without touching any glyph   *
+ * bitmaps.  If OS2TEXT_KERNING is given, the kerning amount between each    *
+ * pair of consecutive glyphs is added as well.                              *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont   : Pointer to the font resource data.       (I) *
+ *   PVOID            pText   : The text to measure.                     (I) *
+ *   ULONG            cbText  : Size of the text, in bytes.              (I) *
+ *   ULONG            ulFormat: OS2TEXT_UTF8 or OS2TEXT_UTF16, optionally    *
+ *                              with OS2TEXT_KERNING.                    (I) *
+ *                                                                           *
+ * RETURNS: LONG                                                             *
+ *   The width of the text in pels.                                          *
+ * ------------------------------------------------------------------------- */
+LONG MeasureOS2FontText( POS2FONTRESOURCE pFont, PVOID pText, ULONG cbText, ULONG ulFormat )
+{
+    ULONG aulGlyphs[ RENDER_CHUNK ];    // glyph indices of part of the text
+    ULONG ofText,                       // offset of the text still to measure
+          cbUsed,                       // bytes of text converted
+          cGlyphs,                      // number of glyph indices
+          ulPrev = OS2KERN_NO_PAIR,     // previous glyph (none to begin with)
+          i;
+    BOOL  fKern;                        // apply kerning?
+    LONG  lWidth = 0;
+
+    fKern = ( ulFormat & OS2TEXT_KERNING ) && pFont->pKernIndex;
+    ulFormat &= ~OS2TEXT_KERNING;
+    for ( ofText = 0; ofText < cbText; ofText += cbUsed ) {
+        cGlyphs = OS2FontGlyphIndices( pFont, (PBYTE) pText + ofText, cbText - ofText,
+                                       ulFormat, aulGlyphs, RENDER_CHUNK, &cbUsed );
+        if ( !cbUsed ) break;       // only an incomplete character is left
+        lWidth += MeasureOS2FontGlyphs( pFont, aulGlyphs, cGlyphs );
+        if ( !fKern ) continue;
+        for ( i = 0; i < cGlyphs; i++ ) {
+            lWidth += OS2FontKerning( pFont, ulPrev, aulGlyphs[ i ] );
+            ulPrev = aulGlyphs[ i ];
+        }
+    }
+    return lWidth;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * NEExtractResource                                                         *
+ *                                                                           *
+ * Extracts a binary resource from a 16-bit (NE-format) OS/2 module.  Each   *
+ * resource of an NE module is stored in a segment of its own; the resource  *
+ * segments are the last ne_hd.cres entries of the segment table, in the     *
+ * same order as the resource table.  The buffer is allocated by this        *
+ * function on successful return, contains the whole resource segment, and   *
+ * must be freed once no longer needed.  Segments in iterated format are not *
+ * supported (the resource compiler does not produce them).                  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   FILE     *pf      : Pointer to the open file.                       (I) *
+ *   NEHEADER  ne_hd   : NE-format executable header                     (I) *
+ *   ULONG     ulBase  : File offset of the NE-format header             (I) *
+ *   ULONG     ulRes   : Index of the resource in the resource table     (I) *
+ *   PBYTE    *ppBuffer: Pointer to a buffer for the resource data       (O) *
+ *   PULONG    pulSize : Pointer to the returned resource size           (O) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   FALSE: Failed to extract resource; ppBuffer & pulSize are unchanged.    *
+ *   TRUE: Data extracted successfully, ppBuffer points to allocated buffer. *
+ * ------------------------------------------------------------------------- */
+BOOL NEExtractResource( FILE *pf, NEHEADER ne_hd, ULONG ulBase, ULONG ulRes, PBYTE *ppBuffer, PULONG pulSize )
+{
+    NESTENTRY ne_seg;       // segment table entry of the resource
+    ULONG     cbSeg;        // size of the resource segment
+    PBYTE     pBuf;
+
+
+    if (( ulRes >= ne_hd.cres ) || ( ne_hd.cres > ne_hd.cseg ) || ( ne_hd.segshift > 16 ))
+        return FALSE;
+    if (( _FILE_SEEK( pf, ulBase + ne_hd.seg_tbl +
+                      ( sizeof( NESTENTRY ) * ( ne_hd.cseg - ne_hd.cres + ulRes )))) ||
+        ( ! _FILE_READ( pf, &ne_seg, sizeof( NESTENTRY ))))
+        return FALSE;
+    if ( !ne_seg.offset || ( ne_seg.flags & NESEG_ITERATED ))
+        return FALSE;
+
+    cbSeg = ne_seg.cb ? ne_seg.cb : 0x10000;
+    pBuf  = (PBYTE) malloc( cbSeg );
+    if ( !pBuf ) return FALSE;
+    if (( _FILE_SEEK( pf, (ULONG) ne_seg.offset << ne_hd.segshift )) ||
+        ( _FILE_READ( pf, pBuf, cbSeg ) != cbSeg ))
+    {
+        free( pBuf );
+        return FALSE;
+    }
+    *ppBuffer = pBuf;
+    *pulSize  = cbSeg;
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * NEIndexFaces                                                              *
+ *                                                                           *
+ * Indexes the font faces of a mapped 16-bit (NE-format) module for          *
+ * OpenOS2FontModule().  As for LX modules, the font directory (if any) is   *
+ * used to resolve each face to its resource-table entry; otherwise each     *
+ * OS2RES_FONTFACE resource is taken as one face, in order.  NE resources    *
+ * are never compressed, so the font directory is read in place.             *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTMODULE pModule: The font module (with pMap, usMagic and         *
+ *                           ulBase set).                               (IO) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_* otherwise.                                          *
+ * ------------------------------------------------------------------------- */
+ULONG NEIndexFaces( POS2FONTMODULE pModule )
+{
+    POS2FILEMAP       pMap = pModule->pMap;
+    POS2FONTDIRECTORY pFD;          // font directory
+    PNEHEADER         pne_hd;       // executable header
+    PNERTENTRY        prtes;        // resource table
+    ULONG             cbDir,        // size of the font directory
+                      cFaces,
+                      i, j;
+
+
+    if (( pModule->ulBase + sizeof( NEHEADER )) > pMap->cbData )
+        return ERR_FILE_FORMAT;
+    pne_hd = (PNEHEADER)( pMap->pData + pModule->ulBase );
+    if ( !pne_hd->cres || ( pne_hd->cres > pne_hd->cseg ) ||
+        (( pModule->ulBase + pne_hd->res_tbl + ( pne_hd->cres * sizeof( NERTENTRY ))) > pMap->cbData ))
+        return ERR_FILE_FORMAT;
+    prtes = (PNERTENTRY)( pMap->pData + pModule->ulBase + pne_hd->res_tbl );
+
+    pModule->paulFaceRes = (PULONG) calloc( pne_hd->cres, sizeof( ULONG ));
+    if ( !pModule->paulFaceRes ) return ERR_MEMORY;
+
+    // Use the font directory, if there is one, to find each face's resource
+    for ( i = 0; i < pne_hd->cres; i++ ) {
+        if ( prtes[ i ].etype != OS2RES_FONTDIR ) continue;
+        pFD = (POS2FONTDIRECTORY) NEResourceInPlace( pMap, pModule->ulBase, i, &cbDir );
+        if ( !pFD || ( cbDir < 6 )) return ERR_FILE_READ;
+        cFaces = pFD->usnFonts;
+        if (( 6 + ( cFaces * sizeof( OS2FONTDIRENTRY ))) > cbDir )
+            cFaces = ( cbDir - 6 ) / sizeof( OS2FONTDIRENTRY );
+        if ( cFaces > pne_hd->cres ) {
+            PULONG paul = (PULONG) realloc( pModule->paulFaceRes, cFaces * sizeof( ULONG ));
+            if ( !paul ) return ERR_MEMORY;
+            pModule->paulFaceRes = paul;
+        }
+        for ( j = 0; j < cFaces; j++ ) {
+            ULONG k;
+            pModule->paulFaceRes[ j ] = (ULONG) -1;
+            for ( k = 0; k < pne_hd->cres; k++ ) {
+                if (( prtes[ k ].etype != OS2RES_FONTDIR ) &&
+                    ( prtes[ k ].ename == pFD->fntEntry[ j ].usIndex )) {
+                    pModule->paulFaceRes[ j ] = k;
+                    break;
+                }
+            }
+        }
+        pModule->cFaces = cFaces;
+        return 0;
+    }
+
+    // No font directory, so just use the font resources in order
+    for ( i = 0; i < pne_hd->cres; i++ ) {
+        if ( prtes[ i ].etype == OS2RES_FONTFACE )
+            pModule->paulFaceRes[ pModule->cFaces++ ] = i;
+    }
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * NEResourceInPlace                                                         *
+ *                                                                           *
+ * Locates a resource within a mapped 16-bit (NE-format) module.  NE         *
+ * resources are stored uncompressed, each in its own segment (see           *
+ * NEExtractResource), so they can always be referenced directly within      *
+ * the mapping unless the segment is in iterated format.                     *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FILEMAP pMap  : The mapped module file.                         (I) *
+ *   ULONG       ulBase: File offset of the NE-format header.            (I) *
+ *   ULONG       ulRes : Index of the resource in the resource table.    (I) *
+ *   PULONG      pcb   : Size of the resource segment.                   (O) *
+ *                                                                           *
+ * RETURNS: PBYTE                                                            *
+ *   Pointer to the resource data within the mapping, or NULL if the         *
+ *   resource cannot be located.                                             *
+ * ------------------------------------------------------------------------- */
+PBYTE NEResourceInPlace( POS2FILEMAP pMap, ULONG ulBase, ULONG ulRes, PULONG pcb )
+{
+    PNEHEADER pne_hd;       // executable header
+    NESTENTRY ne_seg;       // segment table entry of the resource
+    ULONG     ofEntry,      // file offset of the segment table entry
+              ofSeg,        // file offset of the segment
+              cbSeg;        // size of the segment
+
+
+    if (( ulBase + sizeof( NEHEADER )) > pMap->cbData ) return NULL;
+    pne_hd = (PNEHEADER)( pMap->pData + ulBase );
+    if (( ulRes >= pne_hd->cres ) || ( pne_hd->cres > pne_hd->cseg ) || ( pne_hd->segshift > 16 ))
+        return NULL;
+    ofEntry = ulBase + pne_hd->seg_tbl +
+              ( sizeof( NESTENTRY ) * ( pne_hd->cseg - pne_hd->cres + ulRes ));
+    if (( ofEntry + sizeof( NESTENTRY )) > pMap->cbData ) return NULL;
+    memcpy( &ne_seg, pMap->pData + ofEntry, sizeof( NESTENTRY ));
+    if ( !ne_seg.offset || ( ne_seg.flags & NESEG_ITERATED )) return NULL;
+
+    ofSeg = (ULONG) ne_seg.offset << pne_hd->segshift;
+    cbSeg = ne_seg.cb ? ne_seg.cb : 0x10000;
+    if (( ofSeg + cbSeg ) > pMap->cbData ) return NULL;
+    *pcb = cbSeg;
+    return pMap->pData + ofSeg;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * NewCachedGlyph                                                            *
+ *                                                                           *
+ * Extracts a glyph into a new (unpinned) glyph cache entry, which is not    *
+ * yet added to any cache.  The entry starts with the one reference which    *
+ * the cache holds.                                                          *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *                                                                           *
+ * RETURNS: PGLYPHCACHEENTRY                                                 *
+ *   The new entry, or NULL if the glyph does not exist or memory ran out.   *
+ * ------------------------------------------------------------------------- */
+PGLYPHCACHEENTRY NewCachedGlyph( ULONG ulIndex, POS2FONTRESOURCE pFont )
+{
+    PGLYPHCACHEENTRY pEntry;
+    GLYPHBITMAP      glyph;
+    ULONG            cb;
+
+    if ( !LocateGlyph( ulIndex, pFont, &glyph )) return NULL;
+    cb = sizeof( GLYPHCACHEENTRY ) + glyph.cbBuffer;
+    pEntry = (PGLYPHCACHEENTRY) calloc( 1, cb );
+    if ( !pEntry ) return NULL;
+    if ( !ExtractOS2FontGlyphInto( ulIndex, pFont, &pEntry->glyph,
+                                   (PBYTE)( pEntry + 1 ), cb - sizeof( GLYPHCACHEENTRY ))) {
+        free( pEntry );
+        return NULL;
+    }
+    pEntry->pFont   = pFont;
+    pEntry->ulIndex = ulIndex;
+    pEntry->cb      = cb;
+    pEntry->cRefs   = 1;
+    return pEntry;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * NewCachedObject                                                           *
+ *                                                                           *
+ * Allocates an object cache entry for an LX object of the given number of   *
+ * pages, with the (zeroed) object data and page flags following the entry   *
+ * itself.  No pages are unpacked yet, so only the entry and the flags count *
+ * towards the budget.  The caller fills in the identity and object number   *
+ * before adding it to the cache with InsertCachedObject().                  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG cPages: Number of pages in the object.                        (I) *
+ *                                                                           *
+ * RETURNS: POBJCACHEENTRY                                                   *
+ *   The new entry, or NULL if memory could not be allocated.                *
+ * ------------------------------------------------------------------------- */
+POBJCACHEENTRY NewCachedObject( ULONG cPages )
+{
+    POBJCACHEENTRY pEntry;
+    ULONG          cb;
+
+    if ( cPages > (( 0xFFFFFFFF - sizeof( OBJCACHEENTRY )) / ( LX_PAGE_SIZE + 1 )))
+        return NULL;
+    cb = sizeof( OBJCACHEENTRY ) + ( cPages * ( LX_PAGE_SIZE + 1 ));
+    pEntry = (POBJCACHEENTRY) calloc( 1, cb );
+    if ( !pEntry ) return NULL;
+    pEntry->cPages = cPages;
+    pEntry->cb     = sizeof( OBJCACHEENTRY ) + cPages;
+    pEntry->pData  = (PBYTE)( pEntry + 1 );
+    pEntry->pbDone = pEntry->pData + ( cPages * LX_PAGE_SIZE );
+#ifdef HAVE_PTHREADS
+    pthread_mutex_init( &pEntry->mtxPages, NULL );
+#endif
+    return pEntry;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * OS2FontGlyphIndex                                                         *
+ *                                                                           *
+ * Given a Unicode (UCS) codepoint, convert it into a glyph index/codepoint  *
+ * within an OS/2 GPI bitmap font.  This currently supports only standard    *
+ * UGL encoding; everything else will be treated as a symbol font (that is   *
+ * to say, with passthrough encoding).  Fonts from non-English versions of   *
+ * OS/2 prior to 4.5x therefore may not work properly, but such fonts are    *
+ * likely vanishingly rare nowadays anyway.  (If the utilising program cares *
+ * about this, it should check the pFont->pMetrics->usCodepage field and     *
+ * reject any font which does not report 850 or 65400.)  Since OS/2 4.5x     *
+ * (circa 1998) bitmap fonts from all languages use the common UGL encoding. *
+ *                                                                           *
+ * Note that while there is a direct correspondence between the glyph index  *
+ * and the physical glyph offset, the two may not be exactly the same if the *
+ * first actual character in the font is not character index 0.  The glyph   *
+ * offset will be equal to the character index minus the index of the first  *
+ * actual character in the font; the conversion is done in the               *
+ * ExtractOS2FontGlyph() function.  (The caller need not be aware of the     *
+ * distinction, but it is mentioned here just to be thorough.)               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont: Pointer to the font data structure.         (I) *
+ *   ULONG            index: UCS-2 codepoint requested.                  (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The corresponding index within the font's own encoding (either UGL or   *
+ *   passthrough/verbatim), or 0 if the requested character does not exist.  *
+ *   (Technically index 0 corresponds to the .null character, but there      *
+ *   should be no need to maintain a distinction as .null is by definition   *
+ *   not a displayable glyph in any case.)                                   *
+ * ------------------------------------------------------------------------- */
+ULONG OS2FontGlyphIndex( POS2FONTRESOURCE pFont, ULONG index )
+{
+    USHORT i;
+
+    // If this is not a UGL font (reported as 0 or 850), assume no translation
+    if ( pFont->pMetrics->usCodePage && ( pFont->pMetrics->usCodePage != 850 ))
+        return index;
+
+    // Basic ASCII needs no translation and is always supported
+    if ( index >= 32 && index <= 126 ) return index;
+
+
+    /* Look up the UGL index in the Unicode-to-UGL table (this includes the
+     * character blocks which have direct mappings).  Nothing outside the BMP
+     * has a UGL equivalent.
+     */
+    if ( index > 0xFFFF ) return 0;
+    i = UNI2UGL( index );
+
+
+    /* We have our UGL index, now see if the font actually supports it
+     */
+
+    // Character not supported by UGL encoding at all, return 0.
+    if ( i >= OS2UGL_MAX_GLYPH ) return 0;
+
+    // Character is not in the font, or belongs to an unsupported group
+    if ( !UGLGlyphInFont( pFont->pMetrics, i )) return 0;
+
+    return ( i );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * OS2FontGlyphIndices                                                       *
+ *                                                                           *
+ * Converts a string of UTF-8 or UTF-16 text into glyph indices within an    *
+ * OS/2 GPI bitmap font, in a single pass.  Each character gives the same    *
+ * result as OS2FontGlyphIndex() would, but instead of checking the font's   *
+ * glyph range and character groups for every character, this uses the UGL   *
+ * coverage bitmap which ParseOS2FontResource() builds for the font; each    *
+ * character therefore costs only a table lookup and a bit test.             *
+ *                                                                           *
+ * Malformed UTF-8 sequences and unpaired UTF-16 surrogates are treated as   *
+ * U+FFFD (one per invalid byte or code unit).  Conversion stops when either *
+ * the text or the output array is exhausted; pcbUsed (if not NULL) receives *
+ * the number of bytes of text which were converted, so that a long buffer   *
+ * can be converted in several calls.  A character split across the end of   *
+ * the text is left unconverted.                                             *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont    : Pointer to the font data structure.     (I) *
+ *   PVOID            pText    : The text to convert.                    (I) *
+ *   ULONG            cbText   : Size of the text, in bytes.             (I) *
+ *   ULONG            ulFormat : OS2TEXT_UTF8 or OS2TEXT_UTF16.          (I) *
+ *   PULONG           pulGlyphs: Array to receive the glyph indices.     (O) *
+ *   ULONG            cMax     : Size of the pulGlyphs array.            (I) *
+ *   PULONG           pcbUsed  : Number of bytes of text converted.      (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The number of glyph indices written to pulGlyphs.                       *
+ * ------------------------------------------------------------------------- */
+ULONG OS2FontGlyphIndices( POS2FONTRESOURCE pFont, PVOID pText, ULONG cbText, ULONG ulFormat, PULONG pulGlyphs, ULONG cMax, PULONG pcbUsed )
+{
+    PBYTE   pb = (PBYTE) pText;     // UTF-8 text
+    PUSHORT pus = (PUSHORT) pText;  // UTF-16 text
+    ULONG   ofIn,                   // offset of the current character
+            ofNext,                 // offset of the next character
+            cTrail,                 // number of UTF-8 trailing bytes
+            c,                      // current codepoint
+            i,                      // UGL index
+            n;                      // number of glyph indices written
+    USHORT  us;
+
+
+    ofIn = 0;
+    n    = 0;
+    if ( ulFormat == OS2TEXT_UTF16 ) cbText &= ~1;
+    while (( ofIn < cbText ) && ( n < cMax )) {
+
+        // Decode the next character
+        if ( ulFormat == OS2TEXT_UTF16 ) {
+            us = pus[ ofIn / 2 ];
+            ofNext = ofIn + 2;
+            c = us;
+            if (( us >= 0xD800 ) && ( us <= 0xDBFF )) {
+                if ( ofNext >= cbText ) break;
+                us = pus[ ofNext / 2 ];
+                if (( us >= 0xDC00 ) && ( us <= 0xDFFF )) {
+                    c = 0x10000 + (( c - 0xD800 ) << 10 ) + ( us - 0xDC00 );
+                    ofNext += 2;
+                }
+                else c = 0xFFFD;
+            }
+            else if (( us >= 0xDC00 ) && ( us <= 0xDFFF ))
+                c = 0xFFFD;
+        }
+        else {
+            c = pb[ ofIn ];
+            ofNext = ofIn + 1;
+            if ( c >= 0x80 ) {
+                if (( c >= 0xC2 ) && ( c <= 0xDF ))      { c &= 0x1F; cTrail = 1; }
+                else if (( c >= 0xE0 ) && ( c <= 0xEF )) { c &= 0x0F; cTrail = 2; }
+                else if (( c >= 0xF0 ) && ( c <= 0xF4 )) { c &= 0x07; cTrail = 3; }
+                else cTrail = 0;
+                if ( !cTrail )
+                    c = 0xFFFD;
+                else {
+                    for ( ; cTrail && ( ofNext < cbText ) && (( pb[ ofNext ] & 0xC0 ) == 0x80 ); cTrail-- )
+                        c = ( c << 6 ) | ( pb[ ofNext++ ] & 0x3F );
+                    // Stop at a character split across the end of the text
+                    if ( cTrail && ( ofNext == cbText )) break;
+                    // Reject truncated, overlong and surrogate sequences
+                    if ( cTrail ||
+                         (( ofNext - ofIn ) == 3 && ( c < 0x800 )) ||
+                         (( ofNext - ofIn ) == 4 && (( c < 0x10000 ) || ( c > 0x10FFFF ))) ||
+                         (( c >= 0xD800 ) && ( c <= 0xDFFF )))
+                    {
+                        c = 0xFFFD;
+                        ofNext = ofIn + 1;
+                    }
+                }
+            }
+        }
+        ofIn = ofNext;
+
+        // Convert it into a glyph index
+        if ( !pFont->fUGL || (( c >= 32 ) && ( c <= 126 )))
+            pulGlyphs[ n++ ] = c;
+        else if ( c > 0xFFFF )
+            pulGlyphs[ n++ ] = 0;
+        else {
+            i = UNI2UGL( c );
+            pulGlyphs[ n++ ] = ( pFont->abCoverage[ i >> 3 ] & ( 1 << ( i & 7 ))) ? i : 0;
+        }
+    }
+
+    if ( pcbUsed ) *pcbUsed = ofIn;
+    return n;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * OS2FontGlyphMetrics                                                       *
+ *                                                                           *
+ * Gets the metrics of the OS/2 font glyph at the given index, without       *
+ * extracting its bitmap.  The glyph information is filled in exactly as     *
+ * ExtractOS2FontGlyph() would, except that the buffer field is set to NULL. *
+ * Use this (or MeasureOS2FontText) where only the advances are needed.      *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *   PGLYPHBITMAP     pGlyph : Pointer to the glyph information.         (O) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   FALSE if the glyph does not exist.                                      *
+ * ------------------------------------------------------------------------- */
+BOOL OS2FontGlyphMetrics( ULONG ulIndex, POS2FONTRESOURCE pFont, PGLYPHBITMAP pGlyph )
+{
+    return LocateFontGlyph( ulIndex, pFont, pGlyph ) ? TRUE : FALSE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * OS2FontGlyphSize                                                          *
+ *                                                                           *
+ * Returns the size of the buffer needed to hold the bitmap of the OS/2 font *
+ * glyph at the given index, once extracted by ExtractOS2FontGlyphInto().    *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG            ulIndex: Glyph index (codepoint) within the font.  (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The bitmap size in bytes, or 0 if the glyph does not exist.             *
+ * ------------------------------------------------------------------------- */
+ULONG OS2FontGlyphSize( ULONG ulIndex, POS2FONTRESOURCE pFont )
+{
+    GLYPHBITMAP glyph;
+
+    if ( !LocateGlyph( ulIndex, pFont, &glyph )) return 0;
+    return glyph.cbBuffer;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * OS2FontKerning                                                            *
+ *                                                                           *
+ * Returns the kerning amount between two OS/2 font glyphs, that is, the     *
+ * adjustment made to the pen position between drawing the first glyph and   *
+ * drawing the second (negative values move them closer together).  The      *
+ * lookup uses the font's kerning index, and takes constant time.            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont   : Pointer to the font resource data.       (I) *
+ *   ULONG            ulFirst : Glyph index of the first glyph.          (I) *
+ *   ULONG            ulSecond: Glyph index of the second glyph.         (I) *
+ *                                                                           *
+ * RETURNS: LONG                                                             *
+ *   The kerning amount in pels, or 0 if the font does not kern the pair.    *
+ * ------------------------------------------------------------------------- */
+LONG OS2FontKerning( POS2FONTRESOURCE pFont, ULONG ulFirst, ULONG ulSecond )
+{
+    POS2KERNINDEX pIndex = pFont->pKernIndex;
+    ULONG         ulPair,
+                  i;
+
+    if ( !pIndex ) return 0;
+
+    // Map index 0 to the default/substitution glyph
+    if ( ulFirst == 0 )
+        ulFirst = pFont->pMetrics->usFirstChar + pFont->pMetrics->usDefaultChar;
+    if ( ulSecond == 0 )
+        ulSecond = pFont->pMetrics->usFirstChar + pFont->pMetrics->usDefaultChar;
+    if (( ulFirst > 0xFFFF ) || ( ulSecond > 0xFFFF )) return 0;
+
+    ulPair = ( ulFirst << 16 ) | ulSecond;
+    for ( i = KERN_HASH( ulPair, pIndex->ulMask ); ; i = ( i + 1 ) & pIndex->ulMask ) {
+        if ( pIndex->paSlots[ i ].ulPair == ulPair )
+            return pIndex->paSlots[ i ].lAmount;
+        if ( pIndex->paSlots[ i ].ulPair == OS2KERN_NO_PAIR )
+            return 0;
+    }
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * OS2MapFile                                                                *
+ *                                                                           *
+ * Maps the entire contents of a file into memory, read-only.  Where memory  *
+ * mapping is not supported (or fails), the file is instead read into an     *
+ * allocated buffer with a single read.  The returned map has a reference    *
+ * count of 1; release it with OS2ReleaseFileMap().                          *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PSZ          pszFile: Fully-qualified name of the file.             (I) *
+ *   POS2FILEMAP *ppMap  : Pointer to the returned file map.             (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_* otherwise (in which case ppMap is unchanged).       *
+ * ------------------------------------------------------------------------- */
+ULONG OS2MapFile( PSZ pszFile, POS2FILEMAP *ppMap )
+{
+    struct stat fs = {0};       // file information structure
+    POS2FILEMAP pMap;
+    FILE        *pf;
+
+    pMap = (POS2FILEMAP) calloc( 1, sizeof( OS2FILEMAP ));
+    if ( !pMap ) return ERR_MEMORY;
+    pMap->cRefs = 1;
+
+#ifdef HAVE_MMAP
+    {
+        int   fd;
+        PVOID pv;
+
+        if (( fd = open( pszFile, O_RDONLY )) == -1 ) {
+            free( pMap );
+            return ERR_FILE_OPEN;
+        }
+        if ( fstat( fd, &fs ) || ( fs.st_size <= 0 )) {
+            close( fd );
+            free( pMap );
+            return fs.st_size ? ERR_FILE_STAT : ERR_FILE_FORMAT;
+        }
+        pv = mmap( NULL, fs.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        close( fd );
+        if ( pv != MAP_FAILED ) {
+            pMap->pData   = (PBYTE) pv;
+            pMap->cbData  = fs.st_size;
+            pMap->fMapped = TRUE;
+            StatFileID( &fs, &(pMap->id) );
+            *ppMap = pMap;
+            return 0;
+        }
+    }
+#endif
+
+    if (( pf = _FILE_OPEN( pszFile )) == NULL ) {
+        free( pMap );
+        return ERR_FILE_OPEN;
+    }
+    if ( _FILE_STAT( pf, &fs ) || ( fs.st_size <= 0 )) {
+        _FILE_CLOSE( pf );
+        free( pMap );
+        return fs.st_size ? ERR_FILE_STAT : ERR_FILE_FORMAT;
+    }
+    pMap->pData = (PBYTE) malloc( fs.st_size );
+    if ( !pMap->pData ) {
+        _FILE_CLOSE( pf );
+        free( pMap );
+        return ERR_MEMORY;
+    }
+    if ( _FILE_READ( pf, pMap->pData, fs.st_size ) != (size_t) fs.st_size ) {
+        _FILE_CLOSE( pf );
+        free( pMap->pData );
+        free( pMap );
+        return ERR_FILE_READ;
+    }
+    _FILE_CLOSE( pf );
+    pMap->cbData = fs.st_size;
+    StatFileID( &fs, &(pMap->id) );
+    *ppMap = pMap;
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * OS2ReleaseFileMap                                                         *
+ *                                                                           *
+ * Drops a reference to a file map created by OS2MapFile(), unmapping (or    *
+ * freeing) the file contents once the last reference has been released.     *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FILEMAP pMap: The file map to release.                         (IO) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void OS2ReleaseFileMap( POS2FILEMAP pMap )
+{
+    if ( !pMap || --pMap->cRefs ) return;
+#ifdef HAVE_MMAP
+    if ( pMap->fMapped )
+        munmap( pMap->pData, pMap->cbData );
+    else
+#endif
+        free( pMap->pData );
+    free( pMap );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * ObjectCacheBudget                                                         *
+ *                                                                           *
+ * Returns the current object cache budget (see SetOS2ObjectCacheBudget),    *
+ * reading it under the cache lock since another thread may be changing it.  *
+ *                                                                           *
+ * ARGUMENTS: N/A                                                            *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The budget in bytes; 0 if the object cache is disabled.                 *
+ * ------------------------------------------------------------------------- */
+ULONG ObjectCacheBudget( void )
+{
+    ULONG cbBudget;
+
+    _OBJCACHE_LOCK();
+    cbBudget = object_cache.stats.cbBudget;
+    _OBJCACHE_UNLOCK();
+    return cbBudget;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * OpenOS2FontCatalog                                                        *
+ *                                                                           *
+ * Opens a font catalog: a record of the faces in a set of font files,       *
+ * which is kept in an index file so that it need not be rebuilt each time.  *
+ * If the index file exists it is loaded; otherwise (or if it is not a       *
+ * valid index of the current format) the catalog starts out empty.          *
+ *                                                                           *
+ * Files are added to the catalog, or brought up to date, with               *
+ * UpdateOS2FontCatalog(); files which no longer exist may be dropped with   *
+ * PruneOS2FontCatalog(); and the changes are written back to the index with *
+ * SaveOS2FontCatalog().  The catalog can be queried with                    *
+ * QueryOS2FontCatalog() without opening any of its files.  It must be       *
+ * closed with CloseOS2FontCatalog() when no longer needed.                  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PSZ              pszIndexFile: Name of the index file.              (I) *
+ *   POS2FONTCATALOG *ppCatalog   : Pointer to the returned catalog.     (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_MEMORY otherwise (in which case ppCatalog is          *
+ *   unchanged).                                                             *
+ * ------------------------------------------------------------------------- */
+ULONG OpenOS2FontCatalog( PSZ pszIndexFile, POS2FONTCATALOG *ppCatalog )
+{
+    POS2FONTCATALOG pCatalog;
+    CATALOGHEADER   hdr;            // index file header
+    CATALOGFILEREC  rec;            // current file record
+    PCATALOGFILE    pFile;
+    POS2FILEMAP     pMap;
+    PBYTE           pRecs,          // file records in the index
+                    pFaces;         // face records in the index
+    PSZ             pszNames;       // filenames in the index
+    ULONG           cFaces = 0,     // number of face records loaded
+                    ulRC = 0,
+                    i, j;
+
+
+    pCatalog = (POS2FONTCATALOG) calloc( 1, sizeof( OS2FONTCATALOG ));
+    if ( !pCatalog ) return ERR_MEMORY;
+    pCatalog->pszIndex = strdup( pszIndexFile );
+    if ( !pCatalog->pszIndex ) {
+        free( pCatalog );
+        return ERR_MEMORY;
+    }
+    pCatalog->fChanged = TRUE;
+
+    // Load the index file, if there is a valid one
+    if ( OS2MapFile( pszIndexFile, &pMap ) != 0 ) {
+        *ppCatalog = pCatalog;
+        return 0;
+    }
+    if ( pMap->cbData < sizeof( hdr )) goto done;
+    memcpy( &hdr, pMap->pData, sizeof( hdr ));
+    if ( memcmp( hdr.achMagic, CATALOG_MAGIC, sizeof( CATALOG_MAGIC )) ||
+         ( hdr.ulVersion != CATALOG_VERSION ) ||
+         ( hdr.cbFace != sizeof( OS2CATALOGFACE )) ||
+         (( sizeof( hdr ) + ( (uint64_t) hdr.cFiles * sizeof( CATALOGFILEREC )) +
+            ( (uint64_t) hdr.cFaces * sizeof( OS2CATALOGFACE )) + hdr.cbNames ) != pMap->cbData ))
+        goto done;
+    pRecs    = pMap->pData + sizeof( hdr );
+    pFaces   = pRecs + ( hdr.cFiles * sizeof( CATALOGFILEREC ));
+    pszNames = (PSZ)( pFaces + ( hdr.cFaces * sizeof( OS2CATALOGFACE )));
+    if ( hdr.cbNames && pszNames[ hdr.cbNames - 1 ] ) goto done;
+    if ( !hdr.cFiles ) {
+        pCatalog->fChanged = FALSE;
+        goto done;
+    }
+
+    pCatalog->paFiles = (PCATALOGFILE) calloc( hdr.cFiles, sizeof( CATALOGFILE ));
+    if ( !pCatalog->paFiles ) {
+        ulRC = ERR_MEMORY;
+        goto done;
+    }
+    pCatalog->cAlloc = hdr.cFiles;
+    for ( i = 0; i < hdr.cFiles; i++ ) {
+        memcpy( &rec, pRecs + ( i * sizeof( rec )), sizeof( rec ));
+        if (( rec.ofName >= hdr.cbNames ) || ( rec.cFaces > ( hdr.cFaces - cFaces )) ||
+            ( i && ( strcmp( pszNames + rec.ofName, pCatalog->paFiles[ i - 1 ].pszPath ) <= 0 )))
+            break;
+        pFile = pCatalog->paFiles + i;
+        pFile->pszPath  = strdup( pszNames + rec.ofName );
+        pFile->ullMTime = rec.ullMTime;
+        pFile->ullSize  = rec.ullSize;
+        if ( rec.cFaces ) {
+            pFile->paFaces = (POS2CATALOGFACE) malloc( rec.cFaces * sizeof( OS2CATALOGFACE ));
+            if ( pFile->paFaces ) {
+                memcpy( pFile->paFaces, pFaces + ( cFaces * sizeof( OS2CATALOGFACE )),
+                        rec.cFaces * sizeof( OS2CATALOGFACE ));
+                for ( j = 0; j < rec.cFaces; j++ ) {
+                    pFile->paFaces[ j ].szFamilyname[ sizeof( pFile->paFaces[ j ].szFamilyname ) - 1 ] = 0;
+                    pFile->paFaces[ j ].szFacename[ sizeof( pFile->paFaces[ j ].szFacename ) - 1 ]     = 0;
+                }
+            }
+        }
+        pCatalog->cFiles++;
+        if ( !pFile->pszPath || ( rec.cFaces && !pFile->paFaces )) {
+            ulRC = ERR_MEMORY;
+            break;
+        }
+        pFile->cFaces = rec.cFaces;
+        cFaces += rec.cFaces;
+    }
+
+    // Start afresh if the index turned out not to be valid after all
+    if (( i < hdr.cFiles ) || ( cFaces != hdr.cFaces )) {
+        for ( i = 0; i < pCatalog->cFiles; i++ ) {
+            free( pCatalog->paFiles[ i ].pszPath );
+            free( pCatalog->paFiles[ i ].paFaces );
+        }
+        pCatalog->cFiles = 0;
+    }
+    else pCatalog->fChanged = FALSE;
+
+done:
+    OS2ReleaseFileMap( pMap );
+    if ( ulRC != 0 ) {
+        CloseOS2FontCatalog( pCatalog );
+        return ulRC;
+    }
+    *ppCatalog = pCatalog;
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * OpenOS2FontModule                                                         *
+ *                                                                           *
+ * Opens a font file (which may be a plain FNT file, or an LX-format or      *
+ * NE-format font module) and indexes the font faces it contains.  The file  *
+ * is memory-mapped where supported.  For modules, the font directory (if    *
+ * any) is read once, and each face is resolved to its resource-table entry; *
+ * otherwise each OS2RES_FONTFACE resource is taken as one face, in order.   *
+ *                                                                           *
+ * Faces may then be retrieved in any order with GetOS2FontModuleFace().     *
+ * The module must be closed with CloseOS2FontModule() when no longer        *
+ * needed.                                                                   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PSZ             pszFile : Fully-qualified name of the font file.    (I) *
+ *   POS2FONTMODULE *ppModule: Pointer to the returned module handle.    (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_* otherwise (in which case ppModule is unchanged).    *
+ * ------------------------------------------------------------------------- */
+ULONG OpenOS2FontModule( PSZ pszFile, POS2FONTMODULE *ppModule )
+{
+    POS2FONTMODULE pModule;
+    POS2FILEMAP    pMap;
+    LXHEADER      *plx_hd;      // executable header
+    LXRTENTRY     *prtes;       // resource table
+    PLXRESKEY      paIndex;     // resource index
+    ULONG          ulAddr,      // address of the new-style EXE header
+                   ulRC,
+                   i, j;
+    USHORT         usMagic;     // 2-byte magic number
+
+
+    paIndex = NULL;
+    ulRC = OS2MapFile( pszFile, &pMap );
+    if ( ulRC != 0 ) return ulRC;
+
+    pModule = (POS2FONTMODULE) calloc( 1, sizeof( OS2FONTMODULE ));
+    if ( !pModule ) {
+        OS2ReleaseFileMap( pMap );
+        return ERR_MEMORY;
+    }
+    pModule->pMap  = pMap;
+    pModule->cRefs = 1;
+    ulRC = ERR_FILE_FORMAT;
+
+    if ( pMap->cbData < sizeof( GENERICRECORD )) goto fail;
+    usMagic = WORDFROMBYTES( pMap->pData[ 0 ], pMap->pData[ 1 ] );
+
+    if ( usMagic == MAGIC_MZ ) {
+        // Locate the new-type executable header
+        if (( EH_OFFSET_ADDRESS + 4 ) > pMap->cbData ) goto fail;
+        memcpy( &ulAddr, pMap->pData + EH_OFFSET_ADDRESS, 4 );
+        if (( ulAddr + 2 ) > pMap->cbData ) goto fail;
+        usMagic = WORDFROMBYTES( pMap->pData[ ulAddr ], pMap->pData[ ulAddr + 1 ] );
+    }
+    else if (( usMagic == MAGIC_LX ) || ( usMagic == MAGIC_NE )) {
+        // No stub header
+        ulAddr = 0;
+    }
+    else {
+        // Not a compiled (exe) font module, so treat it as a raw font file
+        if ((( PGENERICRECORD ) pMap->pData )->Identity != SIG_OS2FONTSTART )
+            goto fail;
+        pModule->cFaces = 1;
+        *ppModule = pModule;
+        return 0;
+    }
+    if (( usMagic != MAGIC_LX ) && ( usMagic != MAGIC_NE )) goto fail;
+
+    pModule->usMagic = usMagic;
+    pModule->ulBase  = ulAddr;
+    if ( usMagic == MAGIC_NE ) {
+        ulRC = NEIndexFaces( pModule );
+        if ( ulRC != 0 ) goto fail;
+        *ppModule = pModule;
+        return 0;
+    }
+    if (( ulAddr + sizeof( LXHEADER )) > pMap->cbData ) goto fail;
+    plx_hd = (LXHEADER *)( pMap->pData + ulAddr );
+    if ( !plx_hd->cres ) goto fail;
+    if (( ulAddr + plx_hd->res_tbl + ( plx_hd->cres * sizeof( LXRTENTRY ))) > pMap->cbData )
+        goto fail;
+    prtes = (LXRTENTRY *)( pMap->pData + ulAddr + plx_hd->res_tbl );
+
+    ulRC = ERR_MEMORY;
+    pModule->cObjects   = plx_hd->objcnt;
+    pModule->papObjects   = (PBYTE *) calloc( plx_hd->objcnt + 1, sizeof( PBYTE ));
+    pModule->papPagesDone = (PBYTE *) calloc( plx_hd->objcnt + 1, sizeof( PBYTE ));
+    pModule->paulFaceRes  = (PULONG) calloc( plx_hd->cres, sizeof( ULONG ));
+    paIndex = LXIndexResources( prtes, plx_hd->cres );
+    if ( !pModule->papObjects || !pModule->papPagesDone || !pModule->paulFaceRes || !paIndex )
+        goto fail;
+
+    // Use the font directory, if there is one, to find each face's resource
+    i = LXLookupResource( paIndex, plx_hd->cres, OS2RES_FONTDIR, 0 );
+    if (( i < plx_hd->cres ) && ( paIndex[ i ].usType == OS2RES_FONTDIR )) {
+        POS2FONTDIRECTORY pFD;
+        LXRTENTRY        *plx_rte;
+        PBYTE             pRes;
+        BOOL              fCopied;
+        ULONG             cFaces;
+
+        plx_rte = prtes + paIndex[ i ].ulEntry;
+        if (( plx_rte->cb < 6 ) ||
+            !LXMapResource( pMap, ulAddr, plx_rte, &pRes, &fCopied )) {
+            ulRC = ERR_FILE_READ;
+            goto fail;
+        }
+        pFD = (POS2FONTDIRECTORY) pRes;
+        cFaces = pFD->usnFonts;
+        if (( 6 + ( cFaces * sizeof( OS2FONTDIRENTRY ))) > plx_rte->cb )
+            cFaces = ( plx_rte->cb - 6 ) / sizeof( OS2FONTDIRENTRY );
+        if ( cFaces > plx_hd->cres ) {
+            PULONG paul = (PULONG) realloc( pModule->paulFaceRes, cFaces * sizeof( ULONG ));
+            if ( !paul ) {
+                if ( fCopied ) free( pRes );
+                goto fail;
+            }
+            pModule->paulFaceRes = paul;
+        }
+        for ( j = 0; j < cFaces; j++ )
+            pModule->paulFaceRes[ j ] = LXFindFontFace( paIndex, plx_hd->cres,
+                                                        pFD->fntEntry[ j ].usIndex );
+        pModule->cFaces = cFaces;
+        if ( fCopied ) free( pRes );
+    }
+    else {
+        // No font directory, so just use the font resources in order
+        for ( i = 0; i < plx_hd->cres; i++ ) {
+            if ( prtes[ i ].type == OS2RES_FONTFACE )
+                pModule->paulFaceRes[ pModule->cFaces++ ] = i;
+        }
+    }
+    free( paIndex );
+    *ppModule = pModule;
+    return 0;
+
+fail:
+    free( paIndex );
+    CloseOS2FontModule( pModule );
+    return ulRC;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * PackOS2ObjectPage                                                         *
+ *                                                                           *
+ * Compresses a page of an LX object using the EXEPACK1 or EXEPACK2 method,  *
+ * so that it can be written to a module with the OP32_ITERDATA or           *
+ * OP32_ITERDATA2 page flag respectively.  Each page is packed on its own,   *
+ * so an object can be written out a page at a time as it is produced.  By   *
+ * default a fast, greedy encoder is used; with OS2PACK_BEST, a much slower  *
+ * one which searches for the smallest encoding (and never does worse than   *
+ * the fast one).  The result is not necessarily smaller than the page: the  *
+ * caller should store the page unpacked unless it is.                       *
+ *                                                                           *
+ * Only the last page of an object may be shorter than 4096 bytes, since     *
+ * the loader treats every packed page as a full page (padded with zeros).   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pPage   : The page data.                                      (I) *
+ *   ULONG cbPage  : Size of the page data (1-4096 bytes).               (I) *
+ *   ULONG ulMethod: OS2PACK_EXEPACK1 or OS2PACK_EXEPACK2, optionally        *
+ *                   combined with OS2PACK_BEST.                         (I) *
+ *   PBYTE pOut    : Buffer for the packed data (4096 bytes).            (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The size of the packed data, or 0 if it would not fit in a page or the  *
+ *   arguments are invalid.                                                  *
+ * ------------------------------------------------------------------------- */
+ULONG PackOS2ObjectPage( PBYTE pPage, ULONG cbPage, ULONG ulMethod, PBYTE pOut )
+{
+    PLXPACKWORK pWork;
+    ULONG       cb,
+                cbFast;
+
+    if ( !pPage || !pOut || !cbPage || ( cbPage > LX_PAGE_SIZE )) return 0;
+    if ((( ulMethod & ~OS2PACK_BEST ) != OS2PACK_EXEPACK1 ) &&
+        (( ulMethod & ~OS2PACK_BEST ) != OS2PACK_EXEPACK2 ))
+        return 0;
+
+    /* The best-ratio encoders' search limits occasionally make them miss
+     * what the fast ones find, so the smaller result of the two is used.
+     * If the working storage can't be had, settle for the fast encoder.
+     */
+    if (( ulMethod & OS2PACK_BEST ) &&
+        (( pWork = (PLXPACKWORK) malloc( sizeof( LXPACKWORK ))) != NULL ))
+    {
+        if ( ulMethod & OS2PACK_EXEPACK1 ) {
+            cb     = LXPack1Best( pPage, cbPage, pWork, pOut );
+            cbFast = LXPack1Fast( pPage, cbPage, pWork->abFast );
+        }
+        else {
+            cb     = LXPack2Best( pPage, cbPage, pWork, pOut );
+            cbFast = LXPack2Fast( pPage, cbPage, pWork->abFast );
+        }
+        if ( cbFast && ( !cb || ( cbFast < cb ))) {
+            memcpy( pOut, pWork->abFast, cbFast );
+            cb = cbFast;
+        }
+        free( pWork );
+        return cb;
+    }
+    if ( ulMethod & OS2PACK_EXEPACK1 )
+        return LXPack1Fast( pPage, cbPage, pOut );
+    return LXPack2Fast( pPage, cbPage, pOut );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * ParseOS2FontResource                                                      *
+ *                                                                           *
+ * Parses a standard GPI-format OS/2 font resource.  Takes as input an       *
+ * already-populated memory buffer containing the raw font resource data.    *
+ * On successful return, the fields within the OS2FONTRESOURCE structure     *
+ * will point to the appropriate structures within the font file data.       *
+ *                                                                           *
+ * NOTE: Even if this function returns success, the pPanose, pKerning and    *
+ * pEnd fields of the pFont structure may be NULL.  The application must     *
+ * check for this if it intends to use these fields.                         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PVOID            pBuffer : Buffer containing the font resource data.(I) *
+ *   ULONG            cbBuffer: Size of pBuffer in bytes.                (I) *
+ *   POS2FONTRESOURCE pFont   : Pointer to an OS2FONTRESOURCE structure      *
+ *                              which will receive the parsed font data. (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success or ERR_* on error                                          *
+ * ------------------------------------------------------------------------- */
+ULONG ParseOS2FontResource( PVOID pBuffer, ULONG cbBuffer, POS2FONTRESOURCE pFont )
+{
+    PGENERICRECORD pRecord;
+
+    // Verify the file format
+    pRecord = (PGENERICRECORD) pBuffer;
+    if ( ( pRecord->Identity != SIG_OS2FONTSTART ) ||
+         ( pRecord->ulSize != sizeof( OS2FONTSTART )))
+        return ERR_FILE_FORMAT;
+
+    // Now set the pointers in our font type to the correct offsets
+    pFont->pSignature = (POS2FONTSTART) pBuffer;
+    pFont->pMetrics   = (POS2FOCAMETRICS)( (PBYTE) pBuffer + sizeof( OS2FONTSTART ));
+    pFont->pKerning   = NULL;
+    pFont->pPanose    = NULL;
+    pFont->pEnd       = NULL;
+    pFont->ulStorage  = OS2FONT_STORE_HEAP;
+    pFont->pStorage   = NULL;
+    pFont->pAtlas     = NULL;
+    pFont->pKernIndex = NULL;
+    pRecord           = (PGENERICRECORD)( (PBYTE)pFont->pMetrics + pFont->pMetrics->ulSize );
+    if ( pRecord->Identity != SIG_OS2FONTDEF ) {
+        return ERR_FILE_FORMAT;
+    }
+    pFont->pFontDef  = (POS2FONTDEFHEADER) pRecord;
+    if ( pFont->pFontDef->fsChardef == OS2FONTDEF_CHAR3 ) {
+        pFont->data.pABC = (POS2CHARDEF3)( (PBYTE) pRecord + sizeof( OS2FONTDEFHEADER ));
+    }
+    else {
+        pFont->data.pChars = (POS2CHARDEF1)( (PBYTE) pRecord + sizeof( OS2FONTDEFHEADER ));
+    }
+    pRecord = (PGENERICRECORD)( (PBYTE) pRecord + pFont->pFontDef->ulSize );
+
+    if ( pFont->pMetrics->usKerningPairs  && ( pRecord->Identity == SIG_OS2KERN )) {
+        pFont->pKerning = (POS2KERNPAIRTABLE) pRecord;
+        // Index the pairs for lookup; if this fails the font is left unkerned
+        BuildKerningIndex( pFont, (PBYTE) pBuffer + cbBuffer );
+        /* Advance to the next record (whether OS2ADDMETRICS or OS2FONTEND).
+         * This is a guess; since the actual format, and thus size, of the
+         * kerning information is unclear (see remarks in gpifont.h), there is
+         * no guarantee this will work.  Fortunately, we've already parsed the
+         * important stuff.
+         */
+        pRecord = (PGENERICRECORD)
+                     ( (PBYTE)pRecord + sizeof( OS2KERNPAIRTABLE ) +
+                       ( pFont->pMetrics->usKerningPairs * sizeof ( OS2KERNINGPAIRS )));
+    }
+    // The remaining records are optional, so stop at the end of the buffer
+    if ( (PBYTE) pRecord + sizeof( GENERICRECORD ) > (PBYTE) pBuffer + cbBuffer )
+        goto done;
+    if ( pRecord->Identity == SIG_OS2ADDMETRICS ) {
+        pFont->pPanose = (POS2ADDMETRICS) pRecord;
+        pRecord = (PGENERICRECORD)( (PBYTE)pRecord + pRecord->ulSize );
+    }
+
+    /* We set the pointer to the end signature, but there's really no need to
+     * use it for anything.  We check the Identity field to make sure it's
+     * valid (if we did miscalculate the kern table size above, then it could
+     * well be wrong) before setting the pointer.
+     */
+    if ((( (PBYTE) pRecord + sizeof( GENERICRECORD )) <= (PBYTE) pBuffer + cbBuffer ) &&
+        ( pRecord->Identity == SIG_OS2FONTEND ))
+        pFont->pEnd = (POS2FONTEND) pRecord;
+
+done:
+    pFont->cbSize = cbBuffer;
+    SetUGLCoverage( pFont );
+    SetFixedAdvance( pFont );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * PinOS2CachedGlyphs                                                        *
+ *                                                                           *
+ * Adds a range of glyphs to a glyph cache (where not already there) and     *
+ * pins them, so that they are never evicted.  Pinned glyphs still count     *
+ * towards the cache's memory budget; if they use up all of it, every other  *
+ * glyph is evicted as soon as the next one is added.  They remain until the *
+ * font is purged from the cache (see PurgeOS2GlyphCache).                   *
+ *                                                                           *
+ * This is intended for character groups which the font marks as frequently  *
+ * used, as Uni-fonts do with the UNIFONT_FREQUENT_GROUP flag (in which case *
+ * this should be called for each such UNICHARGROUPENTRY).                   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2GLYPHCACHE   pCache : The glyph cache.                         (IO) *
+ *   ULONG            ulFirst: First glyph index of the range.           (I) *
+ *   ULONG            ulLast : Last glyph index of the range.            (I) *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The number of glyphs in the range which are now pinned.                 *
+ * ------------------------------------------------------------------------- */
+ULONG PinOS2CachedGlyphs( POS2GLYPHCACHE pCache, ULONG ulFirst, ULONG ulLast, POS2FONTRESOURCE pFont )
+{
+    PGLYPHCACHEENTRY pEntry;
+    ULONG            cPinned = 0,
+                     i;
+
+
+    _CACHE_WRITE( pCache );
+    for ( i = ulFirst; i && ( i <= ulLast ); i++ ) {
+        pEntry = FindCachedGlyph( pCache, i, pFont );
+        if ( !pEntry ) {
+            pEntry = NewCachedGlyph( i, pFont );
+            if ( !pEntry ) continue;
+            pEntry->fPinned = TRUE;
+            InsertCachedGlyph( pCache, pEntry );
+        }
+        else if ( !pEntry->fPinned ) {
+            // Take it out of the ring
+            if ( pEntry->pRingNext == pEntry )
+                pCache->pHand = NULL;
+            else {
+                if ( pCache->pHand == pEntry ) pCache->pHand = pEntry->pRingNext;
+                pEntry->pRingPrev->pRingNext = pEntry->pRingNext;
+                pEntry->pRingNext->pRingPrev = pEntry->pRingPrev;
+            }
+            pEntry->fPinned = TRUE;
+            pCache->stats.cPinned++;
+        }
+        cPinned++;
+        if ( i == 0xFFFFFFFF ) break;
+    }
+    _CACHE_UNLOCK( pCache );
+    return cPinned;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * PruneOS2FontCatalog                                                       *
+ *                                                                           *
+ * Removes from a font catalog every file which has not been passed to       *
+ * UpdateOS2FontCatalog() since the catalog was opened.  After a rescan has  *
+ * updated every file which still exists, this drops those which are gone.   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTCATALOG pCatalog: The font catalog.                        (IO) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The number of files removed.                                            *
+ * ------------------------------------------------------------------------- */
+ULONG PruneOS2FontCatalog( POS2FONTCATALOG pCatalog )
+{
+    PCATALOGFILE pFile;
+    ULONG        cKept = 0,
+                 cRemoved,
+                 i;
+
+    for ( i = 0; i < pCatalog->cFiles; i++ ) {
+        pFile = pCatalog->paFiles + i;
+        if ( pFile->fSeen )
+            pCatalog->paFiles[ cKept++ ] = *pFile;
+        else {
+            free( pFile->pszPath );
+            free( pFile->paFaces );
+        }
+    }
+    cRemoved = pCatalog->cFiles - cKept;
+    pCatalog->cFiles = cKept;
+    pCatalog->stats.cRemoved += cRemoved;
+    if ( cRemoved ) pCatalog->fChanged = TRUE;
+    return cRemoved;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * PurgeOS2GlyphCache                                                        *
+ *                                                                           *
+ * Removes every glyph belonging to the given font (pinned or not) from a    *
+ * glyph cache, or every glyph in the cache if no font is given.  A font     *
+ * which has been used with a cache must be purged from it before the font   *
+ * is freed.  Glyphs which are still in use are freed once released.         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2GLYPHCACHE   pCache: The glyph cache.                          (IO) *
+ *   POS2FONTRESOURCE pFont : The font to purge, or NULL for all fonts.  (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void PurgeOS2GlyphCache( POS2GLYPHCACHE pCache, POS2FONTRESOURCE pFont )
+{
+    PGLYPHCACHEENTRY pEntry,
+                     pNext;
+    ULONG            i;
+
+
+    _CACHE_WRITE( pCache );
+    for ( i = 0; i < pCache->cBuckets; i++ ) {
+        for ( pEntry = pCache->papBuckets[ i ]; pEntry; pEntry = pNext ) {
+            pNext = pEntry->pNext;
+            if ( !pFont || ( pEntry->pFont == pFont ))
+                RemoveCachedGlyph( pCache, pEntry );
+        }
+    }
+    _CACHE_UNLOCK( pCache );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * QueryOS2ExtractStats                                                      *
+ *                                                                           *
+ * Returns the accumulated statistics about resource extraction from LX      *
+ * modules, optionally resetting them.                                       *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2EXTRACTSTATS pStats: Structure to receive the statistics.       (O) *
+ *   BOOL             fReset: Reset the statistics afterwards?           (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void QueryOS2ExtractStats( POS2EXTRACTSTATS pStats, BOOL fReset )
+{
+    if ( pStats ) *pStats = extract_stats;
+    if ( fReset ) memset( &extract_stats, 0, sizeof( extract_stats ));
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * QueryOS2FontCatalog                                                       *
+ *                                                                           *
+ * Finds the faces in a font catalog which cover the given character,        *
+ * optionally at a given point size, using only the catalog records.  A      *
+ * face covers a character if OS2FontGlyphIndex() would map it to a glyph    *
+ * which the face contains.  Faces are returned in order of filename, and    *
+ * then face number.                                                         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTCATALOG  pCatalog   : The font catalog.                     (I) *
+ *   ULONG            ulChar     : Unicode codepoint requested.          (I) *
+ *   ULONG            ulPointSize: Nominal point size * 10 (as in the        *
+ *                                 font metrics), or 0 for any size.     (I) *
+ *   POS2CATALOGMATCH paMatches  : Array to receive the faces found.     (O) *
+ *   ULONG            cMax       : Number of entries in paMatches.       (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The number of faces found.  This may be more than cMax, in which case   *
+ *   only the first cMax are returned.                                       *
+ * ------------------------------------------------------------------------- */
+ULONG QueryOS2FontCatalog( POS2FONTCATALOG pCatalog, ULONG ulChar, ULONG ulPointSize, POS2CATALOGMATCH paMatches, ULONG cMax )
+{
+    PCATALOGFILE    pFile;
+    POS2CATALOGFACE pFace;
+    ULONG           ulUGL,          // UGL glyph index of the character
+                    ulIndex,        // glyph index in the current face
+                    n = 0,          // number of faces found
+                    i, j;
+
+
+    // ASCII needs no translation, and nothing outside the BMP is in UGL
+    if (( ulChar >= 32 ) && ( ulChar <= 126 )) ulUGL = ulChar;
+    else if ( ulChar > 0xFFFF )                ulUGL = 0;
+    else                                       ulUGL = UNI2UGL( ulChar );
+
+    for ( i = 0; i < pCatalog->cFiles; i++ ) {
+        pFile = pCatalog->paFiles + i;
+        for ( j = 0; j < pFile->cFaces; j++ ) {
+            pFace = pFile->paFaces + j;
+            if ( ulPointSize && ( pFace->usPointSize != ulPointSize )) continue;
+            ulIndex = pFace->fUGL ? ulUGL : ulChar;
+            if ( !ulIndex || ( ulIndex >= ( OS2FONT_COVERAGE_SIZE * 8 )) ||
+                 !( pFace->abCoverage[ ulIndex >> 3 ] & ( 1 << ( ulIndex & 7 ))))
+                continue;
+            if ( n < cMax ) {
+                paMatches[ n ].pszFile = pFile->pszPath;
+                paMatches[ n ].pFace   = pFace;
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * QueryOS2FontCatalogStats                                                  *
+ *                                                                           *
+ * Gets the size of a font catalog, and the number of files which have been  *
+ * parsed, found unchanged, or pruned since it was opened.                   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTCATALOG  pCatalog: The font catalog.                        (I) *
+ *   POS2CATALOGSTATS pStats  : Pointer to the returned statistics.      (O) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void QueryOS2FontCatalogStats( POS2FONTCATALOG pCatalog, POS2CATALOGSTATS pStats )
+{
+    ULONG i;
+
+    *pStats = pCatalog->stats;
+    pStats->cFiles = pCatalog->cFiles;
+    pStats->cFaces = 0;
+    for ( i = 0; i < pCatalog->cFiles; i++ )
+        pStats->cFaces += pCatalog->paFiles[ i ].cFaces;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * QueryOS2FontModuleFaces                                                   *
+ *                                                                           *
+ * Returns the number of font faces in an opened font module.                *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTMODULE pModule: The opened font module.                     (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The number of faces which GetOS2FontModuleFace() can retrieve.          *
+ * ------------------------------------------------------------------------- */
+ULONG QueryOS2FontModuleFaces( POS2FONTMODULE pModule )
+{
+    return pModule ? pModule->cFaces : 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * QueryOS2GlyphAtlasSize                                                    *
+ *                                                                           *
+ * Returns the total amount of memory taken up by the font's glyph atlas     *
+ * (see BuildOS2GlyphAtlas) or, if it does not have one, how much would be   *
+ * taken up by building it.                                                  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont: Pointer to the font resource data.          (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The size of the glyph atlas in bytes.                                   *
+ * ------------------------------------------------------------------------- */
+ULONG QueryOS2GlyphAtlasSize( POS2FONTRESOURCE pFont )
+{
+    if ( pFont->pAtlas ) return pFont->pAtlas->cbTotal;
+    if ( pFont->pMetrics->usLastChar < 0 ) return 0;
+    return sizeof( OS2GLYPHATLAS ) +
+           (( pFont->pMetrics->usLastChar + 1 ) * sizeof( OS2ATLASGLYPH )) +
+           ( OS2ATLAS_ALIGN - 1 ) + LayoutGlyphAtlas( pFont, NULL );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * QueryOS2GlyphCacheStats                                                   *
+ *                                                                           *
+ * Returns the statistics of a glyph cache, optionally resetting the hit,    *
+ * miss and eviction counters.                                               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2GLYPHCACHE      pCache: The glyph cache.                       (IO) *
+ *   POS2GLYPHCACHESTATS pStats: Structure to receive the statistics.    (O) *
+ *   BOOL                fReset: Reset the counters afterwards?          (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void QueryOS2GlyphCacheStats( POS2GLYPHCACHE pCache, POS2GLYPHCACHESTATS pStats, BOOL fReset )
+{
+    _CACHE_WRITE( pCache );
+    *pStats = pCache->stats;
+    if ( fReset ) {
+        pCache->stats.ulHits      = 0;
+        pCache->stats.ulMisses    = 0;
+        pCache->stats.ulEvictions = 0;
+    }
+    _CACHE_UNLOCK( pCache );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * QueryOS2ObjectCacheStats                                                  *
+ *                                                                           *
+ * Returns the statistics of the object cache (see SetOS2ObjectCacheBudget), *
+ * optionally resetting the hit, miss and eviction counters.                 *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2OBJECTCACHESTATS pStats: Structure to receive the statistics.   (O) *
+ *   BOOL                 fReset: Reset the counters afterwards?         (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void QueryOS2ObjectCacheStats( POS2OBJECTCACHESTATS pStats, BOOL fReset )
+{
+    _OBJCACHE_LOCK();
+    if ( pStats ) *pStats = object_cache.stats;
+    if ( fReset ) {
+        object_cache.stats.ulHits      = 0;
+        object_cache.stats.ulMisses    = 0;
+        object_cache.stats.ulEvictions = 0;
+    }
+    _OBJCACHE_UNLOCK();
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * QueryOS2UnpackThreads                                                     *
+ *                                                                           *
+ * Returns the number of threads currently used to unpack the compressed     *
+ * pages of LX-format modules (see SetOS2UnpackThreads).                     *
+ *                                                                           *
+ * ARGUMENTS: N/A                                                            *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The number of unpacking threads, including the calling thread.          *
+ * ------------------------------------------------------------------------- */
+ULONG QueryOS2UnpackThreads( void )
+{
+    return unpack_threads;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * ReadOS2FNTFile                                                            *
+ *                                                                           *
+ * Opens, reads, and parses a standard GPI-format OS/2 font from a FNT file  *
+ * (as produced by the Font Editor).  It does NOT read compiled fonts        *
+ * (FON/DLL or EXE resources), which are handled by ReadOS2FontResource().   *
+ *                                                                           *
+ * On successful return, the font contents will be read into the unformatted *
+ * buffer pointed to by ppBuffer, which is allocated by this function.  This *
+ * buffer should then be passed to ParseOS2FontResource(), and will be       *
+ * retained in the resulting OS2FONTRESOURCE structure.                      *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   FILE  *pf      : Handle to the already-opened file.                 (I) *
+ *   PBYTE *ppBuffer: Pointer to the buffer which will be created.       (O) *
+ *   PULONG pulSize : Pointer to the created buffer size.                (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, in which case ppBuffer will point to the read file        *
+ *   contents.  ERR_* on failure (in which case ppBuffer will be unchanged). *
+ * ------------------------------------------------------------------------- */
+ULONG ReadOS2FNTFile( FILE *pf, PBYTE *ppBuffer, PULONG pulSize )
+{
+    struct stat   fs = {0};    // file information structure
+    size_t        cbRead;
+    ULONG         ulRC;           // return code variable
+    PBYTE         pBuf;           // raw buffer containing file contents
+    GENERICRECORD startrec;
+
+
+    // Get the file size
+    if ( _FILE_STAT( pf, &fs ))
+        return ERR_FILE_STAT;
+    if (( fs.st_size < sizeof( GENERICRECORD )) ||
+        ( ! _FILE_READ( pf, &startrec, sizeof( GENERICRECORD ))))
+        return ERR_FILE_FORMAT;
+    if ( _FILE_SEEK( pf, 0 ))
+        return ERR_FILE_READ;
+
+    if ( startrec.Identity != SIG_OS2FONTSTART )
+        return ERR_FILE_FORMAT;
+
+    // Allocate our read/write buffer using the file size
+    pBuf = (char *) calloc( fs.st_size, 1 );
+    if ( !pBuf )
+        return ERR_MEMORY;
+
+    /* Read the file contents into memory (this shouldn't be too expensive, as
+     * an average FNT file is only around 15-30 KB, and even the largest font
+     * shouldn't be more than about twice that).
+     */
+    cbRead = _FILE_READ( pf, pBuf, fs.st_size );
+    if ( !cbRead ) {
+        free( pBuf );
+        return ERR_FILE_READ;
+    }
+    *ppBuffer = pBuf;
+    *pulSize  = fs.st_size;
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * ReadOS2FontResource                                                       *
+ *                                                                           *
+ * Extracts and parses a font face from the specified file.  This requires   *
+ * reading the binary resources from an OS/2 executable (program or DLL).    *
+ *                                                                           *
+ * On successful return, the fields within the OS2FONTRESOURCE structure     *
+ * will point to the appropriate structures within the font file data.  The  *
+ * entire font is read into an allocated memory buffer which must be freed   *
+ * when no longer needed.  (The pSignature pointer within OS2FONTRESOURCE    *
+ * corresponds to the start of the buffer, and can be used as a reference to *
+ * the allocated buffer as a whole.)                                         *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PSZ              pszFile : Fully-qualified name of the font file.   (I) *
+ *   ULONG            ulFace  : Font (face) number within the file to        *
+ *                              retrieve (where 0 is the first font).    (I) *
+ *   PULONG           pulCount: Total number of faces found in file.     (O) *
+ *   POS2FONTRESOURCE pFont   : Pointer to an OS2FONTRESOURCE structure      *
+ *                              which will receive the parsed font data. (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 if the font was successfully read and parsed, ERR_* otherwise.        *
+ * ------------------------------------------------------------------------- */
+ULONG ReadOS2FontResource( PSZ pszFile, ULONG ulFace, PULONG pulCount, POS2FONTRESOURCE pFont )
+{
+    ULONG       ulAddr,         // address of the new-style EXE header
+                ulFaceCount,    // number of faces found
+                ulResID,        // target resource ID (when fontdir is used)
+                cbFont = 0,     // size of found font resource
+                cbInc,          // offset increment of current resource entry
+                i,
+                ulRC;
+    USHORT      usMagic,        // 2-byte magic number
+                cb_rte;         // size of a resource entry
+    BOOL        fFound;         // has the requested font been found?
+    PBYTE       pBuf;
+    FILE        *pf;
+
+#ifdef DEBUG_DUMP_RESOURCE
+    FILE *tf;
+#endif
+
+
+    ulRC        = ERR_NO_FONT;
+    fFound      = FALSE;
+    ulFaceCount = 0;
+    ulResID     = 0;
+    pBuf        = NULL;
+
+    // Open the file
+    if (( pf = _FILE_OPEN( pszFile )) == NULL )
+        return ERR_FILE_OPEN;
+
+    // See if it's an executable (EXE or DLL)
+    if ( ! _FILE_READ( pf, &usMagic, 2 )) goto read_fail;
+
+    if ( usMagic == MAGIC_MZ ) {
+        // Locate the new-type executable header
+        if ( _FILE_SEEK( pf, EH_OFFSET_ADDRESS )) goto read_fail;
+        if ( ! _FILE_READ( pf, &ulAddr, 4 ))      goto read_fail;
+        // Read the 2-byte magic number from this address
+        if ( _FILE_SEEK( pf, ulAddr ))            goto read_fail;
+        if ( ! _FILE_READ( pf, &usMagic, 2 ))     goto read_fail;
+        // Now back up to the start of the new-type header again
+        if ( _FILE_SEEK( pf, ulAddr ))            goto read_fail;
+    }
+    else if (( usMagic == MAGIC_LX ) || ( usMagic == MAGIC_NE )) {
+        // No stub header, just start at the beginning of the file
+        ulAddr = 0;
+        if ( _FILE_SEEK( pf, 0 )) goto read_fail;
+    }
+    else {
+        // Not a compiled (exe) font module
+        // (non-compiled fonts cannot contain more than one face)
+        if ( ulFace ) return ERR_NO_FONT;
+
+        // Try to read it as a raw font file and then return
+        if ( _FILE_SEEK( pf, 0 )) goto read_fail;
+        ulRC = ReadOS2FNTFile( pf, &pBuf, &cbFont );
+        if ( ulRC != 0 ) goto read_fail;
+        ulRC = ParseOS2FontResource( pBuf, cbFont, pFont );
+        if ( ulRC != 0 ) {
+            free( pBuf );
+            goto read_fail;
+        }
+        fFound = TRUE;
+        ulFaceCount = 1;
+        goto done;
+    }
+
+    // Identify the executable type and parse the resource data accordingly
+    if ( usMagic == MAGIC_LX )
+    {
+        LXTABLES   lxt;     // header, resource, object & page tables
+        LXRTENTRY *plx_rte; // resource table entry of the requested font
+        ULONG      ulRes;   // resource table entry number of the font
+
+        ulRC = LXReadTables( pf, ulAddr, &lxt );
+        if ( ulRC != 0 ) goto done;
+
+        // Make sure the file actually contains resources
+        if ( !lxt.lx_hd.cres ) {
+            ulRC = ERR_FILE_FORMAT;
+            goto lx_done;
+        }
+
+        /* If a font directory exists we use that to find the face's resource
+         * ID, as in this case it is not guaranteed to have a type of
+         * OS2RES_FONTFACE (7).  Both are found through the resource index.
+         */
+        ulRes = (ULONG) -1;
+        i = LXLookupResource( lxt.paIndex, lxt.lx_hd.cres, OS2RES_FONTDIR, 0 );
+        if (( i < lxt.lx_hd.cres ) && ( lxt.paIndex[ i ].usType == OS2RES_FONTDIR )) {
+            POS2FONTDIRECTORY pFD;
+
+            pBuf = NULL;
+            if ( !LXExtractResource( pf, &lxt, lxt.paResources + lxt.paIndex[ i ].ulEntry,
+                                     &pBuf, &cbFont ) || !pBuf ) {
+                ulRC = ERR_FILE_READ;
+                goto lx_done;
+            }
+#ifdef DEBUG_DUMP_RESOURCE
+            tf = fopen( tmpnam(NULL), "wb");
+            fwrite( pBuf, 1, cbFont, tf );
+            fclose( tf );
+#endif
+            pFD = (POS2FONTDIRECTORY) pBuf;
+            if ( cbFont < 6 ) {
+                free( pBuf );
+                ulRC = ERR_FILE_FORMAT;
+                goto lx_done;
+            }
+            ulFaceCount = pFD->usnFonts;
+            if (( ulFaceCount < ( ulFace + 1 )) ||
+                (( 6 + (( ulFace + 1 ) * sizeof( OS2FONTDIRENTRY ))) > cbFont )) {
+                free( pBuf );
+                ulRC = ERR_NO_FONT;
+                goto lx_done;
+            }
+            ulResID = pFD->fntEntry[ ulFace ].usIndex;
+            free( pBuf );
+            ulRes = LXFindFontFace( lxt.paIndex, lxt.lx_hd.cres, (USHORT) ulResID );
+        }
+        else {
+            // No font directory, so just use the font resources in order
+            for ( i = 0; i < lxt.lx_hd.cres; i++ ) {
+                if ( lxt.paResources[ i ].type != OS2RES_FONTFACE ) continue;
+                if ( ulFaceCount++ == ulFace ) ulRes = i;
+            }
+        }
+        if ( ulRes == (ULONG) -1 ) {
+            ulRC = ERR_NO_FONT;
+            goto lx_done;
+        }
+
+        /* Extract the font itself; the buffer contains exactly our font, and
+         * can be entrusted to the caller as it is.
+         */
+        plx_rte = lxt.paResources + ulRes;
+        pBuf = NULL;
+        if ( !LXExtractResource( pf, &lxt, plx_rte, &pBuf, &cbFont ) || !pBuf ) {
+            ulRC = ERR_FILE_READ;
+            goto lx_done;
+        }
+#ifdef DEBUG_DUMP_RESOURCE
+        tf = fopen( tmpnam(NULL), "wb");
+        fwrite( pBuf, 1, cbFont, tf );
+        fclose( tf );
+#endif
+        ulRC = ParseOS2FontResource( pBuf, cbFont, pFont );
+        if ( ulRC != 0 ) {
+            free( pBuf );
+            ulRC = ERR_FILE_READ;
+        }
+        else fFound = TRUE;
+lx_done:
+        LXFreeTables( &lxt );
+    }
+    else if ( usMagic == MAGIC_NE )
+    {
+        NEHEADER  ne_hd;   // executable header
+        NERTENTRY ne_rte;  // resource table entry
+        BOOL      fDir;    // has the font directory been read?
+
+        if ( ! _FILE_READ( pf, &ne_hd, sizeof( NEHEADER ))) goto read_fail;
+
+        // Make sure the file actually contains resources
+        if ( !ne_hd.cres || ( ne_hd.cres > ne_hd.cseg )) {
+            ulRC = ERR_FILE_FORMAT;
+            goto done;
+        }
+
+        // Now look for font resources
+        cb_rte = sizeof( NERTENTRY );
+        fDir   = FALSE;
+        for ( i = 0; i < ne_hd.cres; i++ ) {
+            cbInc = cb_rte * i;
+            if ( _FILE_SEEK( pf, ulAddr + ne_hd.res_tbl + cbInc )) goto read_fail;
+            if ( ! _FILE_READ( pf, &ne_rte, cb_rte ))              goto read_fail;
+
+            /* As for LX modules: once a font directory has been read, look
+             * for the resource it names; until then, count the font
+             * resources and take the ulFace'th one.
+             */
+            if ( fDir ) {
+                if (( ne_rte.etype == OS2RES_FONTDIR ) || ( ne_rte.ename != ulResID ))
+                    continue;
+            }
+            else if ( ne_rte.etype == OS2RES_FONTFACE ) {
+                ulFaceCount++;
+                if ( fFound || (( ulFaceCount - 1 ) != ulFace )) continue;
+            }
+            else if ( ne_rte.etype != OS2RES_FONTDIR )
+                continue;
+
+            pBuf = NULL;
+            if ( !NEExtractResource( pf, ne_hd, ulAddr, i, &pBuf, &cbFont ) || !pBuf )
+                goto read_fail;
+
+            if ( ne_rte.etype == OS2RES_FONTDIR ) {
+                POS2FONTDIRECTORY pFD = (POS2FONTDIRECTORY) pBuf;
+
+                if ( cbFont < 6 ) {
+                    free( pBuf );
+                    ulRC = ERR_FILE_FORMAT;
+                    goto done;
+                }
+                ulFaceCount = pFD->usnFonts;
+                if (( ulFaceCount < ( ulFace + 1 )) ||
+                    (( 6 + (( ulFace + 1 ) * sizeof( OS2FONTDIRENTRY ))) > cbFont )) {
+                    free( pBuf );
+                    ulRC = ERR_NO_FONT;
+                    goto done;
+                }
+                /* Look up the requested font's resource ID, then scan the
+                 * resource table again from the start (the font may come
+                 * before the directory).
+                 */
+                ulResID = pFD->fntEntry[ ulFace ].usIndex;
+                fDir    = TRUE;
+                free( pBuf );
+                if ( fFound ) {
+                    FreeOS2FontResource( pFont );
+                    fFound = FALSE;
+                }
+                i = (ULONG) -1;
+            }
+            else {
+                ulRC = ParseOS2FontResource( pBuf, cbFont, pFont );
+                if ( ulRC != 0 ) {
+                    free( pBuf );
+                    goto read_fail;
+                }
+                fFound = TRUE;
+                if ( fDir ) goto done;
+            }
+        }
+        if ( !fFound ) {
+            ulRC = ERR_NO_FONT;
+        }
+    }
+    else {
+        ulRC = ERR_FILE_FORMAT;
+    }
+
+    goto done;
+
+read_fail:
+    ulRC = ERR_FILE_READ;
+done:
+    _FILE_CLOSE( pf );
+    *pulCount = ulFaceCount;
+    return ulRC;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * ReleaseCachedObject                                                       *
+ *                                                                           *
+ * Releases a reference to an object from the object cache.  If the object   *
+ * has been evicted from the cache in the meantime, and nothing else is      *
+ * using it, it is freed.                                                    *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POBJCACHEENTRY pEntry: The cached object.                          (IO) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void ReleaseCachedObject( POBJCACHEENTRY pEntry )
+{
+    ULONG cRefs;
+
+    if ( !pEntry ) return;
+    _OBJCACHE_LOCK();
+    cRefs = --pEntry->cRefs;
+    _OBJCACHE_UNLOCK();
+    if ( cRefs == 0 ) FreeCachedObject( pEntry );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * ReleaseOS2CachedGlyph                                                     *
+ *                                                                           *
+ * Releases a glyph returned by GetOS2CachedGlyph().  If the glyph has been  *
+ * removed from the cache in the meantime, and nothing else is using it,     *
+ * it is freed.  The buffer field of the glyph information is cleared.       *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PGLYPHBITMAP pGlyph: The glyph information.                        (IO) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void ReleaseOS2CachedGlyph( PGLYPHBITMAP pGlyph )
+{
+    PGLYPHCACHEENTRY pEntry;
+
+    if ( !pGlyph || !pGlyph->buffer ) return;
+    pEntry = (PGLYPHCACHEENTRY)( pGlyph->buffer ) - 1;
+    if ( !_REF_RELEASE( pEntry->cRefs )) free( pEntry );
+    pGlyph->buffer = NULL;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * RemoveCachedGlyph                                                         *
+ *                                                                           *
+ * Removes an entry from a glyph cache, and drops the cache's reference to   *
+ * it (freeing it unless it is still in use).  The cache must be locked      *
+ * exclusively.                                                              *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2GLYPHCACHE   pCache: The glyph cache.                          (IO) *
+ *   PGLYPHCACHEENTRY pEntry: The cache entry to remove.                 (I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void RemoveCachedGlyph( POS2GLYPHCACHE pCache, PGLYPHCACHEENTRY pEntry )
+{
+    PGLYPHCACHEENTRY *ppLink;
+
+    ppLink = pCache->papBuckets + GLYPH_CACHE_HASH( pEntry->pFont, pEntry->ulIndex, pCache->cBuckets );
+    while ( *ppLink != pEntry ) ppLink = &((*ppLink)->pNext );
+    *ppLink = pEntry->pNext;
+
+    if ( pEntry->fPinned )
+        pCache->stats.cPinned--;
+    else if ( pEntry->pRingNext == pEntry )
+        pCache->pHand = NULL;
+    else {
+        if ( pCache->pHand == pEntry ) pCache->pHand = pEntry->pRingNext;
+        pEntry->pRingPrev->pRingNext = pEntry->pRingNext;
+        pEntry->pRingNext->pRingPrev = pEntry->pRingPrev;
+    }
+    pCache->stats.cEntries--;
+    pCache->stats.cbUsed -= pEntry->cb;
+    if ( !_REF_RELEASE( pEntry->cRefs )) free( pEntry );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * RenderOS2FontText                                                         *
+ *                                                                           *
+ * Draws a run of UTF-8 or UTF-16 text onto a 1 or 8 bit per pel surface     *
+ * (see gpifont.h).  The text is converted to glyph indices (as with         *
+ * OS2FontGlyphIndices), and each glyph is drawn at its left side-bearing    *
+ * from the current pen position, which then moves on by the glyph's         *
+ * advance.  The glyphs are drawn straight from the font's own bitmaps,      *
+ * without extracting them, and are clipped to the surface.                  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont   : Pointer to the font resource data.       (I) *
+ *   PVOID            pText   : The text to draw.                        (I) *
+ *   ULONG            cbText  : Size of the text, in bytes.              (I) *
+ *   ULONG            ulFormat: OS2TEXT_UTF8 or OS2TEXT_UTF16, optionally    *
+ *                              with OS2TEXT_KERNING.                    (I) *
+ *   POS2TEXTSURFACE  pSurface: The surface to draw on.                 (IO) *
+ *   LONG             x       : Starting pen position (may be outside        *
+ *                              the surface).                            (I) *
+ *   LONG             y       : Surface row of the baseline.             (I) *
+ *                                                                           *
+ * RETURNS: LONG                                                             *
+ *   The pen position following the text (x itself if the surface depth is   *
+ *   not supported).                                                         *
+ * ------------------------------------------------------------------------- */
+LONG RenderOS2FontText( POS2FONTRESOURCE pFont, PVOID pText, ULONG cbText, ULONG ulFormat, POS2TEXTSURFACE pSurface, LONG x, LONG y )
+{
+    ULONG       aulGlyphs[ RENDER_CHUNK ];  // glyph indices of part of the text
+    GLYPHBITMAP glyph;                      // glyph information
+    PBYTE       pBitmap;                    // pointer to bitmap within the font
+    ULONG       ofText,                     // offset of the text still to draw
+                cbUsed,                     // bytes of text converted
+                cGlyphs,                    // number of glyph indices
+                ulPrev = OS2KERN_NO_PAIR,   // previous glyph (none at first)
+                i;
+    BOOL        fKern;                      // apply kerning?
+    LONG        yTop;                       // surface row of the glyphs' top
+
+
+    if (( pSurface->ulDepth != 1 ) && ( pSurface->ulDepth != 8 )) return x;
+    yTop = y - pFont->pFontDef->pCellBaseOffset;
+    fKern = ( ulFormat & OS2TEXT_KERNING ) && pFont->pKernIndex;
+    ulFormat &= ~OS2TEXT_KERNING;
+
+    for ( ofText = 0; ofText < cbText; ofText += cbUsed ) {
+        cGlyphs = OS2FontGlyphIndices( pFont, (PBYTE) pText + ofText, cbText - ofText,
+                                       ulFormat, aulGlyphs, RENDER_CHUNK, &cbUsed );
+        if ( !cbUsed ) break;       // only an incomplete character is left
+        for ( i = 0; i < cGlyphs; i++ ) {
+            if ( fKern ) {
+                x += OS2FontKerning( pFont, ulPrev, aulGlyphs[ i ] );
+                ulPrev = aulGlyphs[ i ];
+            }
+            pBitmap = LocateFontGlyph( aulGlyphs[ i ], pFont, &glyph );
+            if ( !pBitmap ) continue;
+            if ( pSurface->ulDepth == 1 )
+                DrawGlyph1bpp( pBitmap, &glyph, pSurface, x + glyph.horiBearingX, yTop );
+            else
+                DrawGlyph8bpp( pBitmap, &glyph, pSurface, x + glyph.horiBearingX, yTop );
+            x += glyph.horiAdvance;
+        }
+    }
+    return x;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * SaveOS2FontCatalog                                                        *
+ *                                                                           *
+ * Writes a font catalog to its index file, if it has changed since it was   *
+ * loaded (or last saved).  The whole index is written with a single call.   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTCATALOG pCatalog: The font catalog.                         (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_* otherwise.                                          *
+ * ------------------------------------------------------------------------- */
+ULONG SaveOS2FontCatalog( POS2FONTCATALOG pCatalog )
+{
+    CATALOGHEADER  hdr;             // index file header
+    CATALOGFILEREC rec;             // current file record
+    PCATALOGFILE   pFile;
+    FILE          *pf;
+    PBYTE          pBuf,            // the index file contents
+                   pRecs,           // file records
+                   pFaces;          // face records
+    PSZ            pszNames;        // filenames
+    ULONG          cb,
+                   ulRC = 0,
+                   i;
+
+
+    if ( !pCatalog->fChanged ) return 0;
+
+    memset( &hdr, 0, sizeof( hdr ));
+    memcpy( hdr.achMagic, CATALOG_MAGIC, sizeof( CATALOG_MAGIC ));
+    hdr.ulVersion = CATALOG_VERSION;
+    hdr.cbFace    = sizeof( OS2CATALOGFACE );
+    hdr.cFiles    = pCatalog->cFiles;
+    for ( i = 0; i < pCatalog->cFiles; i++ ) {
+        hdr.cFaces  += pCatalog->paFiles[ i ].cFaces;
+        hdr.cbNames += strlen( pCatalog->paFiles[ i ].pszPath ) + 1;
+    }
+    cb = sizeof( hdr ) + ( hdr.cFiles * sizeof( CATALOGFILEREC )) +
+         ( hdr.cFaces * sizeof( OS2CATALOGFACE )) + hdr.cbNames;
+    pBuf = (PBYTE) malloc( cb );
+    if ( !pBuf ) return ERR_MEMORY;
+
+    memcpy( pBuf, &hdr, sizeof( hdr ));
+    pRecs    = pBuf + sizeof( hdr );
+    pFaces   = pRecs + ( hdr.cFiles * sizeof( CATALOGFILEREC ));
+    pszNames = (PSZ)( pFaces + ( hdr.cFaces * sizeof( OS2CATALOGFACE )));
+    rec.ofName = 0;
+    for ( i = 0; i < pCatalog->cFiles; i++ ) {
+        pFile = pCatalog->paFiles + i;
+        rec.ullMTime = pFile->ullMTime;
+        rec.ullSize  = pFile->ullSize;
+        rec.cFaces   = pFile->cFaces;
+        memcpy( pRecs, &rec, sizeof( rec ));
+        pRecs += sizeof( rec );
+        if ( pFile->cFaces ) {
+            memcpy( pFaces, pFile->paFaces, pFile->cFaces * sizeof( OS2CATALOGFACE ));
+            pFaces += pFile->cFaces * sizeof( OS2CATALOGFACE );
+        }
+        strcpy( pszNames + rec.ofName, pFile->pszPath );
+        rec.ofName += strlen( pFile->pszPath ) + 1;
+    }
+
+    pf = fopen( pCatalog->pszIndex, "wb");
+    if ( !pf )
+        ulRC = ERR_FILE_OPEN;
+    else {
+        if ( fwrite( pBuf, 1, cb, pf ) != cb ) ulRC = ERR_FILE_WRITE;
+        if ( fclose( pf ) && !ulRC ) ulRC = ERR_FILE_WRITE;
+    }
+    free( pBuf );
+    if ( ulRC == 0 ) pCatalog->fChanged = FALSE;
+    return ulRC;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * SetFixedAdvance                                                           *
+ *                                                                           *
+ * Works out whether every glyph in the font has the same advance, so that   *
+ * MeasureOS2FontGlyphs() can measure text with a single multiplication.     *
+ * Only fixed-pitch (type 1) fonts are checked; the advance is only used if  *
+ * each glyph in the font's range exists, with its bitmap inside the font    *
+ * data (see GlyphAdvance), and has the same width, so a malformed font      *
+ * simply falls back to adding up the advances.  This is done once when the  *
+ * font is parsed.                                                           *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont: Pointer to the parsed font.                (IO) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void SetFixedAdvance( POS2FONTRESOURCE pFont )
+{
+    ULONG ulFirst = pFont->pMetrics->usFirstChar,
+          ulLast  = ulFirst + pFont->pMetrics->usLastChar,
+          i;
+    LONG  lAdvance;
+
+    pFont->lFixedAdvance = 0;
+    if (( pFont->pFontDef->fsFontdef != OS2FONTDEF_FONT1 ) ||
+        ( pFont->pFontDef->fsChardef == OS2FONTDEF_CHAR3 ))
+        return;
+    lAdvance = GlyphAdvance( ulFirst, pFont );
+    if ( lAdvance <= 0 ) return;
+    for ( i = ulFirst + 1; i <= ulLast; i++ )
+        if ( GlyphAdvance( i, pFont ) != lAdvance ) return;
+    pFont->lFixedAdvance = lAdvance;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * SetOS2ObjectCacheBudget                                                   *
+ *                                                                           *
+ * Sets the memory budget of the object cache.  The cache holds LX objects   *
+ * which had to be unpacked (because their pages are compressed or not       *
+ * stored contiguously), so that they can be shared by every face they       *
+ * contain, whether the faces are loaded through the same font module or     *
+ * not, and by any number of modules or files opened on the same module      *
+ * file.  Only the pages of an object which cover the faces (or other        *
+ * resources) used so far are unpacked, and only they count towards the      *
+ * budget.  Fonts obtained from a module may point directly into a cached    *
+ * object, which is kept alive for as long as they use it even if it is      *
+ * evicted.  The least recently used objects are evicted to stay within the  *
+ * budget.                                                                   *
+ *                                                                           *
+ * A budget of 0 disables the cache and empties it; objects are then         *
+ * unpacked separately for every module.  The cache is enabled by default.   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG cbBudget: Maximum memory (in bytes) to use for cached objects.(I) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void SetOS2ObjectCacheBudget( ULONG cbBudget )
+{
+    _OBJCACHE_LOCK();
+    object_cache.stats.cbBudget = cbBudget;
+    EvictCachedObjects( 0 );
+    _OBJCACHE_UNLOCK();
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * SetOS2UnpackThreads                                                       *
+ *                                                                           *
+ * Sets the number of threads used to unpack the compressed pages of         *
+ * LX-format modules.  Each object page is packed independently, so once     *
+ * the page map entries and stored page data have been read, the pages       *
+ * covering a resource can be unpacked in parallel, each into its own slot   *
+ * of the output buffer.  The calling thread always takes part, so a value   *
+ * of n starts a pool of (n-1) worker threads; any existing pool is shut     *
+ * down first.                                                               *
+ *                                                                           *
+ * The default is 1, which unpacks every page on the calling thread.  The    *
+ * unpacked data is identical whatever the number of threads.  Where the     *
+ * platform has no thread support, only 1 thread is ever used.               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   ULONG cThreads: Number of threads to use, or 0 to use one thread per    *
+ *                   online processor.                                   (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The number of unpacking threads now in use (which may be fewer than     *
+ *   requested if the worker threads could not all be started).              *
+ * ------------------------------------------------------------------------- */
+ULONG SetOS2UnpackThreads( ULONG cThreads )
+{
+#ifdef HAVE_PTHREADS
+    ULONG i;
+    long  lCPUs;
+
+    if ( !cThreads ) {
+#ifdef _SC_NPROCESSORS_ONLN
+        lCPUs = sysconf( _SC_NPROCESSORS_ONLN );
+        cThreads = ( lCPUs > 0 ) ? (ULONG) lCPUs : 1;
+#else
+        cThreads = 1;
+#endif
+    }
+    if ( cThreads > LX_POOL_MAX_THREADS ) cThreads = LX_POOL_MAX_THREADS;
+
+    pthread_mutex_lock( &unpack_pool.mtxBatch );
+
+    // Stop the existing workers (if any)
+    if ( unpack_pool.cWorkers ) {
+        pthread_mutex_lock( &unpack_pool.mtx );
+        unpack_pool.fStop = TRUE;
+        pthread_cond_broadcast( &unpack_pool.cvWork );
+        pthread_mutex_unlock( &unpack_pool.mtx );
+        for ( i = 0; i < unpack_pool.cWorkers; i++ )
+            pthread_join( unpack_pool.paThreads[ i ], NULL );
+        free( unpack_pool.paThreads );
+        unpack_pool.paThreads = NULL;
+        unpack_pool.cWorkers  = 0;
+        unpack_pool.fStop     = FALSE;
+    }
+
+    // Start the new ones
+    if ( cThreads > 1 ) {
+        unpack_pool.paThreads = (pthread_t *) calloc( cThreads - 1, sizeof( pthread_t ));
+        if ( unpack_pool.paThreads ) {
+            for ( i = 0; i < ( cThreads - 1 ); i++ ) {
+                if ( pthread_create( unpack_pool.paThreads + i, NULL, LXUnpackWorker, NULL ))
+                    break;
+                unpack_pool.cWorkers++;
+            }
+        }
+    }
+    unpack_threads = unpack_pool.cWorkers + 1;
+
+    pthread_mutex_unlock( &unpack_pool.mtxBatch );
+#else
+    unpack_threads = 1;
+#endif
+    return unpack_threads;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * SetUGLCoverage                                                            *
+ *                                                                           *
+ * Works out whether the font uses UGL encoding, and if so builds its UGL    *
+ * coverage bitmap: one bit for every UGL glyph index, set if the glyph lies *
+ * within the font's range and belongs to a character group which the font   *
+ * supports.  This is done once when the font is parsed, so that             *
+ * OS2FontGlyphIndices() can test each character with a single lookup.       *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont: Pointer to the parsed font.                (IO) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void SetUGLCoverage( POS2FONTRESOURCE pFont )
+{
+    ULONG i;
+
+    memset( pFont->abCoverage, 0, OS2FONT_COVERAGE_SIZE );
+    pFont->fUGL = ( !pFont->pMetrics->usCodePage || ( pFont->pMetrics->usCodePage == 850 ));
+    if ( !pFont->fUGL ) return;
+    for ( i = 0; i < OS2UGL_MAX_GLYPH; i++ )
+        if ( UGLGlyphInFont( pFont->pMetrics, i ))
+            pFont->abCoverage[ i >> 3 ] |= ( 1 << ( i & 7 ));
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * StatFileID                                                                *
+ *                                                                           *
+ * Sets the identity of a file (see gpifont.h) from its status information.  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   struct stat *pfs: The file's status information.                    (I) *
+ *   POS2FILEID   pID: Receives the identity of the file.                (O) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void StatFileID( struct stat *pfs, POS2FILEID pID )
+{
+    pID->ullDevice = (uint64_t) pfs->st_dev;
+    pID->ullFile   = (uint64_t) pfs->st_ino;
+    pID->ullSize   = (uint64_t) pfs->st_size;
+    pID->ullMTime  = (uint64_t) pfs->st_mtime;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * StoreGlyph                                                                *
+ *                                                                           *
+ * Writes a glyph bitmap found by LocateGlyph() into the given buffer as a   *
+ * standard row-major bitmap.  If the font has a glyph atlas, the bitmap is  *
+ * already in that format and is simply copied; otherwise it is converted.   *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTRESOURCE pFont  : Pointer to the font resource data.        (I) *
+ *   PBYTE            pBitmap: The bitmap returned by LocateGlyph().     (I) *
+ *   PGLYPHBITMAP     pGlyph : The glyph information from LocateGlyph(). (I) *
+ *   PBYTE            pDest  : Buffer to receive the bitmap.             (O) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void StoreGlyph( POS2FONTRESOURCE pFont, PBYTE pBitmap, PGLYPHBITMAP pGlyph, PBYTE pDest )
+{
+    if ( pFont->pAtlas )
+        memcpy( pDest, pBitmap, pGlyph->cbBuffer );
+    else
+        TransposeGlyph( pBitmap, pGlyph->rows, pGlyph->pitch, pDest );
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * TransposeGlyph                                                            *
+ *                                                                           *
+ * Converts a glyph bitmap from the OS/2 font format, where consecutive      *
+ * bytes represent vertical columns (each 8 pels wide), into a standard      *
+ * row-major bitmap.  In other words, this transposes a matrix of usWidth    *
+ * rows by cy bytes.                                                         *
+ *                                                                           *
+ * The rows are converted in blocks by the widest of the TransposeRows*      *
+ * routines which the CPU supports (as determined on the first call), with   *
+ * the narrower routines picking up whatever rows are left over.  All of     *
+ * them produce exactly the same output as TransposeRowsScalar().            *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pSrc   : The bitmap in OS/2 font format.                      (I) *
+ *   ULONG cy     : Height of the bitmap in pels (rows).                 (I) *
+ *   ULONG usWidth: Number of bytes in each row (columns).               (I) *
+ *   PBYTE pDest  : Buffer to receive the bitmap (cy * usWidth bytes).   (O) *
+ *                                                                           *
+ * RETURNS: N/A                                                              *
+ * ------------------------------------------------------------------------- */
+void TransposeGlyph( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest )
+{
+    ULONG i = 0;
+
+#ifdef HAVE_X86_SIMD
+    if ( transpose_simd == SIMD_UNKNOWN ) {
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports("avx2"))
+            transpose_simd = SIMD_AVX2;
+        else if ( __builtin_cpu_supports("sse2"))
+            transpose_simd = SIMD_SSE2;
+        else
+            transpose_simd = SIMD_NONE;
+    }
+    if ( transpose_simd >= SIMD_AVX2 )
+        i = TransposeRowsAVX2( pSrc, cy, usWidth, pDest, i );
+    if ( transpose_simd >= SIMD_SSE2 )
+        i = TransposeRowsSSE2( pSrc, cy, usWidth, pDest, i );
+#endif
+    TransposeRowsScalar( pSrc, cy, usWidth, pDest, i );
+}
+
+
+#ifdef HAVE_X86_SIMD
+/* ------------------------------------------------------------------------- *
+ * TransposeRowsAVX2                                                         *
+ *                                                                           *
+ * AVX2 version of TransposeRowsSSE2(), which converts 32 rows at a time.    *
+ * Since the AVX2 unpack instructions work within each 128-bit half, rows    *
+ * 0-15 of each block end up in the low halves and rows 16-31 in the high    *
+ * halves; the halves are put back in order before storing.                  *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pSrc   : The bitmap in OS/2 font format.                      (I) *
+ *   ULONG cy     : Height of the bitmap in pels (rows).                 (I) *
+ *   ULONG usWidth: Number of bytes in each row (columns).               (I) *
+ *   PBYTE pDest  : Buffer to receive the bitmap (cy * usWidth bytes).   (O) *
+ *   ULONG iFirst : First row to convert.                                (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The first row which was not converted.                                  *
+ * ------------------------------------------------------------------------- */
+__attribute__(( target("avx2") ))
+ULONG TransposeRowsAVX2( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst )
+{
+    __m256i c0, c1, c2, c3,     // four byte columns (32 rows)
+            a, b, c, d,         // pairs of columns interleaved
+            r[ 4 ];             // groups of columns interleaved, in row order
+    BYTE    abRows[ 128 ];      // 32 rows of (up to) four bytes
+    ULONG   i, j, k;
+
+
+    for ( i = iFirst; ( i + 32 ) <= cy; i += 32 ) {
+        for ( j = 0; ( j + 4 ) <= usWidth; j += 4 ) {
+            c0 = _mm256_loadu_si256( (__m256i *)( pSrc + i + ( cy * j )));
+            c1 = _mm256_loadu_si256( (__m256i *)( pSrc + i + ( cy * ( j + 1 ))));
+            c2 = _mm256_loadu_si256( (__m256i *)( pSrc + i + ( cy * ( j + 2 ))));
+            c3 = _mm256_loadu_si256( (__m256i *)( pSrc + i + ( cy * ( j + 3 ))));
+            a  = _mm256_unpacklo_epi8( c0, c1 );    // rows 0-7   | 16-23
+            b  = _mm256_unpackhi_epi8( c0, c1 );    // rows 8-15  | 24-31
+            c  = _mm256_unpacklo_epi8( c2, c3 );
+            d  = _mm256_unpackhi_epi8( c2, c3 );
+            c0 = _mm256_unpacklo_epi16( a, c );     // rows 0-3   | 16-19
+            c1 = _mm256_unpackhi_epi16( a, c );     // rows 4-7   | 20-23
+            c2 = _mm256_unpacklo_epi16( b, d );     // rows 8-11  | 24-27
+            c3 = _mm256_unpackhi_epi16( b, d );     // rows 12-15 | 28-31
+            r[ 0 ] = _mm256_permute2x128_si256( c0, c1, 0x20 );
+            r[ 1 ] = _mm256_permute2x128_si256( c2, c3, 0x20 );
+            r[ 2 ] = _mm256_permute2x128_si256( c0, c1, 0x31 );
+            r[ 3 ] = _mm256_permute2x128_si256( c2, c3, 0x31 );
+            if ( usWidth == 4 ) {
+                for ( k = 0; k < 4; k++ )
+                    _mm256_storeu_si256( (__m256i *)( pDest + ( i * 4 ) + ( k * 32 )), r[ k ] );
+                continue;
+            }
+            for ( k = 0; k < 4; k++ )
+                _mm256_storeu_si256( (__m256i *)( abRows + ( k * 32 )), r[ k ] );
+            for ( k = 0; k < 32; k++ )
+                memcpy( pDest + (( i + k ) * usWidth ) + j, abRows + ( k * 4 ), 4 );
+        }
+        for ( ; ( j + 2 ) <= usWidth; j += 2 ) {
+            c0 = _mm256_loadu_si256( (__m256i *)( pSrc + i + ( cy * j )));
+            c1 = _mm256_loadu_si256( (__m256i *)( pSrc + i + ( cy * ( j + 1 ))));
+            a  = _mm256_unpacklo_epi8( c0, c1 );    // rows 0-7   | 16-23
+            b  = _mm256_unpackhi_epi8( c0, c1 );    // rows 8-15  | 24-31
+            r[ 0 ] = _mm256_permute2x128_si256( a, b, 0x20 );
+            r[ 1 ] = _mm256_permute2x128_si256( a, b, 0x31 );
+            if ( usWidth == 2 ) {
+                _mm256_storeu_si256( (__m256i *)( pDest + ( i * 2 )), r[ 0 ] );
+                _mm256_storeu_si256( (__m256i *)( pDest + ( i * 2 ) + 32 ), r[ 1 ] );
+                continue;
+            }
+            _mm256_storeu_si256( (__m256i *) abRows, r[ 0 ] );
+            _mm256_storeu_si256( (__m256i *)( abRows + 32 ), r[ 1 ] );
+            for ( k = 0; k < 32; k++ )
+                memcpy( pDest + (( i + k ) * usWidth ) + j, abRows + ( k * 2 ), 2 );
+        }
+        for ( ; j < usWidth; j++ )
+            for ( k = 0; k < 32; k++ )
+                pDest[ (( i + k ) * usWidth ) + j ] = pSrc[ i + k + ( cy * j ) ];
+    }
+    return i;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * TransposeRowsSSE2                                                         *
+ *                                                                           *
+ * Converts as many whole blocks of 16 rows as possible (starting at row     *
+ * iFirst) for TransposeGlyph(), using SSE2.  Four byte columns are loaded   *
+ * and interleaved, first bytewise and then in pairs, which leaves the four  *
+ * bytes of each row next to each other in row order.  These are stored      *
+ * directly if the glyph is exactly four bytes wide, or else copied to each  *
+ * row in turn.  Leftover pairs of columns are handled in the same way, and  *
+ * a single leftover column byte by byte.                                    *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pSrc   : The bitmap in OS/2 font format.                      (I) *
+ *   ULONG cy     : Height of the bitmap in pels (rows).                 (I) *
+ *   ULONG usWidth: Number of bytes in each row (columns).               (I) *
+ *   PBYTE pDest  : Buffer to receive the bitmap (cy * usWidth bytes).   (O) *
+ *   ULONG iFirst : First row to convert.                                (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The first row which was not converted.                                  *
+ * ------------------------------------------------------------------------- */
+__attribute__(( target("sse2") ))
+ULONG TransposeRowsSSE2( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst )
+{
+    __m128i c0, c1, c2, c3,     // four byte columns (16 rows)
+            a, b, c, d,         // pairs of columns interleaved
+            r[ 4 ];             // groups of columns interleaved, in row order
+    BYTE    abRows[ 64 ];       // 16 rows of (up to) four bytes
+    ULONG   i, j, k;
+
+
+    for ( i = iFirst; ( i + 16 ) <= cy; i += 16 ) {
+        for ( j = 0; ( j + 4 ) <= usWidth; j += 4 ) {
+            c0 = _mm_loadu_si128( (__m128i *)( pSrc + i + ( cy * j )));
+            c1 = _mm_loadu_si128( (__m128i *)( pSrc + i + ( cy * ( j + 1 ))));
+            c2 = _mm_loadu_si128( (__m128i *)( pSrc + i + ( cy * ( j + 2 ))));
+            c3 = _mm_loadu_si128( (__m128i *)( pSrc + i + ( cy * ( j + 3 ))));
+            a  = _mm_unpacklo_epi8( c0, c1 );       // rows 0-7
+            b  = _mm_unpackhi_epi8( c0, c1 );       // rows 8-15
+            c  = _mm_unpacklo_epi8( c2, c3 );
+            d  = _mm_unpackhi_epi8( c2, c3 );
+            r[ 0 ] = _mm_unpacklo_epi16( a, c );    // rows 0-3
+            r[ 1 ] = _mm_unpackhi_epi16( a, c );    // rows 4-7
+            r[ 2 ] = _mm_unpacklo_epi16( b, d );    // rows 8-11
+            r[ 3 ] = _mm_unpackhi_epi16( b, d );    // rows 12-15
+            if ( usWidth == 4 ) {
+                for ( k = 0; k < 4; k++ )
+                    _mm_storeu_si128( (__m128i *)( pDest + ( i * 4 ) + ( k * 16 )), r[ k ] );
+                continue;
+            }
+            for ( k = 0; k < 4; k++ )
+                _mm_storeu_si128( (__m128i *)( abRows + ( k * 16 )), r[ k ] );
+            for ( k = 0; k < 16; k++ )
+                memcpy( pDest + (( i + k ) * usWidth ) + j, abRows + ( k * 4 ), 4 );
+        }
+        for ( ; ( j + 2 ) <= usWidth; j += 2 ) {
+            c0 = _mm_loadu_si128( (__m128i *)( pSrc + i + ( cy * j )));
+            c1 = _mm_loadu_si128( (__m128i *)( pSrc + i + ( cy * ( j + 1 ))));
+            r[ 0 ] = _mm_unpacklo_epi8( c0, c1 );   // rows 0-7
+            r[ 1 ] = _mm_unpackhi_epi8( c0, c1 );   // rows 8-15
+            if ( usWidth == 2 ) {
+                _mm_storeu_si128( (__m128i *)( pDest + ( i * 2 )), r[ 0 ] );
+                _mm_storeu_si128( (__m128i *)( pDest + ( i * 2 ) + 16 ), r[ 1 ] );
+                continue;
+            }
+            _mm_storeu_si128( (__m128i *) abRows, r[ 0 ] );
+            _mm_storeu_si128( (__m128i *)( abRows + 16 ), r[ 1 ] );
+            for ( k = 0; k < 16; k++ )
+                memcpy( pDest + (( i + k ) * usWidth ) + j, abRows + ( k * 2 ), 2 );
+        }
+        for ( ; j < usWidth; j++ )
+            for ( k = 0; k < 16; k++ )
+                pDest[ (( i + k ) * usWidth ) + j ] = pSrc[ i + k + ( cy * j ) ];
+    }
+    return i;
+}
+#endif
+
+
+/* ------------------------------------------------------------------------- *
+ * TransposeRowsScalar                                                       *
+ *                                                                           *
+ * Converts the remaining rows (from iFirst onwards) for TransposeGlyph(),   *
+ * one byte at a time.  This is the portable version, and the reference      *
+ * against which the others are checked.                                     *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PBYTE pSrc   : The bitmap in OS/2 font format.                      (I) *
+ *   ULONG cy     : Height of the bitmap in pels (rows).                 (I) *
+ *   ULONG usWidth: Number of bytes in each row (columns).               (I) *
+ *   PBYTE pDest  : Buffer to receive the bitmap (cy * usWidth bytes).   (O) *
+ *   ULONG iFirst : First row to convert.                                (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   The first row which was not converted.                                  *
+ * ------------------------------------------------------------------------- */
+ULONG TransposeRowsScalar( PBYTE pSrc, ULONG cy, ULONG usWidth, PBYTE pDest, ULONG iFirst )
+{
+    ULONG i, j,
+          ulPos = iFirst * usWidth;
+
+    for ( i = iFirst; i < cy; i++ ) {
+        for ( j = 0; j < usWidth; j++ ) {
+            pDest[ ulPos++ ] = pSrc[ i + (cy * j) ];
+        }
+    }
+    return cy;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * UGLGlyphInFont                                                            *
+ *                                                                           *
+ * Checks whether a UGL glyph index is supported by a UGL-encoded font; that *
+ * is, whether it lies within the font's own range, and belongs to one of    *
+ * the character groups the font claims to support.                          *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FOCAMETRICS pMetrics: Pointer to the font metrics.              (I) *
+ *   ULONG           i       : UGL glyph index.                          (I) *
+ *                                                                           *
+ * RETURNS: BOOL                                                             *
+ *   TRUE if the font supports the glyph, FALSE otherwise.                   *
+ * ------------------------------------------------------------------------- */
+BOOL UGLGlyphInFont( POS2FOCAMETRICS pMetrics, ULONG i )
+{
+    // Character falls outside the font's own range
+    if (( i < (ULONG) pMetrics->usFirstChar ) ||
+        ( i > (ULONG)( pMetrics->usFirstChar + pMetrics->usLastChar )))
+        return FALSE;
+
+    // Character belongs to an unsupported character group
+    if ( CHAR_IS_LATIN1( i )   && !( pMetrics->fsDefn & FOCA_CHARSET_LATIN1 ))
+        return FALSE;
+    if ( CHAR_IS_PCEXTRA( i )  && !( pMetrics->fsDefn & FOCA_CHARSET_PC ))
+        return FALSE;
+    if ( CHAR_IS_LATINEXT( i ) && !( pMetrics->fsDefn & FOCA_CHARSET_LATINX ))
+        return FALSE;
+    if ( CHAR_IS_CYRILLIC( i ) && !( pMetrics->fsDefn & FOCA_CHARSET_CYRILLIC ))
+        return FALSE;
+    if ( CHAR_IS_HEBREW( i )   && !( pMetrics->fsDefn & FOCA_CHARSET_HEBREW ))
+        return FALSE;
+    if ( CHAR_IS_GREEK( i )    && !( pMetrics->fsDefn & FOCA_CHARSET_GREEK ))
+        return FALSE;
+    if ( CHAR_IS_ARABIC( i )   && !( pMetrics->fsDefn & FOCA_CHARSET_ARABIC ))
+        return FALSE;
+    if ( CHAR_IS_UGLEXT( i )   && !( pMetrics->fsDefn & FOCA_CHARSET_UGLEXT ))
+        return FALSE;
+    if ( CHAR_IS_KANA( i )     && !( pMetrics->fsDefn & FOCA_CHARSET_KANA ))
+        return FALSE;
+    if ( CHAR_IS_THAI( i )     && !( pMetrics->fsDefn & FOCA_CHARSET_THAI ))
+        return FALSE;
+
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * UpdateOS2FontCatalog                                                      *
+ *                                                                           *
+ * Brings the catalog records of a font file up to date.  Files are keyed by *
+ * name, modification time and size: if the file is already in the catalog   *
+ * and neither its time nor its size has changed, it is not opened at all;   *
+ * otherwise it is parsed and its records are replaced.  A file which turns  *
+ * out not to contain any fonts is recorded without faces, so that it is     *
+ * not parsed again until it changes.                                        *
+ *                                                                           *
+ * The file is looked up by exactly the name given, so a rescan should pass  *
+ * each file by the same name as before.                                     *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   POS2FONTCATALOG pCatalog: The font catalog.                        (IO) *
+ *   PSZ             pszFile : Name of the font file.                    (I) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_* otherwise.  ERR_NO_FONT or ERR_FILE_FORMAT means    *
+ *   that the file was recorded without faces (ERR_NO_FONT is returned for   *
+ *   such a file if it is unchanged); after any other error, the catalog is  *
+ *   left as it was.                                                         *
+ * ------------------------------------------------------------------------- */
+ULONG UpdateOS2FontCatalog( POS2FONTCATALOG pCatalog, PSZ pszFile )
+{
+    struct stat     fs;             // file information structure
+    PCATALOGFILE    pFile,
+                    paFiles;
+    POS2CATALOGFACE paFaces = NULL; // the file's new face records
+    ULONG           cFaces = 0,     // number of new face records
+                    ulRC,
+                    i;
+    PSZ             pszPath;
+    BOOL            fFound;
+
+
+    if ( stat( pszFile, &fs ) != 0 ) return ERR_FILE_STAT;
+    i = CatalogFile( pCatalog, pszFile, &fFound );
+    pFile = fFound ? pCatalog->paFiles + i : NULL;
+    if ( pFile && ( pFile->ullMTime == (uint64_t) fs.st_mtime ) &&
+         ( pFile->ullSize == (uint64_t) fs.st_size ))
+    {
+        pFile->fSeen = TRUE;
+        pCatalog->stats.cUnchanged++;
+        return pFile->cFaces ? 0 : ERR_NO_FONT;
+    }
+
+    // The file is new or has changed, so parse it
+    ulRC = CatalogFaces( pszFile, &paFaces, &cFaces );
+    if (( ulRC != 0 ) && ( ulRC != ERR_NO_FONT ) && ( ulRC != ERR_FILE_FORMAT ))
+        return ulRC;
+    if ( !pFile ) {
+        pszPath = strdup( pszFile );
+        if ( pszPath && ( pCatalog->cFiles == pCatalog->cAlloc )) {
+            paFiles = (PCATALOGFILE) realloc( pCatalog->paFiles,
+                                              ( pCatalog->cAlloc + CATALOG_GROW ) * sizeof( CATALOGFILE ));
+            if ( paFiles ) {
+                pCatalog->paFiles = paFiles;
+                pCatalog->cAlloc += CATALOG_GROW;
+            }
+        }
+        if ( !pszPath || ( pCatalog->cFiles == pCatalog->cAlloc )) {
+            free( pszPath );
+            free( paFaces );
+            return ERR_MEMORY;
+        }
+        pFile = pCatalog->paFiles + i;
+        memmove( pFile + 1, pFile, ( pCatalog->cFiles - i ) * sizeof( CATALOGFILE ));
+        pFile->pszPath = pszPath;
+        pCatalog->cFiles++;
+    }
+    else free( pFile->paFaces );
+
+    pFile->ullMTime = (uint64_t) fs.st_mtime;
+    pFile->ullSize  = (uint64_t) fs.st_size;
+    pFile->paFaces  = paFaces;
+    pFile->cFaces   = cFaces;
+    pFile->fSeen    = TRUE;
+    pCatalog->stats.cParsed++;
+    pCatalog->fChanged = TRUE;
+    return ulRC;
+}
+
+
+/* ------------------------------------------------------------------------- *
+ * WriteOS2FontModule                                                        *
+ *                                                                           *
+ * Writes a font module (see BuildOS2FontModule) holding the given fonts.    *
+ * The module is named after the file, as OS/2 requires of a DLL, and is     *
+ * written with a single call.                                               *
+ *                                                                           *
+ * ARGUMENTS:                                                                *
+ *   PSZ              pszFile  : Name of the module file to create.      (I) *
+ *   POS2FONTRESOURCE paFonts  : Array of parsed fonts to include.       (I) *
+ *   ULONG            cFonts   : Number of fonts in paFonts (1-65534).   (I) *
+ *   ULONG            ulPack   : OS2PACK_* compression method for object     *
+ *                               pages, or 0 to store them unpacked.     (I) *
+ *   PULONG           pcbModule: Pointer to the size of the module written,  *
+ *                               or NULL.                                (O) *
+ *                                                                           *
+ * RETURNS: ULONG                                                            *
+ *   0 on success, ERR_* otherwise.                                          *
+ * ------------------------------------------------------------------------- */
+ULONG WriteOS2FontModule( PSZ pszFile, POS2FONTRESOURCE paFonts, ULONG cFonts, ULONG ulPack, PULONG pcbModule )
+{
+    CHAR   achName[ 256 ];      // module name
+    FILE  *pf;
+    PBYTE  pModule;
+    PSZ    psz,
+           pszName = pszFile;
+    ULONG  cb,
+           cch,
+           ulRC;
+
+    // The module name is the filename, without any path or extension
+    for ( psz = pszFile; *psz; psz++ )
+        if (( *psz == '/') || ( *psz == '\\') || ( *psz == ':'))
+            pszName = psz + 1;
+    for ( cch = 0; pszName[ cch ] && ( pszName[ cch ] != '.') && ( cch < 255 ); cch++ )
+        achName[ cch ] = (( pszName[ cch ] >= 'a') && ( pszName[ cch ] <= 'z')) ?
+                         pszName[ cch ] - 'a' + 'A' : pszName[ cch ];
+    achName[ cch ] = 0;
+
+    ulRC = BuildOS2FontModule( paFonts, cFonts, (PSZ) achName, ulPack, &pModule, &cb );
+    if ( ulRC ) return ulRC;
+    pf = fopen( pszFile, "wb");
+    if ( !pf )
+        ulRC = ERR_FILE_OPEN;
+    else {
+        if ( fwrite( pModule, 1, cb, pf ) != cb ) ulRC = ERR_FILE_WRITE;
+        if ( fclose( pf ) && !ulRC ) ulRC = ERR_FILE_WRITE;
+    }
+    free( pModule );
+    if ( pcbModule ) *pcbModule = ulRC ? 0 : cb;
+    return ulRC;
+}
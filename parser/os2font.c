@@ -1,509 +1,1946 @@
-/*****************************************************************************
- *                                                                           *
- * os2font.c                                                                 *
- *                                                                           *
- * Program to parse an OS/2 GPI-format bitmap font and do various things     *
- * with it.                                                                  *
- *                                                                           *
- *  (C) 2012,2023 Alexander Taylor                                           *
- *                                                                           *
- *  This code is placed in the public domain.                                *
- *                                                                           *
- *****************************************************************************/
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
-#include <math.h>
-#include "otypes.h"
-#include "gpifont.h"
-
-/* Local function prototypes */
-void show_glyph( ULONG ulOffset, POS2FONTRESOURCE pFont );
-BOOL write_font( OS2FONTRESOURCE font, ULONG count, USHORT dpi, PSZ pszFileName );
-
-
-/* ------------------------------------------------------------------------ */
-int main( int argc, char *argv[] )
-{
-    OS2FONTRESOURCE font = {0};
-    CHAR            achOutFile[ 251 ] = {0};
-    BOOL            bOutput = FALSE,    /* write font to output file? */
-                    bIndex = FALSE;     /* is glyph ID an absolute glyph index (instead of Unicode)? */
-    PSZ             pszFile,            /* input filename */
-                    pszArg;             /* argument pointer */
-    ULONG           number = 0,         /* glyph ID (if bOutput FALSE) or number of glyphs (if bOutput TRUE) */
-                    resource = 0,       /* font number within the input file to read */
-                    total,              /* count of fonts found in the input file */
-                    index,              /* absolute glyph index to read */
-                    error;              /* error code */
-    USHORT          a,                  /* arg loop counter */
-                    dpi = 0;            /* target DPI of output font */
-
-
-    /* parse command-line arguments */
-    if ( argc < 2 ) {
-        printf("OS2FONT <input file> [/F:<n>] [/O:<filename>] [/D:<96|120>] [/I] [<number>]\n\n");
-        printf("<input file>   OS/2-GPI font file to parse; this can be any of the following:\n");
-        printf("                - A plain FNT file (as output by the toolkit Font Editor)\n");
-        printf("                - A font resource DLL (usually with the .FON extension)\n");
-        printf("                - A program DLL (LX or NE format) containing font reources.\n\n");
-        printf("/D:<96|120>    If /O is specified, force the output font's DPI to 96 or 120.\n\n");
-        printf("/F:<n>         Where multiple fonts exist in the file, extract the <n>th font\n");
-        printf("               found, counted from 0 (the default behaviour is /F:0).\n\n");
-        printf("/I             Interpret <number> as a UGL glyph index, instead of a Unicode\n");
-        printf("               codepoint (ignored if /O is specified).\n\n");
-        printf("/O:<filename>  Write the parsed font resource into <filename>.\n\n");
-        printf("<number>       If /O is specified, indicates the number of glyphs (starting\n");
-        printf("               from the first in the font) to copy into the output file.\n");
-        printf("               If /O is not specified, identifies a font character to preview\n");
-        printf("               on-screen.  May be specified in decimal or (if prefixed by 'U'\n");
-        printf("               or '0x') in hexadecimal; in either case it is interpreted as a\n");
-        printf("               Unicode codepoint unless /I or /O is used.\n");
-        return 0;
-    }
-    pszFile = argv[1];
-    for ( a = 2; a < argc; a++ ) {
-        pszArg = argv[a];
-        if ( *pszArg == '/' || *pszArg == '-') {
-            pszArg++;
-            if ( !(*pszArg) ) continue;
-            if (( tolower( *pszArg ) == 'o') &&
-                ( sscanf( pszArg+1, ":%250s", achOutFile ) == 1 ))
-            {
-                bOutput = TRUE;
-            }
-            else if ( tolower( *pszArg ) == 'i') {
-                bIndex = TRUE;
-            }
-            else if ( tolower( *pszArg ) == 'f') {
-                if ( !sscanf( pszArg+1, ":%u", &resource ))
-                    resource = 0;
-            }
-            else if ( tolower( *pszArg ) == 'd') {
-                if ( !sscanf( pszArg+1, ":%hu", &dpi ))
-                    dpi = 0;
-            }
-
-        }
-        else if ( !sscanf( pszArg, "u%x", &number ) &&
-                  !sscanf( pszArg, "U%x", &number ) &&
-                  !sscanf( pszArg, "%i",  &number )    )
-        {
-            fprintf( stderr, "%s is not a recognized glyph number.\n", pszArg );
-            number = 0;
-        }
-    }
-
-    /* try to parse a font from the file */
-    error = ReadOS2FontResource( pszFile, resource, &total, &font );
-    if ( error ) {
-        switch ( error ) {
-            case ERR_FILE_OPEN:
-                fprintf( stderr, "The file %s could not be opened.\n", pszFile );
-                break;
-            case ERR_FILE_STAT:
-            case ERR_FILE_READ:
-                fprintf( stderr, "Failed to read file %s.\n", pszFile );
-                break;
-            case ERR_FILE_FORMAT:
-                fprintf( stderr, "The file %s does not contain a valid font.\n", pszFile );
-                break;
-            case ERR_NO_FONT:
-                fprintf( stderr, "The requested font number was not found in %s\n", pszFile );
-                break;
-            case ERR_MEMORY:
-                fprintf( stderr, "A memory allocation error occurred.\n");
-                break;
-            default:
-                fprintf( stderr, "An unknown error occurred.\n");
-                break;
-        }
-        return error;
-    }
-
-    /* show font information */
-
-    printf("File %s contains %u fonts.  Reading first font.\n", pszFile, total );
-    printf(" - Font size:         %u bytes\n", font.cbSize );
-    printf(" - Font signature:    %s\n", font.pSignature->achSignature );
-    printf(" - Family name:       %s\n - Face name:         %s\n",
-           font.pMetrics->szFamilyname, font.pMetrics->szFacename );
-    printf(" - Point size:        %u (%ux%u dpi)\n",
-           font.pMetrics->usNominalPointSize / 10,
-           font.pMetrics->xDeviceRes, font.pMetrics->yDeviceRes );
-    printf(" - First glyph index: %u\n", font.pMetrics->usFirstChar );
-    printf(" - Last glyph index:  %u\n", font.pMetrics->usLastChar + font.pMetrics->usFirstChar );
-    printf(" - Default character: %u\n", font.pMetrics->usDefaultChar + font.pMetrics->usFirstChar );
-    printf(" - Break character:   %u\n", font.pMetrics->usBreakChar + font.pMetrics->usFirstChar );
-    printf(" - Font type:         ");
-    switch ( font.pFontDef->fsChardef ) {
-        case OS2FONTDEF_CHAR3:
-            printf("3 (ABC-space proportional-width)\n");
-            break;
-        default:
-            if ( font.pFontDef->fsFontdef == OS2FONTDEF_FONT2 )
-                printf("2 (single-increment proportional-width)\n");
-            else
-                printf("1 (fixed-width)\n");
-            break;
-    }
-    printf(" - Cell height:       %u\n", font.pFontDef->yCellHeight );
-    printf(" - Glyph data length: %u bytes\n", font.pFontDef->ulSize );
-
-    if ( font.pMetrics->usKerningPairs )
-        printf(" - %d kerning pairs are defined\n", font.pMetrics->usKerningPairs );
-    if ( font.pPanose )
-        printf(" - PANOSE table:      (%u,%u,%u,%u,%u,%u,%u,%u,%u,%u)\n",
-               font.pPanose->panose[0], font.pPanose->panose[1],
-               font.pPanose->panose[2], font.pPanose->panose[3],
-               font.pPanose->panose[4], font.pPanose->panose[5],
-               font.pPanose->panose[6], font.pPanose->panose[7],
-               font.pPanose->panose[8], font.pPanose->panose[8] );
-    if ( !bOutput && !number ) goto done;
-
-    printf("\n");
-    if ( bOutput && achOutFile[0] ) {
-        /* write the output file */
-        write_font( font, number, dpi, achOutFile );
-    }
-    else {
-        /* show the requested glyph */
-        if ( bIndex ) {
-            index = number;
-        }
-        else {
-            index = OS2FontGlyphIndex( &font, number );
-            if ( index == 0 )
-                printf("The character U+%04X is not supported by this font. Loading default glyph %u.\n",
-                        number, font.pMetrics->usFirstChar + font.pMetrics->usDefaultChar );
-            else
-                printf("The character U+%04X corresponds to font glyph index %u.\n", number, index );
-        }
-        show_glyph( index, &font );
-    }
-done:
-    free( font.pSignature );
-    return 0;
-}
-
-
-/* ------------------------------------------------------------------------ */
-void show_glyph( ULONG ulOffset, POS2FONTRESOURCE pFont )
-{
-    GLYPHBITMAP glyph;
-    USHORT      i, j, k;
-
-    if ( ! ExtractOS2FontGlyph( ulOffset, pFont, &glyph )) {
-        fprintf( stderr, "Failed to extract glyph bitmap.\n");
-        return;
-    }
-
-    /* now draw the bitmap (inside a border indicating the cell size) */
-    for ( i = 0; i < glyph.horiBearingX; i++ ) printf(" ");
-    printf("+");
-    for ( i = 0; i < glyph.width; i++ ) printf("-");
-    printf("+\n");
-    for ( i = 0; i < glyph.rows; i++ ) {
-        for ( j = 0; j < glyph.horiBearingX; j++ ) printf(" ");
-        printf("|");
-        for ( j = 0; j < glyph.pitch; j++ ) {
-            for ( k = 0; k < 8; k++ ) {
-                if ((( j * 8 ) + k ) >= glyph.width ) break;
-                if (( glyph.buffer[ (i * glyph.pitch) + j ] << k ) & 0x80 )
-                    printf("*");
-                else
-                    printf(( i+1 ) == pFont->pFontDef->pCellBaseOffset ? "." : " ");
-            }
-        }
-        printf("|\n");
-    }
-    for ( i = 0; i < glyph.horiBearingX; i++ ) printf(" ");
-    printf("+");
-    for ( i = 0; i < glyph.width; i++ ) printf("-");
-    printf("+\n");
-
-    free( glyph.buffer );
-}
-
-
-/* ------------------------------------------------------------------------ */
-BOOL write_font( OS2FONTRESOURCE font, ULONG count, USHORT dpi, PSZ pszFileName )
-{
-    /* font records */
-    OS2FONTSTART     recFontSignature = {0};
-    OS2FOCAMETRICS   recFontMetrics   = {0};
-    OS2FONTDEFHEADER recFontDefHeader = {0};
-    OS2ADDMETRICS    recFontPanose    = {0};
-    OS2FONTEND       recFontEnd       = {0};
-
-    PBYTE  pGlyphData = NULL,
-           pOffset    = NULL,
-           pBitmap    = NULL;
-    BYTE   bWidth,
-           bHeight;
-    USHORT i,
-           usPts;
-    FILE  *newFontFile;
-    ULONG  cbBaseOffset,
-           cbOffset,
-           cbCharDefs,
-           cbFont,
-           cbBitmap;
-
-
-    /* default to all glyphs (note that usLastChar is an offset from
-     * usFirstChar, so we add 1 to get the total glyph count)
-     */
-    if ( !count || (count > font.pMetrics->usLastChar ))
-        count = font.pMetrics->usLastChar + 1;
-
-    printf("Saving %u glyphs to output file %s...\n", count, pszFileName );
-
-    /* copy the required header records */
-    memcpy( &recFontSignature, font.pSignature, sizeof( recFontSignature ));
-    memcpy( &recFontMetrics, font.pMetrics, sizeof( recFontMetrics ));
-    memcpy( &recFontDefHeader, font.pFontDef, sizeof( recFontDefHeader ));
-    recFontSignature.ulSize = sizeof( recFontSignature );
-    recFontMetrics.ulSize = sizeof( recFontMetrics );
-    recFontDefHeader.ulSize = sizeof( recFontDefHeader );
-
-    /* we don't support the kerning table feature */
-    recFontMetrics.usKerningPairs = 0;
-
-    /* copy the glyph data */
-    cbFont = 0xFFFF;            /* allocate 64 KB (maximum size of a font resource) */
-    pGlyphData = (PBYTE) malloc( cbFont );
-    if ( !pGlyphData ) {
-        fprintf( stderr, "Failed to allocate memory for glyph data.  Cannot continue.\n");
-        return FALSE;
-    }
-    memset( pGlyphData, 0, cbFont );
-    cbBaseOffset = sizeof( recFontSignature )
-                 + sizeof( recFontMetrics )
-                 + sizeof( recFontDefHeader );
-
-    /* all glyphs have the same cell height */
-    bHeight = recFontDefHeader.yCellHeight;
-
-    if ( font.pFontDef->fsChardef == OS2FONTDEF_CHAR3 ) {       /* Type 3 glyph data */
-        POS2CHARDEF3 pCharDefs,
-                     pCharSrc, pCharDest;
-
-        pCharDefs = (POS2CHARDEF3) pGlyphData;
-
-        /* copy the requested number of character definition records
-         * (adding space for the .null character if needed)
-         */
-        cbCharDefs = (count) * font.pFontDef->usCellSize;
-        if ( font.pMetrics->usFirstChar )
-            cbCharDefs += font.pFontDef->usCellSize;
-        memcpy( pCharDefs, font.data.pABC, cbCharDefs );
-
-        /* keep track of the current offset */
-        pOffset = pGlyphData + cbCharDefs;
-        cbOffset = cbBaseOffset + cbCharDefs;
-
-        /* now copy each corresponding glyph bitmap */
-        for ( i = 0; i < count; i++ ) {
-            pCharSrc = (POS2CHARDEF3)( (PBYTE)font.data.pABC + (i * font.pFontDef->usCellSize) );
-            if ( !pCharSrc->ulOffset ) {
-                fprintf( stderr, "The character definition at index %u is not valid.\n", i );
-                continue;
-            }
-            pBitmap = (PBYTE)font.pSignature + pCharSrc->ulOffset;
-
-            /* get the size of the glyph bitmap */
-            bWidth = ceil( pCharSrc->bSpace / 8.0 );
-            cbBitmap = bWidth * bHeight;
-
-            /* make sure it has the correct offset in the new file */
-            pCharDest = (POS2CHARDEF3)( (PBYTE)pCharDefs + (i * recFontDefHeader.usCellSize) );
-            pCharDest->ulOffset = cbOffset;
-            if (( cbOffset + cbBitmap ) > ( cbFont - 28 )) {
-                printf("Maximum font size reached.\n");
-                break;
-            }
-#ifdef DEBUG
-            printf("Copying ABC-type glyph %u (%ux%u), %u bytes at offset %u\n", i, bWidth, bHeight, cbBitmap, pCharDest->ulOffset );
-#endif
-            memcpy( pOffset, pBitmap, cbBitmap );
-            pOffset += cbBitmap;
-            cbOffset += cbBitmap;
-        }
-
-        /* add the .null character, unless it's already present as glyph 0 */
-        if ( font.pMetrics->usFirstChar ) {
-            pCharDest = (POS2CHARDEF3)( (PBYTE)pCharDefs + (i * recFontDefHeader.usCellSize) );
-            cbBitmap = bHeight;                     /* width is always 1 byte */
-            pCharDest->ulOffset = cbOffset;
-            if (( cbOffset + cbBitmap ) > ( cbFont - 28 )) {
-                printf("Maximum font size reached.\n");
-            }
-            else {
-#ifdef DEBUG
-                printf("Adding .null glyph of %u bytes at offset %u\n", cbBitmap, pCharDest->ulOffset );
-#endif
-                memset( pOffset, 0, cbBitmap );     /* blank glyph bitmap */
-                pOffset += cbBitmap;
-                cbOffset += cbBitmap;
-            }
-        }
-    }
-    else {                                  /* Type 1 or 2 glyph data */
-        POS2CHARDEF1 pCharDefs,
-                     pCharSrc, pCharDest;
-
-        pCharDefs = (POS2CHARDEF1) pGlyphData;
-
-        /* copy the requested number of character definition records
-         * (adding space for the .null character if needed)
-         */
-        cbCharDefs = (count) * font.pFontDef->usCellSize;
-        if ( font.pMetrics->usFirstChar )
-            cbCharDefs += font.pFontDef->usCellSize;
-        memcpy( pCharDefs, font.data.pChars, cbCharDefs );
-
-        /* keep track of the current offset */
-        pOffset = pGlyphData + cbCharDefs;
-        cbOffset = cbBaseOffset + cbCharDefs;
-
-        /* now copy each corresponding glyph bitmap */
-        for ( i = 0; i < count; i++ ) {
-            pCharSrc = (POS2CHARDEF1)( (PBYTE)font.data.pChars + (i * font.pFontDef->usCellSize) );
-            if ( !pCharSrc->ulOffset ) {
-                fprintf( stderr, "The character definition at index %u is not valid.\n", i );
-                continue;
-            }
-            pBitmap = (PBYTE)font.pSignature + pCharSrc->ulOffset;
-
-            /* get the size of the glyph bitmap */
-            bWidth = ceil( pCharSrc->ulWidth / 8.0 );
-            cbBitmap = bWidth * bHeight;
-
-            /* make sure it has the correct offset in the new file */
-            pCharDest = (POS2CHARDEF1)( (PBYTE)pCharDefs + (i * recFontDefHeader.usCellSize) );
-            pCharDest->ulOffset = cbOffset;
-            if (( cbOffset + cbBitmap ) > ( cbFont - 28 )) {
-                printf("Maximum font size reached.\n");
-                break;
-            }
-#ifdef DEBUG
-            printf("Copying single-increment glyph %u (%ux%u), %u bytes from %u at offset %u\n", i, bWidth, bHeight, cbBitmap, pCharSrc->ulOffset, pCharDest->ulOffset );
-#endif
-            memcpy( pOffset, pBitmap, cbBitmap );
-            pOffset += cbBitmap;
-            cbOffset += cbBitmap;
-        }
-
-        /* add the .null character, unless it's already present as glyph 0 */
-        if ( font.pMetrics->usFirstChar ) {
-            pCharDest = (POS2CHARDEF1)( (PBYTE)pCharDefs + (i * recFontDefHeader.usCellSize) );
-            cbBitmap = bHeight;                     /* width is always 1 byte */
-            pCharDest->ulOffset = cbOffset;
-            if (( cbOffset + cbBitmap ) > ( cbFont - 28 )) {
-                printf("Maximum font size reached.\n");
-            }
-            else {
-#ifdef DEBUG
-                printf("Adding .null glyph of %u bytes at offset %u\n", cbBitmap, pCharDest->ulOffset );
-#endif
-                memset( pOffset, 0, cbBitmap );     /* blank glyph bitmap */
-                pOffset += cbBitmap;
-                cbOffset += cbBitmap;
-            }
-        }
-    }
-
-    cbFont = cbOffset;
-    cbOffset -= cbBaseOffset;
-    recFontDefHeader.ulSize = sizeof( recFontDefHeader ) + cbOffset;
-
-    if ( font.pPanose && ( font.pPanose->Identity == SIG_OS2ADDMETRICS )) {
-        memcpy( &recFontPanose, font.pPanose, sizeof( recFontPanose ));
-        recFontPanose.ulSize = sizeof( recFontPanose );
-        cbFont += recFontPanose.ulSize;
-    }
-
-    recFontEnd.Identity = SIG_OS2FONTEND;
-    recFontEnd.ulSize = sizeof( recFontEnd );
-    cbFont += recFontEnd.ulSize;
-
-    /* update the character count metrics */
-    recFontMetrics.usLastChar = count - 1;
-    if ( recFontMetrics.usDefaultChar > recFontMetrics.usLastChar )
-        recFontMetrics.usDefaultChar = recFontMetrics.usFirstChar;
-
-    if (( dpi == 96 ) || ( dpi == 120 )) {
-        usPts = 10 * round( recFontMetrics.yEmHeight / (dpi / 72.0) );
-        recFontMetrics.xDeviceRes = dpi;
-        recFontMetrics.yDeviceRes = dpi;
-        recFontMetrics.usNominalPointSize = usPts;
-        recFontMetrics.usMinimumPointSize = usPts;
-        recFontMetrics.usMaximumPointSize = usPts;
-    }
-
-    /* now save the font*/
-
-    printf("Saving new font %s (%u bytes)...\n", pszFileName, cbFont );
-    newFontFile = fopen( pszFileName, "wb");
-
-    /* font file signature */
-    printf(" - Font signature:    %s\n", recFontSignature.achSignature );
-    fwrite( &recFontSignature, recFontSignature.ulSize, 1, newFontFile );
-
-    /* font metrics */
-    printf(" - Family name:       %s\n - Face name:         %s\n",
-           recFontMetrics.szFamilyname, recFontMetrics.szFacename );
-    printf(" - Point size:        %u (%ux%u dpi)\n",
-           recFontMetrics.usNominalPointSize / 10,
-           recFontMetrics.xDeviceRes, recFontMetrics.yDeviceRes );
-    printf(" - First glyph index: %u\n", recFontMetrics.usFirstChar );
-    printf(" - Last glyph index:  %u\n", recFontMetrics.usLastChar + recFontMetrics.usFirstChar );
-    printf(" - Default character: %u\n", recFontMetrics.usDefaultChar + recFontMetrics.usFirstChar );
-    printf(" - Break character:   %u\n", recFontMetrics.usBreakChar + recFontMetrics.usFirstChar );
-    fwrite( &recFontMetrics, recFontMetrics.ulSize, 1, newFontFile );
-
-    /* character definition header */
-    printf(" - Font type:         ");
-    switch ( recFontDefHeader.fsChardef ) {
-        case OS2FONTDEF_CHAR3:
-            printf("3 (ABC-space proportional-width)\n");
-            break;
-        default:
-            if ( recFontDefHeader.fsFontdef == OS2FONTDEF_FONT2 )
-                printf("2 (single-increment proportional-width)\n");
-            else
-                printf("1 (fixed-width)\n");
-            break;
-    }
-    printf(" - Cell height:       %u\n", recFontDefHeader.yCellHeight );
-    printf(" - Definition length: %u\n", recFontDefHeader.ulSize );
-    fwrite( &recFontDefHeader, sizeof( recFontDefHeader ), 1, newFontFile );
-
-    /* character data */
-    printf(" - Glyph data length: %u\n", cbOffset );
-    fwrite( pGlyphData, cbOffset, 1, newFontFile );
-    free( pGlyphData );
-
-    /* panose table, if present */
-    if ( recFontPanose.Identity == SIG_OS2ADDMETRICS ) {
-        printf(" - PANOSE table:      (%u,%u,%u,%u,%u,%u,%u,%u,%u,%u)\n",
-               recFontPanose.panose[0], recFontPanose.panose[1],
-               recFontPanose.panose[2], recFontPanose.panose[3],
-               recFontPanose.panose[4], recFontPanose.panose[5],
-               recFontPanose.panose[6], recFontPanose.panose[7],
-               recFontPanose.panose[8], recFontPanose.panose[8] );
-        fwrite( &recFontPanose, recFontPanose.ulSize, 1, newFontFile );
-    }
-
-    /* font end signature */
-    printf("\n");
-    fwrite( &recFontEnd, recFontEnd.ulSize, 1, newFontFile );
-
-    fclose( newFontFile );
-    printf("File saved.\n");
-
-    return TRUE;
-}
+/*****************************************************************************
+ *                                                                           *
+ * os2font.c                                                                 *
+ *                                                                           *
+ * Program to parse an OS/2 GPI-format bitmap font and do various things     *
+ * with it.                                                                  *
+ *                                                                           *
+ *  (C) 2012,2023 Alexander Taylor                                           *
+ *                                                                           *
+ *  This code is placed in the public domain.                                *
+ *                                                                           *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <dirent.h>
+#include "otypes.h"
+#include "gpifont.h"
+
+/* Batch conversion runs on multiple threads where POSIX threads are
+ * available; otherwise everything is done on the main thread.
+ */
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <unistd.h>
+#if defined( _POSIX_THREADS ) && ( _POSIX_THREADS > 0 )
+#include <pthread.h>
+#define HAVE_PTHREADS
+#endif
+#endif
+
+#define NO_GLYPH    0xFFFFFFFF
+
+/* A subset of a font's glyphs is a bitmap with one bit per glyph index */
+#define SUBSET_SIZE             ( 0x20000 / 8 )
+#define GLYPH_KEPT( pb, i )     ( (pb)[ (i) >> 3 ] & ( 1 << ( (i) & 7 )))
+#define KEEP_GLYPH( pb, i )     ( (pb)[ (i) >> 3 ] |= ( 1 << ( (i) & 7 )))
+
+/* Batch conversion (see batch_convert) */
+#define BATCH_MAX_THREADS       64
+#define BATCH_OPEN              0xFFFFFFFF  /* task opens a module */
+
+/* Options for a batch conversion */
+typedef struct _Batch_Options {
+    PSZ    pszOutDir;           /* output directory, or NULL to only check fonts */
+    PSZ    pszRanges;           /* ranges of glyphs making up a subset */
+    PSZ    pszTextFile;         /* text whose glyphs make up a subset */
+    BOOL   bIndex;              /* ranges are glyph indices, not codepoints */
+    USHORT dpi;                 /* target DPI of output fonts */
+    ULONG  cThreads;            /* number of threads (0 for one per CPU) */
+    BOOL   bModules;            /* write a font module per input, not FNT files */
+    ULONG  ulPack;              /* OS2PACK_* method for module pages, or 0 */
+} BATCHOPTIONS, *PBATCHOPTIONS;
+
+/* A font module in a batch.  Its faces are kept until all of them have been
+ * converted, and are then freed together by whichever thread finishes last.
+ */
+typedef struct _Batch_Module {
+    PSZ              pszFile;   /* module filename */
+    PSZ              pszStem;   /* start of the output filename */
+    ULONG            cchStem,   /* length of the output filename stem */
+                     ulCopy;    /* number of earlier modules with that stem */
+    POS2FONTMODULE   pModule;   /* the opened module */
+    POS2FONTRESOURCE paFonts;   /* faces retrieved from the module */
+    POS2FONTRESOURCE paOut;     /* converted faces, if writing a module */
+    ULONG            cFaces;    /* number of faces in the module */
+    ULONG            cPending;  /* faces (plus the opening task) not done */
+} BATCHMODULE, *PBATCHMODULE;
+
+/* A unit of batch work: opening a module, or converting one of its faces */
+typedef struct _Batch_Task {
+    PBATCHMODULE pModule;
+    ULONG        ulFace;        /* face number, or BATCH_OPEN */
+} BATCHTASK, *PBATCHTASK;
+
+/* A batch worker thread.  Each has its own queue of tasks: the worker takes
+ * the newest task from its own queue, and when that is empty steals the
+ * oldest task from another worker's.
+ */
+typedef struct _Batch_Worker {
+    struct _Batch_Job *pJob;    /* the batch this worker belongs to */
+#ifdef HAVE_PTHREADS
+    pthread_t       thread;
+    pthread_mutex_t mtx;        /* protects the task queue */
+#endif
+    PBATCHTASK      paTasks;    /* task queue */
+    ULONG           ulHead,     /* oldest task in the queue */
+                    ulTail,     /* end of the queue */
+                    cAlloc;     /* size of the queue array */
+    ULONG           cFiles,     /* modules opened */
+                    cFaces,     /* faces converted */
+                    cModules,   /* font modules written */
+                    cFailed;    /* modules or faces which failed */
+    double          dBytesIn,   /* size of the modules opened */
+                    dBytesOut;  /* size of the fonts written */
+} BATCHWORKER, *PBATCHWORKER;
+
+/* A batch conversion in progress */
+typedef struct _Batch_Job {
+    PBATCHOPTIONS   pOptions;
+    PBATCHWORKER    paWorkers;
+    ULONG           cWorkers;
+#ifdef HAVE_PTHREADS
+    pthread_mutex_t mtx;        /* protects the fields below */
+    pthread_cond_t  cvWork;     /* signalled when a task is queued */
+#endif
+    LONG            cQueued;    /* tasks waiting in the queues (this may
+                                   briefly be -1 while a task is queued) */
+    ULONG           cOutstanding; /* tasks not yet finished */
+} BATCHJOB, *PBATCHJOB;
+
+/* Local function prototypes */
+PSZ base_name( PSZ pszPath );
+BOOL batch_add_input( PSZ pszInput, BOOL fExplicit, PSZ **ppapszFiles, PULONG pcFiles, PULONG pcAlloc );
+ULONG batch_convert( PSZ *papszInputs, ULONG cInputs, PBATCHOPTIONS pOptions );
+void batch_face( PBATCHWORKER pWorker, PBATCHMODULE pMod, ULONG ulFace );
+void batch_module( PBATCHWORKER pWorker, PBATCHMODULE pMod );
+void batch_open( PBATCHWORKER pWorker, PBATCHMODULE pMod );
+BOOL batch_push( PBATCHWORKER pWorker, PBATCHMODULE pMod, ULONG ulFace );
+void batch_release( PBATCHWORKER pWorker, PBATCHMODULE pMod );
+BOOL batch_take( PBATCHWORKER pWorker, PBATCHTASK pTask );
+void *batch_worker( void *pArg );
+ULONG catalog_fonts( PSZ pszIndex, PSZ *papszInputs, ULONG cInputs, BOOL fQuery, ULONG ulChar, ULONG ulPoints );
+int compare_modules( const void *p1, const void *p2 );
+ULONG convert_face( POS2FONTRESOURCE pFont, PBATCHOPTIONS pOptions, PSZ pszFileName, PBYTE *ppFont );
+ULONG dedup_bitmaps( PBYTE *papBitmaps, PULONG pulSizes, ULONG cGlyphs, PULONG pulSame );
+ULONG glyph_bitmap( POS2FONTRESOURCE pFont, ULONG i, PBYTE *ppBitmap );
+BOOL kern_pair_saved( POS2KERNINGPAIRS pPair, ULONG ulFirst, ULONG count, PBYTE pbKeep );
+ULONG link_fonts( PSZ pszModule, PSZ *papszInputs, ULONG cInputs, PBATCHOPTIONS pOptions );
+BOOL match_wildcard( PSZ pszPattern, PSZ pszName );
+void show_error( ULONG error, PSZ pszFile );
+void show_glyph( ULONG ulOffset, POS2FONTRESOURCE pFont );
+LONG stem_order( PBATCHMODULE pMod1, PBATCHMODULE pMod2 );
+BOOL subset_ranges( POS2FONTRESOURCE pFont, PSZ pszRanges, BOOL bIndex, PBYTE pbKeep );
+BOOL subset_text( POS2FONTRESOURCE pFont, PSZ pszFile, PBYTE pbKeep );
+ULONG write_font( OS2FONTRESOURCE font, ULONG count, PBYTE pbKeep, USHORT dpi, PSZ pszFileName, BOOL fQuiet, PBYTE *ppFont );
+
+
+/* ------------------------------------------------------------------------ */
+int main( int argc, char *argv[] )
+{
+    OS2FONTRESOURCE font = {0};
+    BATCHOPTIONS    batch = {0};        /* batch conversion options */
+    CHAR            achOutFile[ 251 ] = {0},
+                    achTextFile[ 251 ] = {0};   /* text whose glyphs make up a subset */
+    BOOL            bOutput = FALSE,    /* write font to output file? */
+                    bBatch = FALSE,     /* convert a batch of files? */
+                    bCatalog = FALSE,   /* build or query a font catalog? */
+                    bLink = FALSE,      /* write a batch of fonts into one module? */
+                    bModules = FALSE,   /* write a module per input in batch mode? */
+                    bQuery = FALSE,     /* look up a character in the catalog? */
+                    bIndex = FALSE;     /* is glyph ID an absolute glyph index (instead of Unicode)? */
+    PSZ             pszFile,            /* input filename */
+                    pszRanges = NULL,   /* ranges of glyphs making up a subset */
+                    pszArg,             /* argument pointer */
+                   *papszInputs = NULL; /* input files or directories (batch or catalog mode) */
+    PBYTE           pbKeep = NULL;      /* subset of glyphs to save */
+    ULONG           number = 0,         /* glyph ID (if bOutput FALSE) or number of glyphs (if bOutput TRUE) */
+                    resource = 0,       /* font number within the input file to read */
+                    total,              /* count of fonts found in the input file */
+                    index,              /* absolute glyph index to read */
+                    threads = 0,        /* number of page unpacking (or batch) threads */
+                    cInputs = 0,        /* number of batch (or catalog) inputs */
+                    query = 0,          /* character to look up in the catalog */
+                    points = 0,         /* point size to look up in the catalog */
+                    pack = 0,           /* OS2PACK_* method for module pages */
+                    error;              /* error code */
+    USHORT          a,                  /* arg loop counter */
+                    dpi = 0;            /* target DPI of output font */
+
+
+    /* parse command-line arguments */
+    if ( argc < 2 ) {
+        printf("OS2FONT <input file> [/F:<n>] [/O:<filename>] [/D:<96|120>] [/I] [/T:<n>]\n");
+        printf("        [/R:<ranges>] [/S:<filename>] [<number>]\n");
+        printf("OS2FONT /B[:<directory>] <input> [<input> ...] [/D:<96|120>] [/I] [/T:<n>]\n");
+        printf("        [/R:<ranges>] [/S:<filename>] [/M] [/X:<n>]\n");
+        printf("OS2FONT /C:<index> [<input> ...] [/Q:<character>] [/P:<points>]\n");
+        printf("OS2FONT /L:<module> <input> [<input> ...] [/D:<96|120>] [/I] [/R:<ranges>]\n");
+        printf("        [/S:<filename>] [/X:<n>]\n\n");
+        printf("<input file>   OS/2-GPI font file to parse; this can be any of the following:\n");
+        printf("                - A plain FNT file (as output by the toolkit Font Editor)\n");
+        printf("                - A font resource DLL (usually with the .FON extension)\n");
+        printf("                - A program DLL (LX or NE format) containing font reources.\n\n");
+        printf("/B:<directory> Batch mode (must come first): convert every font in each of the\n");
+        printf("               given inputs into a separate FNT file in <directory>, named\n");
+        printf("               after the input file and font number (e.g. HELV.0.fnt).  Each\n");
+        printf("               input may be a file, a directory (whose .FON, .FNT and .DLL\n");
+        printf("               files, including those in subdirectories, are converted) or a\n");
+        printf("               filename pattern containing * or ?.  Without a directory, the\n");
+        printf("               fonts are only checked by extracting all of their glyphs.\n\n");
+        printf("/C:<index>     Catalog mode (must come first): record the fonts in each of the\n");
+        printf("               given inputs (as for /B) in the catalog file <index>.  Only\n");
+        printf("               files which are new or have changed since the last scan are\n");
+        printf("               read, and files which are no longer among the inputs are\n");
+        printf("               dropped.  Without inputs, the catalog is used as it is.\n\n");
+        printf("/D:<96|120>    If /O is specified, force the output font's DPI to 96 or 120.\n\n");
+        printf("/F:<n>         Where multiple fonts exist in the file, extract the <n>th font\n");
+        printf("               found, counted from 0 (the default behaviour is /F:0).\n\n");
+        printf("/I             Interpret <number> as a UGL glyph index, instead of a Unicode\n");
+        printf("               codepoint (ignored if /O is specified).\n\n");
+        printf("/L:<module>    Link mode (must come first): write every font in the given\n");
+        printf("               inputs (as for /B) into the single font module <module>,\n");
+        printf("               e.g. to build a .FON file from a set of FNT files.\n\n");
+        printf("/M             In batch mode, write the fonts in each input into a font\n");
+        printf("               module in <directory> (e.g. HELV.fon) instead of FNT files.\n\n");
+        printf("/O:<filename>  Write the parsed font resource into <filename>.\n\n");
+        printf("/P:<points>    With /Q, only list fonts of the given point size.\n\n");
+        printf("/Q:<character> In catalog mode, list the fonts which support the given Unicode\n");
+        printf("               character (given as for <number>) without opening them.\n\n");
+        printf("/R:<ranges>    If /O is specified, save only the glyphs for the given Unicode\n");
+        printf("               codepoints (or UGL glyph indices, if /I is also specified),\n");
+        printf("               as a comma-separated list of hexadecimal values or ranges,\n");
+        printf("               e.g. /R:20-7E,A0-FF,20AC.  May be combined with /S.\n\n");
+        printf("/S:<filename>  If /O is specified, save only the glyphs needed to display the\n");
+        printf("               UTF-8 text in <filename>.  May be combined with /R.\n\n");
+        printf("/T:<n>         Unpack compressed module pages using <n> threads (0 means one\n");
+        printf("               per processor; the default is 1).  In batch mode, convert\n");
+        printf("               fonts using <n> threads (the default is one per processor).\n\n");
+        printf("/X:<n>         Compress the pages of font modules written with /L or /M using\n");
+        printf("               EXEPACK method <n>: 1, or 2 (which needs OS/2 Warp 3 or later).\n");
+        printf("               Add B (e.g. /X:2B) for the best, but much slower, compression.\n\n");
+        printf("<number>       If /O is specified, indicates the number of glyphs (starting\n");
+        printf("               from the first in the font) to copy into the output file.\n");
+        printf("               If /O is not specified, identifies a font character to preview\n");
+        printf("               on-screen.  May be specified in decimal or (if prefixed by 'U'\n");
+        printf("               or '0x') in hexadecimal; in either case it is interpreted as a\n");
+        printf("               Unicode codepoint unless /I or /O is used.\n");
+        return 0;
+    }
+    pszFile = argv[1];
+    if ((( *pszFile == '/') || ( *pszFile == '-')) &&
+        (( tolower( pszFile[1] ) == 'b') || ( tolower( pszFile[1] ) == 'c') ||
+         ( tolower( pszFile[1] ) == 'l')))
+    {
+        bBatch   = ( tolower( pszFile[1] ) == 'b');
+        bCatalog = ( tolower( pszFile[1] ) == 'c');
+        bLink    = ( tolower( pszFile[1] ) == 'l');
+        if (( sscanf( pszFile+2, ":%250s", achOutFile ) == 1 ) && bBatch )
+            batch.pszOutDir = (PSZ) achOutFile;
+        if ( bCatalog && !achOutFile[0] ) {
+            fprintf( stderr, "No catalog file was specified.\n");
+            return 1;
+        }
+        if ( bLink && !achOutFile[0] ) {
+            fprintf( stderr, "No module file was specified.\n");
+            return 1;
+        }
+        papszInputs = (PSZ *) calloc( argc, sizeof( PSZ ));
+        if ( !papszInputs ) {
+            fprintf( stderr, "A memory allocation error occurred.\n");
+            return ERR_MEMORY;
+        }
+    }
+    for ( a = 2; a < argc; a++ ) {
+        pszArg = argv[a];
+        if ( *pszArg == '/' || *pszArg == '-') {
+            pszArg++;
+            if ( !(*pszArg) ) continue;
+            if (( tolower( *pszArg ) == 'o') &&
+                ( sscanf( pszArg+1, ":%250s", achOutFile ) == 1 ))
+            {
+                bOutput = TRUE;
+            }
+            else if ( tolower( *pszArg ) == 'i') {
+                bIndex = TRUE;
+            }
+            else if ( tolower( *pszArg ) == 'f') {
+                if ( !sscanf( pszArg+1, ":%u", &resource ))
+                    resource = 0;
+            }
+            else if ( tolower( *pszArg ) == 'd') {
+                if ( !sscanf( pszArg+1, ":%hu", &dpi ))
+                    dpi = 0;
+            }
+            else if ( tolower( *pszArg ) == 't') {
+                if (( sscanf( pszArg+1, ":%u", &threads ) == 1 ) && !bBatch )
+                    SetOS2UnpackThreads( threads );
+            }
+            else if ( tolower( *pszArg ) == 'r') {
+                if ( pszArg[1] == ':')
+                    pszRanges = pszArg + 2;
+            }
+            else if ( tolower( *pszArg ) == 'p') {
+                if ( !sscanf( pszArg+1, ":%u", &points ))
+                    points = 0;
+            }
+            else if ( tolower( *pszArg ) == 'q') {
+                bQuery = (( pszArg[1] == ':') &&
+                          ( sscanf( pszArg+2, "u%x", &query ) ||
+                            sscanf( pszArg+2, "U%x", &query ) ||
+                            sscanf( pszArg+2, "%i",  &query )    ));
+                if ( !bQuery )
+                    fprintf( stderr, "%s is not a recognized character.\n", pszArg+1 );
+            }
+            else if ( tolower( *pszArg ) == 's') {
+                if ( sscanf( pszArg+1, ":%250s", achTextFile ) != 1 )
+                    achTextFile[0] = 0;
+            }
+            else if ( tolower( *pszArg ) == 'm') {
+                bModules = TRUE;
+            }
+            else if ( tolower( *pszArg ) == 'x') {
+                if (( sscanf( pszArg+1, ":%u", &pack ) != 1 ) || ( pack < 1 ) || ( pack > 2 )) {
+                    fprintf( stderr, "%s is not a recognized compression method.\n", pszArg+1 );
+                    pack = 0;
+                }
+                else {
+                    pack = ( pack == 1 ) ? OS2PACK_EXEPACK1 : OS2PACK_EXEPACK2;
+                    if ( tolower( pszArg[3] ) == 'b')
+                        pack |= OS2PACK_BEST;
+                }
+            }
+
+        }
+        else if ( bBatch || bCatalog || bLink ) {
+            papszInputs[ cInputs++ ] = pszArg;
+        }
+        else if ( !sscanf( pszArg, "u%x", &number ) &&
+                  !sscanf( pszArg, "U%x", &number ) &&
+                  !sscanf( pszArg, "%i",  &number )    )
+        {
+            fprintf( stderr, "%s is not a recognized glyph number.\n", pszArg );
+            number = 0;
+        }
+    }
+
+    /* convert every font in a batch of files, either into separate files
+     * (or modules) or into a single module
+     */
+    if ( bBatch || bLink ) {
+        batch.pszRanges   = pszRanges;
+        batch.pszTextFile = achTextFile[0] ? (PSZ) achTextFile : NULL;
+        batch.bIndex      = bIndex;
+        batch.dpi         = dpi;
+        batch.cThreads    = threads;
+        batch.bModules    = bModules && batch.pszOutDir;
+        batch.ulPack      = pack;
+        if ( bLink )
+            error = link_fonts( (PSZ) achOutFile, papszInputs, cInputs, &batch );
+        else
+            error = batch_convert( papszInputs, cInputs, &batch );
+        free( papszInputs );
+        return error;
+    }
+
+    /* update and/or query a font catalog */
+    if ( bCatalog ) {
+        error = catalog_fonts( (PSZ) achOutFile, papszInputs, cInputs, bQuery, query, points );
+        free( papszInputs );
+        return error;
+    }
+
+    /* try to parse a font from the file */
+    error = MapOS2FontResource( pszFile, resource, &total, &font );
+    if ( error ) {
+        show_error( error, pszFile );
+        return error;
+    }
+
+    /* show font information */
+
+    printf("File %s contains %u fonts.  Reading first font.\n", pszFile, total );
+    printf(" - Font size:         %u bytes\n", font.cbSize );
+    printf(" - Font signature:    %s\n", font.pSignature->achSignature );
+    printf(" - Family name:       %s\n - Face name:         %s\n",
+           font.pMetrics->szFamilyname, font.pMetrics->szFacename );
+    printf(" - Point size:        %u (%ux%u dpi)\n",
+           font.pMetrics->usNominalPointSize / 10,
+           font.pMetrics->xDeviceRes, font.pMetrics->yDeviceRes );
+    printf(" - First glyph index: %u\n", font.pMetrics->usFirstChar );
+    printf(" - Last glyph index:  %u\n", font.pMetrics->usLastChar + font.pMetrics->usFirstChar );
+    printf(" - Default character: %u\n", font.pMetrics->usDefaultChar + font.pMetrics->usFirstChar );
+    printf(" - Break character:   %u\n", font.pMetrics->usBreakChar + font.pMetrics->usFirstChar );
+    printf(" - Font type:         ");
+    switch ( font.pFontDef->fsChardef ) {
+        case OS2FONTDEF_CHAR3:
+            printf("3 (ABC-space proportional-width)\n");
+            break;
+        default:
+            if ( font.pFontDef->fsFontdef == OS2FONTDEF_FONT2 )
+                printf("2 (single-increment proportional-width)\n");
+            else
+                printf("1 (fixed-width)\n");
+            break;
+    }
+    printf(" - Cell height:       %u\n", font.pFontDef->yCellHeight );
+    printf(" - Glyph data length: %u bytes\n", font.pFontDef->ulSize );
+    printf(" - Glyph atlas size:  %u bytes\n", QueryOS2GlyphAtlasSize( &font ));
+
+    if ( font.pMetrics->usKerningPairs )
+        printf(" - %d kerning pairs are defined\n", font.pMetrics->usKerningPairs );
+    if ( font.pPanose )
+        printf(" - PANOSE table:      (%u,%u,%u,%u,%u,%u,%u,%u,%u,%u)\n",
+               font.pPanose->panose[0], font.pPanose->panose[1],
+               font.pPanose->panose[2], font.pPanose->panose[3],
+               font.pPanose->panose[4], font.pPanose->panose[5],
+               font.pPanose->panose[6], font.pPanose->panose[7],
+               font.pPanose->panose[8], font.pPanose->panose[8] );
+    if ( !bOutput && !number ) goto done;
+
+    printf("\n");
+    if ( bOutput && achOutFile[0] ) {
+        /* build the subset of glyphs to save, if one was requested */
+        if ( pszRanges || achTextFile[0] ) {
+            pbKeep = (PBYTE) calloc( SUBSET_SIZE, 1 );
+            if ( !pbKeep ) {
+                fprintf( stderr, "A memory allocation error occurred.\n");
+                goto done;
+            }
+            if (( pszRanges && !subset_ranges( &font, pszRanges, bIndex, pbKeep )) ||
+                ( achTextFile[0] && !subset_text( &font, (PSZ) achTextFile, pbKeep )))
+                goto done;
+        }
+        /* write the output file */
+        write_font( font, number, pbKeep, dpi, achOutFile, FALSE, NULL );
+    }
+    else {
+        /* show the requested glyph */
+        if ( bIndex ) {
+            index = number;
+        }
+        else {
+            index = OS2FontGlyphIndex( &font, number );
+            if ( index == 0 )
+                printf("The character U+%04X is not supported by this font. Loading default glyph %u.\n",
+                        number, font.pMetrics->usFirstChar + font.pMetrics->usDefaultChar );
+            else
+                printf("The character U+%04X corresponds to font glyph index %u.\n", number, index );
+        }
+        show_glyph( index, &font );
+    }
+done:
+    free( pbKeep );
+    FreeOS2FontResource( &font );
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Return the filename part of a path.                                      *
+ * ------------------------------------------------------------------------ */
+PSZ base_name( PSZ pszPath )
+{
+    PSZ psz,
+        pszName = pszPath;
+
+    for ( psz = pszPath; *psz; psz++ )
+        if (( *psz == '/') || ( *psz == '\\') || ( *psz == ':'))
+            pszName = psz + 1;
+    return pszName;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Add the font files named by a batch input to the list of files.  The     *
+ * input may be a file, a directory (whose font files are added, including  *
+ * those in subdirectories) or a filename pattern containing * or ?.  Files *
+ * found in a directory are only added if they have a font file extension.  *
+ * Returns FALSE if memory ran out.                                         *
+ * ------------------------------------------------------------------------ */
+BOOL batch_add_input( PSZ pszInput, BOOL fExplicit, PSZ **ppapszFiles, PULONG pcFiles, PULONG pcAlloc )
+{
+    struct stat    st;
+    struct dirent *pEntry;
+    DIR           *pDir;
+    PSZ            pszName,
+                   pszPattern = NULL,
+                   pszPath,
+                  *papsz;
+    size_t         cchDir;
+    BOOL           fDir,
+                   fOK = TRUE;
+
+    pszName = base_name( pszInput );
+    fDir    = ( !stat( pszInput, &st ) && S_ISDIR( st.st_mode ));
+    if ( !fDir && strpbrk( pszName, "*?")) {
+        pszPattern = pszName;
+        cchDir = pszName - pszInput;
+    }
+    else if ( fDir )
+        cchDir = strlen( pszInput );
+    else {
+        /* a single file */
+        if ( !fExplicit && !match_wildcard("*.fon", pszName ) &&
+             !match_wildcard("*.fnt", pszName ) && !match_wildcard("*.dll", pszName ))
+            return TRUE;
+        if ( *pcFiles == *pcAlloc ) {
+            papsz = (PSZ *) realloc( *ppapszFiles, ( *pcAlloc + 256 ) * sizeof( PSZ ));
+            if ( !papsz ) return FALSE;
+            *ppapszFiles = papsz;
+            *pcAlloc += 256;
+        }
+        (*ppapszFiles)[ *pcFiles ] = strdup( pszInput );
+        if ( !(*ppapszFiles)[ *pcFiles ] ) return FALSE;
+        (*pcFiles)++;
+        return TRUE;
+    }
+
+    /* go through the directory (or the one the pattern applies to) */
+    pszPath = (PSZ) malloc( cchDir + 2 );
+    if ( !pszPath ) return FALSE;
+    memcpy( pszPath, pszInput, cchDir );
+    pszPath[ cchDir ] = 0;
+    pDir = opendir( cchDir ? pszPath : ".");
+    free( pszPath );
+    if ( !pDir ) {
+        fprintf( stderr, "The directory %.*s could not be opened.\n", (int) cchDir, pszInput );
+        return TRUE;
+    }
+    while ( fOK && (( pEntry = readdir( pDir )) != NULL )) {
+        if ( !strcmp( pEntry->d_name, ".") || !strcmp( pEntry->d_name, ".."))
+            continue;
+        if ( pszPattern && !match_wildcard( pszPattern, pEntry->d_name ))
+            continue;
+        pszPath = (PSZ) malloc( cchDir + strlen( pEntry->d_name ) + 2 );
+        if ( !pszPath ) {
+            fOK = FALSE;
+            break;
+        }
+        if ( cchDir && !strchr("/\\:", pszInput[ cchDir - 1 ] ))
+            sprintf( pszPath, "%.*s/%s", (int) cchDir, pszInput, pEntry->d_name );
+        else
+            sprintf( pszPath, "%.*s%s", (int) cchDir, pszInput, pEntry->d_name );
+
+        /* files matching a pattern are taken as they are, but directories
+         * are searched (all the way down) for font files
+         */
+        if ( !pszPattern )
+            fOK = batch_add_input( pszPath, FALSE, ppapszFiles, pcFiles, pcAlloc );
+        else if ( !stat( pszPath, &st ) && !S_ISDIR( st.st_mode ))
+            fOK = batch_add_input( pszPath, TRUE, ppapszFiles, pcFiles, pcAlloc );
+        free( pszPath );
+    }
+    closedir( pDir );
+    return fOK;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Convert (or check) every font in the given files and directories, using  *
+ * a pool of worker threads, and show a summary of the results.  Returns    *
+ * the number of files and fonts which failed.                              *
+ * ------------------------------------------------------------------------ */
+ULONG batch_convert( PSZ *papszInputs, ULONG cInputs, PBATCHOPTIONS pOptions )
+{
+    BATCHJOB       job = {0};
+    PBATCHMODULE   paModules = NULL,
+                  *papSorted = NULL;
+    PSZ           *papszFiles = NULL,
+                   pszExt;
+    struct stat    st;
+    OS2OBJECTCACHESTATS ocs;
+    struct timeval tvStart,
+                   tvEnd;
+    ULONG          cFiles  = 0,
+                   cAlloc  = 0,
+                   cRead   = 0,
+                   cFaces  = 0,
+                   cModules = 0,
+                   cFailed = 0,
+                   cThreads = 1,
+                   i;
+    double         dBytesIn  = 0,
+                   dBytesOut = 0,
+                   dElapsed;
+#ifdef HAVE_PTHREADS
+    long           lCPUs;
+#endif
+
+    if ( !cInputs ) {
+        fprintf( stderr, "No input files were specified.\n");
+        return 1;
+    }
+    if ( pOptions->pszOutDir &&
+         ( stat( pOptions->pszOutDir, &st ) || !S_ISDIR( st.st_mode )))
+    {
+        fprintf( stderr, "The output directory %s does not exist.\n", pOptions->pszOutDir );
+        return 1;
+    }
+
+    gettimeofday( &tvStart, NULL );
+    for ( i = 0; i < cInputs; i++ ) {
+        if ( !batch_add_input( papszInputs[ i ], TRUE, &papszFiles, &cFiles, &cAlloc )) {
+            fprintf( stderr, "A memory allocation error occurred.\n");
+            cFailed = 1;
+            goto done;
+        }
+    }
+    if ( !cFiles ) {
+        fprintf( stderr, "No font files were found.\n");
+        return 1;
+    }
+
+#ifdef HAVE_PTHREADS
+    job.cWorkers = pOptions->cThreads;
+    if ( !job.cWorkers ) {
+#ifdef _SC_NPROCESSORS_ONLN
+        lCPUs = sysconf( _SC_NPROCESSORS_ONLN );
+        job.cWorkers = ( lCPUs > 0 ) ? (ULONG) lCPUs : 1;
+#else
+        job.cWorkers = 1;
+#endif
+    }
+    if ( job.cWorkers > BATCH_MAX_THREADS ) job.cWorkers = BATCH_MAX_THREADS;
+    pthread_mutex_init( &job.mtx, NULL );
+    pthread_cond_init( &job.cvWork, NULL );
+#else
+    job.cWorkers = 1;
+#endif
+    job.pOptions  = pOptions;
+    job.paWorkers = (PBATCHWORKER) calloc( job.cWorkers, sizeof( BATCHWORKER ));
+    paModules     = (PBATCHMODULE) calloc( cFiles, sizeof( BATCHMODULE ));
+    papSorted     = (PBATCHMODULE *) calloc( cFiles, sizeof( PBATCHMODULE ));
+    if ( !job.paWorkers || !paModules || !papSorted ) {
+        fprintf( stderr, "A memory allocation error occurred.\n");
+        cFailed = 1;
+        goto done;
+    }
+    for ( i = 0; i < job.cWorkers; i++ ) {
+        job.paWorkers[ i ].pJob = &job;
+#ifdef HAVE_PTHREADS
+        pthread_mutex_init( &job.paWorkers[ i ].mtx, NULL );
+#endif
+    }
+
+    /* name the output files after the modules (without the extension),
+     * numbering any which would otherwise have the same name
+     */
+    for ( i = 0; i < cFiles; i++ ) {
+        paModules[ i ].pszFile = papszFiles[ i ];
+        paModules[ i ].pszStem = base_name( papszFiles[ i ] );
+        pszExt = strrchr( paModules[ i ].pszStem, '.');
+        paModules[ i ].cchStem = pszExt ? (ULONG)( pszExt - paModules[ i ].pszStem ) :
+                                          strlen( paModules[ i ].pszStem );
+        papSorted[ i ] = paModules + i;
+    }
+    qsort( papSorted, cFiles, sizeof( PBATCHMODULE ), compare_modules );
+    for ( i = 1; i < cFiles; i++ )
+        if ( !stem_order( papSorted[ i - 1 ], papSorted[ i ] ))
+            papSorted[ i ]->ulCopy = papSorted[ i - 1 ]->ulCopy + 1;
+
+    /* deal the modules out to the workers; their faces are queued by the
+     * worker which opens them, and then shared out by stealing
+     */
+    for ( i = 0; i < cFiles; i++ ) {
+        if ( !batch_push( job.paWorkers + ( i % job.cWorkers ), paModules + i, BATCH_OPEN )) {
+            fprintf( stderr, "A memory allocation error occurred.\n");
+            cFailed++;
+        }
+    }
+
+    /* the calling thread is the first worker */
+#ifdef HAVE_PTHREADS
+    for ( ; cThreads < job.cWorkers; cThreads++ )
+        if ( pthread_create( &job.paWorkers[ cThreads ].thread, NULL,
+                             batch_worker, job.paWorkers + cThreads ))
+            break;
+#endif
+    batch_worker( job.paWorkers );
+#ifdef HAVE_PTHREADS
+    for ( i = 1; i < cThreads; i++ )
+        pthread_join( job.paWorkers[ i ].thread, NULL );
+#endif
+    gettimeofday( &tvEnd, NULL );
+
+    for ( i = 0; i < job.cWorkers; i++ ) {
+        cRead     += job.paWorkers[ i ].cFiles;
+        cFaces    += job.paWorkers[ i ].cFaces;
+        cModules  += job.paWorkers[ i ].cModules;
+        cFailed   += job.paWorkers[ i ].cFailed;
+        dBytesIn  += job.paWorkers[ i ].dBytesIn;
+        dBytesOut += job.paWorkers[ i ].dBytesOut;
+    }
+    dElapsed = ( tvEnd.tv_sec - tvStart.tv_sec ) + (( tvEnd.tv_usec - tvStart.tv_usec ) / 1000000.0 );
+    if ( dElapsed <= 0 ) dElapsed = 0.000001;
+
+    printf("Batch %s finished in %.2f seconds using %u threads.\n",
+           pOptions->pszOutDir ? "conversion" : "check", dElapsed, cThreads );
+    printf(" - Files read:        %u of %u (%.1f files/s)\n", cRead, cFiles, cRead / dElapsed );
+    if ( pOptions->pszOutDir )
+        printf(" - Fonts converted:   %u (%.1f fonts/s)\n", cFaces, cFaces / dElapsed );
+    else
+        printf(" - Fonts checked:     %u (%.1f fonts/s)\n", cFaces, cFaces / dElapsed );
+    if ( pOptions->bModules )
+        printf(" - Modules written:   %u (%.1f modules/s)\n", cModules, cModules / dElapsed );
+    printf(" - Bytes read:        %.0f (%.1f MB/s)\n", dBytesIn, dBytesIn / ( dElapsed * 1048576.0 ));
+    printf(" - Bytes written:     %.0f (%.1f MB/s)\n", dBytesOut, dBytesOut / ( dElapsed * 1048576.0 ));
+    QueryOS2ObjectCacheStats( &ocs, FALSE );
+    printf(" - Objects unpacked:  %u (%u more reused from the cache)\n", ocs.ulMisses, ocs.ulHits );
+    printf(" - Failures:          %u\n", cFailed );
+
+done:
+    if ( job.paWorkers ) {
+        for ( i = 0; i < job.cWorkers; i++ ) {
+#ifdef HAVE_PTHREADS
+            pthread_mutex_destroy( &job.paWorkers[ i ].mtx );
+#endif
+            free( job.paWorkers[ i ].paTasks );
+        }
+        free( job.paWorkers );
+    }
+#ifdef HAVE_PTHREADS
+    pthread_mutex_destroy( &job.mtx );
+    pthread_cond_destroy( &job.cvWork );
+#endif
+    free( paModules );
+    free( papSorted );
+    for ( i = 0; i < cFiles; i++ )
+        free( papszFiles[ i ] );
+    free( papszFiles );
+    return cFailed;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Batch task: convert (or check) one face of a module, then release the    *
+ * worker's hold on the module.  When writing font modules, the converted   *
+ * face is kept until the whole module can be written.                      *
+ * ------------------------------------------------------------------------ */
+void batch_face( PBATCHWORKER pWorker, PBATCHMODULE pMod, ULONG ulFace )
+{
+    POS2FONTRESOURCE pFont    = pMod->paFonts + ulFace;
+    PBATCHOPTIONS    pOptions = pWorker->pJob->pOptions;
+    GLYPHBITMAP      glyph;
+    PSZ              pszOutFile;
+    PBYTE            pbFont;
+    ULONG            cbOut,
+                     cBad = 0,
+                     i;
+    BOOL             fOK = FALSE;
+
+    if ( !pOptions->pszOutDir ) {
+        /* just check the font, by extracting every glyph */
+        for ( i = pFont->pMetrics->usFirstChar;
+              i <= (ULONG) pFont->pMetrics->usFirstChar + pFont->pMetrics->usLastChar; i++ )
+        {
+            if ( ExtractOS2FontGlyph( i, pFont, &glyph ))
+                free( glyph.buffer );
+            else
+                cBad++;
+        }
+        if ( cBad )
+            fprintf( stderr, "%u glyphs of font %u in %s could not be extracted.\n",
+                     cBad, ulFace, pMod->pszFile );
+        fOK = !cBad;
+    }
+    else if ( pOptions->bModules ) {
+        cbOut = convert_face( pFont, pOptions, pMod->pszFile, &pbFont );
+        if ( cbOut && ParseOS2FontResource( pbFont, cbOut, pMod->paOut + ulFace )) {
+            memset( pMod->paOut + ulFace, 0, sizeof( OS2FONTRESOURCE ));
+            free( pbFont );
+            cbOut = 0;
+        }
+        fOK = ( cbOut != 0 );
+    }
+    else {
+        pszOutFile = (PSZ) malloc( strlen( pOptions->pszOutDir ) + pMod->cchStem + 32 );
+        if ( !pszOutFile )
+            fprintf( stderr, "A memory allocation error occurred.\n");
+        else {
+            /* the output file is named after the module and face number */
+            if ( pMod->ulCopy )
+                sprintf( pszOutFile, "%s/%.*s~%u.%u.fnt", pOptions->pszOutDir,
+                         (int) pMod->cchStem, pMod->pszStem, pMod->ulCopy, ulFace );
+            else
+                sprintf( pszOutFile, "%s/%.*s.%u.fnt", pOptions->pszOutDir,
+                         (int) pMod->cchStem, pMod->pszStem, ulFace );
+            cbOut = convert_face( pFont, pOptions, pszOutFile, NULL );
+            pWorker->dBytesOut += cbOut;
+            fOK = ( cbOut != 0 );
+        }
+        free( pszOutFile );
+    }
+    if ( fOK )
+        pWorker->cFaces++;
+    else
+        pWorker->cFailed++;
+    batch_release( pWorker, pMod );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Write the faces converted from a batch module (leaving out any which     *
+ * failed) into a font module named after it in the output directory, then  *
+ * free them.                                                               *
+ * ------------------------------------------------------------------------ */
+void batch_module( PBATCHWORKER pWorker, PBATCHMODULE pMod )
+{
+    PBATCHOPTIONS pOptions = pWorker->pJob->pOptions;
+    PSZ           pszOutFile;
+    ULONG         cFonts = 0,
+                  cbOut,
+                  ulRC,
+                  i;
+
+    for ( i = 0; i < pMod->cFaces; i++ )
+        if ( pMod->paOut[ i ].pSignature )
+            pMod->paOut[ cFonts++ ] = pMod->paOut[ i ];
+    if ( cFonts ) {
+        pszOutFile = (PSZ) malloc( strlen( pOptions->pszOutDir ) + pMod->cchStem + 32 );
+        if ( !pszOutFile ) {
+            show_error( ERR_MEMORY, pMod->pszFile );
+            pWorker->cFailed++;
+        }
+        else {
+            if ( pMod->ulCopy )
+                sprintf( pszOutFile, "%s/%.*s~%u.fon", pOptions->pszOutDir,
+                         (int) pMod->cchStem, pMod->pszStem, pMod->ulCopy );
+            else
+                sprintf( pszOutFile, "%s/%.*s.fon", pOptions->pszOutDir,
+                         (int) pMod->cchStem, pMod->pszStem );
+            ulRC = WriteOS2FontModule( pszOutFile, pMod->paOut, cFonts, pOptions->ulPack, &cbOut );
+            if ( ulRC ) {
+                show_error( ulRC, pszOutFile );
+                pWorker->cFailed++;
+            }
+            else {
+                pWorker->cModules++;
+                pWorker->dBytesOut += cbOut;
+            }
+            free( pszOutFile );
+        }
+    }
+    for ( i = 0; i < cFonts; i++ )
+        FreeOS2FontResource( pMod->paOut + i );
+    free( pMod->paOut );
+    pMod->paOut = NULL;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Batch task: open a module and retrieve each of its faces, queueing a     *
+ * task to convert each one as soon as it has been retrieved.               *
+ * ------------------------------------------------------------------------ */
+void batch_open( PBATCHWORKER pWorker, PBATCHMODULE pMod )
+{
+    ULONG ulRC,
+          i;
+
+    ulRC = OpenOS2FontModule( pMod->pszFile, &pMod->pModule );
+    if ( ulRC ) {
+        show_error( ulRC, pMod->pszFile );
+        pWorker->cFailed++;
+        return;
+    }
+    pWorker->cFiles++;
+    pWorker->dBytesIn += pMod->pModule->pMap->cbData;
+
+    pMod->cFaces  = QueryOS2FontModuleFaces( pMod->pModule );
+    pMod->paFonts = (POS2FONTRESOURCE) calloc( pMod->cFaces + 1, sizeof( OS2FONTRESOURCE ));
+    if ( pWorker->pJob->pOptions->bModules )
+        pMod->paOut = (POS2FONTRESOURCE) calloc( pMod->cFaces + 1, sizeof( OS2FONTRESOURCE ));
+    if ( !pMod->paFonts || ( pWorker->pJob->pOptions->bModules && !pMod->paOut )) {
+        show_error( ERR_MEMORY, pMod->pszFile );
+        pWorker->cFailed++;
+        free( pMod->paFonts );
+        free( pMod->paOut );
+        pMod->paFonts = pMod->paOut = NULL;
+        CloseOS2FontModule( pMod->pModule );
+        return;
+    }
+
+    /* Only this thread uses the module itself, so a face can be converted
+     * on another thread while the next one is being retrieved.  Each face
+     * task holds the module until it is done, as does this one until every
+     * face has been queued.
+     */
+    pMod->cPending = pMod->cFaces + 1;
+    for ( i = 0; i < pMod->cFaces; i++ ) {
+        ulRC = GetOS2FontModuleFace( pMod->pModule, i, pMod->paFonts + i );
+        if ( ulRC ) {
+            memset( pMod->paFonts + i, 0, sizeof( OS2FONTRESOURCE ));
+            show_error( ulRC, pMod->pszFile );
+            pWorker->cFailed++;
+            batch_release( pWorker, pMod );
+        }
+        else if ( !batch_push( pWorker, pMod, i ))
+            batch_face( pWorker, pMod, i );
+    }
+    batch_release( pWorker, pMod );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Add a task to the end of a worker's queue.  Returns FALSE if memory ran  *
+ * out (in which case the caller should carry out the task itself).         *
+ * ------------------------------------------------------------------------ */
+BOOL batch_push( PBATCHWORKER pWorker, PBATCHMODULE pMod, ULONG ulFace )
+{
+    PBATCHJOB  pJob = pWorker->pJob;
+    PBATCHTASK paTasks;
+    BOOL       fOK = TRUE;
+
+    /* count the task before anyone can take it, so that the batch never
+     * appears to be finished while it is still in a queue
+     */
+#ifdef HAVE_PTHREADS
+    pthread_mutex_lock( &pJob->mtx );
+#endif
+    pJob->cOutstanding++;
+#ifdef HAVE_PTHREADS
+    pthread_mutex_unlock( &pJob->mtx );
+    pthread_mutex_lock( &pWorker->mtx );
+#endif
+    if ( pWorker->ulTail == pWorker->cAlloc ) {
+        if ( pWorker->ulHead ) {
+            memmove( pWorker->paTasks, pWorker->paTasks + pWorker->ulHead,
+                     ( pWorker->ulTail - pWorker->ulHead ) * sizeof( BATCHTASK ));
+            pWorker->ulTail -= pWorker->ulHead;
+            pWorker->ulHead  = 0;
+        }
+        else {
+            paTasks = (PBATCHTASK) realloc( pWorker->paTasks, ( pWorker->cAlloc + 64 ) * sizeof( BATCHTASK ));
+            if ( paTasks ) {
+                pWorker->paTasks = paTasks;
+                pWorker->cAlloc += 64;
+            }
+            else fOK = FALSE;
+        }
+    }
+    if ( fOK ) {
+        pWorker->paTasks[ pWorker->ulTail ].pModule = pMod;
+        pWorker->paTasks[ pWorker->ulTail ].ulFace  = ulFace;
+        pWorker->ulTail++;
+    }
+#ifdef HAVE_PTHREADS
+    pthread_mutex_unlock( &pWorker->mtx );
+    pthread_mutex_lock( &pJob->mtx );
+#endif
+    if ( fOK ) {
+        pJob->cQueued++;
+#ifdef HAVE_PTHREADS
+        pthread_cond_signal( &pJob->cvWork );
+#endif
+    }
+    else pJob->cOutstanding--;
+#ifdef HAVE_PTHREADS
+    pthread_mutex_unlock( &pJob->mtx );
+#endif
+    return fOK;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Release a worker's hold on a batch module.  When the last is released,   *
+ * the converted faces are written as a font module (if requested), all of  *
+ * the faces are freed and the module is closed.                            *
+ * ------------------------------------------------------------------------ */
+void batch_release( PBATCHWORKER pWorker, PBATCHMODULE pMod )
+{
+    ULONG cPending,
+          i;
+
+#ifdef HAVE_PTHREADS
+    pthread_mutex_lock( &pWorker->pJob->mtx );
+#endif
+    cPending = --pMod->cPending;
+#ifdef HAVE_PTHREADS
+    pthread_mutex_unlock( &pWorker->pJob->mtx );
+#endif
+    if ( cPending ) return;
+
+    if ( pMod->paOut )
+        batch_module( pWorker, pMod );
+
+    for ( i = 0; i < pMod->cFaces; i++ )
+        if ( pMod->paFonts[ i ].ulStorage )
+            FreeOS2FontResource( pMod->paFonts + i );
+    free( pMod->paFonts );
+    pMod->paFonts = NULL;
+    CloseOS2FontModule( pMod->pModule );
+    pMod->pModule = NULL;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Take the next task for a worker: the newest one in its own queue, or if  *
+ * that is empty, the oldest one in another worker's queue.  Returns FALSE  *
+ * if every queue is empty.                                                 *
+ * ------------------------------------------------------------------------ */
+BOOL batch_take( PBATCHWORKER pWorker, PBATCHTASK pTask )
+{
+    PBATCHJOB    pJob = pWorker->pJob;
+    PBATCHWORKER pVictim;
+    ULONG        i;
+    BOOL         fFound = FALSE;
+
+    for ( i = 0; !fFound && ( i < pJob->cWorkers ); i++ ) {
+        pVictim = pJob->paWorkers + ((( pWorker - pJob->paWorkers ) + i ) % pJob->cWorkers );
+#ifdef HAVE_PTHREADS
+        pthread_mutex_lock( &pVictim->mtx );
+#endif
+        if ( pVictim->ulHead < pVictim->ulTail ) {
+            if ( pVictim == pWorker )
+                *pTask = pVictim->paTasks[ --pVictim->ulTail ];
+            else
+                *pTask = pVictim->paTasks[ pVictim->ulHead++ ];
+            if ( pVictim->ulHead == pVictim->ulTail )
+                pVictim->ulHead = pVictim->ulTail = 0;
+            fFound = TRUE;
+        }
+#ifdef HAVE_PTHREADS
+        pthread_mutex_unlock( &pVictim->mtx );
+#endif
+    }
+    if ( fFound ) {
+#ifdef HAVE_PTHREADS
+        pthread_mutex_lock( &pJob->mtx );
+#endif
+        pJob->cQueued--;
+#ifdef HAVE_PTHREADS
+        pthread_mutex_unlock( &pJob->mtx );
+#endif
+    }
+    return fFound;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Batch worker thread: carry out tasks until every task in the batch has   *
+ * been finished, waiting for more to be queued whenever none are left to   *
+ * take.                                                                    *
+ * ------------------------------------------------------------------------ */
+void *batch_worker( void *pArg )
+{
+    PBATCHWORKER pWorker = (PBATCHWORKER) pArg;
+    PBATCHJOB    pJob    = pWorker->pJob;
+    BATCHTASK    task;
+    BOOL         fDone = FALSE;
+
+    while ( !fDone ) {
+        if ( batch_take( pWorker, &task )) {
+            if ( task.ulFace == BATCH_OPEN )
+                batch_open( pWorker, task.pModule );
+            else
+                batch_face( pWorker, task.pModule, task.ulFace );
+#ifdef HAVE_PTHREADS
+            pthread_mutex_lock( &pJob->mtx );
+            if ( !--pJob->cOutstanding )
+                pthread_cond_broadcast( &pJob->cvWork );
+            pthread_mutex_unlock( &pJob->mtx );
+#else
+            pJob->cOutstanding--;
+#endif
+            continue;
+        }
+#ifdef HAVE_PTHREADS
+        pthread_mutex_lock( &pJob->mtx );
+        while (( pJob->cQueued <= 0 ) && pJob->cOutstanding )
+            pthread_cond_wait( &pJob->cvWork, &pJob->mtx );
+        fDone = !pJob->cOutstanding;
+        pthread_mutex_unlock( &pJob->mtx );
+#else
+        fDone = TRUE;
+#endif
+    }
+    return NULL;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Bring a font catalog up to date with the font files in the given inputs  *
+ * (if any), dropping any files which are no longer among them, and then    *
+ * list the fonts which support the requested character (if any) using      *
+ * only the catalog.  Returns the number of files which could not be read.  *
+ * ------------------------------------------------------------------------ */
+ULONG catalog_fonts( PSZ pszIndex, PSZ *papszInputs, ULONG cInputs, BOOL fQuery, ULONG ulChar, ULONG ulPoints )
+{
+    POS2FONTCATALOG  pCatalog;
+    OS2CATALOGSTATS  stats;
+    POS2CATALOGMATCH paMatches = NULL;
+    POS2CATALOGFACE  pFace;
+    PSZ             *papszFiles = NULL;
+    struct timeval   tvStart,
+                     tvEnd;
+    ULONG            cFiles  = 0,
+                     cAlloc  = 0,
+                     cFailed = 0,
+                     cFound,
+                     error,
+                     i;
+    double           dElapsed;
+
+    error = OpenOS2FontCatalog( pszIndex, &pCatalog );
+    if ( error ) {
+        show_error( error, pszIndex );
+        return 1;
+    }
+
+    /* rescan the inputs; only the files which are new or have changed are
+     * actually read
+     */
+    if ( cInputs ) {
+        gettimeofday( &tvStart, NULL );
+        for ( i = 0; i < cInputs; i++ ) {
+            if ( !batch_add_input( papszInputs[ i ], TRUE, &papszFiles, &cFiles, &cAlloc )) {
+                fprintf( stderr, "A memory allocation error occurred.\n");
+                cFailed = 1;
+                goto done;
+            }
+        }
+        for ( i = 0; i < cFiles; i++ ) {
+            error = UpdateOS2FontCatalog( pCatalog, papszFiles[ i ] );
+            if ( error && ( error != ERR_NO_FONT ) && ( error != ERR_FILE_FORMAT )) {
+                show_error( error, papszFiles[ i ] );
+                cFailed++;
+            }
+        }
+        PruneOS2FontCatalog( pCatalog );
+        if ( SaveOS2FontCatalog( pCatalog )) {
+            fprintf( stderr, "The catalog could not be written to %s.\n", pszIndex );
+            cFailed++;
+        }
+        gettimeofday( &tvEnd, NULL );
+        dElapsed = ( tvEnd.tv_sec - tvStart.tv_sec ) + (( tvEnd.tv_usec - tvStart.tv_usec ) / 1000000.0 );
+
+        QueryOS2FontCatalogStats( pCatalog, &stats );
+        printf("Catalog %s updated in %.2f seconds.\n", pszIndex, dElapsed );
+        printf(" - Files parsed:      %u\n", stats.cParsed );
+        printf(" - Files unchanged:   %u\n", stats.cUnchanged );
+        printf(" - Files removed:     %u\n", stats.cRemoved );
+        printf(" - Fonts catalogued:  %u (in %u files)\n", stats.cFaces, stats.cFiles );
+        printf(" - Failures:          %u\n", cFailed );
+    }
+    else if ( !fQuery ) {
+        QueryOS2FontCatalogStats( pCatalog, &stats );
+        printf("Catalog %s holds %u fonts in %u files.\n", pszIndex, stats.cFaces, stats.cFiles );
+    }
+
+    /* list the fonts which support the character */
+    if ( fQuery ) {
+        cFound = QueryOS2FontCatalog( pCatalog, ulChar, ulPoints * 10, NULL, 0 );
+        if ( cFound ) {
+            paMatches = (POS2CATALOGMATCH) calloc( cFound, sizeof( OS2CATALOGMATCH ));
+            if ( !paMatches ) {
+                fprintf( stderr, "A memory allocation error occurred.\n");
+                cFailed++;
+                goto done;
+            }
+            QueryOS2FontCatalog( pCatalog, ulChar, ulPoints * 10, paMatches, cFound );
+        }
+        if ( cInputs ) printf("\n");
+        if ( ulPoints )
+            printf("%u fonts support the character U+%04X at %u points.\n", cFound, ulChar, ulPoints );
+        else
+            printf("%u fonts support the character U+%04X.\n", cFound, ulChar );
+        for ( i = 0; i < cFound; i++ ) {
+            pFace = paMatches[ i ].pFace;
+            printf(" - %s, %u pt (%ux%u dpi, codepage %u): %s, font %u (resource %u)\n",
+                   pFace->szFacename, pFace->usPointSize / 10, pFace->xDeviceRes,
+                   pFace->yDeviceRes, pFace->usCodePage, paMatches[ i ].pszFile,
+                   pFace->usFace, pFace->usResourceID );
+        }
+    }
+
+done:
+    free( paMatches );
+    for ( i = 0; i < cFiles; i++ )
+        free( papszFiles[ i ] );
+    free( papszFiles );
+    CloseOS2FontCatalog( pCatalog );
+    return cFailed;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * qsort() comparison function for batch modules: orders them by output     *
+ * filename stem, and then by their original order.                         *
+ * ------------------------------------------------------------------------ */
+int compare_modules( const void *p1, const void *p2 )
+{
+    PBATCHMODULE pMod1 = *(PBATCHMODULE *) p1,
+                 pMod2 = *(PBATCHMODULE *) p2;
+    LONG         lOrder;
+
+    lOrder = stem_order( pMod1, pMod2 );
+    if ( lOrder ) return lOrder;
+    return ( pMod1 < pMod2 ) ? -1 : ( pMod1 > pMod2 );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Convert a font as the batch options ask: keep the requested subset of    *
+ * its glyphs (if any) and force the requested DPI (if any), then save it   *
+ * as a FNT file or, if ppFont is not NULL, return it in an allocated       *
+ * buffer (see write_font).  Returns the size of the new font, or 0 on      *
+ * error.                                                                   *
+ * ------------------------------------------------------------------------ */
+ULONG convert_face( POS2FONTRESOURCE pFont, PBATCHOPTIONS pOptions, PSZ pszFileName, PBYTE *ppFont )
+{
+    PBYTE pbKeep = NULL;
+    ULONG cbOut  = 0;
+
+    if ( pOptions->pszRanges || pOptions->pszTextFile ) {
+        pbKeep = (PBYTE) calloc( SUBSET_SIZE, 1 );
+        if ( !pbKeep ) {
+            fprintf( stderr, "A memory allocation error occurred.\n");
+            return 0;
+        }
+    }
+    if (( !pOptions->pszRanges ||
+          subset_ranges( pFont, pOptions->pszRanges, pOptions->bIndex, pbKeep )) &&
+        ( !pOptions->pszTextFile ||
+          subset_text( pFont, pOptions->pszTextFile, pbKeep )))
+        cbOut = write_font( *pFont, 0, pbKeep, pOptions->dpi, pszFileName, TRUE, ppFont );
+    free( pbKeep );
+    return cbOut;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Find glyphs whose bitmaps are identical to an earlier glyph's, using a   *
+ * hash of the bitmap bytes.  On return, pulSame[i] is the first glyph with *
+ * the same bitmap as glyph i (i itself if there is none, or if the glyph   *
+ * has no bitmap).  Returns the total size of the distinct bitmaps.         *
+ * ------------------------------------------------------------------------ */
+ULONG dedup_bitmaps( PBYTE *papBitmaps, PULONG pulSizes, ULONG cGlyphs, PULONG pulSame )
+{
+    PULONG pulSlots;            /* hash table of distinct glyphs */
+    ULONG  cSlots,
+           ulHash,
+           cbTotal = 0,
+           i, j, n;
+
+    for ( cSlots = 16; cSlots < ( cGlyphs * 2 ); cSlots <<= 1 );
+    pulSlots = (PULONG) malloc( cSlots * sizeof( ULONG ));
+    if ( pulSlots ) memset( pulSlots, 0xFF, cSlots * sizeof( ULONG ));
+
+    for ( i = 0; i < cGlyphs; i++ ) {
+        pulSame[ i ] = i;
+        if ( !pulSizes[ i ] ) continue;
+        cbTotal += pulSizes[ i ];
+        if ( !pulSlots ) continue;
+
+        /* FNV-1a hash of the bitmap */
+        for ( ulHash = 2166136261UL, n = 0; n < pulSizes[ i ]; n++ )
+            ulHash = ( ulHash ^ papBitmaps[ i ][ n ] ) * 16777619UL;
+        for ( n = ulHash & ( cSlots - 1 ); ( j = pulSlots[ n ] ) != NO_GLYPH; n = ( n + 1 ) & ( cSlots - 1 ))
+            if (( pulSizes[ j ] == pulSizes[ i ] ) &&
+                (( papBitmaps[ j ] == papBitmaps[ i ] ) || !memcmp( papBitmaps[ j ], papBitmaps[ i ], pulSizes[ i ] )))
+                break;
+        if ( j == NO_GLYPH )
+            pulSlots[ n ] = i;
+        else {
+            pulSame[ i ] = j;
+            cbTotal -= pulSizes[ i ];
+        }
+    }
+    free( pulSlots );
+    return cbTotal;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Find the bitmap of the glyph at offset i within the font, and return its *
+ * size in bytes (or 0 if the character definition is not valid, or the     *
+ * bitmap lies outside the font data).                                      *
+ * ------------------------------------------------------------------------ */
+ULONG glyph_bitmap( POS2FONTRESOURCE pFont, ULONG i, PBYTE *ppBitmap )
+{
+    POS2CHARDEF1 pChar1;
+    POS2CHARDEF3 pChar3;
+    ULONG        cx,
+                 cb;
+
+    if ( pFont->pFontDef->fsChardef == OS2FONTDEF_CHAR3 ) {
+        pChar3 = (POS2CHARDEF3)( (PBYTE)pFont->data.pABC + (i * pFont->pFontDef->usCellSize) );
+        if ( !pChar3->ulOffset ) return 0;
+        *ppBitmap = (PBYTE)pFont->pSignature + pChar3->ulOffset;
+        cx = (USHORT) pChar3->bSpace;
+    }
+    else {
+        pChar1 = (POS2CHARDEF1)( (PBYTE)pFont->data.pChars + (i * pFont->pFontDef->usCellSize) );
+        if ( !pChar1->ulOffset ) return 0;
+        *ppBitmap = (PBYTE)pFont->pSignature + pChar1->ulOffset;
+        cx = pChar1->ulWidth;
+    }
+    cb = (( cx + 7 ) / 8 ) * pFont->pFontDef->yCellHeight;
+    if (( (ULONG)( *ppBitmap - (PBYTE)pFont->pSignature ) + cb ) > pFont->cbSize ) return 0;
+    return cb;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Check whether both glyphs of a kerning pair lie within the <count>       *
+ * glyphs being saved starting at glyph index ulFirst (and, for a subset,   *
+ * are both in it), i.e. whether write_font() saves the pair.               *
+ * ------------------------------------------------------------------------ */
+BOOL kern_pair_saved( POS2KERNINGPAIRS pPair, ULONG ulFirst, ULONG count, PBYTE pbKeep )
+{
+    ULONG ulLast   = ulFirst + count - 1,
+          ulFirstC = (USHORT) pPair->sFirstChar,
+          ulSecond = (USHORT) pPair->sSecondChar;
+
+    if (( ulFirstC < ulFirst ) || ( ulFirstC > ulLast ) ||
+        ( ulSecond < ulFirst ) || ( ulSecond > ulLast ))
+        return FALSE;
+    return ( !pbKeep || ( GLYPH_KEPT( pbKeep, ulFirstC ) && GLYPH_KEPT( pbKeep, ulSecond )));
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Convert every font in the given inputs (as batch_convert would, but one  *
+ * at a time) and write them all into the single font module pszModule, in  *
+ * the order found.  Returns the number of files and fonts which failed.    *
+ * ------------------------------------------------------------------------ */
+ULONG link_fonts( PSZ pszModule, PSZ *papszInputs, ULONG cInputs, PBATCHOPTIONS pOptions )
+{
+    POS2FONTMODULE   pModule;
+    POS2FONTRESOURCE paFonts = NULL,
+                     paMore;
+    OS2FONTRESOURCE  font;
+    PSZ             *papszFiles = NULL;
+    PBYTE            pbFont;
+    ULONG            cFiles  = 0,
+                     cAlloc  = 0,
+                     cFonts  = 0,
+                     cMax    = 0,
+                     cFailed = 0,
+                     cFaces,
+                     cbFont,
+                     cbModule,
+                     ulRC,
+                     i, j;
+
+    if ( !cInputs ) {
+        fprintf( stderr, "No input files were specified.\n");
+        return 1;
+    }
+    for ( i = 0; i < cInputs; i++ ) {
+        if ( !batch_add_input( papszInputs[ i ], TRUE, &papszFiles, &cFiles, &cAlloc )) {
+            fprintf( stderr, "A memory allocation error occurred.\n");
+            cFailed = 1;
+            goto done;
+        }
+    }
+    if ( !cFiles ) {
+        fprintf( stderr, "No font files were found.\n");
+        return 1;
+    }
+
+    for ( i = 0; i < cFiles; i++ ) {
+        ulRC = OpenOS2FontModule( papszFiles[ i ], &pModule );
+        if ( ulRC ) {
+            show_error( ulRC, papszFiles[ i ] );
+            cFailed++;
+            continue;
+        }
+        cFaces = QueryOS2FontModuleFaces( pModule );
+        for ( j = 0; j < cFaces; j++ ) {
+            if ( cFonts == cMax ) {
+                paMore = (POS2FONTRESOURCE) realloc( paFonts, ( cMax + 64 ) * sizeof( OS2FONTRESOURCE ));
+                if ( !paMore ) {
+                    fprintf( stderr, "A memory allocation error occurred.\n");
+                    CloseOS2FontModule( pModule );
+                    cFailed++;
+                    goto done;
+                }
+                paFonts = paMore;
+                cMax   += 64;
+            }
+            ulRC = GetOS2FontModuleFace( pModule, j, &font );
+            if ( ulRC ) {
+                show_error( ulRC, papszFiles[ i ] );
+                cFailed++;
+                continue;
+            }
+            cbFont = convert_face( &font, pOptions, papszFiles[ i ], &pbFont );
+            FreeOS2FontResource( &font );
+            if ( cbFont && !ParseOS2FontResource( pbFont, cbFont, paFonts + cFonts ))
+                cFonts++;
+            else {
+                if ( cbFont ) free( pbFont );
+                cFailed++;
+            }
+        }
+        CloseOS2FontModule( pModule );
+    }
+
+    if ( cFonts > 0xFFFE ) {
+        fprintf( stderr, "A font module can hold no more than 65534 fonts.\n");
+        cFailed++;
+    }
+    else if ( cFonts ) {
+        ulRC = WriteOS2FontModule( pszModule, paFonts, cFonts, pOptions->ulPack, &cbModule );
+        if ( ulRC ) {
+            show_error( ulRC, pszModule );
+            cFailed++;
+        }
+        else
+            printf("Wrote %u fonts from %u files to %s (%u bytes).\n",
+                   cFonts, cFiles, pszModule, cbModule );
+    }
+
+done:
+    for ( i = 0; i < cFonts; i++ )
+        FreeOS2FontResource( paFonts + i );
+    free( paFonts );
+    for ( i = 0; i < cFiles; i++ )
+        free( papszFiles[ i ] );
+    free( papszFiles );
+    return cFailed;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Check whether a filename matches a pattern, in which * stands for any    *
+ * number of characters and ? for any single character (ignoring case).     *
+ * ------------------------------------------------------------------------ */
+BOOL match_wildcard( PSZ pszPattern, PSZ pszName )
+{
+    PSZ pszStar   = NULL,       /* pattern following the last '*' seen */
+        pszResume = NULL;       /* where in the name to try it again */
+
+    while ( *pszName ) {
+        if ( *pszPattern == '*') {
+            pszStar   = ++pszPattern;
+            pszResume = pszName;
+        }
+        else if (( *pszPattern == '?') ||
+                 ( tolower( (UCHAR) *pszPattern ) == tolower( (UCHAR) *pszName )))
+        {
+            pszPattern++;
+            pszName++;
+        }
+        else if ( pszStar ) {
+            pszPattern = pszStar;
+            pszName    = ++pszResume;
+        }
+        else return FALSE;
+    }
+    while ( *pszPattern == '*') pszPattern++;
+    return ( *pszPattern == 0 );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Show the message for an error returned while reading a font file.        *
+ * ------------------------------------------------------------------------ */
+void show_error( ULONG error, PSZ pszFile )
+{
+    switch ( error ) {
+        case ERR_FILE_OPEN:
+            fprintf( stderr, "The file %s could not be opened.\n", pszFile );
+            break;
+        case ERR_FILE_STAT:
+        case ERR_FILE_READ:
+            fprintf( stderr, "Failed to read file %s.\n", pszFile );
+            break;
+        case ERR_FILE_FORMAT:
+            fprintf( stderr, "The file %s does not contain a valid font.\n", pszFile );
+            break;
+        case ERR_FILE_WRITE:
+            fprintf( stderr, "Failed to write file %s.\n", pszFile );
+            break;
+        case ERR_NO_FONT:
+            fprintf( stderr, "The requested font number was not found in %s\n", pszFile );
+            break;
+        case ERR_MEMORY:
+            fprintf( stderr, "A memory allocation error occurred.\n");
+            break;
+        default:
+            fprintf( stderr, "An unknown error occurred.\n");
+            break;
+    }
+}
+
+
+/* ------------------------------------------------------------------------ */
+void show_glyph( ULONG ulOffset, POS2FONTRESOURCE pFont )
+{
+    GLYPHBITMAP glyph;
+    USHORT      i, j, k;
+
+    if ( ! ExtractOS2FontGlyph( ulOffset, pFont, &glyph )) {
+        fprintf( stderr, "Failed to extract glyph bitmap.\n");
+        return;
+    }
+
+    /* now draw the bitmap (inside a border indicating the cell size) */
+    for ( i = 0; i < glyph.horiBearingX; i++ ) printf(" ");
+    printf("+");
+    for ( i = 0; i < glyph.width; i++ ) printf("-");
+    printf("+\n");
+    for ( i = 0; i < glyph.rows; i++ ) {
+        for ( j = 0; j < glyph.horiBearingX; j++ ) printf(" ");
+        printf("|");
+        for ( j = 0; j < glyph.pitch; j++ ) {
+            for ( k = 0; k < 8; k++ ) {
+                if ((( j * 8 ) + k ) >= glyph.width ) break;
+                if (( glyph.buffer[ (i * glyph.pitch) + j ] << k ) & 0x80 )
+                    printf("*");
+                else
+                    printf(( i+1 ) == pFont->pFontDef->pCellBaseOffset ? "." : " ");
+            }
+        }
+        printf("|\n");
+    }
+    for ( i = 0; i < glyph.horiBearingX; i++ ) printf(" ");
+    printf("+");
+    for ( i = 0; i < glyph.width; i++ ) printf("-");
+    printf("+\n");
+
+    free( glyph.buffer );
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Compare the output filename stems of two batch modules, ignoring case.   *
+ * ------------------------------------------------------------------------ */
+LONG stem_order( PBATCHMODULE pMod1, PBATCHMODULE pMod2 )
+{
+    ULONG i;
+    LONG  lDiff;
+
+    for ( i = 0; ( i < pMod1->cchStem ) && ( i < pMod2->cchStem ); i++ ) {
+        lDiff = tolower( (UCHAR) pMod1->pszStem[ i ] ) - tolower( (UCHAR) pMod2->pszStem[ i ] );
+        if ( lDiff ) return lDiff;
+    }
+    return (LONG) pMod1->cchStem - (LONG) pMod2->cchStem;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Add the glyphs for a list of codepoints or glyph indices to a subset.    *
+ * The list is a comma-separated set of hexadecimal values (each optionally *
+ * prefixed by "U+") or ranges, e.g. "20-7E,U+20AC".  Codepoints are mapped *
+ * to glyphs with OS2FontGlyphIndex(); those the font lacks are ignored.    *
+ * ------------------------------------------------------------------------ */
+BOOL subset_ranges( POS2FONTRESOURCE pFont, PSZ pszRanges, BOOL bIndex, PBYTE pbKeep )
+{
+    ULONG ulFirst = pFont->pMetrics->usFirstChar,
+          ulLast  = ulFirst + pFont->pMetrics->usLastChar,
+          ulFrom,
+          ulTo,
+          c, g;
+    PSZ   psz = pszRanges,
+          pszEnd;
+
+    while ( *psz ) {
+        if (( tolower( psz[0] ) == 'u') && ( psz[1] == '+')) psz += 2;
+        ulFrom = ulTo = strtoul( psz, &pszEnd, 16 );
+        if ( pszEnd == psz ) break;
+        psz = pszEnd;
+        if ( *psz == '-') {
+            psz++;
+            if (( tolower( psz[0] ) == 'u') && ( psz[1] == '+')) psz += 2;
+            ulTo = strtoul( psz, &pszEnd, 16 );
+            if ( pszEnd == psz ) break;
+            psz = pszEnd;
+        }
+        if (( *psz && ( *psz != ',')) || ( ulTo < ulFrom ) || ( ulTo > 0x10FFFF )) break;
+        if ( *psz ) psz++;
+
+        for ( c = ulFrom; c <= ulTo; c++ ) {
+            g = bIndex ? c : OS2FontGlyphIndex( pFont, c );
+            if ( g && ( g >= ulFirst ) && ( g <= ulLast ))
+                KEEP_GLYPH( pbKeep, g );
+        }
+    }
+    if ( *psz ) {
+        fprintf( stderr, "%s is not a valid list of ranges.\n", pszRanges );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Add the glyphs needed to display the UTF-8 text in a file to a subset.   *
+ * ------------------------------------------------------------------------ */
+BOOL subset_text( POS2FONTRESOURCE pFont, PSZ pszFile, PBYTE pbKeep )
+{
+    FILE  *pf;
+    PBYTE  pText;
+    ULONG  aulGlyphs[ 256 ],
+           ulFirst = pFont->pMetrics->usFirstChar,
+           ulLast  = ulFirst + pFont->pMetrics->usLastChar,
+           cbText,
+           ofText,
+           cbUsed,
+           cGlyphs,
+           i;
+    long   lSize;
+
+    pf = fopen( pszFile, "rb");
+    if ( !pf ) {
+        fprintf( stderr, "The file %s could not be opened.\n", pszFile );
+        return FALSE;
+    }
+    fseek( pf, 0, SEEK_END );
+    lSize = ftell( pf );
+    fseek( pf, 0, SEEK_SET );
+    pText = ( lSize >= 0 ) ? (PBYTE) malloc( lSize + 1 ) : NULL;
+    if ( !pText ) {
+        fprintf( stderr, "Failed to read file %s.\n", pszFile );
+        fclose( pf );
+        return FALSE;
+    }
+    cbText = fread( pText, 1, lSize, pf );
+    fclose( pf );
+
+    for ( ofText = 0; ofText < cbText; ofText += cbUsed ) {
+        cGlyphs = OS2FontGlyphIndices( pFont, pText + ofText, cbText - ofText,
+                                       OS2TEXT_UTF8, aulGlyphs, 256, &cbUsed );
+        if ( !cbUsed ) break;
+        for ( i = 0; i < cGlyphs; i++ )
+            if ( aulGlyphs[ i ] && ( aulGlyphs[ i ] >= ulFirst ) && ( aulGlyphs[ i ] <= ulLast ))
+                KEEP_GLYPH( pbKeep, aulGlyphs[ i ] );
+    }
+    free( pText );
+    return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------ *
+ * Save the first <count> glyphs of the font (all of them if 0), or if      *
+ * pbKeep is not NULL, only the glyphs in that subset, as a new FNT file.   *
+ * If ppFont is not NULL, the new font is returned in an allocated buffer   *
+ * instead (pszFileName then only names it in messages).  Unless fQuiet is  *
+ * TRUE, progress and the new font's details are shown.  Returns the size   *
+ * of the font, or 0 on error.                                              *
+ * ------------------------------------------------------------------------ */
+ULONG write_font( OS2FONTRESOURCE font, ULONG count, PBYTE pbKeep, USHORT dpi, PSZ pszFileName, BOOL fQuiet, PBYTE *ppFont )
+{
+    /* font records */
+    OS2FONTSTART     recFontSignature = {0};
+    OS2FOCAMETRICS   recFontMetrics   = {0};
+    OS2FONTDEFHEADER recFontDefHeader = {0};
+    OS2KERNPAIRTABLE recFontKerning   = {0};
+    OS2ADDMETRICS    recFontPanose    = {0};
+    OS2FONTEND       recFontEnd       = {0};
+
+    POS2CHARDEF1 pCharDest;     /* ulOffset comes first in every type of definition */
+    POS2KERNINGPAIRS pKernPairs = NULL;     /* kerning pairs of the source font */
+    PBYTE  pFile   = NULL,
+           pBitmap = NULL,
+           pNull   = NULL,      /* blank bitmap for the .null glyph */
+          *papBitmaps;          /* bitmap of each glyph (and the .null glyph) */
+    PULONG pulSizes,            /* size of each glyph bitmap */
+           pulSame,             /* first glyph with an identical bitmap */
+           pulSource;           /* source font glyph saved in each position */
+    USHORT usPts;
+    FILE  *newFontFile;
+    ULONG  i,
+           ulFirst    = font.pMetrics->usFirstChar,
+           ulFrom     = 0,      /* offset of the first glyph saved */
+           ulDefault  = font.pMetrics->usDefaultChar,
+           cKernPairs = 0,
+           cSrcPairs  = 0,      /* number of pairs at pKernPairs */
+           cKept      = 0,
+           cInvalid   = 0,
+           cbBaseOffset,
+           cbOffset,
+           cbCharDefs,
+           cbGlyphData,
+           cbBitmaps,
+           cbFont,
+           cbNull,
+           cbKernPairs,         /* space for pairs after the kerning table */
+           cbBitmap;
+    BOOL   fOK;
+
+
+    if ( pbKeep ) {
+        /* save the range of glyphs from the first to the last in the subset,
+         * which always includes the default and break characters
+         */
+        KEEP_GLYPH( pbKeep, ulFirst + ulDefault );
+        if ( font.pMetrics->usBreakChar <= font.pMetrics->usLastChar )
+            KEEP_GLYPH( pbKeep, ulFirst + font.pMetrics->usBreakChar );
+        for ( i = 0, count = 0; i <= (ULONG) font.pMetrics->usLastChar; i++ ) {
+            if ( !GLYPH_KEPT( pbKeep, ulFirst + i )) continue;
+            if ( !count ) ulFrom = i;
+            count = i - ulFrom + 1;
+            cKept++;
+        }
+        if ( !fQuiet )
+            printf("Saving a subset of %u glyphs (%u to %u) to output file %s...\n",
+                   cKept, ulFirst + ulFrom, ulFirst + ulFrom + count - 1, pszFileName );
+    }
+    else {
+        /* default to all glyphs (note that usLastChar is an offset from
+         * usFirstChar, so we add 1 to get the total glyph count)
+         */
+        if ( !count || (count > font.pMetrics->usLastChar ))
+            count = font.pMetrics->usLastChar + 1;
+
+        if ( !fQuiet )
+            printf("Saving %u glyphs to output file %s...\n", count, pszFileName );
+    }
+
+    /* copy the required header records */
+    memcpy( &recFontSignature, font.pSignature, sizeof( recFontSignature ));
+    memcpy( &recFontMetrics, font.pMetrics, sizeof( recFontMetrics ));
+    memcpy( &recFontDefHeader, font.pFontDef, sizeof( recFontDefHeader ));
+    recFontSignature.ulSize = sizeof( recFontSignature );
+    recFontMetrics.ulSize = sizeof( recFontMetrics );
+    recFontDefHeader.ulSize = sizeof( recFontDefHeader );
+    cbBaseOffset = sizeof( recFontSignature )
+                 + sizeof( recFontMetrics )
+                 + sizeof( recFontDefHeader );
+
+    /* find the source glyph and bitmap for each position: glyphs left out of
+     * a subset are replaced by the default character (whose bitmap is then
+     * shared), and the .null character, if it needs to be added, is a blank
+     * bitmap the size of the default character's
+     */
+    cbNull = glyph_bitmap( &font, ulDefault, &pBitmap );
+    if ( !cbNull ) cbNull = recFontDefHeader.yCellHeight;
+    papBitmaps = (PBYTE *) calloc( count + 1, sizeof( PBYTE ) + ( 3 * sizeof( ULONG )));
+    pNull = (PBYTE) calloc( cbNull, 1 );
+    if ( !papBitmaps || !pNull ) {
+        fprintf( stderr, "Failed to allocate memory for glyph data.  Cannot continue.\n");
+        free( papBitmaps );
+        free( pNull );
+        return 0;
+    }
+    pulSizes  = (PULONG)( papBitmaps + count + 1 );
+    pulSame   = pulSizes + count + 1;
+    pulSource = pulSame + count + 1;
+    for ( i = 0; i < count; i++ ) {
+        pulSource[ i ] = ulFrom + i;
+        if ( pbKeep && !GLYPH_KEPT( pbKeep, ulFirst + ulFrom + i ))
+            pulSource[ i ] = ulDefault;
+        pulSizes[ i ] = glyph_bitmap( &font, pulSource[ i ], papBitmaps + i );
+    }
+    pulSource[ count ] = ulDefault;
+    if ( ulFirst + ulFrom ) {
+        papBitmaps[ count ] = pNull;
+        pulSizes[ count ]   = cbNull;
+    }
+
+    /* work out the size of the glyph data: the requested number of character
+     * definition records (adding space for the .null character if needed),
+     * followed by each distinct glyph bitmap
+     */
+    cbCharDefs = count * font.pFontDef->usCellSize;
+    if ( ulFirst + ulFrom )
+        cbCharDefs += font.pFontDef->usCellSize;
+    for ( i = 0, cbBitmaps = 0; i <= count; i++ )
+        cbBitmaps += pulSizes[ i ];
+    cbGlyphData = cbCharDefs + dedup_bitmaps( papBitmaps, pulSizes, count + 1, pulSame );
+    recFontDefHeader.ulSize = sizeof( recFontDefHeader ) + cbGlyphData;
+    cbFont = cbBaseOffset + cbGlyphData;
+
+    /* keep the kerning pairs whose glyphs are both being saved; if the font
+     * could not be given a kerning index, the pairs are taken straight from
+     * the kerning table instead (as many of them as fit within the font)
+     */
+    if ( font.pKernIndex ) {
+        pKernPairs = font.pKernIndex->paPairs;
+        cSrcPairs  = font.pKernIndex->cPairs;
+    }
+    else if ( font.pKerning && font.pMetrics->usKerningPairs ) {
+        pKernPairs = (POS2KERNINGPAIRS)( (PBYTE) font.pKerning + sizeof( OS2KERNPAIRTABLE ));
+        cSrcPairs  = font.pMetrics->usKerningPairs;
+        cbKernPairs = (PBYTE) pKernPairs - (PBYTE) font.pSignature;
+        cbKernPairs = ( cbKernPairs < font.cbSize ) ? font.cbSize - cbKernPairs : 0;
+        if ( cSrcPairs > ( cbKernPairs / sizeof( OS2KERNINGPAIRS )))
+            cSrcPairs = cbKernPairs / sizeof( OS2KERNINGPAIRS );
+    }
+    for ( i = 0; i < cSrcPairs; i++ )
+        if ( kern_pair_saved( pKernPairs + i, ulFirst + ulFrom, count, pbKeep ))
+            cKernPairs++;
+    if ( cKernPairs ) {
+        memcpy( &recFontKerning, font.pKerning, sizeof( recFontKerning ));
+        cbFont += sizeof( recFontKerning ) + ( cKernPairs * sizeof( OS2KERNINGPAIRS ));
+    }
+    recFontMetrics.usKerningPairs = cKernPairs;
+
+    if ( font.pPanose && ( font.pPanose->Identity == SIG_OS2ADDMETRICS )) {
+        memcpy( &recFontPanose, font.pPanose, sizeof( recFontPanose ));
+        recFontPanose.ulSize = sizeof( recFontPanose );
+        cbFont += recFontPanose.ulSize;
+    }
+
+    recFontEnd.Identity = SIG_OS2FONTEND;
+    recFontEnd.ulSize = sizeof( recFontEnd );
+    cbFont += recFontEnd.ulSize;
+
+    /* update the character count metrics */
+    recFontMetrics.usFirstChar = ulFirst + ulFrom;
+    recFontMetrics.usLastChar = count - 1;
+    if ( pbKeep ) {
+        recFontMetrics.usDefaultChar -= ulFrom;
+        if ( font.pMetrics->usBreakChar <= font.pMetrics->usLastChar )
+            recFontMetrics.usBreakChar -= ulFrom;
+    }
+    else if ( recFontMetrics.usDefaultChar > recFontMetrics.usLastChar )
+        recFontMetrics.usDefaultChar = recFontMetrics.usFirstChar;
+
+    if (( dpi == 96 ) || ( dpi == 120 )) {
+        usPts = 10 * round( recFontMetrics.yEmHeight / (dpi / 72.0) );
+        recFontMetrics.xDeviceRes = dpi;
+        recFontMetrics.yDeviceRes = dpi;
+        recFontMetrics.usNominalPointSize = usPts;
+        recFontMetrics.usMinimumPointSize = usPts;
+        recFontMetrics.usMaximumPointSize = usPts;
+    }
+
+    /* now build the whole file in a buffer of exactly the right size */
+    pFile = (PBYTE) calloc( cbFont, 1 );
+    if ( !pFile ) {
+        fprintf( stderr, "Failed to allocate memory for the output font.  Cannot continue.\n");
+        free( papBitmaps );
+        free( pNull );
+        return 0;
+    }
+    memcpy( pFile, &recFontSignature, sizeof( recFontSignature ));
+    cbOffset = sizeof( recFontSignature );
+    memcpy( pFile + cbOffset, &recFontMetrics, sizeof( recFontMetrics ));
+    cbOffset += sizeof( recFontMetrics );
+    memcpy( pFile + cbOffset, &recFontDefHeader, sizeof( recFontDefHeader ));
+    cbOffset += sizeof( recFontDefHeader );
+
+    /* copy the character definitions, then each distinct glyph bitmap (making
+     * sure each definition has the correct offset in the new file, and that
+     * duplicates point to the first copy); the .null character, if added,
+     * is last
+     */
+    for ( i = 0; ( i * recFontDefHeader.usCellSize ) < cbCharDefs; i++ )
+        memcpy( pFile + cbOffset + ( i * recFontDefHeader.usCellSize ),
+                (PBYTE)font.data.pChars + ( pulSource[ i ] * recFontDefHeader.usCellSize ),
+                recFontDefHeader.usCellSize );
+    cbOffset += cbCharDefs;
+    for ( i = 0; i <= count; i++ ) {
+        cbBitmap = pulSizes[ i ];
+        if ( !cbBitmap ) {
+            if (( i < count ) && !fQuiet )
+                fprintf( stderr, "The character definition at index %u is not valid.\n", i );
+            if ( i < count ) cInvalid++;
+            continue;
+        }
+        pCharDest = (POS2CHARDEF1)( pFile + cbBaseOffset + ( i * recFontDefHeader.usCellSize ));
+        if ( pulSame[ i ] != i ) {
+            pCharDest->ulOffset = ((POS2CHARDEF1)( pFile + cbBaseOffset +
+                                    ( pulSame[ i ] * recFontDefHeader.usCellSize )))->ulOffset;
+            continue;
+        }
+        pCharDest->ulOffset = cbOffset;
+#ifdef DEBUG
+        printf("Copying glyph %u, %u bytes at offset %u\n", i, cbBitmap, pCharDest->ulOffset );
+#endif
+        memcpy( pFile + cbOffset, papBitmaps[ i ], cbBitmap );
+        cbOffset += cbBitmap;
+    }
+    free( papBitmaps );
+    free( pNull );
+    if ( cInvalid && fQuiet )
+        fprintf( stderr, "%s: %u character definitions are not valid.\n", pszFileName, cInvalid );
+
+    /* kerning table, if any pairs were kept */
+    if ( cKernPairs ) {
+        memcpy( pFile + cbOffset, &recFontKerning, sizeof( recFontKerning ));
+        cbOffset += sizeof( recFontKerning );
+        for ( i = 0; i < cSrcPairs; i++ ) {
+            if ( !kern_pair_saved( pKernPairs + i, ulFirst + ulFrom, count, pbKeep ))
+                continue;
+            memcpy( pFile + cbOffset, pKernPairs + i, sizeof( OS2KERNINGPAIRS ));
+            cbOffset += sizeof( OS2KERNINGPAIRS );
+        }
+    }
+
+    /* panose table, if present */
+    if ( recFontPanose.Identity == SIG_OS2ADDMETRICS ) {
+        memcpy( pFile + cbOffset, &recFontPanose, recFontPanose.ulSize );
+        cbOffset += recFontPanose.ulSize;
+    }
+
+    /* font end signature */
+    memcpy( pFile + cbOffset, &recFontEnd, recFontEnd.ulSize );
+
+    /* now save the font */
+
+    if ( !fQuiet ) {
+        printf("Saving new font %s (%u bytes)...\n", pszFileName, cbFont );
+        printf(" - Font signature:    %s\n", recFontSignature.achSignature );
+        printf(" - Family name:       %s\n - Face name:         %s\n",
+               recFontMetrics.szFamilyname, recFontMetrics.szFacename );
+        printf(" - Point size:        %u (%ux%u dpi)\n",
+               recFontMetrics.usNominalPointSize / 10,
+               recFontMetrics.xDeviceRes, recFontMetrics.yDeviceRes );
+        printf(" - First glyph index: %u\n", recFontMetrics.usFirstChar );
+        printf(" - Last glyph index:  %u\n", recFontMetrics.usLastChar + recFontMetrics.usFirstChar );
+        printf(" - Default character: %u\n", recFontMetrics.usDefaultChar + recFontMetrics.usFirstChar );
+        printf(" - Break character:   %u\n", recFontMetrics.usBreakChar + recFontMetrics.usFirstChar );
+        printf(" - Font type:         ");
+        switch ( recFontDefHeader.fsChardef ) {
+            case OS2FONTDEF_CHAR3:
+                printf("3 (ABC-space proportional-width)\n");
+                break;
+            default:
+                if ( recFontDefHeader.fsFontdef == OS2FONTDEF_FONT2 )
+                    printf("2 (single-increment proportional-width)\n");
+                else
+                    printf("1 (fixed-width)\n");
+                break;
+        }
+        printf(" - Cell height:       %u\n", recFontDefHeader.yCellHeight );
+        printf(" - Definition length: %u\n", recFontDefHeader.ulSize );
+        printf(" - Glyph data length: %u\n", cbGlyphData );
+        printf(" - Duplicate bitmaps: %u bytes saved\n", cbBitmaps - ( cbGlyphData - cbCharDefs ));
+        if ( cKernPairs )
+            printf(" - Kerning pairs:     %u\n", cKernPairs );
+        if ( recFontPanose.Identity == SIG_OS2ADDMETRICS )
+            printf(" - PANOSE table:      (%u,%u,%u,%u,%u,%u,%u,%u,%u,%u)\n",
+                   recFontPanose.panose[0], recFontPanose.panose[1],
+                   recFontPanose.panose[2], recFontPanose.panose[3],
+                   recFontPanose.panose[4], recFontPanose.panose[5],
+                   recFontPanose.panose[6], recFontPanose.panose[7],
+                   recFontPanose.panose[8], recFontPanose.panose[8] );
+        printf("\n");
+    }
+
+    /* the caller may want the font itself, rather than a file */
+    if ( ppFont ) {
+        *ppFont = pFile;
+        return cbFont;
+    }
+
+    /* the whole file goes out in a single write */
+    newFontFile = fopen( pszFileName, "wb");
+    if ( !newFontFile ) {
+        fprintf( stderr, "The file %s could not be created.\n", pszFileName );
+        free( pFile );
+        return 0;
+    }
+    fOK = ( fwrite( pFile, cbFont, 1, newFontFile ) == 1 );
+    if ( fclose( newFontFile )) fOK = FALSE;
+    free( pFile );
+    if ( !fOK ) {
+        fprintf( stderr, "Failed to write file %s.\n", pszFileName );
+        return 0;
+    }
+    if ( !fQuiet )
+        printf("File saved.\n");
+
+    return cbFont;
+}